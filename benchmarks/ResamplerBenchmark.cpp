@@ -0,0 +1,69 @@
+// Throughput of the capture-side resampling stage: 44.1 kHz float in,
+// 16 kHz signed 16-bit PCM out, on a single core.
+//
+// Run with VIBECO_DISABLE_SIMD=1 to measure the scalar fallback.
+
+#include "CpuFeatures.h"
+#include "PolyphaseResampler.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    constexpr int kInputRate = 44100;
+    constexpr int kOutputRate = 16000;
+    // Matches the chunk size AudioWriter drains from the ring buffer
+    constexpr size_t kChunkSamples = 4096;
+    constexpr double kPi = 3.14159265358979323846;
+
+    std::vector<float> makeSignal(size_t count) {
+        std::vector<float> signal(count);
+        for (size_t i = 0; i < count; ++i) {
+            const double t = static_cast<double>(i) / kInputRate;
+            signal[i] = static_cast<float>(0.5 * std::sin(2.0 * kPi * 440.0 * t) +
+                                           0.25 * std::sin(2.0 * kPi * 3100.0 * t));
+        }
+        return signal;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    const int seconds = argc > 1 ? std::max(1, std::atoi(argv[1])) : 600;
+    const std::vector<float> input = makeSignal(static_cast<size_t>(seconds) * kInputRate);
+
+    PolyphaseResampler resampler(kInputRate, kOutputRate);
+    std::vector<float> resampled;
+    std::vector<int16_t> pcm;
+    resampled.reserve(kChunkSamples);
+    pcm.reserve(kChunkSamples);
+
+    size_t outputSamples = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t offset = 0; offset < input.size(); offset += kChunkSamples) {
+        const size_t count = std::min(kChunkSamples, input.size() - offset);
+        resampled.clear();
+        resampler.process(input.data() + offset, count, resampled);
+        pcm.resize(resampled.size());
+        SimdKernels::floatToInt16(resampled.data(), pcm.data(), resampled.size());
+        outputSamples += pcm.size();
+    }
+    resampled.clear();
+    outputSamples += resampler.flush(resampled);
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double secondsElapsed = std::chrono::duration<double>(elapsed).count();
+    const double inputRate = input.size() / secondsElapsed;
+
+    std::printf("kernels:        %s\n", CpuFeatures::simdLevelName());
+    std::printf("taps per phase: %zu\n", resampler.tapsPerPhase());
+    std::printf("audio:          %d s (%zu in, %zu out)\n", seconds, input.size(), outputSamples);
+    std::printf("elapsed:        %.3f s\n", secondsElapsed);
+    std::printf("throughput:     %.2f M input samples/s/core, %.2f M output samples/s/core\n",
+                inputRate / 1e6, outputSamples / secondsElapsed / 1e6);
+    std::printf("realtime:       %.0fx\n", inputRate / kInputRate);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// Cold start: launches the app repeatedly with --startup-benchmark and reports
+// time to tray icon and time to ready-to-record (PortAudio up, hotkeys live).
+//
+// The app prints its own milestones, measured from main(); process_ready_ms is
+// measured here and also includes process creation and dynamic loading.
+//
+// Usage: startup_benchmark <path-to-vibeco> [runs]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QProcess>
+#include <QStringList>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+namespace {
+    constexpr int kDefaultRuns = 10;
+    constexpr int kTimeoutMs = 30000;
+
+    // Parses "startup tray_icon_ms=12.3 ready_to_record_ms=45.6" into the map
+    bool parseMilestones(const QByteArray& output, QMap<QByteArray, std::vector<double>>& results) {
+        for (const QByteArray& line : output.split('\n')) {
+            const QByteArray trimmed = line.trimmed();
+            if (!trimmed.startsWith("startup ")) {
+                continue;
+            }
+            for (const QByteArray& field : trimmed.mid(8).split(' ')) {
+                const qsizetype equals = field.indexOf('=');
+                if (equals <= 0) {
+                    continue;
+                }
+                bool ok = false;
+                const double value = field.mid(equals + 1).toDouble(&ok);
+                if (ok) {
+                    results[field.left(equals)].push_back(value);
+                }
+            }
+            return true;
+        }
+        return false;
+    }
+} // namespace
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    if (args.size() < 2) {
+        std::fprintf(stderr, "usage: %s <path-to-vibeco> [runs]\n", argv[0]);
+        return 2;
+    }
+    const QString program = args.at(1);
+    const int runs = args.size() > 2 ? std::max(1, args.at(2).toInt()) : kDefaultRuns;
+
+    QMap<QByteArray, std::vector<double>> results;
+    for (int run = 0; run < runs; ++run) {
+        QProcess process;
+        process.setProcessChannelMode(QProcess::SeparateChannels);
+
+        QElapsedTimer timer;
+        timer.start();
+        process.start(program, {"--startup-benchmark"});
+        if (!process.waitForFinished(kTimeoutMs)) {
+            process.kill();
+            process.waitForFinished();
+            std::fprintf(stderr, "run %d: no exit within %d ms\n", run + 1, kTimeoutMs);
+            return 1;
+        }
+        const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+        if (process.exitStatus() != QProcess::NormalExit ||
+            !parseMilestones(process.readAllStandardOutput(), results)) {
+            std::fprintf(stderr, "run %d: app did not report ready (exit code %d)\n", run + 1,
+                         process.exitCode());
+            return 1;
+        }
+        results["process_ready_ms"].push_back(elapsedMs);
+    }
+
+    std::printf("%d runs of %s\n", runs, qPrintable(program));
+    for (auto it = results.begin(); it != results.end(); ++it) {
+        std::vector<double>& values = it.value();
+        std::sort(values.begin(), values.end());
+        std::printf("  %-24s min %8.1f  median %8.1f  max %8.1f\n", it.key().constData(),
+                    values.front(), values[values.size() / 2], values.back());
+    }
+    return 0;
+}
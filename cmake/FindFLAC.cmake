@@ -0,0 +1,45 @@
+# FindFLAC.cmake
+# Try to find libFLAC
+# Once done, this will define:
+#
+#  FLAC_FOUND - system has libFLAC
+#  FLAC_INCLUDE_DIRS - the libFLAC include directories
+#  FLAC_LIBRARIES - link these to use libFLAC
+
+find_path(FLAC_INCLUDE_DIR
+    NAMES FLAC/stream_encoder.h
+    PATHS
+    /opt/homebrew/include
+    /usr/local/include
+    /usr/include
+    /opt/local/include
+)
+
+find_library(FLAC_LIBRARY
+    NAMES FLAC
+    PATHS
+    /opt/homebrew/lib
+    /usr/local/lib
+    /usr/lib
+    /opt/local/lib
+)
+
+# Handle the QUIETLY and REQUIRED arguments and set FLAC_FOUND
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(FLAC DEFAULT_MSG
+    FLAC_LIBRARY FLAC_INCLUDE_DIR)
+
+if(FLAC_FOUND)
+    set(FLAC_LIBRARIES ${FLAC_LIBRARY})
+    set(FLAC_INCLUDE_DIRS ${FLAC_INCLUDE_DIR})
+
+    if(NOT TARGET FLAC::FLAC)
+        add_library(FLAC::FLAC UNKNOWN IMPORTED)
+        set_target_properties(FLAC::FLAC PROPERTIES
+            IMPORTED_LOCATION "${FLAC_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${FLAC_INCLUDE_DIR}"
+        )
+    endif()
+endif()
+
+mark_as_advanced(FLAC_INCLUDE_DIR FLAC_LIBRARY)
@@ -0,0 +1,75 @@
+# FindOpusEnc.cmake
+# Try to find libopusenc (Ogg Opus encoding) and the libopus it builds on
+# Once done, this will define:
+#
+#  OPUSENC_FOUND - system has libopusenc and libopus
+#  OPUSENC_INCLUDE_DIRS - the libopusenc/libopus include directories
+#  OPUSENC_LIBRARIES - link these to use libopusenc
+
+# opusenc.h includes <opus.h>, so both live under include/opus
+find_path(OPUSENC_INCLUDE_DIR
+    NAMES opusenc.h
+    PATH_SUFFIXES opus
+    PATHS
+    /opt/homebrew/include
+    /usr/local/include
+    /usr/include
+    /opt/local/include
+)
+
+find_path(OPUS_INCLUDE_DIR
+    NAMES opus.h
+    PATH_SUFFIXES opus
+    PATHS
+    /opt/homebrew/include
+    /usr/local/include
+    /usr/include
+    /opt/local/include
+)
+
+find_library(OPUSENC_LIBRARY
+    NAMES opusenc
+    PATHS
+    /opt/homebrew/lib
+    /usr/local/lib
+    /usr/lib
+    /opt/local/lib
+)
+
+find_library(OPUS_LIBRARY
+    NAMES opus
+    PATHS
+    /opt/homebrew/lib
+    /usr/local/lib
+    /usr/lib
+    /opt/local/lib
+)
+
+# Handle the QUIETLY and REQUIRED arguments and set OPUSENC_FOUND
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(OpusEnc DEFAULT_MSG
+    OPUSENC_LIBRARY OPUS_LIBRARY OPUSENC_INCLUDE_DIR OPUS_INCLUDE_DIR)
+
+if(OPUSENC_FOUND)
+    set(OPUSENC_LIBRARIES ${OPUSENC_LIBRARY} ${OPUS_LIBRARY})
+    set(OPUSENC_INCLUDE_DIRS ${OPUSENC_INCLUDE_DIR} ${OPUS_INCLUDE_DIR})
+
+    if(NOT TARGET Opus::Opus)
+        add_library(Opus::Opus UNKNOWN IMPORTED)
+        set_target_properties(Opus::Opus PROPERTIES
+            IMPORTED_LOCATION "${OPUS_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${OPUS_INCLUDE_DIR}"
+        )
+    endif()
+
+    if(NOT TARGET OpusEnc::OpusEnc)
+        add_library(OpusEnc::OpusEnc UNKNOWN IMPORTED)
+        set_target_properties(OpusEnc::OpusEnc PROPERTIES
+            IMPORTED_LOCATION "${OPUSENC_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${OPUSENC_INCLUDE_DIR}"
+            INTERFACE_LINK_LIBRARIES Opus::Opus
+        )
+    endif()
+endif()
+
+mark_as_advanced(OPUSENC_INCLUDE_DIR OPUS_INCLUDE_DIR OPUSENC_LIBRARY OPUS_LIBRARY)
@@ -0,0 +1,63 @@
+# FindWhisper.cmake
+# Try to find whisper.cpp (libwhisper) and the ggml libraries it links against
+# Once done, this will define:
+#
+#  WHISPER_FOUND - system has whisper.cpp
+#  WHISPER_INCLUDE_DIRS - the whisper.cpp include directory
+#  WHISPER_LIBRARIES - link these to use whisper.cpp
+
+find_path(WHISPER_INCLUDE_DIR
+    NAMES whisper.h
+    PATHS
+    /opt/homebrew/include
+    /usr/local/include
+    /usr/include
+    /opt/local/include
+)
+
+find_library(WHISPER_LIBRARY
+    NAMES whisper
+    PATHS
+    /opt/homebrew/lib
+    /usr/local/lib
+    /usr/lib
+    /opt/local/lib
+)
+
+# Recent whisper.cpp builds ggml as separate libraries; older ones bundle it
+find_library(GGML_LIBRARY
+    NAMES ggml
+    PATHS
+    /opt/homebrew/lib
+    /usr/local/lib
+    /usr/lib
+    /opt/local/lib
+)
+
+# Handle the QUIETLY and REQUIRED arguments and set WHISPER_FOUND
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Whisper DEFAULT_MSG
+    WHISPER_LIBRARY WHISPER_INCLUDE_DIR)
+
+if(WHISPER_FOUND)
+    set(WHISPER_LIBRARIES ${WHISPER_LIBRARY})
+    if(GGML_LIBRARY)
+        list(APPEND WHISPER_LIBRARIES ${GGML_LIBRARY})
+    endif()
+    set(WHISPER_INCLUDE_DIRS ${WHISPER_INCLUDE_DIR})
+
+    if(NOT TARGET Whisper::Whisper)
+        add_library(Whisper::Whisper UNKNOWN IMPORTED)
+        set_target_properties(Whisper::Whisper PROPERTIES
+            IMPORTED_LOCATION "${WHISPER_LIBRARY}"
+            INTERFACE_INCLUDE_DIRECTORIES "${WHISPER_INCLUDE_DIR}"
+        )
+        if(GGML_LIBRARY)
+            set_target_properties(Whisper::Whisper PROPERTIES
+                INTERFACE_LINK_LIBRARIES "${GGML_LIBRARY}"
+            )
+        endif()
+    endif()
+endif()
+
+mark_as_advanced(WHISPER_INCLUDE_DIR WHISPER_LIBRARY GGML_LIBRARY)
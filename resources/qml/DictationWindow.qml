@@ -16,6 +16,9 @@ Window {
 
     // Public properties and signals
     property bool isRecording: false
+    // Input level 0..1 and (min, max) waveform pairs, fed by setLevels()
+    property real level: 0
+    property var waveform: []
 
     signal dictationClicked
 
@@ -28,6 +31,8 @@ Window {
             top: parent.top
         }
         isRecording: dictationWindow.isRecording
+        level: dictationWindow.level
+        waveform: dictationWindow.waveform
 
         onClicked: {
             dictationWindow.dictationClicked();
@@ -62,6 +67,11 @@ Window {
         raise();
     }
 
+    function setLevels(newLevel, newWaveform) {
+        level = newLevel;
+        waveform = newWaveform;
+    }
+
     function hide() {
         visible = false;
     }
@@ -13,6 +13,8 @@ Rectangle {
 
     // Public properties
     property bool isRecording: false
+    property real level: 0
+    property var waveform: []
 
     // Private properties
     property bool isHovered: false
@@ -39,8 +41,44 @@ Rectangle {
         anchors.verticalCenter: parent.verticalCenter
         color: isRecording ? "#FF3B30" : "transparent"
         visible: isRecording || root.height > 10
+        // Pulses with the input level
+        scale: isRecording ? 0.8 + 0.6 * root.level : 1.0
     }
 
+    // Live waveform, newest on the right
+    Canvas {
+        id: waveformCanvas
+        anchors.right: parent.right
+        anchors.rightMargin: 8
+        anchors.verticalCenter: parent.verticalCenter
+        width: 24
+        height: 20
+        visible: isRecording && root.height > 15
+
+        onPaint: {
+            var ctx = getContext("2d");
+            ctx.clearRect(0, 0, width, height);
+            var columns = root.waveform.length / 2;
+            if (columns === 0)
+                return;
+            ctx.strokeStyle = "white";
+            ctx.lineWidth = 1;
+            ctx.beginPath();
+            var mid = height / 2;
+            // One pixel per column, so only the most recent ones fit
+            for (var x = 0; x < width; ++x) {
+                var i = columns - width + x;
+                if (i < 0)
+                    continue;
+                ctx.moveTo(x + 0.5, mid - root.waveform[2 * i + 1] * mid);
+                ctx.lineTo(x + 0.5, mid - root.waveform[2 * i] * mid + 1);
+            }
+            ctx.stroke();
+        }
+    }
+
+    onWaveformChanged: waveformCanvas.requestPaint()
+
     // Label
     Label {
         id: statusLabel
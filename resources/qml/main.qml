@@ -8,8 +8,6 @@ ApplicationWindow {
     id: mainWindow
     property bool isRecording: false
     property var trayHandler: null
-    property int recentTranscriptionsCount: 0
-    property var recentTranscriptions: []
 
     visible: true
     width: 900
@@ -173,14 +171,29 @@ ApplicationWindow {
                         Layout.fillWidth: true
                     }
 
+                    TextField {
+                        id: searchField
+                        placeholderText: qsTr("Search")
+                        placeholderTextColor: "#888888"
+                        color: "white"
+                        font.pixelSize: 12
+                        font.family: interRegular.name
+                        visible: transcriptionHistory.count > 0 || text.length > 0
+                        onTextChanged: transcriptionSearch.query = text
+                        background: Rectangle {
+                            color: "#333333"
+                            border.color: searchField.activeFocus ? "#777777" : "#555555"
+                            border.width: 1
+                            radius: 5
+                        }
+                        Layout.preferredHeight: 30
+                        Layout.preferredWidth: 220
+                    }
+
                     Button {
                         text: qsTr("Clear All")
-                        visible: mainWindow.recentTranscriptionsCount > 0
-                        onClicked: {
-                            // Clear transcriptions logic
-                            mainWindow.recentTranscriptions = []
-                            mainWindow.recentTranscriptionsCount = 0
-                        }
+                        visible: transcriptionHistory.count > 0
+                        onClicked: transcriptionHistory.clear()
                         background: Rectangle {
                             color: parent.pressed ? "#404040" : "#333333"
                             radius: 5
@@ -207,7 +220,9 @@ ApplicationWindow {
                     ListView {
                         id: transcriptionsList
                         anchors.fill: parent
-                        model: mainWindow.recentTranscriptions
+                        // Search results while there is a query, otherwise the whole history
+                        property bool searching: searchField.text.trim().length > 0
+                        model: searching ? transcriptionSearch : transcriptionHistory
                         spacing: 10
 
                         delegate: Rectangle {
@@ -230,14 +245,14 @@ ApplicationWindow {
                                     Layout.fillWidth: true
 
                                     Label {
-                                        text: modelData.timestamp || "Unknown"
+                                        text: model.timestamp || "Unknown"
                                         font.pixelSize: 12
                                         font.family: interMedium.name
                                         color: "#AAAAAA"
                                     }
 
                                     Label {
-                                        text: modelData.duration ? qsTr("%1 sec").arg(modelData.duration.toFixed(1)) : ""
+                                        text: model.duration ? qsTr("%1 sec").arg(model.duration.toFixed(1)) : ""
                                         font.pixelSize: 12
                                         font.family: interMedium.name
                                         color: "#AAAAAA"
@@ -247,7 +262,9 @@ ApplicationWindow {
                                 }
 
                                 Label {
-                                    text: modelData.text || qsTr("No text available")
+                                    text: transcriptionsList.searching ? model.highlightedText
+                                                                       : (model.text || qsTr("No text available"))
+                                    textFormat: transcriptionsList.searching ? Text.StyledText : Text.PlainText
                                     font.pixelSize: 14
                                     font.family: interRegular.name
                                     color: "white"
@@ -261,9 +278,7 @@ ApplicationWindow {
 
                                     Button {
                                         text: qsTr("Copy")
-                                        onClicked: {
-                                            // Copy text logic
-                                        }
+                                        onClicked: transcriptionsList.model.copyText(index)
                                         background: Rectangle {
                                             color: parent.pressed ? "#404040" : "#333333"
                                             border.color: "#555555"
@@ -284,17 +299,7 @@ ApplicationWindow {
 
                                     Button {
                                         text: qsTr("Delete")
-                                        onClicked: {
-                                            // Remove item logic
-                                            var newList = []
-                                            for (var i = 0; i < mainWindow.recentTranscriptions.length; i++) {
-                                                if (i !== index) {
-                                                    newList.push(mainWindow.recentTranscriptions[i])
-                                                }
-                                            }
-                                            mainWindow.recentTranscriptions = newList
-                                            mainWindow.recentTranscriptionsCount = newList.length
-                                        }
+                                        onClicked: transcriptionsList.model.remove(index)
                                         background: Rectangle {
                                             color: parent.pressed ? "#404040" : "#333333"
                                             border.color: "#555555"
@@ -326,14 +331,15 @@ ApplicationWindow {
                             width: parent.width * 0.8
                             height: 100
                             color: "transparent"
-                            visible: mainWindow.recentTranscriptionsCount === 0
+                            visible: transcriptionsList.model.count === 0
 
                             ColumnLayout {
                                 anchors.centerIn: parent
                                 spacing: 10
 
                                 Label {
-                                    text: qsTr("No transcriptions yet")
+                                    text: transcriptionsList.searching ? qsTr("No matches")
+                                                                       : qsTr("No transcriptions yet")
                                     font.pixelSize: 18
                                     font.family: interMedium.name
                                     color: "#888888"
@@ -341,6 +347,7 @@ ApplicationWindow {
                                 }
 
                                 Label {
+                                    visible: !transcriptionsList.searching
                                     text: qsTr("Use the record button to start transcribing your voice")
                                     font.pixelSize: 14
                                     font.family: interRegular.name
@@ -413,21 +420,6 @@ ApplicationWindow {
         function onRecordingStopped() {
             mainWindow.isRecording = false
         }
-
-        function onTranscriptionReceived(text, duration, language) {
-            // Add new transcription to the list
-            var newTranscription = {
-                text: text,
-                timestamp: new Date().toLocaleString(),
-                duration: duration || 0,
-                language: language || "unknown"
-            }
-
-            // Add to the beginning of the list
-            var newList = [newTranscription].concat(mainWindow.recentTranscriptions)
-            mainWindow.recentTranscriptions = newList
-            mainWindow.recentTranscriptionsCount = newList.length
-        }
     }
 
     // Function to check if trayHandler is available
@@ -436,15 +428,6 @@ ApplicationWindow {
         return mainWindow.trayHandler !== null
     }
 
-    // Function to be called from C++ via invokeMethod
-    function onTranscriptionReceived(transcription) {
-        // Add new transcription to the list
-        // Add to the beginning of the list
-        var newList = [transcription].concat(mainWindow.recentTranscriptions)
-        mainWindow.recentTranscriptions = newList
-        mainWindow.recentTranscriptionsCount = newList.length
-    }
-
     // Font loaders
     FontLoader {
         id: interRegular
@@ -0,0 +1,40 @@
+#ifndef AUDIOENCODER_H
+#define AUDIOENCODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+// Incremental encoder for upload payloads.
+//
+// Samples are pushed as they are captured and compressed bytes come out of
+// the sink as soon as the codec produces them, so the payload is complete
+// right after finish(). Output is always streamable: no seeking back to patch
+// headers, which lets it go straight into an upload that is already running.
+class AudioEncoder {
+  public:
+    enum class Format { Wav, Flac, Opus };
+
+    using Sink = std::function<void(const uint8_t* data, size_t size)>;
+
+    virtual ~AudioEncoder() = default;
+
+    virtual bool begin(int sampleRate, int channels, Sink sink) = 0;
+    // Interleaved signed 16-bit samples; frames is the count per channel
+    virtual bool encode(const int16_t* samples, size_t frames) = 0;
+    // Flushes buffered audio and trailing container data through the sink
+    virtual bool finish() = 0;
+
+    // Returns null for Wav (no encoding needed) or if the codec was not compiled in
+    static std::unique_ptr<AudioEncoder> create(Format format);
+    static bool isAvailable(Format format);
+
+    // Settings keys ("wav", "flac", "opus"); unknown names map to Wav
+    static const char* formatName(Format format);
+    static Format formatFromName(const char* name);
+    static const char* fileExtension(Format format);
+    static const char* contentType(Format format);
+};
+
+#endif // AUDIOENCODER_H
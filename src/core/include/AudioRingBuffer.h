@@ -0,0 +1,105 @@
+#ifndef AUDIORINGBUFFER_H
+#define AUDIORINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Single-producer/single-consumer ring buffer for captured samples.
+//
+// The producer is the real-time audio callback: write() never allocates,
+// locks or blocks, it only copies into preallocated storage. When the
+// consumer falls behind and a block does not fit, the whole block is dropped
+// and the overflow counters are bumped so the loss can be reported later.
+class AudioRingBuffer {
+  public:
+    // Capacity is rounded up to the next power of two.
+    explicit AudioRingBuffer(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_buffer.resize(size);
+        m_mask = size - 1;
+    }
+
+    AudioRingBuffer(const AudioRingBuffer&) = delete;
+    AudioRingBuffer& operator=(const AudioRingBuffer&) = delete;
+
+    size_t capacity() const {
+        return m_buffer.size();
+    }
+
+    // Producer side. Returns false (and counts an overflow) if the block does not fit.
+    bool write(const float* data, size_t count) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        if (count > m_buffer.size() - (head - tail)) {
+            m_overflows.fetch_add(1, std::memory_order_relaxed);
+            m_droppedSamples.fetch_add(count, std::memory_order_relaxed);
+            return false;
+        }
+
+        const size_t offset = head & m_mask;
+        const size_t firstPart = std::min(count, m_buffer.size() - offset);
+        std::memcpy(m_buffer.data() + offset, data, firstPart * sizeof(float));
+        std::memcpy(m_buffer.data(), data + firstPart, (count - firstPart) * sizeof(float));
+
+        m_head.store(head + count, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Copies up to maxCount samples and returns how many were read.
+    size_t read(float* data, size_t maxCount) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t count = std::min(maxCount, head - tail);
+        if (count == 0) {
+            return 0;
+        }
+
+        const size_t offset = tail & m_mask;
+        const size_t firstPart = std::min(count, m_buffer.size() - offset);
+        std::memcpy(data, m_buffer.data() + offset, firstPart * sizeof(float));
+        std::memcpy(data + firstPart, m_buffer.data(), (count - firstPart) * sizeof(float));
+
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t available() const {
+        return m_head.load(std::memory_order_acquire) - m_tail.load(std::memory_order_acquire);
+    }
+
+    // Consumer side. Drops everything not yet read and zeroes the counters; safe while
+    // the producer is still writing, which then only adds to the new contents.
+    void discard() {
+        m_tail.store(m_head.load(std::memory_order_acquire), std::memory_order_release);
+        m_overflows.store(0, std::memory_order_relaxed);
+        m_droppedSamples.store(0, std::memory_order_relaxed);
+    }
+
+    // Number of producer writes that were dropped because the buffer was full.
+    uint64_t overflowCount() const {
+        return m_overflows.load(std::memory_order_relaxed);
+    }
+
+    uint64_t droppedSamples() const {
+        return m_droppedSamples.load(std::memory_order_relaxed);
+    }
+
+  private:
+    std::vector<float> m_buffer;
+    size_t m_mask = 0;
+
+    // Head and tail live on separate cache lines so producer and consumer don't false-share.
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<uint64_t> m_overflows{0};
+    std::atomic<uint64_t> m_droppedSamples{0};
+};
+
+#endif // AUDIORINGBUFFER_H
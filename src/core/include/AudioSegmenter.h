@@ -0,0 +1,23 @@
+#ifndef AUDIOSEGMENTER_H
+#define AUDIOSEGMENTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Splits a finished mono PCM16 recording into pieces that can be transcribed
+// independently, cutting in the middle of pauses so no word is split.
+namespace AudioSegmenter {
+    struct Segment {
+        size_t start;  // first sample
+        size_t length; // in samples
+    };
+
+    // Every segment is at most maxSeconds long and, except the last, at least half
+    // of that. Segments without any detected speech are left out; a recording with
+    // no speech at all comes back as a single segment.
+    std::vector<Segment> plan(const int16_t* samples, size_t count, int sampleRate,
+                              double maxSeconds);
+} // namespace AudioSegmenter
+
+#endif // AUDIOSEGMENTER_H
@@ -0,0 +1,46 @@
+#ifndef CHUNKARENA_H
+#define CHUNKARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Append-only byte store made of fixed-size chunks.
+//
+// Growing never moves data that is already stored (unlike a std::vector or
+// QByteArray), so a long recording costs no reallocation copies and readers can
+// work directly on the chunk memory through peek().
+//
+// Not synchronised: one thread appends, and readers may only look at it once
+// appending has finished (e.g. after AudioWriter::stopWriting()).
+class ChunkArena {
+  public:
+    // 64 KiB is two seconds of 16 kHz PCM16
+    static constexpr size_t kDefaultChunkSize = 64 * 1024;
+
+    explicit ChunkArena(size_t chunkSize = kDefaultChunkSize);
+
+    void append(const void* data, size_t size);
+    void clear();
+
+    size_t size() const {
+        return m_size;
+    }
+    size_t chunkSize() const {
+        return m_chunkSize;
+    }
+
+    // Pointer to the byte at offset; available is set to the number of contiguous
+    // bytes from there to the end of its chunk (or of the data). Null past the end.
+    const char* peek(size_t offset, size_t& available) const;
+
+    // Copies up to size bytes starting at offset; returns the number copied
+    size_t read(size_t offset, void* out, size_t size) const;
+
+  private:
+    size_t m_chunkSize;
+    size_t m_size;
+    std::vector<std::unique_ptr<char[]>> m_chunks;
+};
+
+#endif // CHUNKARENA_H
@@ -0,0 +1,28 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+// Runtime CPU feature detection used to pick SIMD kernels.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define VIBECO_ARCH_X86 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#define VIBECO_TARGET_AVX2
+#define VIBECO_TARGET_SSE2
+#else
+#define VIBECO_TARGET_AVX2 __attribute__((target("avx2")))
+#define VIBECO_TARGET_SSE2 __attribute__((target("sse2")))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define VIBECO_ARCH_NEON 1
+#endif
+
+namespace CpuFeatures {
+    bool hasSse2();
+    bool hasAvx2();
+    bool hasNeon();
+
+    // Name of the widest SIMD instruction set in use, for logging and benchmarks
+    const char* simdLevelName();
+} // namespace CpuFeatures
+
+#endif // CPUFEATURES_H
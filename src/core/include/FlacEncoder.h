@@ -0,0 +1,26 @@
+#ifndef FLACENCODER_H
+#define FLACENCODER_H
+
+#include "AudioEncoder.h"
+#include <vector>
+
+typedef struct FLAC__StreamEncoder FLAC__StreamEncoder;
+
+// Lossless FLAC via libFLAC's stream encoder. About half the size of PCM16 for speech.
+class FlacEncoder : public AudioEncoder {
+  public:
+    FlacEncoder();
+    ~FlacEncoder() override;
+
+    bool begin(int sampleRate, int channels, Sink sink) override;
+    bool encode(const int16_t* samples, size_t frames) override;
+    bool finish() override;
+
+  private:
+    FLAC__StreamEncoder* m_encoder;
+    Sink m_sink;
+    int m_channels;
+    std::vector<int32_t> m_widened;
+};
+
+#endif // FLACENCODER_H
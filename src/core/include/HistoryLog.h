@@ -0,0 +1,72 @@
+#ifndef HISTORYLOG_H
+#define HISTORYLOG_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only file of opaque records, with an index of record offsets kept in a
+// side file (path + ".idx") so any record can be read with one seek.
+//
+// Each record is framed by its length and a checksum. A crash can leave a torn
+// record at the end of the log, or records the index doesn't list yet; open()
+// finds both, cuts the torn record off and re-indexes the rest, so a reopened
+// log holds exactly the records whose append() completed. Damage anywhere else
+// shows up as read() failing for the affected record. Appends are flushed to the
+// OS before returning (they survive the app crashing, not necessarily the
+// machine losing power).
+//
+// Not synchronised; use from one thread. Another thread (or process) may read
+// the same files through its own HistoryLog opened ReadOnly, which never writes
+// and only sees complete records.
+class HistoryLog {
+  public:
+    enum class Mode { ReadWrite, ReadOnly };
+
+    HistoryLog() = default;
+    ~HistoryLog();
+
+    HistoryLog(const HistoryLog&) = delete;
+    HistoryLog& operator=(const HistoryLog&) = delete;
+
+    // Opens or creates the log and its index, recovering from an interrupted write.
+    // ReadOnly opens an existing log as it stands and repairs nothing.
+    bool open(const std::string& path, Mode mode = Mode::ReadWrite);
+    void close();
+    bool isOpen() const {
+        return m_log != nullptr;
+    }
+
+    size_t size() const {
+        return m_offsets.size();
+    }
+
+    // Picks up records appended through another HistoryLog since open; returns size()
+    size_t refresh();
+
+    bool append(std::string_view payload);
+    // False if index is out of range or the record can't be read back intact
+    bool read(size_t index, std::string& payload);
+
+    // Drops every record
+    bool clear();
+
+  private:
+    bool readHeader(uint64_t offset, uint32_t& length, uint32_t& checksum);
+    bool validRecordAt(uint64_t offset, uint64_t fileSize, uint64_t& next);
+    // Indexes the intact records from m_end up to logSize
+    void scanForward(uint64_t logSize);
+    bool rewriteIndex();
+
+    std::string m_path;
+    Mode m_mode = Mode::ReadWrite;
+    std::FILE* m_log = nullptr;
+    std::FILE* m_index = nullptr;
+    std::vector<uint64_t> m_offsets;
+    uint64_t m_end = 0; // Where the next record goes
+    std::string m_scratch;
+};
+
+#endif // HISTORYLOG_H
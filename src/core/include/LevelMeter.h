@@ -0,0 +1,70 @@
+#ifndef LEVELMETER_H
+#define LEVELMETER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Peak/RMS metering and a scrolling min/max waveform for a live level display.
+//
+// The producer feeds every captured sample through process(); samples are
+// reduced to one waveform column per columnSeconds, and each finished column
+// publishes a new snapshot. A reader on another thread picks up the latest one
+// with read(). Hand-over is a triple buffer: neither side ever blocks or
+// allocates, and a slow reader just skips snapshots.
+class LevelMeter {
+  public:
+    static constexpr size_t kWaveformColumns = 64;
+
+    struct Snapshot {
+        // Of the most recent column, as linear amplitude (1.0 = full scale)
+        float peak = 0.0f;
+        float rms = 0.0f;
+        // Oldest column first
+        std::array<float, kWaveformColumns> minimum{};
+        std::array<float, kWaveformColumns> maximum{};
+        uint64_t sequence = 0; // Columns completed since reset()
+    };
+
+    explicit LevelMeter(int sampleRate, double columnSeconds = 1.0 / 30.0);
+
+    // Only while neither side is running
+    void reset();
+    // For a new capture rate; also resets. Only while neither side is running.
+    void setSampleRate(int sampleRate);
+
+    // Producer thread
+    void process(const float* samples, size_t count);
+
+    // Consumer thread. Returns false (and leaves out alone) if nothing was published
+    // since the previous call.
+    bool read(Snapshot& out);
+
+  private:
+    void finishColumn();
+
+    static constexpr int kFresh = 4; // Flag next to the 0..2 buffer index
+
+    double m_columnSeconds;
+    size_t m_columnSamples;
+
+    // Producer state
+    size_t m_pending;
+    float m_min;
+    float m_max;
+    double m_sumSquares;
+    size_t m_head; // Next column to overwrite in the ring below
+    std::array<float, kWaveformColumns> m_ringMin{};
+    std::array<float, kWaveformColumns> m_ringMax{};
+    uint64_t m_sequence;
+    int m_back;
+
+    // Consumer state
+    int m_front;
+
+    std::array<Snapshot, 3> m_buffers;
+    std::atomic<int> m_middle;
+};
+
+#endif // LEVELMETER_H
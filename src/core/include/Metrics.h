@@ -0,0 +1,89 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Process-wide counters and latency histograms, rendered in the Prometheus
+// text exposition format.
+//
+// Look a metric up once and keep the reference: lookups take a lock, updates
+// are single relaxed atomic operations (safe even on the audio callback).
+// Metrics are never removed, so references stay valid for the process lifetime.
+namespace Metrics {
+    class Counter {
+      public:
+        void add(uint64_t n = 1) {
+            m_value.fetch_add(n, std::memory_order_relaxed);
+        }
+        uint64_t value() const {
+            return m_value.load(std::memory_order_relaxed);
+        }
+
+      private:
+        std::atomic<uint64_t> m_value{0};
+    };
+
+    // HDR-style histogram of durations: exact below 16 us, then eight log-linear
+    // buckets per power of two (at most 12.5% relative error) up to about 25 days.
+    class Histogram {
+      public:
+        void record(double milliseconds);
+
+        uint64_t count() const;
+        double sumMs() const;
+        // Value at quantile q in [0, 1], in milliseconds (midpoint of its bucket)
+        double quantileMs(double q) const;
+
+      private:
+        static constexpr int kLinearBuckets = 16;
+        static constexpr int kSubBuckets = 8;
+        static constexpr int kMaxExponent = 40;
+        static constexpr size_t kBucketCount = kLinearBuckets + (kMaxExponent - 3) * kSubBuckets;
+
+        static size_t bucketFor(uint64_t micros);
+        static double bucketMidpointUs(size_t index);
+
+        std::array<std::atomic<uint64_t>, kBucketCount> m_buckets{};
+        std::atomic<uint64_t> m_count{0};
+        std::atomic<uint64_t> m_sumUs{0};
+    };
+
+    class Registry {
+      public:
+        static Registry& instance();
+
+        // labels is the inside of the braces, e.g. type="timeout"; empty for none
+        Counter& counter(const std::string& name, const std::string& help,
+                         const std::string& labels = {});
+        // Exported as a summary in seconds (quantiles, _sum, _count)
+        Histogram& histogram(const std::string& name, const std::string& help);
+
+        std::string renderPrometheus() const;
+
+      private:
+        struct CounterFamily {
+            std::string help;
+            std::map<std::string, std::unique_ptr<Counter>> series;
+        };
+        struct HistogramFamily {
+            std::string help;
+            std::unique_ptr<Histogram> histogram;
+        };
+
+        mutable std::mutex m_mutex;
+        std::map<std::string, CounterFamily> m_counters;
+        std::map<std::string, HistogramFamily> m_histograms;
+    };
+
+    // Bumps vibeco_errors_total{type="..."}; type is a short snake_case tag
+    void countError(const std::string& type);
+} // namespace Metrics
+
+#endif // METRICS_H
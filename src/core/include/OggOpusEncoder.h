@@ -0,0 +1,28 @@
+#ifndef OGGOPUSENCODER_H
+#define OGGOPUSENCODER_H
+
+#include "AudioEncoder.h"
+
+typedef struct OggOpusEnc OggOpusEnc;
+typedef struct OggOpusComments OggOpusComments;
+
+// Ogg Opus via libopusenc, tuned for speech. Roughly 20x smaller than PCM16.
+class OggOpusEncoder : public AudioEncoder {
+  public:
+    OggOpusEncoder();
+    ~OggOpusEncoder() override;
+
+    bool begin(int sampleRate, int channels, Sink sink) override;
+    bool encode(const int16_t* samples, size_t frames) override;
+    bool finish() override;
+
+  private:
+    static int writePage(void* userData, const unsigned char* data, int32_t length);
+    static int closeStream(void* userData);
+
+    OggOpusEnc* m_encoder;
+    OggOpusComments* m_comments;
+    Sink m_sink;
+};
+
+#endif // OGGOPUSENCODER_H
@@ -0,0 +1,61 @@
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming rational-ratio resampler for mono float audio.
+//
+// The rate change is reduced to L/M (160/441 for 44.1 kHz -> 16 kHz) and a
+// Kaiser-windowed sinc low-pass is split into L polyphase branches, so each
+// output sample costs one short dot product over contiguous input. The dot
+// products go through SimdKernels and pick up AVX2/SSE2/NEON at runtime.
+//
+// Not thread-safe; meant to be driven by a single consumer such as the
+// audio writer thread.
+class PolyphaseResampler {
+  public:
+    PolyphaseResampler(int inputRate, int outputRate);
+
+    int inputRate() const {
+        return m_inputRate;
+    }
+    int outputRate() const {
+        return m_outputRate;
+    }
+    size_t tapsPerPhase() const {
+        return m_tapsPerPhase;
+    }
+
+    // Resamples count input samples and appends the result to out.
+    // Returns the number of samples appended.
+    size_t process(const float* in, size_t count, std::vector<float>& out);
+
+    // Pushes the samples still held back by the filter delay into out and
+    // resets the resampler for the next stream.
+    size_t flush(std::vector<float>& out);
+
+    // Drops buffered history, e.g. before starting a new recording.
+    void reset();
+
+  private:
+    size_t produce(std::vector<float>& out, uint64_t limit);
+
+    int m_inputRate;
+    int m_outputRate;
+    size_t m_interpolation; // L
+    size_t m_decimation;    // M
+    size_t m_tapsPerPhase;
+    size_t m_primeSamples;
+
+    // Phase p's taps live at [p * m_tapsPerPhase, (p + 1) * m_tapsPerPhase)
+    std::vector<float> m_coefficients;
+    std::vector<float> m_history;
+    size_t m_position;
+    size_t m_phase;
+    uint64_t m_inputCount;
+    uint64_t m_outputCount;
+};
+
+#endif // POLYPHASERESAMPLER_H
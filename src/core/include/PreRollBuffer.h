@@ -0,0 +1,84 @@
+#ifndef PREROLLBUFFER_H
+#define PREROLLBUFFER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// The most recent samples captured while no recording is running, so that a
+// recording can start with the audio from just before it was triggered.
+//
+// Owned by the real-time audio callback: write() and drain() never allocate,
+// lock or block, and new samples simply overwrite the oldest. There is no
+// consumer on another thread, so no synchronization is needed; setCapacity()
+// may only be called while the stream is closed.
+class PreRollBuffer {
+  public:
+    explicit PreRollBuffer(size_t capacity = 0) {
+        setCapacity(capacity);
+    }
+
+    PreRollBuffer(const PreRollBuffer&) = delete;
+    PreRollBuffer& operator=(const PreRollBuffer&) = delete;
+
+    // Allocates; discards what was held
+    void setCapacity(size_t capacity) {
+        m_buffer.assign(capacity, 0.0f);
+        clear();
+    }
+
+    size_t capacity() const {
+        return m_buffer.size();
+    }
+    size_t size() const {
+        return m_size;
+    }
+
+    void clear() {
+        m_head = 0;
+        m_size = 0;
+    }
+
+    // Keeps the newest capacity() samples of everything written so far
+    void write(const float* data, size_t count) {
+        const size_t capacity = m_buffer.size();
+        if (capacity == 0) {
+            return;
+        }
+        if (count >= capacity) {
+            std::memcpy(m_buffer.data(), data + count - capacity, capacity * sizeof(float));
+            m_head = 0;
+            m_size = capacity;
+            return;
+        }
+
+        const size_t firstPart = std::min(count, capacity - m_head);
+        std::memcpy(m_buffer.data() + m_head, data, firstPart * sizeof(float));
+        std::memcpy(m_buffer.data(), data + firstPart, (count - firstPart) * sizeof(float));
+        m_head = (m_head + count) % capacity;
+        m_size = std::min(capacity, m_size + count);
+    }
+
+    // Hands the held samples to sink(const float*, size_t) oldest first, in at most
+    // two calls, then empties the buffer
+    template <typename Sink> void drain(Sink&& sink) {
+        const size_t capacity = m_buffer.size();
+        const size_t start = (m_head + capacity - m_size) % std::max<size_t>(capacity, 1);
+        const size_t firstPart = std::min(m_size, capacity - start);
+        if (firstPart > 0) {
+            sink(m_buffer.data() + start, firstPart);
+        }
+        if (m_size > firstPart) {
+            sink(m_buffer.data(), m_size - firstPart);
+        }
+        clear();
+    }
+
+  private:
+    std::vector<float> m_buffer;
+    size_t m_head = 0; // Next slot to write
+    size_t m_size = 0;
+};
+
+#endif // PREROLLBUFFER_H
@@ -0,0 +1,79 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inverted index for full-text search over numbered documents (history records).
+//
+// Words are runs of letters and digits between whitespace, punctuation and
+// symbols, matched case insensitively for ASCII only. Chinese and Japanese, which
+// aren't written with spaces, are indexed a character at a time, so a query of
+// several characters matches documents containing each of them. Each term keeps the documents containing it and
+// how often, in document order, so adding the newest document only appends.
+// Removed documents stay in the postings and are skipped when searching.
+//
+// A query matches documents containing all of its words; the last word also
+// matches as a prefix, unless the query ends in a space, so results follow the
+// user's typing. Results are ranked by BM25, newest first among equal scores.
+//
+// Not synchronised; use from one thread.
+class SearchIndex {
+  public:
+    struct Hit {
+        uint32_t document;
+        float score;
+    };
+    // Byte range in a document's UTF-8 text
+    struct Range {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    // Documents must be added in increasing order; skipped numbers count as removed
+    void add(uint32_t document, std::string_view text);
+    void remove(uint32_t document);
+    void clear();
+
+    // One past the last document added; adding resumes from here after load()
+    uint32_t documentCount() const {
+        return static_cast<uint32_t>(m_lengths.size());
+    }
+    size_t termCount() const {
+        return m_terms.size();
+    }
+
+    // Best matches first, at most limit of them
+    std::vector<Hit> search(std::string_view query, size_t limit) const;
+    // Where query's words occur in text, in order
+    static std::vector<Range> highlights(std::string_view text, std::string_view query);
+
+    // The index is saved whole, with a checksum; load() fails, leaving the index
+    // empty, if the file is missing or damaged. Removals are not saved.
+    bool save(const std::string& path) const;
+    bool load(const std::string& path);
+
+  private:
+    struct Postings {
+        std::vector<uint32_t> documents;
+        std::vector<uint16_t> counts;
+    };
+    struct Query {
+        std::vector<std::string> words;
+        bool lastIsPrefix = false;
+    };
+
+    static Query parse(std::string_view query);
+
+    std::map<std::string, Postings, std::less<>> m_terms;
+    std::vector<uint16_t> m_lengths; // Words per document, for length normalisation
+    std::vector<bool> m_removed;
+    uint64_t m_totalLength = 0; // Of documents not removed
+    uint32_t m_liveCount = 0;
+};
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,95 @@
+#ifndef SILENCETRIMMER_H
+#define SILENCETRIMMER_H
+
+#include "VoiceActivityDetector.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Streaming silence gate in front of the upload.
+//
+// Drops leading and trailing silence and shortens long pauses, keeping a
+// little padding around speech so word onsets and tails survive. Decisions
+// are made per VAD frame, so output lags input by at most the pause limit.
+// Every kept stretch is recorded in a TimeMap, which translates timestamps in
+// the trimmed audio back to positions in the original recording.
+class SilenceTrimmer {
+  public:
+    // A run of samples copied unchanged from the source to the trimmed output
+    struct Span {
+        uint64_t sourceStart;
+        uint64_t trimmedStart;
+        uint64_t length;
+    };
+
+    class TimeMap {
+      public:
+        TimeMap() = default;
+        TimeMap(std::vector<Span> spans, int sampleRate)
+            : m_spans(std::move(spans)), m_sampleRate(sampleRate) {
+        }
+
+        // Converts a time in the trimmed audio to a time in the source, in seconds
+        double toSourceTime(double trimmedSeconds) const;
+
+        const std::vector<Span>& spans() const {
+            return m_spans;
+        }
+        bool isEmpty() const {
+            return m_spans.empty();
+        }
+
+      private:
+        std::vector<Span> m_spans;
+        int m_sampleRate = 0;
+    };
+
+    explicit SilenceTrimmer(int sampleRate);
+
+    // Appends the samples that survive trimming to out; returns how many were appended.
+    size_t process(const float* in, size_t count, std::vector<float>& out);
+
+    // Ends the stream: emits the tail padding after the last speech, drops the rest.
+    size_t flush(std::vector<float>& out);
+
+    void reset();
+
+    bool speechDetected() const {
+        return m_speechSeen;
+    }
+    uint64_t samplesIn() const {
+        return m_sourcePosition;
+    }
+    uint64_t samplesOut() const {
+        return m_trimmedPosition;
+    }
+    TimeMap timeMap() const {
+        return TimeMap(m_spans, m_sampleRate);
+    }
+
+  private:
+    void handleFrame(const float* frame, bool speech, std::vector<float>& out);
+    void emit(const float* samples, uint64_t sourceStart, size_t count, std::vector<float>& out);
+
+    int m_sampleRate;
+    VoiceActivityDetector m_detector;
+    size_t m_frameSize;
+    size_t m_padSamples;
+    size_t m_maxPauseSamples;
+
+    std::vector<float> m_partial; // input not yet making up a full frame
+
+    // Silence since the last speech frame, contiguous in the source from m_pendingStart.
+    // Once the pause is too long to keep (collapsing), the padding after the speech has
+    // been emitted and only the last m_padSamples are held for the next onset.
+    std::vector<float> m_pending;
+    uint64_t m_pendingStart;
+    bool m_collapsing;
+
+    bool m_speechSeen;
+    uint64_t m_sourcePosition;
+    uint64_t m_trimmedPosition;
+    std::vector<Span> m_spans;
+};
+
+#endif // SILENCETRIMMER_H
@@ -0,0 +1,30 @@
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Vectorized sample-processing primitives.
+//
+// Each function dispatches once, on first use, to an AVX2, SSE2 or NEON
+// implementation depending on the running CPU, with a scalar fallback.
+namespace SimdKernels {
+    // Sum of a[i] * b[i]
+    float dotProduct(const float* a, const float* b, size_t count);
+
+    // Clamps to [-1, 1] and scales to signed 16-bit PCM
+    void floatToInt16(const float* in, int16_t* out, size_t count);
+
+    // Number of sign changes between neighbouring samples
+    size_t zeroCrossings(const float* in, size_t count);
+
+    // Sum of log2(in[i]) for positive inputs, accurate to about 2e-4 per element
+    float sumLog2(const float* in, size_t count);
+
+    // Smallest and largest sample and the sum of squares, in one pass (for metering).
+    // An empty input gives min = max = sumSquares = 0.
+    void minMaxSumSquares(const float* in, size_t count, float& minValue, float& maxValue,
+                          float& sumSquares);
+} // namespace SimdKernels
+
+#endif // SIMDKERNELS_H
@@ -0,0 +1,69 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Latency tracing for the path from hotkey to text on screen.
+//
+// Events go into a fixed-size in-memory ring (the oldest are overwritten) and
+// can be exported as Chrome trace JSON for chrome://tracing or Perfetto. Every
+// event carries the ID of the dictation it belongs to, so one dictation can be
+// followed across threads and callbacks.
+//
+// Tracing is off by default. When it is off, each call costs one relaxed atomic
+// load and a branch, and Span doesn't even read the clock.
+//
+// Event names must be string literals (or otherwise outlive the ring); only
+// the pointer is stored.
+namespace Trace {
+    namespace detail {
+        extern std::atomic<bool> enabled;
+    } // namespace detail
+
+    inline bool enabled() {
+        return detail::enabled.load(std::memory_order_relaxed);
+    }
+    void setEnabled(bool enabled);
+
+    // Starts a new dictation and makes it current; returns its ID (never 0)
+    uint64_t beginDictation();
+    // The most recently started dictation, 0 before the first
+    uint64_t currentDictation();
+
+    // Microseconds on a monotonic clock
+    int64_t nowUs();
+
+    // A span that has already finished, e.g. one reconstructed from network timings
+    void complete(const char* name, int64_t startUs, int64_t durationUs, uint64_t dictation);
+    void instant(const char* name, uint64_t dictation);
+    // A span that starts and ends in different callbacks; pairs match on name and dictation
+    void asyncBegin(const char* name, uint64_t dictation);
+    void asyncEnd(const char* name, uint64_t dictation);
+
+    // Records the enclosing scope as a complete span
+    class Span {
+      public:
+        explicit Span(const char* name, uint64_t dictation = currentDictation())
+            : m_name(name), m_dictation(dictation), m_start(enabled() ? nowUs() : -1) {}
+        ~Span() {
+            if (m_start >= 0) {
+                complete(m_name, m_start, nowUs() - m_start, m_dictation);
+            }
+        }
+        Span(const Span&) = delete;
+        Span& operator=(const Span&) = delete;
+
+      private:
+        const char* m_name;
+        uint64_t m_dictation;
+        int64_t m_start;
+    };
+
+    // {"traceEvents": [...]} with everything currently in the ring, oldest first
+    std::string exportChromeJson();
+    void clear();
+} // namespace Trace
+
+#endif // TRACE_H
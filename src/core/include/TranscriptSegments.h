@@ -0,0 +1,107 @@
+#ifndef TRANSCRIPTSEGMENTS_H
+#define TRANSCRIPTSEGMENTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Timed pieces of a transcript, stored as parallel arrays.
+//
+// Each segment (a phrase, as the model split it) and each word (only present
+// when word timestamps were requested) has a start and end in seconds; segments
+// also carry the model's confidence. All text lives in one UTF-8 arena and is
+// addressed by offsets, so a transcript costs a handful of allocations however
+// long it is. Times are floats: millisecond precision for recordings of up to a
+// few hours.
+class TranscriptSegments {
+  public:
+    size_t size() const {
+        return m_start.size();
+    }
+    bool empty() const {
+        return m_start.empty();
+    }
+    size_t wordCount() const {
+        return m_wordStart.size();
+    }
+
+    void clear();
+    void reserve(size_t segments, size_t words, size_t textBytes);
+
+    void appendSegment(double start, double end, double avgLogProb, double noSpeechProb,
+                       std::string_view text);
+    void appendWord(double start, double end, std::string_view text);
+    // Appends other's segments and words with offsetSeconds added to their times
+    void append(const TranscriptSegments& other, double offsetSeconds = 0.0);
+
+    // Segment i
+    double start(size_t i) const {
+        return m_start[i];
+    }
+    double end(size_t i) const {
+        return m_end[i];
+    }
+    double avgLogProb(size_t i) const {
+        return m_avgLogProb[i];
+    }
+    double noSpeechProb(size_t i) const {
+        return m_noSpeechProb[i];
+    }
+    std::string_view text(size_t i) const {
+        return textAt(m_textRanges[i]);
+    }
+
+    // Word i
+    double wordStart(size_t i) const {
+        return m_wordStart[i];
+    }
+    double wordEnd(size_t i) const {
+        return m_wordEnd[i];
+    }
+    std::string_view wordText(size_t i) const {
+        return textAt(m_wordTextRanges[i]);
+    }
+
+    // Index of the segment playing at the given time (the last one starting at or
+    // before it), or size() if there is none
+    size_t segmentAt(double seconds) const;
+
+    // Rewrites every start and end time, e.g. onto the untrimmed recording
+    template <typename Map> void mapTimes(Map&& map) {
+        for (std::vector<float>* times : {&m_start, &m_end, &m_wordStart, &m_wordEnd}) {
+            for (float& time : *times) {
+                time = static_cast<float>(map(static_cast<double>(time)));
+            }
+        }
+    }
+
+    // Heap bytes in use, for keeping an eye on per-transcript memory
+    size_t memoryBytes() const;
+
+  private:
+    struct TextRange {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    std::string_view textAt(TextRange range) const {
+        return std::string_view(m_text).substr(range.offset, range.length);
+    }
+    TextRange storeText(std::string_view text);
+
+    std::vector<float> m_start;
+    std::vector<float> m_end;
+    std::vector<float> m_avgLogProb;
+    std::vector<float> m_noSpeechProb;
+    std::vector<TextRange> m_textRanges;
+
+    std::vector<float> m_wordStart;
+    std::vector<float> m_wordEnd;
+    std::vector<TextRange> m_wordTextRanges;
+
+    std::string m_text; // Arena for segment and word text
+};
+
+#endif // TRANSCRIPTSEGMENTS_H
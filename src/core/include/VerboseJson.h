@@ -0,0 +1,25 @@
+#ifndef VERBOSEJSON_H
+#define VERBOSEJSON_H
+
+#include "TranscriptSegments.h"
+#include <string>
+#include <string_view>
+
+// The parts of a Whisper-style verbose_json transcription response we keep
+struct VerboseTranscript {
+    std::string text;
+    std::string language;
+    std::string task;
+    std::string requestId; // x_groq.id
+    double duration = -1.0; // Negative if absent
+    TranscriptSegments segments;
+};
+
+namespace VerboseJson {
+    // Reads the response in a single pass straight into out, without building a
+    // document tree; fields it doesn't use (tokens, seek, ...) are skipped.
+    // Returns false with error set on malformed JSON or when there is no "text".
+    bool parse(std::string_view json, VerboseTranscript& out, std::string& error);
+} // namespace VerboseJson
+
+#endif // VERBOSEJSON_H
@@ -0,0 +1,58 @@
+#ifndef VOICEACTIVITYDETECTOR_H
+#define VOICEACTIVITYDETECTOR_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Frame-by-frame speech/silence classifier for mono float audio.
+//
+// Each frame is scored on three features: energy against an adaptive noise
+// floor, zero-crossing rate and spectral flatness over the speech band. Voiced
+// speech is loud and tonal (low flatness); unvoiced fricatives are noise-like
+// but loud with a high crossing rate; background noise is neither. Energy,
+// crossings and the log-spectrum sum use the SimdKernels primitives.
+class VoiceActivityDetector {
+  public:
+    struct Features {
+        float energyDb = 0.0f;         // mean power, dBFS
+        float zeroCrossingRate = 0.0f; // crossings per sample
+        float spectralFlatness = 0.0f; // 0 = pure tone, ~0.56 = white noise
+        float noiseFloorDb = 0.0f;
+    };
+
+    explicit VoiceActivityDetector(int sampleRate, int frameMs = 20);
+
+    size_t frameSize() const {
+        return m_frameSize;
+    }
+
+    // Classifies exactly frameSize() samples and updates the noise floor.
+    bool isSpeech(const float* frame);
+
+    const Features& lastFeatures() const {
+        return m_features;
+    }
+
+    void reset();
+
+  private:
+    float spectralFlatness(const float* frame);
+
+    int m_sampleRate;
+    size_t m_frameSize;
+    size_t m_fftSize;
+    size_t m_firstBin;
+    size_t m_lastBin;
+    float m_noiseFloorDb;
+    bool m_noiseFloorValid;
+    Features m_features;
+
+    std::vector<float> m_window;
+    std::vector<std::complex<float>> m_twiddles;
+    std::vector<size_t> m_bitReverse;
+    std::vector<std::complex<float>> m_spectrum;
+    std::vector<float> m_power;
+};
+
+#endif // VOICEACTIVITYDETECTOR_H
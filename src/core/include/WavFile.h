@@ -0,0 +1,44 @@
+#ifndef WAVFILE_H
+#define WAVFILE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Minimal RIFF/WAVE helpers for the canonical 44-byte header the app writes
+// and for locating the sample data in files it reads back.
+namespace WavFile {
+    constexpr size_t kHeaderSize = 44;
+    // Header with room for an RF64 "ds64" chunk (EBU Tech 3306), see rf64Header()
+    constexpr size_t kRf64HeaderSize = 80;
+    // Most sample data a plain RIFF header can describe
+    constexpr uint64_t kMaxRiffDataSize = 0xFFFFFFFFULL - 36;
+    constexpr uint16_t kFormatPcm = 1;
+    constexpr uint16_t kFormatIeeeFloat = 3;
+    // Size placeholder for data whose length is unknown while it is being streamed
+    constexpr uint32_t kUnknownSize = 0xFFFFFFFF;
+
+    struct Format {
+        uint16_t audioFormat = kFormatPcm;
+        uint16_t channels = 1;
+        uint32_t sampleRate = 16000;
+        uint16_t bitsPerSample = 16;
+    };
+
+    // Little-endian header for dataSize bytes of samples (or kUnknownSize)
+    std::array<char, kHeaderSize> header(const Format& format, uint32_t dataSize);
+
+    // Header for data that may outgrow 4 GiB. While it fits, this is an ordinary WAV
+    // file whose reserved space is a "JUNK" chunk; beyond that it becomes "RF64" and
+    // the real sizes move to the "ds64" chunk. Either way it is kRf64HeaderSize bytes,
+    // so it can be rewritten in place as the recording grows.
+    std::array<char, kRf64HeaderSize> rf64Header(const Format& format, uint64_t dataSize);
+
+    // Walks the chunk list for "fmt " and "data" (taking 64-bit sizes from "ds64" in RF64
+    // files). Returns false if this isn't a WAV file; dataSize is clamped to what is
+    // actually present (e.g. unpatched headers).
+    bool parse(const char* bytes, size_t size, Format& format, size_t& dataOffset,
+               size_t& dataSize);
+} // namespace WavFile
+
+#endif // WAVFILE_H
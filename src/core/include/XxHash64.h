@@ -0,0 +1,27 @@
+#ifndef XXHASH64_H
+#define XXHASH64_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Streaming XXH64, a fast non-cryptographic 64-bit hash (same output as the
+// reference xxHash implementation). Used to identify audio payloads, not for
+// anything security relevant.
+class XxHash64 {
+  public:
+    explicit XxHash64(uint64_t seed = 0);
+
+    void update(const void* data, size_t size);
+    uint64_t digest() const;
+
+    static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+  private:
+    uint64_t m_seed;
+    uint64_t m_lanes[4];
+    unsigned char m_buffer[32];
+    size_t m_buffered;
+    uint64_t m_totalLength;
+};
+
+#endif // XXHASH64_H
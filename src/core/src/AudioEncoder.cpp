@@ -0,0 +1,95 @@
+#include "AudioEncoder.h"
+#include <cstring>
+
+#if defined(VIBECO_HAVE_FLAC)
+#include "FlacEncoder.h"
+#endif
+#if defined(VIBECO_HAVE_OPUS)
+#include "OggOpusEncoder.h"
+#endif
+
+std::unique_ptr<AudioEncoder> AudioEncoder::create(Format format) {
+    switch (format) {
+    case Format::Flac:
+#if defined(VIBECO_HAVE_FLAC)
+        return std::make_unique<FlacEncoder>();
+#else
+        return nullptr;
+#endif
+    case Format::Opus:
+#if defined(VIBECO_HAVE_OPUS)
+        return std::make_unique<OggOpusEncoder>();
+#else
+        return nullptr;
+#endif
+    case Format::Wav:
+        break;
+    }
+    return nullptr;
+}
+
+bool AudioEncoder::isAvailable(Format format) {
+    switch (format) {
+    case Format::Wav:
+        return true;
+    case Format::Flac:
+#if defined(VIBECO_HAVE_FLAC)
+        return true;
+#else
+        return false;
+#endif
+    case Format::Opus:
+#if defined(VIBECO_HAVE_OPUS)
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+const char* AudioEncoder::formatName(Format format) {
+    switch (format) {
+    case Format::Flac:
+        return "flac";
+    case Format::Opus:
+        return "opus";
+    case Format::Wav:
+        break;
+    }
+    return "wav";
+}
+
+AudioEncoder::Format AudioEncoder::formatFromName(const char* name) {
+    if (name && std::strcmp(name, "flac") == 0) {
+        return Format::Flac;
+    }
+    if (name && std::strcmp(name, "opus") == 0) {
+        return Format::Opus;
+    }
+    return Format::Wav;
+}
+
+const char* AudioEncoder::fileExtension(Format format) {
+    switch (format) {
+    case Format::Flac:
+        return "flac";
+    case Format::Opus:
+        return "ogg";
+    case Format::Wav:
+        break;
+    }
+    return "wav";
+}
+
+const char* AudioEncoder::contentType(Format format) {
+    switch (format) {
+    case Format::Flac:
+        return "audio/flac";
+    case Format::Opus:
+        return "audio/ogg";
+    case Format::Wav:
+        break;
+    }
+    return "audio/wav";
+}
@@ -0,0 +1,80 @@
+#include "AudioSegmenter.h"
+#include "VoiceActivityDetector.h"
+#include <algorithm>
+
+namespace AudioSegmenter {
+    std::vector<Segment> plan(const int16_t* samples, size_t count, int sampleRate,
+                              double maxSeconds) {
+        VoiceActivityDetector detector(sampleRate);
+        const size_t frameSize = detector.frameSize();
+        const size_t frameCount = count / frameSize;
+        const size_t maxFrames = std::max<size_t>(
+            2, static_cast<size_t>(maxSeconds * sampleRate) / frameSize);
+        const size_t minFrames = maxFrames / 2;
+
+        if (frameCount <= maxFrames) {
+            return {{0, count}};
+        }
+
+        // Classify every frame once up front
+        std::vector<bool> speech(frameCount);
+        std::vector<float> energy(frameCount);
+        std::vector<float> frame(frameSize);
+        for (size_t f = 0; f < frameCount; ++f) {
+            const int16_t* in = samples + f * frameSize;
+            for (size_t i = 0; i < frameSize; ++i) {
+                frame[i] = in[i] / 32768.0f;
+            }
+            speech[f] = detector.isSpeech(frame.data());
+            energy[f] = detector.lastFeatures().energyDb;
+        }
+
+        // Cut points in frames: in the window [start + min, start + max], the middle of
+        // the longest silent run, or the quietest frame if the speaker never paused
+        std::vector<size_t> cuts = {0};
+        size_t start = 0;
+        while (frameCount - start > maxFrames) {
+            const size_t windowBegin = start + minFrames;
+            const size_t windowEnd = start + maxFrames;
+
+            size_t bestRunStart = 0;
+            size_t bestRunLength = 0;
+            size_t quietest = windowBegin;
+            size_t runStart = windowBegin;
+            for (size_t f = windowBegin; f < windowEnd; ++f) {
+                if (energy[f] < energy[quietest]) {
+                    quietest = f;
+                }
+                if (speech[f]) {
+                    runStart = f + 1;
+                } else if (f + 1 - runStart > bestRunLength) {
+                    bestRunStart = runStart;
+                    bestRunLength = f + 1 - runStart;
+                }
+            }
+
+            const size_t cut = bestRunLength > 0 ? bestRunStart + bestRunLength / 2 : quietest;
+            cuts.push_back(cut);
+            start = cut;
+        }
+
+        std::vector<Segment> segments;
+        for (size_t i = 0; i < cuts.size(); ++i) {
+            const size_t first = cuts[i];
+            const size_t last = i + 1 < cuts.size() ? cuts[i + 1] : frameCount;
+            if (!std::any_of(speech.begin() + first, speech.begin() + last,
+                             [](bool s) { return s; })) {
+                continue;
+            }
+            const size_t sampleStart = first * frameSize;
+            // The final segment also takes the partial frame at the end
+            const size_t sampleEnd = i + 1 < cuts.size() ? last * frameSize : count;
+            segments.push_back({sampleStart, sampleEnd - sampleStart});
+        }
+
+        if (segments.empty()) {
+            return {{0, count}};
+        }
+        return segments;
+    }
+} // namespace AudioSegmenter
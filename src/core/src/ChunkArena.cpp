@@ -0,0 +1,53 @@
+#include "ChunkArena.h"
+#include <algorithm>
+#include <cstring>
+
+ChunkArena::ChunkArena(size_t chunkSize)
+    : m_chunkSize(std::max<size_t>(chunkSize, 1)), m_size(0) {}
+
+void ChunkArena::append(const void* data, size_t size) {
+    const auto* in = static_cast<const char*>(data);
+    while (size > 0) {
+        const size_t used = m_size % m_chunkSize;
+        if (used == 0 && m_size / m_chunkSize == m_chunks.size()) {
+            m_chunks.emplace_back(new char[m_chunkSize]);
+        }
+
+        const size_t take = std::min(size, m_chunkSize - used);
+        std::memcpy(m_chunks[m_size / m_chunkSize].get() + used, in, take);
+        m_size += take;
+        in += take;
+        size -= take;
+    }
+}
+
+void ChunkArena::clear() {
+    m_chunks.clear();
+    m_size = 0;
+}
+
+const char* ChunkArena::peek(size_t offset, size_t& available) const {
+    if (offset >= m_size) {
+        available = 0;
+        return nullptr;
+    }
+    const size_t within = offset % m_chunkSize;
+    available = std::min(m_chunkSize - within, m_size - offset);
+    return m_chunks[offset / m_chunkSize].get() + within;
+}
+
+size_t ChunkArena::read(size_t offset, void* out, size_t size) const {
+    auto* dest = static_cast<char*>(out);
+    size_t copied = 0;
+    while (copied < size) {
+        size_t available = 0;
+        const char* src = peek(offset + copied, available);
+        if (!src) {
+            break;
+        }
+        const size_t take = std::min(available, size - copied);
+        std::memcpy(dest + copied, src, take);
+        copied += take;
+    }
+    return copied;
+}
@@ -0,0 +1,88 @@
+#include "CpuFeatures.h"
+#include <cstdlib>
+#include <cstring>
+
+#if defined(VIBECO_ARCH_X86) && defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+    // Setting VIBECO_DISABLE_SIMD forces the scalar kernels, e.g. to compare output
+    bool simdDisabled() {
+        static const bool disabled = std::getenv("VIBECO_DISABLE_SIMD") != nullptr;
+        return disabled;
+    }
+
+#if defined(VIBECO_ARCH_X86) && defined(_MSC_VER) && !defined(__clang__)
+    bool detectAvx2() {
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7) {
+            return false;
+        }
+        __cpuid(info, 1);
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+            return false;
+        }
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#endif
+} // namespace
+
+namespace CpuFeatures {
+    bool hasSse2() {
+#if defined(VIBECO_ARCH_X86)
+        if (simdDisabled()) {
+            return false;
+        }
+#if defined(_MSC_VER) && !defined(__clang__)
+        return true; // Every x64 CPU has SSE2
+#else
+        static const bool supported = __builtin_cpu_supports("sse2");
+        return supported;
+#endif
+#else
+        return false;
+#endif
+    }
+
+    bool hasAvx2() {
+#if defined(VIBECO_ARCH_X86)
+        if (simdDisabled()) {
+            return false;
+        }
+#if defined(_MSC_VER) && !defined(__clang__)
+        static const bool supported = detectAvx2();
+#else
+        static const bool supported = __builtin_cpu_supports("avx2");
+#endif
+        return supported;
+#else
+        return false;
+#endif
+    }
+
+    bool hasNeon() {
+#if defined(VIBECO_ARCH_NEON)
+        return !simdDisabled();
+#else
+        return false;
+#endif
+    }
+
+    const char* simdLevelName() {
+        if (hasAvx2()) {
+            return "AVX2";
+        }
+        if (hasSse2()) {
+            return "SSE2";
+        }
+        if (hasNeon()) {
+            return "NEON";
+        }
+        return "scalar";
+    }
+} // namespace CpuFeatures
@@ -0,0 +1,55 @@
+#include "FlacEncoder.h"
+#include <FLAC/stream_encoder.h>
+
+namespace {
+    // libFLAC's default trade-off; higher levels buy little on speech
+    constexpr unsigned kCompressionLevel = 5;
+
+    FLAC__StreamEncoderWriteStatus writeCallback(const FLAC__StreamEncoder* /*encoder*/,
+                                                 const FLAC__byte buffer[], size_t bytes,
+                                                 uint32_t /*samples*/, uint32_t /*frame*/,
+                                                 void* clientData) {
+        auto* sink = static_cast<AudioEncoder::Sink*>(clientData);
+        (*sink)(buffer, bytes);
+        return FLAC__STREAM_ENCODER_WRITE_STATUS_OK;
+    }
+} // namespace
+
+FlacEncoder::FlacEncoder() : m_encoder(FLAC__stream_encoder_new()), m_channels(1) {
+}
+
+FlacEncoder::~FlacEncoder() {
+    if (m_encoder) {
+        FLAC__stream_encoder_delete(m_encoder);
+    }
+}
+
+bool FlacEncoder::begin(int sampleRate, int channels, Sink sink) {
+    if (!m_encoder) {
+        return false;
+    }
+
+    m_sink = std::move(sink);
+    m_channels = channels;
+
+    FLAC__stream_encoder_set_channels(m_encoder, static_cast<uint32_t>(channels));
+    FLAC__stream_encoder_set_bits_per_sample(m_encoder, 16);
+    FLAC__stream_encoder_set_sample_rate(m_encoder, static_cast<uint32_t>(sampleRate));
+    FLAC__stream_encoder_set_compression_level(m_encoder, kCompressionLevel);
+    FLAC__stream_encoder_set_streamable_subset(m_encoder, true);
+
+    // No seek callback: STREAMINFO keeps a zero length instead of being patched at the end
+    return FLAC__stream_encoder_init_stream(m_encoder, writeCallback, nullptr, nullptr, nullptr,
+                                            &m_sink) == FLAC__STREAM_ENCODER_INIT_STATUS_OK;
+}
+
+bool FlacEncoder::encode(const int16_t* samples, size_t frames) {
+    const size_t count = frames * static_cast<size_t>(m_channels);
+    m_widened.assign(samples, samples + count);
+    return FLAC__stream_encoder_process_interleaved(m_encoder, m_widened.data(),
+                                                    static_cast<uint32_t>(frames));
+}
+
+bool FlacEncoder::finish() {
+    return FLAC__stream_encoder_finish(m_encoder);
+}
@@ -0,0 +1,279 @@
+#include "HistoryLog.h"
+#include "XxHash64.h"
+#include <cstring>
+#include <filesystem>
+
+namespace {
+    constexpr char kMagic[8] = {'V', 'B', 'H', 'I', 'S', 'T', '0', '1'};
+    constexpr uint64_t kHeaderBytes = sizeof(kMagic);
+    constexpr uint64_t kRecordHeaderBytes = 8; // Length and checksum, little endian
+    // Refuse absurd lengths from a damaged header instead of allocating them
+    constexpr uint32_t kMaxRecordBytes = 64 * 1024 * 1024;
+
+    uint32_t checksum(const char* data, size_t size) {
+        return static_cast<uint32_t>(XxHash64::hash(data, size));
+    }
+
+    void putLe32(unsigned char* out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    uint32_t getLe32(const unsigned char* in) {
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            value |= static_cast<uint32_t>(in[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    void putLe64(unsigned char* out, uint64_t value) {
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+    }
+
+    uint64_t getLe64(const unsigned char* in) {
+        uint64_t value = 0;
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    bool seek(std::FILE* file, uint64_t offset) {
+        // fseeko would be needed for logs past 2 GiB on 32-bit longs; history stays far below
+        return std::fseek(file, static_cast<long>(offset), SEEK_SET) == 0;
+    }
+
+    std::FILE* openReadWrite(const std::string& path) {
+        std::FILE* file = std::fopen(path.c_str(), "r+b");
+        return file ? file : std::fopen(path.c_str(), "w+b");
+    }
+
+    uint64_t fileSize(const std::string& path) {
+        std::error_code error;
+        const auto size = std::filesystem::file_size(path, error);
+        return error ? 0 : static_cast<uint64_t>(size);
+    }
+
+    void truncate(const std::string& path, uint64_t size) {
+        std::error_code error;
+        std::filesystem::resize_file(path, size, error);
+    }
+} // namespace
+
+HistoryLog::~HistoryLog() {
+    close();
+}
+
+bool HistoryLog::open(const std::string& path, Mode mode) {
+    close();
+    m_path = path;
+    m_mode = mode;
+    if (mode == Mode::ReadOnly) {
+        m_log = std::fopen(path.c_str(), "rb");
+        if (m_log) {
+            // A buffered read can survive a seek, and would show bytes the writer has
+            // since replaced (an append in progress that was retried)
+            std::setvbuf(m_log, nullptr, _IONBF, 0);
+        }
+        // Without an index every record is found by scanning the log
+        m_index = std::fopen((path + ".idx").c_str(), "rb");
+    } else {
+        m_log = openReadWrite(path);
+        m_index = openReadWrite(path + ".idx");
+    }
+    if (!m_log || (!m_index && mode == Mode::ReadWrite)) {
+        close();
+        return false;
+    }
+
+    uint64_t logSize = fileSize(path);
+    unsigned char header[kHeaderBytes];
+    if (logSize < kHeaderBytes || !seek(m_log, 0) ||
+        std::fread(header, 1, kHeaderBytes, m_log) != kHeaderBytes ||
+        std::memcmp(header, kMagic, kHeaderBytes) != 0) {
+        if (logSize >= kHeaderBytes || mode == Mode::ReadOnly) {
+            // Not ours (don't write over it), or not written yet
+            close();
+            return false;
+        }
+        // New (or torn before the header was complete)
+        truncate(path, 0);
+        seek(m_log, 0);
+        std::fwrite(kMagic, 1, kHeaderBytes, m_log);
+        std::fflush(m_log);
+        logSize = kHeaderBytes;
+        truncate(path + ".idx", 0);
+    }
+
+    // Trust the index if it is ordered and its last record is intact; checking every
+    // record would read the whole history at startup
+    const uint64_t indexSize = m_index ? fileSize(path + ".idx") : 0;
+    std::vector<unsigned char> index(static_cast<size_t>(indexSize / 8 * 8));
+    size_t indexBytes = 0;
+    if (m_index && seek(m_index, 0)) {
+        indexBytes = std::fread(index.data(), 1, index.size(), m_index);
+    }
+    m_offsets.clear();
+    uint64_t previous = 0;
+    for (size_t i = 0; i + 8 <= indexBytes; i += 8) {
+        const uint64_t offset = getLe64(&index[i]);
+        if (offset < kHeaderBytes || offset <= previous) {
+            // Index unusable: rebuild it from the log
+            m_offsets.clear();
+            break;
+        }
+        m_offsets.push_back(offset);
+        previous = offset;
+    }
+    // Entries for a torn or damaged tail go; an earlier damaged record must not
+    // cost the intact ones after it, as a rebuild from the start would
+    m_end = kHeaderBytes;
+    while (!m_offsets.empty() && !validRecordAt(m_offsets.back(), logSize, m_end)) {
+        m_offsets.pop_back();
+    }
+    bool indexChanged = m_offsets.size() * 8 != indexSize;
+
+    // Then pick up records written after the index was last updated
+    const size_t indexed = m_offsets.size();
+    scanForward(logSize);
+    indexChanged = indexChanged || m_offsets.size() != indexed;
+    if (mode == Mode::ReadOnly) {
+        // A short tail here may just be an append in progress
+        return true;
+    }
+    if (m_end < logSize) {
+        // A torn or damaged tail; everything from here on is lost
+        truncate(path, m_end);
+    }
+    if (indexChanged && !rewriteIndex()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void HistoryLog::scanForward(uint64_t logSize) {
+    uint64_t next = 0;
+    while (validRecordAt(m_end, logSize, next)) {
+        m_offsets.push_back(m_end);
+        m_end = next;
+    }
+}
+
+size_t HistoryLog::refresh() {
+    if (m_log) {
+        // Any appends made through this object are already indexed
+        scanForward(fileSize(m_path));
+    }
+    return m_offsets.size();
+}
+
+void HistoryLog::close() {
+    if (m_log) {
+        std::fclose(m_log);
+        m_log = nullptr;
+    }
+    if (m_index) {
+        std::fclose(m_index);
+        m_index = nullptr;
+    }
+    m_offsets.clear();
+    m_end = 0;
+}
+
+bool HistoryLog::readHeader(uint64_t offset, uint32_t& length, uint32_t& checksum) {
+    unsigned char header[kRecordHeaderBytes];
+    if (!seek(m_log, offset) || std::fread(header, 1, sizeof(header), m_log) != sizeof(header)) {
+        return false;
+    }
+    length = getLe32(header);
+    checksum = getLe32(header + 4);
+    return length <= kMaxRecordBytes;
+}
+
+bool HistoryLog::validRecordAt(uint64_t offset, uint64_t fileSize, uint64_t& next) {
+    uint32_t length = 0;
+    uint32_t expected = 0;
+    if (offset + kRecordHeaderBytes > fileSize || !readHeader(offset, length, expected) ||
+        offset + kRecordHeaderBytes + length > fileSize) {
+        return false;
+    }
+    m_scratch.resize(length);
+    if (std::fread(m_scratch.data(), 1, length, m_log) != length ||
+        checksum(m_scratch.data(), length) != expected) {
+        return false;
+    }
+    next = offset + kRecordHeaderBytes + length;
+    return true;
+}
+
+bool HistoryLog::rewriteIndex() {
+    std::fclose(m_index);
+    m_index = std::fopen((m_path + ".idx").c_str(), "w+b");
+    if (!m_index) {
+        return false;
+    }
+    std::vector<unsigned char> index(m_offsets.size() * 8);
+    for (size_t i = 0; i < m_offsets.size(); ++i) {
+        putLe64(&index[i * 8], m_offsets[i]);
+    }
+    return (index.empty() ||
+            std::fwrite(index.data(), 1, index.size(), m_index) == index.size()) &&
+           std::fflush(m_index) == 0;
+}
+
+bool HistoryLog::append(std::string_view payload) {
+    if (!m_log || m_mode == Mode::ReadOnly || payload.size() > kMaxRecordBytes) {
+        return false;
+    }
+
+    unsigned char header[kRecordHeaderBytes];
+    putLe32(header, static_cast<uint32_t>(payload.size()));
+    putLe32(header + 4, checksum(payload.data(), payload.size()));
+    if (!seek(m_log, m_end) || std::fwrite(header, 1, sizeof(header), m_log) != sizeof(header) ||
+        std::fwrite(payload.data(), 1, payload.size(), m_log) != payload.size() ||
+        std::fflush(m_log) != 0) {
+        // Leave m_end alone; the partial record is overwritten (or cut off on open)
+        return false;
+    }
+
+    // The record is safe now; an index entry lost here is recovered on open
+    unsigned char entry[8];
+    putLe64(entry, m_end);
+    if (std::fseek(m_index, 0, SEEK_END) == 0) {
+        std::fwrite(entry, 1, sizeof(entry), m_index);
+        std::fflush(m_index);
+    }
+    m_offsets.push_back(m_end);
+    m_end += kRecordHeaderBytes + payload.size();
+    return true;
+}
+
+bool HistoryLog::read(size_t index, std::string& payload) {
+    if (!m_log || index >= m_offsets.size()) {
+        return false;
+    }
+    uint32_t length = 0;
+    uint32_t expected = 0;
+    if (!readHeader(m_offsets[index], length, expected)) {
+        return false;
+    }
+    payload.resize(length);
+    return std::fread(payload.data(), 1, length, m_log) == length &&
+           checksum(payload.data(), length) == expected;
+}
+
+bool HistoryLog::clear() {
+    if (!m_log || m_mode == Mode::ReadOnly) {
+        return false;
+    }
+    const std::string path = m_path;
+    close();
+    truncate(path, 0);
+    truncate(path + ".idx", 0);
+    return open(path);
+}
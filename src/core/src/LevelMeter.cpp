@@ -0,0 +1,82 @@
+#include "LevelMeter.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+
+LevelMeter::LevelMeter(int sampleRate, double columnSeconds) : m_columnSeconds(columnSeconds) {
+    setSampleRate(sampleRate);
+}
+
+void LevelMeter::setSampleRate(int sampleRate) {
+    m_columnSamples = std::max<size_t>(1, static_cast<size_t>(sampleRate * m_columnSeconds));
+    reset();
+}
+
+void LevelMeter::reset() {
+    m_pending = 0;
+    m_min = 0.0f;
+    m_max = 0.0f;
+    m_sumSquares = 0.0;
+    m_head = 0;
+    m_ringMin.fill(0.0f);
+    m_ringMax.fill(0.0f);
+    m_sequence = 0;
+    m_back = 0;
+    m_front = 1;
+    m_buffers.fill(Snapshot());
+    m_middle.store(2, std::memory_order_relaxed);
+}
+
+void LevelMeter::process(const float* samples, size_t count) {
+    while (count > 0) {
+        const size_t take = std::min(count, m_columnSamples - m_pending);
+        float lo;
+        float hi;
+        float sumSquares;
+        SimdKernels::minMaxSumSquares(samples, take, lo, hi, sumSquares);
+
+        m_min = m_pending == 0 ? lo : std::min(m_min, lo);
+        m_max = m_pending == 0 ? hi : std::max(m_max, hi);
+        m_sumSquares += sumSquares;
+        m_pending += take;
+        samples += take;
+        count -= take;
+
+        if (m_pending == m_columnSamples) {
+            finishColumn();
+        }
+    }
+}
+
+void LevelMeter::finishColumn() {
+    m_ringMin[m_head] = m_min;
+    m_ringMax[m_head] = m_max;
+    m_head = (m_head + 1) % kWaveformColumns;
+    ++m_sequence;
+
+    Snapshot& snapshot = m_buffers[m_back];
+    snapshot.peak = std::max(std::fabs(m_min), std::fabs(m_max));
+    snapshot.rms = static_cast<float>(std::sqrt(m_sumSquares / m_pending));
+    // Unroll the ring so readers get the columns in time order
+    const auto split = static_cast<std::ptrdiff_t>(m_head);
+    std::rotate_copy(m_ringMin.begin(), m_ringMin.begin() + split, m_ringMin.end(),
+                     snapshot.minimum.begin());
+    std::rotate_copy(m_ringMax.begin(), m_ringMax.begin() + split, m_ringMax.end(),
+                     snapshot.maximum.begin());
+    snapshot.sequence = m_sequence;
+
+    // Publish: the filled buffer becomes the middle one, the old middle our next back buffer
+    m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & ~kFresh;
+
+    m_pending = 0;
+    m_sumSquares = 0.0;
+}
+
+bool LevelMeter::read(Snapshot& out) {
+    if (!(m_middle.load(std::memory_order_relaxed) & kFresh)) {
+        return false;
+    }
+    m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & ~kFresh;
+    out = m_buffers[m_front];
+    return true;
+}
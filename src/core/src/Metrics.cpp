@@ -0,0 +1,143 @@
+#include "Metrics.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+    constexpr double kReportedQuantiles[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::string formatDouble(double value) {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%.6g", value);
+        return buffer;
+    }
+} // namespace
+
+namespace Metrics {
+    size_t Histogram::bucketFor(uint64_t micros) {
+        if (micros < kLinearBuckets) {
+            return static_cast<size_t>(micros);
+        }
+        // Top four bits pick the bucket: the leading one sets the power of two,
+        // the three below it the sub-bucket
+        const int msb = 63 - std::countl_zero(micros);
+        const uint64_t sub = (micros >> (msb - 3)) & (kSubBuckets - 1);
+        // Anything past the range lands in the last bucket
+        return std::min<size_t>(kLinearBuckets + (msb - 4) * kSubBuckets + sub, kBucketCount - 1);
+    }
+
+    double Histogram::bucketMidpointUs(size_t index) {
+        if (index < kLinearBuckets) {
+            return static_cast<double>(index);
+        }
+        const size_t k = index - kLinearBuckets;
+        const int shift = static_cast<int>(k / kSubBuckets) + 1;
+        const double lower = std::ldexp(static_cast<double>(kSubBuckets + k % kSubBuckets), shift);
+        return lower + std::ldexp(0.5, shift);
+    }
+
+    void Histogram::record(double milliseconds) {
+        const uint64_t micros =
+            milliseconds > 0.0 ? static_cast<uint64_t>(std::llround(milliseconds * 1000.0)) : 0;
+        m_buckets[bucketFor(micros)].fetch_add(1, std::memory_order_relaxed);
+        m_sumUs.fetch_add(micros, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    uint64_t Histogram::count() const {
+        return m_count.load(std::memory_order_relaxed);
+    }
+
+    double Histogram::sumMs() const {
+        return m_sumUs.load(std::memory_order_relaxed) / 1000.0;
+    }
+
+    double Histogram::quantileMs(double q) const {
+        // Counts may move while we read; summing the buckets keeps the walk self-consistent
+        uint64_t total = 0;
+        for (const auto& bucket : m_buckets) {
+            total += bucket.load(std::memory_order_relaxed);
+        }
+        if (total == 0) {
+            return 0.0;
+        }
+
+        const auto rank = std::max<uint64_t>(
+            1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * total)));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < kBucketCount; ++i) {
+            seen += m_buckets[i].load(std::memory_order_relaxed);
+            if (seen >= rank) {
+                return bucketMidpointUs(i) / 1000.0;
+            }
+        }
+        return bucketMidpointUs(kBucketCount - 1) / 1000.0;
+    }
+
+    Registry& Registry::instance() {
+        static Registry registry;
+        return registry;
+    }
+
+    Counter& Registry::counter(const std::string& name, const std::string& help,
+                               const std::string& labels) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CounterFamily& family = m_counters[name];
+        if (family.help.empty()) {
+            family.help = help;
+        }
+        std::unique_ptr<Counter>& series = family.series[labels];
+        if (!series) {
+            series = std::make_unique<Counter>();
+        }
+        return *series;
+    }
+
+    Histogram& Registry::histogram(const std::string& name, const std::string& help) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        HistogramFamily& family = m_histograms[name];
+        if (!family.histogram) {
+            family.help = help;
+            family.histogram = std::make_unique<Histogram>();
+        }
+        return *family.histogram;
+    }
+
+    std::string Registry::renderPrometheus() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::string out;
+
+        for (const auto& [name, family] : m_counters) {
+            out += "# HELP " + name + " " + family.help + "\n";
+            out += "# TYPE " + name + " counter\n";
+            for (const auto& [labels, counter] : family.series) {
+                out += name;
+                if (!labels.empty()) {
+                    out += "{" + labels + "}";
+                }
+                out += " " + std::to_string(counter->value()) + "\n";
+            }
+        }
+
+        for (const auto& [name, family] : m_histograms) {
+            const Histogram& histogram = *family.histogram;
+            out += "# HELP " + name + " " + family.help + "\n";
+            out += "# TYPE " + name + " summary\n";
+            for (double q : kReportedQuantiles) {
+                out += name + "{quantile=\"" + formatDouble(q) + "\"} " +
+                       formatDouble(histogram.quantileMs(q) / 1000.0) + "\n";
+            }
+            out += name + "_sum " + formatDouble(histogram.sumMs() / 1000.0) + "\n";
+            out += name + "_count " + std::to_string(histogram.count()) + "\n";
+        }
+        return out;
+    }
+
+    void countError(const std::string& type) {
+        Registry::instance()
+            .counter("vibeco_errors_total", "Failures, by where they happened",
+                     "type=\"" + type + "\"")
+            .add();
+    }
+} // namespace Metrics
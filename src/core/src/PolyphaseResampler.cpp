@@ -0,0 +1,137 @@
+#include "PolyphaseResampler.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace {
+    // Zero crossings of the sinc kept on each side of the centre, at the output rate.
+    constexpr double kZeroCrossings = 16.0;
+    // Pass band as a fraction of the lower Nyquist frequency; the rest is transition band.
+    constexpr double kRolloff = 0.9;
+    // Kaiser window shape; 8 gives roughly 80 dB stop-band attenuation.
+    constexpr double kKaiserBeta = 8.0;
+    // Tap counts are padded to a multiple of this so the vector loops have no scalar tail.
+    constexpr size_t kTapAlignment = 16;
+
+    constexpr double kPi = 3.14159265358979323846;
+
+    // Zeroth-order modified Bessel function of the first kind, by power series.
+    double besselI0(double x) {
+        double sum = 1.0;
+        double term = 1.0;
+        const double halfX = x / 2.0;
+        for (int k = 1; k < 50; ++k) {
+            term *= (halfX / k) * (halfX / k);
+            sum += term;
+            if (term < sum * 1e-12) {
+                break;
+            }
+        }
+        return sum;
+    }
+
+    double sinc(double x) {
+        if (std::abs(x) < 1e-9) {
+            return 1.0;
+        }
+        return std::sin(kPi * x) / (kPi * x);
+    }
+} // namespace
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate)
+    : m_inputRate(inputRate), m_outputRate(outputRate), m_position(0), m_phase(0),
+      m_inputCount(0), m_outputCount(0) {
+    const int divisor = std::gcd(inputRate, outputRate);
+    m_interpolation = static_cast<size_t>(outputRate / divisor);
+    m_decimation = static_cast<size_t>(inputRate / divisor);
+
+    // Filter length in input samples grows with the decimation ratio so the
+    // transition band stays the same width relative to the output rate.
+    const double ratio = std::max(1.0, static_cast<double>(m_decimation) / m_interpolation);
+    const size_t taps = static_cast<size_t>(std::ceil(2.0 * kZeroCrossings * ratio));
+    m_tapsPerPhase = (taps + kTapAlignment - 1) / kTapAlignment * kTapAlignment;
+    m_primeSamples = m_tapsPerPhase / 2 - 1;
+
+    const double cutoff = kRolloff / ratio;
+    const double halfWidth = m_tapsPerPhase / 2.0;
+    const double windowNorm = besselI0(kKaiserBeta);
+
+    m_coefficients.resize(m_interpolation * m_tapsPerPhase);
+    for (size_t phase = 0; phase < m_interpolation; ++phase) {
+        float* branch = m_coefficients.data() + phase * m_tapsPerPhase;
+        const double centre =
+            static_cast<double>(m_primeSamples) + static_cast<double>(phase) / m_interpolation;
+
+        double sum = 0.0;
+        for (size_t tap = 0; tap < m_tapsPerPhase; ++tap) {
+            const double x = static_cast<double>(tap) - centre;
+            const double r = x / halfWidth;
+            double value = 0.0;
+            if (std::abs(r) < 1.0) {
+                const double window = besselI0(kKaiserBeta * std::sqrt(1.0 - r * r)) / windowNorm;
+                value = cutoff * sinc(cutoff * x) * window;
+            }
+            branch[tap] = static_cast<float>(value);
+            sum += value;
+        }
+
+        // Unity gain at DC for every phase, otherwise the output picks up a ripple at L Hz
+        for (size_t tap = 0; tap < m_tapsPerPhase; ++tap) {
+            branch[tap] = static_cast<float>(branch[tap] / sum);
+        }
+    }
+
+    reset();
+}
+
+size_t PolyphaseResampler::process(const float* in, size_t count, std::vector<float>& out) {
+    m_history.insert(m_history.end(), in, in + count);
+    m_inputCount += count;
+    return produce(out, UINT64_MAX);
+}
+
+size_t PolyphaseResampler::flush(std::vector<float>& out) {
+    // Outputs that correspond to input we have actually seen: ceil(inputCount * L / M)
+    const uint64_t expected =
+        (m_inputCount * m_interpolation + m_decimation - 1) / m_decimation;
+
+    m_history.insert(m_history.end(), m_tapsPerPhase, 0.0f);
+    const size_t produced = produce(out, expected);
+    reset();
+    return produced;
+}
+
+void PolyphaseResampler::reset() {
+    // Leading zeros line the filter centre up with the first input sample,
+    // so the output is not delayed relative to the input.
+    m_history.assign(m_primeSamples, 0.0f);
+    m_history.reserve(m_primeSamples + 8192);
+    m_position = 0;
+    m_phase = 0;
+    m_inputCount = 0;
+    m_outputCount = 0;
+}
+
+size_t PolyphaseResampler::produce(std::vector<float>& out, uint64_t limit) {
+    const size_t start = out.size();
+    const size_t available = m_history.size();
+
+    while (m_position + m_tapsPerPhase <= available && m_outputCount < limit) {
+        out.push_back(SimdKernels::dotProduct(m_history.data() + m_position,
+                                              m_coefficients.data() + m_phase * m_tapsPerPhase,
+                                              m_tapsPerPhase));
+        ++m_outputCount;
+
+        m_phase += m_decimation;
+        m_position += m_phase / m_interpolation;
+        m_phase %= m_interpolation;
+    }
+
+    // Keep only the samples the next output still needs
+    const size_t consumed = std::min(m_position, available);
+    m_history.erase(m_history.begin(), m_history.begin() + consumed);
+    m_position -= consumed;
+
+    return out.size() - start;
+}
@@ -0,0 +1,473 @@
+#include "SearchIndex.h"
+#include "XxHash64.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+namespace {
+    // 02: words split at Unicode punctuation, CJK indexed by character
+    constexpr char kMagic[8] = {'V', 'B', 'S', 'I', 'D', 'X', '0', '2'};
+    // Longer words are indexed by their first kMaxWordBytes bytes
+    constexpr size_t kMaxWordBytes = 48;
+    // A one-letter prefix could otherwise expand to most of the vocabulary
+    constexpr size_t kMaxPrefixTerms = 256;
+    // BM25 parameters, the usual defaults
+    constexpr float kK1 = 1.2f;
+    constexpr float kB = 0.75f;
+
+    enum class CharKind {
+        Separator,
+        Letter,    // Part of a word that runs until the next separator
+        Ideograph, // A word on its own: these scripts don't put spaces between words
+    };
+
+    // The code point starting at text[i], and its length in bytes. A malformed
+    // sequence reads as its first byte alone, classified as a letter.
+    uint32_t decodeAt(std::string_view text, size_t i, size_t& length) {
+        const auto lead = static_cast<unsigned char>(text[i]);
+        length = 1;
+        size_t extra = 0;
+        uint32_t codePoint = lead;
+        if (lead >= 0xC2 && lead <= 0xDF) {
+            extra = 1;
+            codePoint = lead & 0x1F;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            extra = 2;
+            codePoint = lead & 0x0F;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            extra = 3;
+            codePoint = lead & 0x07;
+        } else {
+            return lead < 0x80 ? lead : 0xFFFD;
+        }
+        if (i + extra >= text.size()) {
+            return 0xFFFD;
+        }
+        for (size_t k = 1; k <= extra; ++k) {
+            const auto next = static_cast<unsigned char>(text[i + k]);
+            if ((next & 0xC0) != 0x80) {
+                return 0xFFFD;
+            }
+            codePoint = (codePoint << 6) | (next & 0x3F);
+        }
+        length = extra + 1;
+        return codePoint;
+    }
+
+    // Whitespace, punctuation and symbols separate words. Not the full Unicode
+    // tables: the blocks dictated text actually uses.
+    CharKind classify(uint32_t c) {
+        if (c < 0x80) {
+            const bool alnum =
+                (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+            return alnum ? CharKind::Letter : CharKind::Separator;
+        }
+        if (c < 0xC0) {
+            // Latin-1 punctuation and NBSP, but ª, µ and º are letters
+            return c == 0xAA || c == 0xB5 || c == 0xBA ? CharKind::Letter : CharKind::Separator;
+        }
+        const bool separator =
+            c == 0xD7 || c == 0xF7 || c == 0x30FB || c == 0xFEFF || // × ÷ ・ and the BOM
+            (c >= 0x2000 && c <= 0x206F && c != 0x200C && c != 0x200D) || // Spaces, dashes, quotes
+            (c >= 0x2190 && c <= 0x2BFF) ||                     // Arrows, maths, shapes
+            (c >= 0x2E00 && c <= 0x2E7F) ||                     // Supplemental punctuation
+            (c >= 0x3000 && c <= 0x3004) || (c >= 0x3008 && c <= 0x303F) || // CJK punctuation
+            (c >= 0xFE10 && c <= 0xFE1F) || (c >= 0xFE30 && c <= 0xFE6F) || // CJK forms
+            (c >= 0xFF01 && c <= 0xFF0F) || (c >= 0xFF1A && c <= 0xFF20) || // Fullwidth
+            (c >= 0xFF3B && c <= 0xFF40) || (c >= 0xFF5B && c <= 0xFF65) || // punctuation
+            (c >= 0x1F000 && c <= 0x1FAFF);                     // Emoji
+        if (separator) {
+            return CharKind::Separator;
+        }
+        const bool ideograph = (c >= 0x3040 && c <= 0x30FF) || // Kana
+                               (c >= 0x3400 && c <= 0x4DBF) || (c >= 0x4E00 && c <= 0x9FFF) ||
+                               (c >= 0xF900 && c <= 0xFAFF) || (c >= 0x20000 && c <= 0x2FFFF);
+        if (ideograph) {
+            return CharKind::Ideograph;
+        }
+        return CharKind::Letter;
+    }
+
+    char fold(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    // Calls f(word, offset, length) for each word of text, word lower-cased and truncated
+    template <typename F> void forEachWord(std::string_view text, F f) {
+        std::string word;
+        size_t i = 0;
+        size_t length = 0;
+        while (i < text.size()) {
+            const CharKind kind = classify(decodeAt(text, i, length));
+            if (kind == CharKind::Separator) {
+                i += length;
+                continue;
+            }
+            const size_t start = i;
+            word.clear();
+            bool full = false;
+            do {
+                // Truncate at a character boundary
+                full = full || word.size() + length > kMaxWordBytes;
+                for (size_t k = 0; k < length && !full; ++k) {
+                    word.push_back(fold(text[i + k]));
+                }
+                i += length;
+            } while (kind == CharKind::Letter && i < text.size() &&
+                     classify(decodeAt(text, i, length)) == CharKind::Letter);
+            f(word, start, i - start);
+        }
+    }
+
+    // Documents matching one query word, with how often it occurs in each
+    struct Matches {
+        std::vector<uint32_t> documents;
+        std::vector<uint32_t> counts;
+    };
+
+    void putVarint(std::string& out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<char>(value));
+    }
+
+    bool getVarint(std::string_view& in, uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+            const auto byte = static_cast<unsigned char>(in.front());
+            in.remove_prefix(1);
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80)) {
+                return true;
+            }
+        }
+        return false;
+    }
+} // namespace
+
+SearchIndex::Query SearchIndex::parse(std::string_view query) {
+    std::vector<std::string> words;
+    size_t wordsEnd = 0;
+    forEachWord(query, [&words, &wordsEnd](const std::string& word, size_t offset, size_t length) {
+        words.push_back(word);
+        wordsEnd = offset + length;
+    });
+
+    Query parsed;
+    // The word still being typed is matched as a prefix, and kept last
+    parsed.lastIsPrefix = !words.empty() && wordsEnd == query.size();
+    std::string prefix;
+    if (parsed.lastIsPrefix) {
+        prefix = std::move(words.back());
+        words.pop_back();
+    }
+    for (std::string& word : words) {
+        if (std::find(parsed.words.begin(), parsed.words.end(), word) == parsed.words.end()) {
+            parsed.words.push_back(std::move(word));
+        }
+    }
+    if (parsed.lastIsPrefix) {
+        parsed.words.push_back(std::move(prefix));
+    }
+    return parsed;
+}
+
+void SearchIndex::add(uint32_t document, std::string_view text) {
+    if (document < m_lengths.size()) {
+        return;
+    }
+    // Numbers skipped over belong to records that couldn't be read
+    m_lengths.resize(document + 1, 0);
+    m_removed.resize(document + 1, true);
+    m_removed[document] = false;
+
+    std::map<std::string, uint32_t, std::less<>> counts;
+    uint32_t length = 0;
+    forEachWord(text, [&counts, &length](const std::string& word, size_t, size_t) {
+        ++counts[word];
+        ++length;
+    });
+    for (const auto& [word, count] : counts) {
+        Postings& postings = m_terms[word];
+        postings.documents.push_back(document);
+        postings.counts.push_back(
+            static_cast<uint16_t>(std::min<uint32_t>(count, std::numeric_limits<uint16_t>::max())));
+    }
+
+    m_lengths[document] =
+        static_cast<uint16_t>(std::min<uint32_t>(length, std::numeric_limits<uint16_t>::max()));
+    m_totalLength += m_lengths[document];
+    ++m_liveCount;
+}
+
+void SearchIndex::remove(uint32_t document) {
+    if (document >= m_removed.size() || m_removed[document]) {
+        return;
+    }
+    m_removed[document] = true;
+    m_totalLength -= m_lengths[document];
+    --m_liveCount;
+}
+
+void SearchIndex::clear() {
+    m_terms.clear();
+    m_lengths.clear();
+    m_removed.clear();
+    m_totalLength = 0;
+    m_liveCount = 0;
+}
+
+std::vector<SearchIndex::Hit> SearchIndex::search(std::string_view query, size_t limit) const {
+    const Query parsed = parse(query);
+    if (parsed.words.empty() || m_liveCount == 0 || limit == 0) {
+        return {};
+    }
+
+    std::vector<Matches> words(parsed.words.size());
+    for (size_t w = 0; w < parsed.words.size(); ++w) {
+        const std::string& word = parsed.words[w];
+        Matches& matches = words[w];
+        if (w + 1 < parsed.words.size() || !parsed.lastIsPrefix) {
+            const auto it = m_terms.find(word);
+            if (it == m_terms.end()) {
+                return {};
+            }
+            matches.documents = it->second.documents;
+            matches.counts.assign(it->second.counts.begin(), it->second.counts.end());
+            continue;
+        }
+
+        // Gather the postings of every term the word is a prefix of, then sum per document
+        std::vector<std::pair<uint32_t, uint32_t>> gathered;
+        size_t expanded = 0;
+        for (auto it = m_terms.lower_bound(word);
+             it != m_terms.end() && it->first.compare(0, word.size(), word) == 0 &&
+             expanded < kMaxPrefixTerms;
+             ++it, ++expanded) {
+            const Postings& postings = it->second;
+            for (size_t i = 0; i < postings.documents.size(); ++i) {
+                gathered.emplace_back(postings.documents[i], postings.counts[i]);
+            }
+        }
+        if (expanded > 1) {
+            std::sort(gathered.begin(), gathered.end());
+        }
+        for (const auto& [document, count] : gathered) {
+            if (!matches.documents.empty() && matches.documents.back() == document) {
+                matches.counts.back() += count;
+            } else {
+                matches.documents.push_back(document);
+                matches.counts.push_back(count);
+            }
+        }
+        if (matches.documents.empty()) {
+            return {};
+        }
+    }
+
+    // Intersect starting from the rarest word, so each step only narrows a short list
+    std::vector<size_t> order(words.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&words](size_t a, size_t b) {
+        return words[a].documents.size() < words[b].documents.size();
+    });
+
+    const float averageLength =
+        std::max(1.0f, static_cast<float>(m_totalLength) / static_cast<float>(m_liveCount));
+    std::vector<float> idf(words.size());
+    for (size_t w = 0; w < words.size(); ++w) {
+        // Postings include removed documents; close enough for weighting
+        const float n =
+            static_cast<float>(std::min<size_t>(words[w].documents.size(), m_liveCount));
+        idf[w] = std::log(1.0f + (static_cast<float>(m_liveCount) - n + 0.5f) / (n + 0.5f));
+    }
+
+    std::vector<Hit> hits;
+    std::vector<size_t> cursor(words.size(), 0);
+    for (const uint32_t document : words[order[0]].documents) {
+        if (m_removed[document]) {
+            continue;
+        }
+        const float norm = kK1 * (1.0f - kB + kB * m_lengths[document] / averageLength);
+        float score = 0.0f;
+        bool all = true;
+        for (const size_t w : order) {
+            const std::vector<uint32_t>& documents = words[w].documents;
+            // Lists are sorted and walked in step, so each cursor only moves forward
+            size_t& at = cursor[w];
+            at = static_cast<size_t>(
+                std::lower_bound(documents.begin() + static_cast<std::ptrdiff_t>(at),
+                                 documents.end(), document) -
+                documents.begin());
+            if (at == documents.size() || documents[at] != document) {
+                all = false;
+                break;
+            }
+            const float count = static_cast<float>(words[w].counts[at]);
+            score += idf[w] * count * (kK1 + 1.0f) / (count + norm);
+        }
+        if (all) {
+            hits.push_back({document, score});
+        }
+    }
+
+    const auto better = [](const Hit& a, const Hit& b) {
+        return a.score != b.score ? a.score > b.score : a.document > b.document;
+    };
+    if (hits.size() > limit) {
+        std::partial_sort(hits.begin(), hits.begin() + static_cast<std::ptrdiff_t>(limit),
+                          hits.end(), better);
+        hits.resize(limit);
+    } else {
+        std::sort(hits.begin(), hits.end(), better);
+    }
+    return hits;
+}
+
+std::vector<SearchIndex::Range> SearchIndex::highlights(std::string_view text,
+                                                        std::string_view query) {
+    const Query parsed = parse(query);
+    std::vector<Range> ranges;
+    forEachWord(text, [&parsed, &ranges](const std::string& word, size_t offset, size_t length) {
+        for (size_t w = 0; w < parsed.words.size(); ++w) {
+            const std::string& queried = parsed.words[w];
+            const bool prefix = parsed.lastIsPrefix && w + 1 == parsed.words.size();
+            if (prefix ? word.compare(0, queried.size(), queried) == 0 : word == queried) {
+                ranges.push_back({static_cast<uint32_t>(offset), static_cast<uint32_t>(length)});
+                break;
+            }
+        }
+    });
+    return ranges;
+}
+
+bool SearchIndex::save(const std::string& path) const {
+    // Lengths, then each term with its documents as deltas, then a checksum of it all
+    std::string data(kMagic, sizeof(kMagic));
+    putVarint(data, m_lengths.size());
+    for (const uint16_t length : m_lengths) {
+        putVarint(data, length);
+    }
+    putVarint(data, m_terms.size());
+    for (const auto& [term, postings] : m_terms) {
+        putVarint(data, term.size());
+        data.append(term);
+        putVarint(data, postings.documents.size());
+        uint32_t previous = 0;
+        for (size_t i = 0; i < postings.documents.size(); ++i) {
+            putVarint(data, postings.documents[i] - previous);
+            putVarint(data, postings.counts[i]);
+            previous = postings.documents[i];
+        }
+    }
+    const uint64_t checksum = XxHash64::hash(data.data(), data.size());
+    for (int i = 0; i < 8; ++i) {
+        data.push_back(static_cast<char>(checksum >> (8 * i)));
+    }
+
+    // Replace the old file only once the new one is complete
+    const std::string temporary = path + ".tmp";
+    std::FILE* file = std::fopen(temporary.c_str(), "wb");
+    if (!file) {
+        return false;
+    }
+    const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (std::fclose(file) != 0 || !written) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    return !error;
+}
+
+bool SearchIndex::load(const std::string& path) {
+    clear();
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        return false;
+    }
+    std::string data;
+    char buffer[1 << 16];
+    size_t read = 0;
+    while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        data.append(buffer, read);
+    }
+    std::fclose(file);
+
+    if (data.size() < sizeof(kMagic) + 8 || std::memcmp(data.data(), kMagic, sizeof(kMagic)) != 0) {
+        return false;
+    }
+    uint64_t stored = 0;
+    for (int i = 0; i < 8; ++i) {
+        stored |= static_cast<uint64_t>(static_cast<unsigned char>(data[data.size() - 8 + i]))
+                  << (8 * i);
+    }
+    if (XxHash64::hash(data.data(), data.size() - 8) != stored) {
+        return false;
+    }
+
+    std::string_view in(data.data() + sizeof(kMagic), data.size() - sizeof(kMagic) - 8);
+    const auto fail = [this]() {
+        clear();
+        return false;
+    };
+    uint64_t documents = 0;
+    if (!getVarint(in, documents) || documents > std::numeric_limits<uint32_t>::max() ||
+        documents > in.size()) {
+        return fail();
+    }
+    m_lengths.resize(documents);
+    for (uint16_t& length : m_lengths) {
+        uint64_t value = 0;
+        if (!getVarint(in, value)) {
+            return fail();
+        }
+        length = static_cast<uint16_t>(value);
+        m_totalLength += length;
+    }
+    // Every document counts as present until the caller says otherwise
+    m_removed.assign(documents, false);
+    m_liveCount = static_cast<uint32_t>(documents);
+
+    uint64_t terms = 0;
+    if (!getVarint(in, terms)) {
+        return fail();
+    }
+    for (uint64_t t = 0; t < terms; ++t) {
+        uint64_t size = 0;
+        uint64_t count = 0;
+        if (!getVarint(in, size) || size > in.size()) {
+            return fail();
+        }
+        Postings& postings = m_terms[std::string(in.substr(0, size))];
+        in.remove_prefix(size);
+        if (!getVarint(in, count) || count > in.size()) {
+            return fail();
+        }
+        postings.documents.reserve(count);
+        postings.counts.reserve(count);
+        uint64_t document = 0;
+        for (uint64_t i = 0; i < count; ++i) {
+            uint64_t delta = 0;
+            uint64_t occurrences = 0;
+            if (!getVarint(in, delta) || !getVarint(in, occurrences)) {
+                return fail();
+            }
+            document += delta;
+            if (document >= documents) {
+                return fail();
+            }
+            postings.documents.push_back(static_cast<uint32_t>(document));
+            postings.counts.push_back(static_cast<uint16_t>(occurrences));
+        }
+    }
+    return in.empty() || fail();
+}
@@ -0,0 +1,154 @@
+#include "SilenceTrimmer.h"
+#include <algorithm>
+
+namespace {
+    // Audio kept on each side of speech so onsets and word tails aren't clipped
+    constexpr size_t kPadMs = 200;
+    // Pauses up to this long are left alone; longer ones shrink to two paddings
+    constexpr size_t kMaxPauseMs = 800;
+} // namespace
+
+double SilenceTrimmer::TimeMap::toSourceTime(double trimmedSeconds) const {
+    if (m_spans.empty() || m_sampleRate <= 0) {
+        return trimmedSeconds;
+    }
+
+    const double trimmed = trimmedSeconds * m_sampleRate;
+    // Last span starting at or before the requested position
+    auto it = std::upper_bound(m_spans.begin(), m_spans.end(), trimmed,
+                               [](double value, const Span& span) {
+                                   return value < static_cast<double>(span.trimmedStart);
+                               });
+    if (it != m_spans.begin()) {
+        --it;
+    }
+    // Past the end of a span (or the whole map) extrapolates from that span's start
+    return (static_cast<double>(it->sourceStart) + trimmed -
+            static_cast<double>(it->trimmedStart)) /
+           m_sampleRate;
+}
+
+SilenceTrimmer::SilenceTrimmer(int sampleRate)
+    : m_sampleRate(sampleRate), m_detector(sampleRate), m_frameSize(m_detector.frameSize()),
+      m_padSamples(static_cast<size_t>(sampleRate) * kPadMs / 1000),
+      m_maxPauseSamples(static_cast<size_t>(sampleRate) * kMaxPauseMs / 1000) {
+    m_partial.reserve(m_frameSize);
+    m_pending.reserve(m_maxPauseSamples + m_frameSize);
+    reset();
+}
+
+void SilenceTrimmer::reset() {
+    m_detector.reset();
+    m_partial.clear();
+    m_pending.clear();
+    m_pendingStart = 0;
+    m_collapsing = false;
+    m_speechSeen = false;
+    m_sourcePosition = 0;
+    m_trimmedPosition = 0;
+    m_spans.clear();
+}
+
+size_t SilenceTrimmer::process(const float* in, size_t count, std::vector<float>& out) {
+    const size_t start = out.size();
+
+    // Top up a partial frame left over from the previous call first
+    if (!m_partial.empty()) {
+        const size_t take = std::min(count, m_frameSize - m_partial.size());
+        m_partial.insert(m_partial.end(), in, in + take);
+        in += take;
+        count -= take;
+        if (m_partial.size() < m_frameSize) {
+            return 0;
+        }
+        handleFrame(m_partial.data(), m_detector.isSpeech(m_partial.data()), out);
+        m_partial.clear();
+    }
+
+    while (count >= m_frameSize) {
+        handleFrame(in, m_detector.isSpeech(in), out);
+        in += m_frameSize;
+        count -= m_frameSize;
+    }
+    m_partial.assign(in, in + count);
+
+    return out.size() - start;
+}
+
+size_t SilenceTrimmer::flush(std::vector<float>& out) {
+    const size_t start = out.size();
+
+    // A trailing partial frame is too short to judge; treat it as silence
+    if (m_pending.empty()) {
+        m_pendingStart = m_sourcePosition;
+    }
+    m_pending.insert(m_pending.end(), m_partial.begin(), m_partial.end());
+    m_sourcePosition += m_partial.size();
+    m_partial.clear();
+
+    // Tail padding after the last speech, unless a long pause already emitted it
+    if (m_speechSeen && !m_collapsing) {
+        emit(m_pending.data(), m_pendingStart, std::min(m_padSamples, m_pending.size()), out);
+    }
+    m_pending.clear();
+    m_collapsing = false;
+
+    return out.size() - start;
+}
+
+void SilenceTrimmer::handleFrame(const float* frame, bool speech, std::vector<float>& out) {
+    const uint64_t frameStart = m_sourcePosition;
+    m_sourcePosition += m_frameSize;
+
+    if (!speech) {
+        if (m_pending.empty()) {
+            m_pendingStart = frameStart;
+        }
+        m_pending.insert(m_pending.end(), frame, frame + m_frameSize);
+
+        if (!m_collapsing && m_pending.size() > m_maxPauseSamples) {
+            // Too long to keep: close off the last speech with its padding now
+            m_collapsing = true;
+            if (m_speechSeen) {
+                emit(m_pending.data(), m_pendingStart, m_padSamples, out);
+            }
+        }
+        if (m_collapsing && m_pending.size() > m_padSamples) {
+            const size_t drop = m_pending.size() - m_padSamples;
+            m_pending.erase(m_pending.begin(), m_pending.begin() + drop);
+            m_pendingStart += drop;
+        }
+        return;
+    }
+
+    if (m_speechSeen && !m_collapsing) {
+        // Short pause between words: keep it as it was
+        emit(m_pending.data(), m_pendingStart, m_pending.size(), out);
+    } else if (!m_pending.empty()) {
+        // Leading silence or a collapsed pause: keep only the padding before the onset
+        const size_t keep = std::min(m_padSamples, m_pending.size());
+        const size_t skip = m_pending.size() - keep;
+        emit(m_pending.data() + skip, m_pendingStart + skip, keep, out);
+    }
+    m_pending.clear();
+    m_collapsing = false;
+    m_speechSeen = true;
+
+    emit(frame, frameStart, m_frameSize, out);
+}
+
+void SilenceTrimmer::emit(const float* samples, uint64_t sourceStart, size_t count,
+                          std::vector<float>& out) {
+    if (count == 0) {
+        return;
+    }
+
+    out.insert(out.end(), samples, samples + count);
+
+    if (!m_spans.empty() && m_spans.back().sourceStart + m_spans.back().length == sourceStart) {
+        m_spans.back().length += count;
+    } else {
+        m_spans.push_back({sourceStart, m_trimmedPosition, count});
+    }
+    m_trimmedPosition += count;
+}
@@ -0,0 +1,431 @@
+#include "SimdKernels.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(VIBECO_ARCH_X86)
+#include <immintrin.h>
+#elif defined(VIBECO_ARCH_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // Least-squares fit of log2(m) for m in [1, 2): c0 + c1 m + c2 m^2 + c3 m^3 + c4 m^4
+    constexpr float kLog2C0 = -2.4968058f;
+    constexpr float kLog2C1 = 4.0284505f;
+    constexpr float kLog2C2 = -2.0811285f;
+    constexpr float kLog2C3 = 0.62884137f;
+    constexpr float kLog2C4 = -0.079153816f;
+
+    // Scalar reference implementations; also used for the tails of the vector loops
+
+    float dotProductScalar(const float* a, const float* b, size_t count) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            sum += a[i] * b[i];
+        }
+        return sum;
+    }
+
+    void floatToInt16Scalar(const float* in, int16_t* out, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            const float clamped = std::clamp(in[i], -1.0f, 1.0f);
+            out[i] = static_cast<int16_t>(std::lrintf(clamped * 32767.0f));
+        }
+    }
+
+    size_t zeroCrossingsScalar(const float* in, size_t count) {
+        size_t crossings = 0;
+        for (size_t i = 1; i < count; ++i) {
+            crossings += std::signbit(in[i]) != std::signbit(in[i - 1]);
+        }
+        return crossings;
+    }
+
+    // Splits x into exponent and mantissa and evaluates the polynomial on the mantissa
+    float log2Approx(float x) {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        const float exponent = static_cast<float>(static_cast<int32_t>(bits >> 23) - 127);
+        bits = (bits & 0x007FFFFF) | 0x3F800000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+        return exponent + kLog2C0 + m * (kLog2C1 + m * (kLog2C2 + m * (kLog2C3 + m * kLog2C4)));
+    }
+
+    float sumLog2Scalar(const float* in, size_t count) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < count; ++i) {
+            sum += log2Approx(in[i]);
+        }
+        return sum;
+    }
+
+    // Folds into the running values rather than resetting them, so the vector
+    // versions can hand their tails over
+    void minMaxSumSquaresScalar(const float* in, size_t count, float& minValue, float& maxValue,
+                                float& sumSquares) {
+        for (size_t i = 0; i < count; ++i) {
+            minValue = std::min(minValue, in[i]);
+            maxValue = std::max(maxValue, in[i]);
+            sumSquares += in[i] * in[i];
+        }
+    }
+
+#if defined(VIBECO_ARCH_X86)
+    VIBECO_TARGET_SSE2 float dotProductSse2(const float* a, const float* b, size_t count) {
+        __m128 acc0 = _mm_setzero_ps();
+        __m128 acc1 = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+            acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+        }
+        __m128 acc = _mm_add_ps(acc0, acc1);
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        return _mm_cvtss_f32(acc) + dotProductScalar(a + i, b + i, count - i);
+    }
+
+    VIBECO_TARGET_SSE2 void floatToInt16Sse2(const float* in, int16_t* out, size_t count) {
+        const __m128 scale = _mm_set1_ps(32767.0f);
+        const __m128 lo = _mm_set1_ps(-1.0f);
+        const __m128 hi = _mm_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), lo), hi);
+            __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), lo), hi);
+            __m128i ia = _mm_cvtps_epi32(_mm_mul_ps(a, scale));
+            __m128i ib = _mm_cvtps_epi32(_mm_mul_ps(b, scale));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(ia, ib));
+        }
+        floatToInt16Scalar(in + i, out + i, count - i);
+    }
+
+    VIBECO_TARGET_AVX2 float dotProductAvx2(const float* a, const float* b, size_t count) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            acc0 = _mm256_add_ps(acc0,
+                                 _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+            acc1 = _mm256_add_ps(
+                acc1, _mm256_mul_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8)));
+        }
+        for (; i + 8 <= count; i += 8) {
+            acc0 = _mm256_add_ps(acc0,
+                                 _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+        }
+        __m256 acc = _mm256_add_ps(acc0, acc1);
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum) + dotProductScalar(a + i, b + i, count - i);
+    }
+
+    VIBECO_TARGET_AVX2 void floatToInt16Avx2(const float* in, int16_t* out, size_t count) {
+        const __m256 scale = _mm256_set1_ps(32767.0f);
+        const __m256 lo = _mm256_set1_ps(-1.0f);
+        const __m256 hi = _mm256_set1_ps(1.0f);
+        size_t i = 0;
+        for (; i + 16 <= count; i += 16) {
+            __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), lo), hi);
+            __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), lo), hi);
+            __m256i ia = _mm256_cvtps_epi32(_mm256_mul_ps(a, scale));
+            __m256i ib = _mm256_cvtps_epi32(_mm256_mul_ps(b, scale));
+            // packs works within 128-bit lanes; restore sample order afterwards
+            __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(ia, ib), 0xD8);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+        }
+        floatToInt16Sse2(in + i, out + i, count - i);
+    }
+
+    VIBECO_TARGET_SSE2 size_t zeroCrossingsSse2(const float* in, size_t count) {
+        if (count < 2) {
+            return 0;
+        }
+        size_t crossings = 0;
+        size_t i = 1;
+        for (; i + 4 <= count; i += 4) {
+            // Sign bits of in[i..i+3] xor in[i-1..i+2] mark the crossings
+            const __m128 diff = _mm_xor_ps(_mm_loadu_ps(in + i), _mm_loadu_ps(in + i - 1));
+            crossings += std::popcount(static_cast<unsigned>(_mm_movemask_ps(diff)));
+        }
+        return crossings + zeroCrossingsScalar(in + i - 1, count - i + 1);
+    }
+
+    VIBECO_TARGET_SSE2 __m128 log2ApproxSse2(__m128 x) {
+        const __m128i bits = _mm_castps_si128(x);
+        const __m128 exponent = _mm_cvtepi32_ps(
+            _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        const __m128 m = _mm_castsi128_ps(_mm_or_si128(
+            _mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+        __m128 p = _mm_add_ps(_mm_set1_ps(kLog2C3), _mm_mul_ps(m, _mm_set1_ps(kLog2C4)));
+        p = _mm_add_ps(_mm_set1_ps(kLog2C2), _mm_mul_ps(m, p));
+        p = _mm_add_ps(_mm_set1_ps(kLog2C1), _mm_mul_ps(m, p));
+        p = _mm_add_ps(_mm_set1_ps(kLog2C0), _mm_mul_ps(m, p));
+        return _mm_add_ps(exponent, p);
+    }
+
+    VIBECO_TARGET_SSE2 float sumLog2Sse2(const float* in, size_t count) {
+        __m128 acc = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            acc = _mm_add_ps(acc, log2ApproxSse2(_mm_loadu_ps(in + i)));
+        }
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        return _mm_cvtss_f32(acc) + sumLog2Scalar(in + i, count - i);
+    }
+
+    VIBECO_TARGET_SSE2 void minMaxSumSquaresSse2(const float* in, size_t count, float& minValue,
+                                                 float& maxValue, float& sumSquares) {
+        __m128 lo = _mm_set1_ps(minValue);
+        __m128 hi = _mm_set1_ps(maxValue);
+        __m128 acc = _mm_setzero_ps();
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const __m128 x = _mm_loadu_ps(in + i);
+            lo = _mm_min_ps(lo, x);
+            hi = _mm_max_ps(hi, x);
+            acc = _mm_add_ps(acc, _mm_mul_ps(x, x));
+        }
+        lo = _mm_min_ps(lo, _mm_movehl_ps(lo, lo));
+        lo = _mm_min_ss(lo, _mm_shuffle_ps(lo, lo, 1));
+        hi = _mm_max_ps(hi, _mm_movehl_ps(hi, hi));
+        hi = _mm_max_ss(hi, _mm_shuffle_ps(hi, hi, 1));
+        acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+        acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+        minValue = _mm_cvtss_f32(lo);
+        maxValue = _mm_cvtss_f32(hi);
+        sumSquares += _mm_cvtss_f32(acc);
+        minMaxSumSquaresScalar(in + i, count - i, minValue, maxValue, sumSquares);
+    }
+
+    VIBECO_TARGET_AVX2 void minMaxSumSquaresAvx2(const float* in, size_t count, float& minValue,
+                                                 float& maxValue, float& sumSquares) {
+        __m256 lo = _mm256_set1_ps(minValue);
+        __m256 hi = _mm256_set1_ps(maxValue);
+        __m256 acc = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 x = _mm256_loadu_ps(in + i);
+            lo = _mm256_min_ps(lo, x);
+            hi = _mm256_max_ps(hi, x);
+            acc = _mm256_add_ps(acc, _mm256_mul_ps(x, x));
+        }
+        __m128 lo4 = _mm_min_ps(_mm256_castps256_ps128(lo), _mm256_extractf128_ps(lo, 1));
+        __m128 hi4 = _mm_max_ps(_mm256_castps256_ps128(hi), _mm256_extractf128_ps(hi, 1));
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        lo4 = _mm_min_ps(lo4, _mm_movehl_ps(lo4, lo4));
+        lo4 = _mm_min_ss(lo4, _mm_shuffle_ps(lo4, lo4, 1));
+        hi4 = _mm_max_ps(hi4, _mm_movehl_ps(hi4, hi4));
+        hi4 = _mm_max_ss(hi4, _mm_shuffle_ps(hi4, hi4, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        minValue = _mm_cvtss_f32(lo4);
+        maxValue = _mm_cvtss_f32(hi4);
+        sumSquares += _mm_cvtss_f32(sum);
+        minMaxSumSquaresSse2(in + i, count - i, minValue, maxValue, sumSquares);
+    }
+
+    VIBECO_TARGET_AVX2 size_t zeroCrossingsAvx2(const float* in, size_t count) {
+        if (count < 2) {
+            return 0;
+        }
+        size_t crossings = 0;
+        size_t i = 1;
+        for (; i + 8 <= count; i += 8) {
+            const __m256 diff =
+                _mm256_xor_ps(_mm256_loadu_ps(in + i), _mm256_loadu_ps(in + i - 1));
+            crossings += std::popcount(static_cast<unsigned>(_mm256_movemask_ps(diff)));
+        }
+        return crossings + zeroCrossingsScalar(in + i - 1, count - i + 1);
+    }
+
+    VIBECO_TARGET_AVX2 float sumLog2Avx2(const float* in, size_t count) {
+        const __m256i mantissaMask = _mm256_set1_epi32(0x007FFFFF);
+        const __m256i one = _mm256_set1_epi32(0x3F800000);
+        const __m256i bias = _mm256_set1_epi32(127);
+        __m256 acc = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            const __m256i bits = _mm256_castps_si256(_mm256_loadu_ps(in + i));
+            const __m256 exponent =
+                _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), bias));
+            const __m256 m =
+                _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, mantissaMask), one));
+            __m256 p = _mm256_add_ps(_mm256_set1_ps(kLog2C3),
+                                     _mm256_mul_ps(m, _mm256_set1_ps(kLog2C4)));
+            p = _mm256_add_ps(_mm256_set1_ps(kLog2C2), _mm256_mul_ps(m, p));
+            p = _mm256_add_ps(_mm256_set1_ps(kLog2C1), _mm256_mul_ps(m, p));
+            p = _mm256_add_ps(_mm256_set1_ps(kLog2C0), _mm256_mul_ps(m, p));
+            acc = _mm256_add_ps(acc, _mm256_add_ps(exponent, p));
+        }
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum) + sumLog2Sse2(in + i, count - i);
+    }
+#endif
+
+#if defined(VIBECO_ARCH_NEON)
+    float dotProductNeon(const float* a, const float* b, size_t count) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            acc0 = vmlaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+            acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        }
+        float32x4_t acc = vaddq_f32(acc0, acc1);
+        float32x2_t pair = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+        const float sum = vget_lane_f32(vpadd_f32(pair, pair), 0);
+        return sum + dotProductScalar(a + i, b + i, count - i);
+    }
+
+    void floatToInt16Neon(const float* in, int16_t* out, size_t count) {
+        const float32x4_t scale = vdupq_n_f32(32767.0f);
+        const float32x4_t lo = vdupq_n_f32(-1.0f);
+        const float32x4_t hi = vdupq_n_f32(1.0f);
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8) {
+            float32x4_t a = vminq_f32(vmaxq_f32(vld1q_f32(in + i), lo), hi);
+            float32x4_t b = vminq_f32(vmaxq_f32(vld1q_f32(in + i + 4), lo), hi);
+            int32x4_t ia = vcvtnq_s32_f32(vmulq_f32(a, scale));
+            int32x4_t ib = vcvtnq_s32_f32(vmulq_f32(b, scale));
+            vst1q_s16(out + i, vcombine_s16(vqmovn_s32(ia), vqmovn_s32(ib)));
+        }
+        floatToInt16Scalar(in + i, out + i, count - i);
+    }
+
+    size_t zeroCrossingsNeon(const float* in, size_t count) {
+        if (count < 2) {
+            return 0;
+        }
+        uint32x4_t acc = vdupq_n_u32(0);
+        size_t i = 1;
+        for (; i + 4 <= count; i += 4) {
+            const uint32x4_t diff = veorq_u32(vreinterpretq_u32_f32(vld1q_f32(in + i)),
+                                              vreinterpretq_u32_f32(vld1q_f32(in + i - 1)));
+            acc = vaddq_u32(acc, vshrq_n_u32(diff, 31));
+        }
+        const size_t crossings = vaddvq_u32(acc);
+        return crossings + zeroCrossingsScalar(in + i - 1, count - i + 1);
+    }
+
+    float sumLog2Neon(const float* in, size_t count) {
+        const uint32x4_t mantissaMask = vdupq_n_u32(0x007FFFFF);
+        const uint32x4_t one = vdupq_n_u32(0x3F800000);
+        const int32x4_t bias = vdupq_n_s32(127);
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const uint32x4_t bits = vreinterpretq_u32_f32(vld1q_f32(in + i));
+            const float32x4_t exponent = vcvtq_f32_s32(
+                vsubq_s32(vreinterpretq_s32_u32(vshrq_n_u32(bits, 23)), bias));
+            const float32x4_t m = vreinterpretq_f32_u32(vorrq_u32(vandq_u32(bits, mantissaMask), one));
+            float32x4_t p = vmlaq_f32(vdupq_n_f32(kLog2C3), m, vdupq_n_f32(kLog2C4));
+            p = vmlaq_f32(vdupq_n_f32(kLog2C2), m, p);
+            p = vmlaq_f32(vdupq_n_f32(kLog2C1), m, p);
+            p = vmlaq_f32(vdupq_n_f32(kLog2C0), m, p);
+            acc = vaddq_f32(acc, vaddq_f32(exponent, p));
+        }
+        return vaddvq_f32(acc) + sumLog2Scalar(in + i, count - i);
+    }
+
+    void minMaxSumSquaresNeon(const float* in, size_t count, float& minValue, float& maxValue,
+                              float& sumSquares) {
+        float32x4_t lo = vdupq_n_f32(minValue);
+        float32x4_t hi = vdupq_n_f32(maxValue);
+        float32x4_t acc = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+            const float32x4_t x = vld1q_f32(in + i);
+            lo = vminq_f32(lo, x);
+            hi = vmaxq_f32(hi, x);
+            acc = vmlaq_f32(acc, x, x);
+        }
+        minValue = vminvq_f32(lo);
+        maxValue = vmaxvq_f32(hi);
+        sumSquares += vaddvq_f32(acc);
+        minMaxSumSquaresScalar(in + i, count - i, minValue, maxValue, sumSquares);
+    }
+#endif
+
+    using DotProductFn = float (*)(const float*, const float*, size_t);
+    using FloatToInt16Fn = void (*)(const float*, int16_t*, size_t);
+    using ZeroCrossingsFn = size_t (*)(const float*, size_t);
+    using SumLog2Fn = float (*)(const float*, size_t);
+    using MinMaxSumSquaresFn = void (*)(const float*, size_t, float&, float&, float&);
+
+    struct KernelTable {
+        DotProductFn dotProduct = dotProductScalar;
+        FloatToInt16Fn floatToInt16 = floatToInt16Scalar;
+        ZeroCrossingsFn zeroCrossings = zeroCrossingsScalar;
+        SumLog2Fn sumLog2 = sumLog2Scalar;
+        MinMaxSumSquaresFn minMaxSumSquares = minMaxSumSquaresScalar;
+
+        KernelTable() {
+#if defined(VIBECO_ARCH_X86)
+            if (CpuFeatures::hasAvx2()) {
+                dotProduct = dotProductAvx2;
+                floatToInt16 = floatToInt16Avx2;
+                zeroCrossings = zeroCrossingsAvx2;
+                sumLog2 = sumLog2Avx2;
+                minMaxSumSquares = minMaxSumSquaresAvx2;
+            } else if (CpuFeatures::hasSse2()) {
+                dotProduct = dotProductSse2;
+                floatToInt16 = floatToInt16Sse2;
+                zeroCrossings = zeroCrossingsSse2;
+                sumLog2 = sumLog2Sse2;
+                minMaxSumSquares = minMaxSumSquaresSse2;
+            }
+#elif defined(VIBECO_ARCH_NEON)
+            if (CpuFeatures::hasNeon()) {
+                dotProduct = dotProductNeon;
+                floatToInt16 = floatToInt16Neon;
+                zeroCrossings = zeroCrossingsNeon;
+                sumLog2 = sumLog2Neon;
+                minMaxSumSquares = minMaxSumSquaresNeon;
+            }
+#endif
+        }
+    };
+
+    const KernelTable& kernels() {
+        static const KernelTable table;
+        return table;
+    }
+} // namespace
+
+namespace SimdKernels {
+    float dotProduct(const float* a, const float* b, size_t count) {
+        return kernels().dotProduct(a, b, count);
+    }
+
+    void floatToInt16(const float* in, int16_t* out, size_t count) {
+        kernels().floatToInt16(in, out, count);
+    }
+
+    size_t zeroCrossings(const float* in, size_t count) {
+        return kernels().zeroCrossings(in, count);
+    }
+
+    float sumLog2(const float* in, size_t count) {
+        return kernels().sumLog2(in, count);
+    }
+
+    void minMaxSumSquares(const float* in, size_t count, float& minValue, float& maxValue,
+                          float& sumSquares) {
+        sumSquares = 0.0f;
+        if (count == 0) {
+            minValue = maxValue = 0.0f;
+            return;
+        }
+        minValue = maxValue = in[0];
+        kernels().minMaxSumSquares(in, count, minValue, maxValue, sumSquares);
+    }
+} // namespace SimdKernels
@@ -0,0 +1,151 @@
+#include "Trace.h"
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace {
+    // Enough for dozens of dictations in under 400 KB
+    constexpr size_t kCapacity = 8192;
+
+    struct Event {
+        const char* name;
+        char phase; // Chrome trace phases: X complete, i instant, b/e async begin/end
+        int64_t timestampUs;
+        int64_t durationUs;
+        uint64_t dictation;
+        uint32_t thread;
+    };
+
+    struct Ring {
+        std::mutex mutex;
+        std::array<Event, kCapacity> events;
+        size_t next = 0;
+        size_t count = 0;
+    };
+
+    Ring& ring() {
+        static Ring instance;
+        return instance;
+    }
+
+    std::atomic<uint64_t> currentDictationId{0};
+    std::atomic<uint32_t> nextThreadId{1};
+
+    // Small stable numbers read better in the viewer than hashed thread IDs
+    uint32_t threadId() {
+        thread_local const uint32_t id = nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+
+    void record(const char* name, char phase, int64_t timestampUs, int64_t durationUs,
+                uint64_t dictation) {
+        const Event event{name, phase, timestampUs, durationUs, dictation, threadId()};
+        Ring& r = ring();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.events[r.next] = event;
+        r.next = (r.next + 1) % kCapacity;
+        if (r.count < kCapacity) {
+            ++r.count;
+        }
+    }
+
+    void appendEscaped(std::string& out, const char* text) {
+        for (const char* p = text; *p; ++p) {
+            const char c = *p;
+            if (c == '"' || c == '\\') {
+                out += '\\';
+                out += c;
+            } else if (static_cast<unsigned char>(c) >= 0x20) {
+                out += c;
+            }
+        }
+    }
+} // namespace
+
+namespace Trace {
+    namespace detail {
+        std::atomic<bool> enabled{false};
+    } // namespace detail
+
+    void setEnabled(bool enabled) {
+        detail::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    uint64_t beginDictation() {
+        const uint64_t id = currentDictationId.fetch_add(1, std::memory_order_relaxed) + 1;
+        instant("dictation", id);
+        return id;
+    }
+
+    uint64_t currentDictation() {
+        return currentDictationId.load(std::memory_order_relaxed);
+    }
+
+    int64_t nowUs() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    void complete(const char* name, int64_t startUs, int64_t durationUs, uint64_t dictation) {
+        if (enabled()) {
+            record(name, 'X', startUs, durationUs, dictation);
+        }
+    }
+
+    void instant(const char* name, uint64_t dictation) {
+        if (enabled()) {
+            record(name, 'i', nowUs(), 0, dictation);
+        }
+    }
+
+    void asyncBegin(const char* name, uint64_t dictation) {
+        if (enabled()) {
+            record(name, 'b', nowUs(), 0, dictation);
+        }
+    }
+
+    void asyncEnd(const char* name, uint64_t dictation) {
+        if (enabled()) {
+            record(name, 'e', nowUs(), 0, dictation);
+        }
+    }
+
+    std::string exportChromeJson() {
+        Ring& r = ring();
+        std::lock_guard<std::mutex> lock(r.mutex);
+
+        std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        const size_t first = (r.next + kCapacity - r.count) % kCapacity;
+        for (size_t i = 0; i < r.count; ++i) {
+            const Event& e = r.events[(first + i) % kCapacity];
+            if (i > 0) {
+                out += ',';
+            }
+            out += "{\"name\":\"";
+            appendEscaped(out, e.name);
+            out += "\",\"cat\":\"vibeco\",\"ph\":\"";
+            out += e.phase;
+            out += "\",\"pid\":1,\"tid\":" + std::to_string(e.thread);
+            out += ",\"ts\":" + std::to_string(e.timestampUs);
+            if (e.phase == 'X') {
+                out += ",\"dur\":" + std::to_string(e.durationUs);
+            } else if (e.phase == 'i') {
+                out += ",\"s\":\"t\"";
+            } else {
+                // Async spans of one dictation share a track in the viewer
+                out += ",\"id\":" + std::to_string(e.dictation);
+            }
+            out += ",\"args\":{\"dictation\":" + std::to_string(e.dictation) + "}}";
+        }
+        out += "]}";
+        return out;
+    }
+
+    void clear() {
+        Ring& r = ring();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.next = 0;
+        r.count = 0;
+    }
+} // namespace Trace
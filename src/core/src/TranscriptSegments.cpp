@@ -0,0 +1,75 @@
+#include "TranscriptSegments.h"
+#include <algorithm>
+
+void TranscriptSegments::clear() {
+    m_start.clear();
+    m_end.clear();
+    m_avgLogProb.clear();
+    m_noSpeechProb.clear();
+    m_textRanges.clear();
+    m_wordStart.clear();
+    m_wordEnd.clear();
+    m_wordTextRanges.clear();
+    m_text.clear();
+}
+
+void TranscriptSegments::reserve(size_t segments, size_t words, size_t textBytes) {
+    m_start.reserve(segments);
+    m_end.reserve(segments);
+    m_avgLogProb.reserve(segments);
+    m_noSpeechProb.reserve(segments);
+    m_textRanges.reserve(segments);
+    m_wordStart.reserve(words);
+    m_wordEnd.reserve(words);
+    m_wordTextRanges.reserve(words);
+    m_text.reserve(textBytes);
+}
+
+TranscriptSegments::TextRange TranscriptSegments::storeText(std::string_view text) {
+    const TextRange range{static_cast<uint32_t>(m_text.size()), static_cast<uint32_t>(text.size())};
+    m_text.append(text);
+    return range;
+}
+
+void TranscriptSegments::appendSegment(double start, double end, double avgLogProb,
+                                       double noSpeechProb, std::string_view text) {
+    m_start.push_back(static_cast<float>(start));
+    m_end.push_back(static_cast<float>(end));
+    m_avgLogProb.push_back(static_cast<float>(avgLogProb));
+    m_noSpeechProb.push_back(static_cast<float>(noSpeechProb));
+    m_textRanges.push_back(storeText(text));
+}
+
+void TranscriptSegments::appendWord(double start, double end, std::string_view text) {
+    m_wordStart.push_back(static_cast<float>(start));
+    m_wordEnd.push_back(static_cast<float>(end));
+    m_wordTextRanges.push_back(storeText(text));
+}
+
+void TranscriptSegments::append(const TranscriptSegments& other, double offsetSeconds) {
+    reserve(size() + other.size(), wordCount() + other.wordCount(),
+            m_text.size() + other.m_text.size());
+    for (size_t i = 0; i < other.size(); ++i) {
+        appendSegment(other.start(i) + offsetSeconds, other.end(i) + offsetSeconds,
+                      other.avgLogProb(i), other.noSpeechProb(i), other.text(i));
+    }
+    for (size_t i = 0; i < other.wordCount(); ++i) {
+        appendWord(other.wordStart(i) + offsetSeconds, other.wordEnd(i) + offsetSeconds,
+                   other.wordText(i));
+    }
+}
+
+size_t TranscriptSegments::segmentAt(double seconds) const {
+    // Segments come in time order; find the first one starting after the time
+    const auto next = std::upper_bound(m_start.begin(), m_start.end(), static_cast<float>(seconds));
+    return next == m_start.begin() ? size() : static_cast<size_t>(next - m_start.begin()) - 1;
+}
+
+size_t TranscriptSegments::memoryBytes() const {
+    const size_t segmentFloats = m_start.capacity() + m_end.capacity() +
+                                 m_avgLogProb.capacity() + m_noSpeechProb.capacity();
+    const size_t wordFloats = m_wordStart.capacity() + m_wordEnd.capacity();
+    return (segmentFloats + wordFloats) * sizeof(float) +
+           (m_textRanges.capacity() + m_wordTextRanges.capacity()) * sizeof(TextRange) +
+           m_text.capacity();
+}
@@ -0,0 +1,429 @@
+#include "VerboseJson.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace {
+    // Deeper than any response nests; bounds the recursion when skipping values
+    constexpr int kMaxDepth = 64;
+
+    // Pull parser over a complete JSON text. Every read skips leading whitespace;
+    // after the first failure all reads fail and error() says why.
+    class Reader {
+      public:
+        explicit Reader(std::string_view json) : m_json(json) {}
+
+        bool failed() const {
+            return !m_error.empty();
+        }
+        const std::string& error() const {
+            return m_error;
+        }
+
+        bool fail(const char* message) {
+            if (m_error.empty()) {
+                m_error = std::string(message) + " at offset " + std::to_string(m_pos);
+            }
+            return false;
+        }
+
+        // Next significant character, 0 at the end
+        char peek() {
+            while (m_pos < m_json.size() && isSpace(m_json[m_pos])) {
+                ++m_pos;
+            }
+            return m_pos < m_json.size() ? m_json[m_pos] : '\0';
+        }
+
+        bool consume(char c) {
+            if (failed() || peek() != c) {
+                return false;
+            }
+            ++m_pos;
+            return true;
+        }
+
+        bool atEnd() {
+            return peek() == '\0';
+        }
+
+        // Calls member(key) for each member; member must read the value
+        template <typename Member> bool readObject(Member&& member) {
+            if (!consume('{')) {
+                return fail("expected an object");
+            }
+            if (consume('}')) {
+                return true;
+            }
+            std::string key;
+            do {
+                if (!readQuoted(key) || !consume(':')) {
+                    return fail("expected a member name");
+                }
+                if (!member(key)) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume('}') || fail("expected '}'");
+        }
+
+        // Calls element() for each element; element must read the value
+        template <typename Element> bool readArray(Element&& element) {
+            if (!consume('[')) {
+                return fail("expected an array");
+            }
+            if (consume(']')) {
+                return true;
+            }
+            do {
+                if (!element()) {
+                    return false;
+                }
+            } while (consume(','));
+            return consume(']') || fail("expected ']'");
+        }
+
+        // null reads as an empty string
+        bool readString(std::string& out) {
+            if (peek() == 'n') {
+                out.clear();
+                return readLiteral("null");
+            }
+            return readQuoted(out);
+        }
+
+        // Quoted only: member names can't be null
+        bool readQuoted(std::string& out) {
+            out.clear();
+            if (!consume('"')) {
+                return fail("expected a string");
+            }
+            while (m_pos < m_json.size()) {
+                // Copy unescaped runs in one go
+                const size_t runStart = m_pos;
+                while (m_pos < m_json.size() && m_json[m_pos] != '"' && m_json[m_pos] != '\\') {
+                    ++m_pos;
+                }
+                out.append(m_json.substr(runStart, m_pos - runStart));
+                if (m_pos >= m_json.size()) {
+                    break;
+                }
+                if (m_json[m_pos++] == '"') {
+                    return true;
+                }
+                if (!readEscape(out)) {
+                    return false;
+                }
+            }
+            return fail("unterminated string");
+        }
+
+        // null reads as nothing and leaves out unchanged
+        bool readNumber(double& out) {
+            if (peek() == 'n') {
+                return readLiteral("null");
+            }
+            const size_t start = m_pos;
+            const bool negative = m_pos < m_json.size() && m_json[m_pos] == '-';
+            if (negative) {
+                ++m_pos;
+            }
+
+            // Locale-independent: up to 19 significant digits, then a power of ten
+            uint64_t mantissa = 0;
+            int significant = 0;
+            int exponent = 0;
+            auto digit = [&](bool fraction) {
+                const int d = m_json[m_pos++] - '0';
+                if (significant < 19) {
+                    if (mantissa != 0 || d != 0) {
+                        ++significant;
+                    }
+                    mantissa = mantissa * 10 + d;
+                    exponent -= fraction ? 1 : 0;
+                } else if (!fraction) {
+                    ++exponent;
+                }
+            };
+            auto digitAhead = [&]() { return m_pos < m_json.size() && isDigit(m_json[m_pos]); };
+
+            // JSON grammar: no leading zeros, and digits on both sides of the point
+            if (!digitAhead()) {
+                m_pos = start;
+                return fail("expected a number");
+            }
+            if (m_json[m_pos] == '0') {
+                ++m_pos;
+                if (digitAhead()) {
+                    return fail("leading zero in a number");
+                }
+            } else {
+                while (digitAhead()) {
+                    digit(false);
+                }
+            }
+            if (m_pos < m_json.size() && m_json[m_pos] == '.') {
+                ++m_pos;
+                if (!digitAhead()) {
+                    return fail("expected a digit after the decimal point");
+                }
+                while (digitAhead()) {
+                    digit(true);
+                }
+            }
+            if (m_pos < m_json.size() && (m_json[m_pos] == 'e' || m_json[m_pos] == 'E')) {
+                ++m_pos;
+                bool negativeExponent = false;
+                if (m_pos < m_json.size() && (m_json[m_pos] == '+' || m_json[m_pos] == '-')) {
+                    negativeExponent = m_json[m_pos++] == '-';
+                }
+                int value = 0;
+                bool exponentDigits = false;
+                while (digitAhead()) {
+                    value = std::min(value * 10 + (m_json[m_pos++] - '0'), 9999);
+                    exponentDigits = true;
+                }
+                if (!exponentDigits) {
+                    return fail("malformed exponent");
+                }
+                exponent += negativeExponent ? -value : value;
+            }
+
+            const double magnitude = static_cast<double>(mantissa) * std::pow(10.0, exponent);
+            out = negative ? -magnitude : magnitude;
+            return true;
+        }
+
+        bool skipValue(int depth = 0) {
+            if (depth > kMaxDepth) {
+                return fail("nested too deeply");
+            }
+            std::string scratch;
+            switch (peek()) {
+            case '{':
+                return readObject([&](const std::string&) { return skipValue(depth + 1); });
+            case '[':
+                return readArray([&]() { return skipValue(depth + 1); });
+            case '"':
+                return readQuoted(scratch);
+            case 't':
+                return readLiteral("true");
+            case 'f':
+                return readLiteral("false");
+            case 'n':
+                return readLiteral("null");
+            default:
+                double ignored;
+                return readNumber(ignored);
+            }
+        }
+
+      private:
+        static bool isSpace(char c) {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+        static bool isDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        bool readLiteral(std::string_view literal) {
+            if (m_json.substr(m_pos, literal.size()) != literal) {
+                return fail("unexpected character");
+            }
+            m_pos += literal.size();
+            return true;
+        }
+
+        bool readHex4(uint32_t& out) {
+            if (m_pos + 4 > m_json.size()) {
+                return fail("truncated \\u escape");
+            }
+            out = 0;
+            for (int i = 0; i < 4; ++i) {
+                const char c = m_json[m_pos++];
+                out <<= 4;
+                if (isDigit(c)) {
+                    out |= c - '0';
+                } else if (c >= 'a' && c <= 'f') {
+                    out |= c - 'a' + 10;
+                } else if (c >= 'A' && c <= 'F') {
+                    out |= c - 'A' + 10;
+                } else {
+                    return fail("bad \\u escape");
+                }
+            }
+            return true;
+        }
+
+        // After a backslash
+        bool readEscape(std::string& out) {
+            if (m_pos >= m_json.size()) {
+                return fail("unterminated string");
+            }
+            const char c = m_json[m_pos++];
+            switch (c) {
+            case '"':
+            case '\\':
+            case '/':
+                out += c;
+                return true;
+            case 'b':
+                out += '\b';
+                return true;
+            case 'f':
+                out += '\f';
+                return true;
+            case 'n':
+                out += '\n';
+                return true;
+            case 'r':
+                out += '\r';
+                return true;
+            case 't':
+                out += '\t';
+                return true;
+            case 'u':
+                break;
+            default:
+                return fail("bad escape");
+            }
+
+            uint32_t codePoint = 0;
+            if (!readHex4(codePoint)) {
+                return false;
+            }
+            if (codePoint >= 0xD800 && codePoint < 0xDC00 &&
+                m_json.substr(m_pos, 2) == "\\u") {
+                // High surrogate; combine with the low one that should follow. Anything
+                // else is left to be read as an escape of its own.
+                const size_t next = m_pos;
+                m_pos += 2;
+                uint32_t low = 0;
+                if (!readHex4(low)) {
+                    return false;
+                }
+                if (low >= 0xDC00 && low < 0xE000) {
+                    codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+                } else {
+                    m_pos = next;
+                    codePoint = 0xFFFD;
+                }
+            } else if (codePoint >= 0xD800 && codePoint < 0xE000) {
+                codePoint = 0xFFFD;
+            }
+            appendUtf8(out, codePoint);
+            return true;
+        }
+
+        static void appendUtf8(std::string& out, uint32_t codePoint) {
+            if (codePoint < 0x80) {
+                out += static_cast<char>(codePoint);
+            } else if (codePoint < 0x800) {
+                out += static_cast<char>(0xC0 | (codePoint >> 6));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else if (codePoint < 0x10000) {
+                out += static_cast<char>(0xE0 | (codePoint >> 12));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (codePoint >> 18));
+                out += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (codePoint & 0x3F));
+            }
+        }
+
+        std::string_view m_json;
+        size_t m_pos = 0;
+        std::string m_error;
+    };
+
+    bool readSegments(Reader& reader, TranscriptSegments& segments) {
+        std::string text;
+        return reader.readArray([&]() {
+            double start = 0.0, end = 0.0, avgLogProb = 0.0, noSpeechProb = 0.0;
+            text.clear();
+            const bool ok = reader.readObject([&](const std::string& key) {
+                if (key == "start") {
+                    return reader.readNumber(start);
+                } else if (key == "end") {
+                    return reader.readNumber(end);
+                } else if (key == "avg_logprob") {
+                    return reader.readNumber(avgLogProb);
+                } else if (key == "no_speech_prob") {
+                    return reader.readNumber(noSpeechProb);
+                } else if (key == "text") {
+                    return reader.readString(text);
+                }
+                return reader.skipValue();
+            });
+            if (ok) {
+                segments.appendSegment(start, end, avgLogProb, noSpeechProb, text);
+            }
+            return ok;
+        });
+    }
+
+    bool readWords(Reader& reader, TranscriptSegments& segments) {
+        std::string word;
+        return reader.readArray([&]() {
+            double start = 0.0, end = 0.0;
+            word.clear();
+            const bool ok = reader.readObject([&](const std::string& key) {
+                if (key == "start") {
+                    return reader.readNumber(start);
+                } else if (key == "end") {
+                    return reader.readNumber(end);
+                } else if (key == "word") {
+                    return reader.readString(word);
+                }
+                return reader.skipValue();
+            });
+            if (ok) {
+                segments.appendWord(start, end, word);
+            }
+            return ok;
+        });
+    }
+} // namespace
+
+namespace VerboseJson {
+    bool parse(std::string_view json, VerboseTranscript& out, std::string& error) {
+        out = VerboseTranscript();
+        Reader reader(json);
+        bool hasText = false;
+
+        const bool ok = reader.readObject([&](const std::string& key) {
+            if (key == "text") {
+                hasText = true;
+                return reader.readString(out.text);
+            } else if (key == "language") {
+                return reader.readString(out.language);
+            } else if (key == "task") {
+                return reader.readString(out.task);
+            } else if (key == "duration") {
+                return reader.readNumber(out.duration);
+            } else if (key == "segments") {
+                return readSegments(reader, out.segments);
+            } else if (key == "words") {
+                return readWords(reader, out.segments);
+            } else if (key == "x_groq") {
+                return reader.readObject([&](const std::string& groqKey) {
+                    return groqKey == "id" ? reader.readString(out.requestId)
+                                           : reader.skipValue();
+                });
+            }
+            return reader.skipValue();
+        });
+
+        if (!ok || !reader.atEnd()) {
+            error = reader.failed() ? reader.error() : "trailing data after the response";
+            return false;
+        }
+        if (!hasText) {
+            error = "no \"text\" in the response";
+            return false;
+        }
+        return true;
+    }
+} // namespace VerboseJson
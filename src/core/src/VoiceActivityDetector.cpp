@@ -0,0 +1,143 @@
+#include "VoiceActivityDetector.h"
+#include "SimdKernels.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    // Frames this far above the noise floor are candidates for speech
+    constexpr float kSpeechMarginDb = 9.0f;
+    // Extra margin at which a frame counts as speech whatever its spectrum looks like
+    constexpr float kLoudMarginDb = 20.0f;
+    // Anything quieter than this is silence, however clean the input is
+    constexpr float kAbsoluteFloorDb = -60.0f;
+    // Starting noise floor, roughly a quiet room; stops a first frame of speech becoming the floor
+    constexpr float kInitialFloorDb = -50.0f;
+    // Voiced speech has a peaky spectrum; broadband noise sits around 0.5
+    constexpr float kVoicedFlatness = 0.35f;
+    // Fricatives (s, f, sh) cross zero far more often than hum or rumble
+    constexpr float kFricativeCrossingRate = 0.25f;
+    // Noise floor follows drops immediately and rises by this much per frame
+    constexpr float kNoiseFloorRiseDb = 0.05f;
+    // Speech band used for the flatness measure
+    constexpr float kBandLowHz = 250.0f;
+    constexpr float kBandHighHz = 4000.0f;
+    // Keeps log2 finite on digital silence
+    constexpr float kPowerEpsilon = 1e-12f;
+
+    constexpr double kPi = 3.14159265358979323846;
+} // namespace
+
+VoiceActivityDetector::VoiceActivityDetector(int sampleRate, int frameMs)
+    : m_sampleRate(sampleRate),
+      m_frameSize(static_cast<size_t>(sampleRate) * static_cast<size_t>(frameMs) / 1000),
+      m_fftSize(1) {
+    while (m_fftSize < m_frameSize) {
+        m_fftSize <<= 1;
+    }
+
+    const float binHz = static_cast<float>(sampleRate) / m_fftSize;
+    m_firstBin = std::max<size_t>(1, static_cast<size_t>(kBandLowHz / binHz));
+    m_lastBin = std::min(m_fftSize / 2, static_cast<size_t>(kBandHighHz / binHz));
+
+    // Hann window so frame edges don't smear energy across the spectrum
+    m_window.resize(m_frameSize);
+    for (size_t i = 0; i < m_frameSize; ++i) {
+        m_window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * kPi * i / (m_frameSize - 1)));
+    }
+
+    m_twiddles.resize(m_fftSize / 2);
+    for (size_t k = 0; k < m_fftSize / 2; ++k) {
+        m_twiddles[k] = std::polar(1.0f, static_cast<float>(-2.0 * kPi * k / m_fftSize));
+    }
+
+    size_t bits = 0;
+    while ((size_t(1) << bits) < m_fftSize) {
+        ++bits;
+    }
+    m_bitReverse.resize(m_fftSize);
+    for (size_t i = 0; i < m_fftSize; ++i) {
+        size_t reversed = 0;
+        for (size_t b = 0; b < bits; ++b) {
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        }
+        m_bitReverse[i] = reversed;
+    }
+
+    m_spectrum.resize(m_fftSize);
+    m_power.resize(m_lastBin - m_firstBin + 1);
+    reset();
+}
+
+void VoiceActivityDetector::reset() {
+    m_noiseFloorDb = kAbsoluteFloorDb;
+    m_noiseFloorValid = false;
+    m_features = Features();
+}
+
+bool VoiceActivityDetector::isSpeech(const float* frame) {
+    const float power = SimdKernels::dotProduct(frame, frame, m_frameSize) / m_frameSize;
+    const float energyDb = 10.0f * std::log10(power + kPowerEpsilon);
+
+    if (!m_noiseFloorValid) {
+        m_noiseFloorDb = std::min(energyDb, kInitialFloorDb);
+        m_noiseFloorValid = true;
+    } else if (energyDb < m_noiseFloorDb) {
+        m_noiseFloorDb = energyDb;
+    } else {
+        m_noiseFloorDb += kNoiseFloorRiseDb;
+    }
+    // Never judge against a floor below the absolute one: after digital silence the tracked
+    // floor sinks so low that any faint hiss would clear the margin as speech
+    const float floorDb = std::max(m_noiseFloorDb, kAbsoluteFloorDb);
+
+    m_features.energyDb = energyDb;
+    m_features.noiseFloorDb = floorDb;
+    m_features.zeroCrossingRate =
+        static_cast<float>(SimdKernels::zeroCrossings(frame, m_frameSize)) / m_frameSize;
+
+    const float margin = energyDb - floorDb;
+    if (margin < kSpeechMarginDb) {
+        m_features.spectralFlatness = 0.0f;
+        return false;
+    }
+    if (margin >= kLoudMarginDb) {
+        m_features.spectralFlatness = 0.0f;
+        return true;
+    }
+
+    m_features.spectralFlatness = spectralFlatness(frame);
+    return m_features.spectralFlatness < kVoicedFlatness ||
+           m_features.zeroCrossingRate > kFricativeCrossingRate;
+}
+
+float VoiceActivityDetector::spectralFlatness(const float* frame) {
+    // Windowed, zero-padded frame in bit-reversed order, then an in-place radix-2 FFT
+    std::fill(m_spectrum.begin(), m_spectrum.end(), std::complex<float>());
+    for (size_t i = 0; i < m_frameSize; ++i) {
+        m_spectrum[m_bitReverse[i]] = frame[i] * m_window[i];
+    }
+    for (size_t half = 1; half < m_fftSize; half <<= 1) {
+        const size_t stride = m_fftSize / (half * 2);
+        for (size_t start = 0; start < m_fftSize; start += half * 2) {
+            for (size_t k = 0; k < half; ++k) {
+                const std::complex<float> t = m_twiddles[k * stride] * m_spectrum[start + k + half];
+                m_spectrum[start + k + half] = m_spectrum[start + k] - t;
+                m_spectrum[start + k] += t;
+            }
+        }
+    }
+
+    for (size_t bin = m_firstBin; bin <= m_lastBin; ++bin) {
+        m_power[bin - m_firstBin] = std::norm(m_spectrum[bin]) + kPowerEpsilon;
+    }
+
+    // Geometric mean over arithmetic mean, with the geometric mean taken in log2 space
+    const size_t count = m_power.size();
+    const float meanLog2 = SimdKernels::sumLog2(m_power.data(), count) / count;
+    float arithmetic = 0.0f;
+    for (float p : m_power) {
+        arithmetic += p;
+    }
+    arithmetic /= count;
+    return std::exp2(meanLog2) / arithmetic;
+}
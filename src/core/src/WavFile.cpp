@@ -0,0 +1,133 @@
+#include "WavFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    void put16(char* out, uint16_t value) {
+        out[0] = static_cast<char>(value & 0xFF);
+        out[1] = static_cast<char>(value >> 8);
+    }
+
+    void put32(char* out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+        }
+    }
+
+    uint16_t get16(const char* in) {
+        const auto* b = reinterpret_cast<const unsigned char*>(in);
+        return static_cast<uint16_t>(b[0] | (b[1] << 8));
+    }
+
+    uint32_t get32(const char* in) {
+        const auto* b = reinterpret_cast<const unsigned char*>(in);
+        return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+               (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    }
+
+    void put64(char* out, uint64_t value) {
+        put32(out, static_cast<uint32_t>(value & 0xFFFFFFFF));
+        put32(out + 4, static_cast<uint32_t>(value >> 32));
+    }
+
+    uint64_t get64(const char* in) {
+        return static_cast<uint64_t>(get32(in)) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+    }
+
+    uint16_t blockAlign(const WavFile::Format& format) {
+        return static_cast<uint16_t>(format.channels * (format.bitsPerSample / 8));
+    }
+
+    // The 24-byte "fmt " chunk, header included
+    void putFormatChunk(char* out, const WavFile::Format& format) {
+        std::memcpy(out, "fmt ", 4);
+        put32(out + 4, 16);
+        put16(out + 8, format.audioFormat);
+        put16(out + 10, format.channels);
+        put32(out + 12, format.sampleRate);
+        put32(out + 16, format.sampleRate * blockAlign(format));
+        put16(out + 20, blockAlign(format));
+        put16(out + 22, format.bitsPerSample);
+    }
+} // namespace
+
+namespace WavFile {
+    std::array<char, kHeaderSize> header(const Format& format, uint32_t dataSize) {
+        std::array<char, kHeaderSize> out{};
+        const uint32_t riffSize =
+            dataSize > kMaxRiffDataSize ? kUnknownSize : static_cast<uint32_t>(dataSize + 36);
+
+        std::memcpy(out.data(), "RIFF", 4);
+        put32(out.data() + 4, riffSize);
+        std::memcpy(out.data() + 8, "WAVE", 4);
+        putFormatChunk(out.data() + 12, format);
+        std::memcpy(out.data() + 36, "data", 4);
+        put32(out.data() + 40, dataSize);
+        return out;
+    }
+
+    std::array<char, kRf64HeaderSize> rf64Header(const Format& format, uint64_t dataSize) {
+        std::array<char, kRf64HeaderSize> out{};
+        const uint64_t riffSize = dataSize + kRf64HeaderSize - 8;
+        // Decided by the RIFF size, which outgrows 32 bits before the data size does
+        const bool rf64 = riffSize > 0xFFFFFFFFULL;
+
+        std::memcpy(out.data(), rf64 ? "RF64" : "RIFF", 4);
+        put32(out.data() + 4, rf64 ? kUnknownSize : static_cast<uint32_t>(riffSize));
+        std::memcpy(out.data() + 8, "WAVE", 4);
+
+        // ds64: RIFF size, data size, sample count, empty table of other chunk sizes
+        std::memcpy(out.data() + 12, rf64 ? "ds64" : "JUNK", 4);
+        put32(out.data() + 16, 28);
+        if (rf64) {
+            put64(out.data() + 20, riffSize);
+            put64(out.data() + 28, dataSize);
+            put64(out.data() + 36, blockAlign(format) ? dataSize / blockAlign(format) : 0);
+        }
+
+        putFormatChunk(out.data() + 48, format);
+        std::memcpy(out.data() + 72, "data", 4);
+        put32(out.data() + 76, rf64 ? kUnknownSize : static_cast<uint32_t>(dataSize));
+        return out;
+    }
+
+    bool parse(const char* bytes, size_t size, Format& format, size_t& dataOffset,
+               size_t& dataSize) {
+        const bool rf64 = size >= 12 && std::memcmp(bytes, "RF64", 4) == 0;
+        if (size < 12 || (!rf64 && std::memcmp(bytes, "RIFF", 4) != 0) ||
+            std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+            return false;
+        }
+
+        bool haveFormat = false;
+        uint64_t ds64DataSize = 0;
+        size_t offset = 12;
+        while (offset + 8 <= size) {
+            const char* chunk = bytes + offset;
+            const uint32_t chunkSize = get32(chunk + 4);
+            const size_t body = offset + 8;
+
+            if (rf64 && std::memcmp(chunk, "ds64", 4) == 0 && chunkSize >= 16 &&
+                body + 16 <= size) {
+                ds64DataSize = get64(bytes + body + 8);
+            } else if (std::memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16 &&
+                       body + 16 <= size) {
+                format.audioFormat = get16(bytes + body);
+                format.channels = get16(bytes + body + 2);
+                format.sampleRate = get32(bytes + body + 4);
+                format.bitsPerSample = get16(bytes + body + 14);
+                haveFormat = true;
+            } else if (std::memcmp(chunk, "data", 4) == 0) {
+                const uint64_t declared =
+                    rf64 && chunkSize == kUnknownSize ? ds64DataSize : chunkSize;
+                dataOffset = body;
+                dataSize = static_cast<size_t>(std::min<uint64_t>(declared, size - body));
+                return haveFormat;
+            }
+
+            // Chunks are padded to an even size
+            offset = body + chunkSize + (chunkSize & 1);
+        }
+        return false;
+    }
+} // namespace WavFile
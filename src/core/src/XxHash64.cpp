@@ -0,0 +1,133 @@
+#include "XxHash64.h"
+#include <cstring>
+
+namespace {
+    constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+    constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+    constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+    constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+    constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+    uint64_t rotl(uint64_t x, int r) {
+        return (x << r) | (x >> (64 - r));
+    }
+
+    // Little-endian loads; memcpy keeps unaligned input well-defined
+    uint64_t read64(const unsigned char* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap64(v);
+#endif
+        return v;
+    }
+
+    uint32_t read32(const unsigned char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        v = __builtin_bswap32(v);
+#endif
+        return v;
+    }
+
+    uint64_t round(uint64_t acc, uint64_t input) {
+        acc += input * kPrime2;
+        acc = rotl(acc, 31);
+        return acc * kPrime1;
+    }
+
+    uint64_t mergeRound(uint64_t acc, uint64_t lane) {
+        acc ^= round(0, lane);
+        return acc * kPrime1 + kPrime4;
+    }
+} // namespace
+
+XxHash64::XxHash64(uint64_t seed) : m_seed(seed), m_buffered(0), m_totalLength(0) {
+    m_lanes[0] = seed + kPrime1 + kPrime2;
+    m_lanes[1] = seed + kPrime2;
+    m_lanes[2] = seed;
+    m_lanes[3] = seed - kPrime1;
+}
+
+void XxHash64::update(const void* data, size_t size) {
+    const auto* p = static_cast<const unsigned char*>(data);
+    m_totalLength += size;
+
+    // Top up a partial stripe from the previous call first
+    if (m_buffered > 0) {
+        const size_t space = sizeof(m_buffer) - m_buffered;
+        const size_t take = size < space ? size : space;
+        std::memcpy(m_buffer + m_buffered, p, take);
+        m_buffered += take;
+        p += take;
+        size -= take;
+        if (m_buffered < sizeof(m_buffer)) {
+            return;
+        }
+        for (int i = 0; i < 4; ++i) {
+            m_lanes[i] = round(m_lanes[i], read64(m_buffer + i * 8));
+        }
+        m_buffered = 0;
+    }
+
+    while (size >= 32) {
+        m_lanes[0] = round(m_lanes[0], read64(p));
+        m_lanes[1] = round(m_lanes[1], read64(p + 8));
+        m_lanes[2] = round(m_lanes[2], read64(p + 16));
+        m_lanes[3] = round(m_lanes[3], read64(p + 24));
+        p += 32;
+        size -= 32;
+    }
+
+    std::memcpy(m_buffer, p, size);
+    m_buffered = size;
+}
+
+uint64_t XxHash64::digest() const {
+    uint64_t h;
+    if (m_totalLength >= 32) {
+        h = rotl(m_lanes[0], 1) + rotl(m_lanes[1], 7) + rotl(m_lanes[2], 12) +
+            rotl(m_lanes[3], 18);
+        for (int i = 0; i < 4; ++i) {
+            h = mergeRound(h, m_lanes[i]);
+        }
+    } else {
+        h = m_seed + kPrime5;
+    }
+    h += m_totalLength;
+
+    const unsigned char* p = m_buffer;
+    size_t remaining = m_buffered;
+    while (remaining >= 8) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * kPrime1 + kPrime4;
+        p += 8;
+        remaining -= 8;
+    }
+    if (remaining >= 4) {
+        h ^= static_cast<uint64_t>(read32(p)) * kPrime1;
+        h = rotl(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+        remaining -= 4;
+    }
+    while (remaining > 0) {
+        h ^= (*p) * kPrime5;
+        h = rotl(h, 11) * kPrime1;
+        ++p;
+        --remaining;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t XxHash64::hash(const void* data, size_t size, uint64_t seed) {
+    XxHash64 state(seed);
+    state.update(data, size);
+    return state.digest();
+}
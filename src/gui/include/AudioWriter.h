@@ -0,0 +1,141 @@
+#ifndef AUDIOWRITER_H
+#define AUDIOWRITER_H
+
+#include "AudioEncoder.h"
+#include "AudioRingBuffer.h"
+#include "ChunkArena.h"
+#include "LevelMeter.h"
+#include "PolyphaseResampler.h"
+#include "SilenceTrimmer.h"
+#include "WavSegmentWriter.h"
+#include <QByteArray>
+#include <QSharedPointer>
+#include <QThread>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class StreamingUploadDevice;
+
+// Drains captured samples from the ring buffer filled by the PortAudio callback
+// and does all of the blocking work (resampling, metering, disk writes) off the
+// real-time thread. Output is mono signed 16-bit PCM at outputRate.
+// The file always gets the full recording; the upload can have silence
+// trimmed and be compressed as it is written.
+class AudioWriter : public QThread {
+    Q_OBJECT
+
+  public:
+    AudioWriter(AudioRingBuffer* ringBuffer, int captureRate, int outputRate,
+                QObject* parent = nullptr);
+    ~AudioWriter();
+
+    // Selects the encoding of the upload payload for the next recording. Call before
+    // startWriting(); returns false (and falls back to WAV) if the encoder can't start.
+    bool setUploadFormat(AudioEncoder::Format format);
+    AudioEncoder::Format uploadFormat() const {
+        return m_uploadFormat;
+    }
+
+    // Rate of the samples in the ring buffer, which follows the input device. Call
+    // before startWriting().
+    void setCaptureRate(int captureRate);
+    int captureRate() const {
+        return m_resampler.inputRate();
+    }
+
+    // Drops leading/trailing silence and long pauses from the upload (not the file).
+    // Call before startWriting().
+    void setTrimSilence(bool enabled) {
+        m_trimSilence = enabled;
+    }
+    bool trimsSilence() const {
+        return m_trimSilence;
+    }
+
+    // Where the recording's PCM16 goes when startWriting() gets no file. Call before
+    // startWriting(); the arena must not be read until stopWriting() has returned.
+    void setRecordingArena(std::shared_ptr<ChunkArena> arena) {
+        m_arena = std::move(arena);
+    }
+
+    // Starts draining into the given (already open) file and, if set, an in-flight upload.
+    // With a compressed upload format the upload receives encoded bytes, not PCM.
+    void startWriting(WavSegmentWriter* outputFile,
+                      const QSharedPointer<StreamingUploadDevice>& streamingUpload = {});
+    // Drains whatever is left in the ring buffer, then returns once the thread has exited.
+    // If producerActive is given, the producer may still be writing: the writer keeps
+    // draining until it reads false, for at most handoffTimeoutMs, before the final drain.
+    void stopWriting(const std::atomic<bool>* producerActive = nullptr, int handoffTimeoutMs = 0);
+
+    qint64 bytesWritten() const {
+        return m_bytesWritten.load(std::memory_order_relaxed);
+    }
+
+    // What should be uploaded instead of the file: the compressed stream, or trimmed
+    // headerless PCM16 for WAV. Empty if the file itself is the payload. Like the
+    // accessors below, only valid once stopWriting() has returned.
+    QByteArray uploadPayload() const {
+        return m_uploadPayload;
+    }
+
+    // Latest input levels; safe to call from any one other thread while writing.
+    // Returns false if nothing new was measured since the last call.
+    bool readLevels(LevelMeter::Snapshot& out) {
+        return m_levelMeter.read(out);
+    }
+
+    // False if silence trimming was on and no speech was found at all
+    bool speechDetected() const {
+        return !m_trimSilence || m_trimmer.speechDetected();
+    }
+    // Maps upload timestamps back to the recording; empty when nothing was trimmed
+    SilenceTrimmer::TimeMap trimMap() const {
+        return m_trimSilence ? m_trimmer.timeMap() : SilenceTrimmer::TimeMap();
+    }
+
+  signals:
+    void captureOverflow(quint64 overflowCount, quint64 droppedSamples);
+
+  protected:
+    void run() override;
+
+  private:
+    size_t drain();
+    void flushResampler();
+    void writeSamples(const std::vector<float>& samples);
+    void uploadSamples(const std::vector<float>& samples);
+    void uploadPcm(const int16_t* samples, size_t count);
+    void flushTrimmer();
+    void finishEncoder();
+    void forwardEncodedData();
+    void checkOverflows();
+
+    AudioRingBuffer* m_ringBuffer;
+    WavSegmentWriter* m_outputFile;
+    std::shared_ptr<ChunkArena> m_arena;
+    QSharedPointer<StreamingUploadDevice> m_streamingUpload;
+    PolyphaseResampler m_resampler;
+    std::vector<float> m_scratch;
+    LevelMeter m_levelMeter;
+    std::vector<float> m_resampled;
+    std::vector<int16_t> m_pcm;
+    bool m_trimSilence;
+    SilenceTrimmer m_trimmer;
+    std::vector<float> m_trimmed;
+    std::vector<int16_t> m_uploadPcm;
+    AudioEncoder::Format m_uploadFormat;
+    std::unique_ptr<AudioEncoder> m_encoder;
+    QByteArray m_uploadPayload;
+    qsizetype m_encodedForwarded;
+    std::atomic<bool> m_stopRequested;
+    // Set by stopWriting() before m_stopRequested
+    const std::atomic<bool>* m_producerActive;
+    int m_handoffTimeoutMs;
+    std::atomic<qint64> m_bytesWritten;
+    quint64 m_reportedOverflows;
+    int m_outputRate;
+};
+
+#endif // AUDIOWRITER_H
@@ -0,0 +1,111 @@
+#ifndef BATCHTRANSCRIBER_H
+#define BATCHTRANSCRIBER_H
+
+#include "TranscriptionResult.h"
+#include <QAbstractTableModel>
+#include <QElapsedTimer>
+#include <QStringList>
+#include <QVector>
+
+class TranscriptionBackend;
+
+// Transcribes existing audio files through a queue, one row per file.
+//
+// Up to Config::getBatchConcurrency() files are in flight at once (always one
+// with the local backend, which already uses every core). Each slot has its own
+// backend instance, kept apart from live dictation, though a local one shares the
+// loaded model and its worker thread with dictation's (see LocalWhisperBackend).
+// Requests are made under the job's ID, so results and upload progress always land
+// on the right row. Higher priority jobs start first, then in the order they were
+// added. Pausing stops new jobs from starting; those in flight finish.
+//
+// A result is saved next to its audio as <file name>.transcript.json (verbose_json),
+// e.g. talk.wav.transcript.json, so talk.wav and talk.flac don't share one; files
+// that already have one, newer than the audio, are skipped.
+class BatchTranscriber : public QAbstractTableModel {
+    Q_OBJECT
+
+  public:
+    enum class Priority { Low, Normal, High };
+    enum class State { Queued, Running, Done, Skipped, Failed };
+    enum Column { FileColumn, StateColumn, ProgressColumn, PriorityColumn, ColumnCount };
+
+    struct Stats {
+        int queued = 0;
+        int running = 0;
+        int done = 0;
+        int skipped = 0;
+        int failed = 0;
+        double audioSeconds = 0.0;  // Transcribed so far
+        qint64 fileBytes = 0;       // Of the files transcribed so far
+        double activeSeconds = 0.0; // Wall time with at least one job running
+    };
+
+    explicit BatchTranscriber(QObject* parent = nullptr);
+    ~BatchTranscriber() override;
+
+    // Audio files the transcription API accepts, as name filters
+    static QStringList audioFileFilters();
+    static QString resultPath(const QString& audioPath);
+    static bool hasResult(const QString& audioPath);
+
+    // Queue files or every audio file in a directory; returns how many were queued
+    int addFiles(const QStringList& paths, Priority priority = Priority::Normal);
+    int addDirectory(const QString& directory, Priority priority = Priority::Normal);
+    void setPriority(int row, Priority priority);
+    // Drops rows that are done, skipped or failed
+    void clearFinished();
+
+    bool isPaused() const {
+        return m_paused;
+    }
+    void setPaused(bool paused);
+
+    Stats stats() const;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+  signals:
+    void jobFinished(const QString& filePath, const TranscriptionResult& result);
+    void pausedChanged(bool paused);
+    void statsChanged();
+
+  private:
+    struct Job {
+        quint64 id = 0;
+        QString path;
+        Priority priority = Priority::Normal;
+        State state = State::Queued;
+        qint64 bytes = 0;
+        qint64 bytesSent = 0;
+        qint64 bytesTotal = 0;
+        QString error;
+    };
+    struct Slot {
+        TranscriptionBackend* backend = nullptr;
+        quint64 job = 0; // 0 when idle
+    };
+
+    int concurrency() const;
+    TranscriptionBackend* createBackend(int slot);
+    // Starts queued jobs on idle slots, up to the concurrency limit
+    void schedule();
+    void finishJob(int slot, quint64 id, const TranscriptionResult* result,
+                   const QString& error);
+    int rowOf(quint64 id) const;
+    int runningCount() const;
+    void jobChanged(int row);
+
+    QVector<Job> m_jobs;
+    QVector<Slot> m_slots;
+    quint64 m_nextId;
+    bool m_paused;
+    Stats m_totals; // Since the batch began; queued and running are counted from m_jobs
+    QElapsedTimer m_activeTimer; // Running while any job is
+};
+
+#endif // BATCHTRANSCRIBER_H
@@ -0,0 +1,37 @@
+#ifndef CHUNKARENADEVICE_H
+#define CHUNKARENADEVICE_H
+
+#include "ChunkArena.h"
+#include <QByteArray>
+#include <QIODevice>
+#include <memory>
+
+// Read-only, seekable view of a finished recording held in a ChunkArena, with
+// an optional prefix (the WAV header) in front of it.
+//
+// Reads go straight from the arena's chunks into the caller's buffer: no
+// contiguous copy of the recording is ever made, and the device is opened
+// unbuffered so QIODevice doesn't add one. Because it is seekable and knows its
+// size, the network stack can rewind it when a request is retried.
+class ChunkArenaDevice : public QIODevice {
+    Q_OBJECT
+
+  public:
+    ChunkArenaDevice(std::shared_ptr<const ChunkArena> arena, const QByteArray& prefix,
+                     QObject* parent = nullptr);
+
+    bool isSequential() const override {
+        return false;
+    }
+    qint64 size() const override;
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+  private:
+    std::shared_ptr<const ChunkArena> m_arena;
+    QByteArray m_prefix;
+};
+
+#endif // CHUNKARENADEVICE_H
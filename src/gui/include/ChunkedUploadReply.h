@@ -0,0 +1,74 @@
+#ifndef CHUNKEDUPLOADREPLY_H
+#define CHUNKEDUPLOADREPLY_H
+
+#include <QByteArray>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QTimer>
+
+class QTcpSocket;
+class StreamingUploadDevice;
+
+// A POST whose body goes out with HTTP/1.1 chunked transfer encoding while it is
+// still being written.
+//
+// QNetworkAccessManager buffers a body of unknown length until it ends, whatever
+// DoNotBufferUploadDataAttribute says, so a streamed upload would only leave once
+// recording stops. This reply speaks HTTP/1.1 over a socket of its own instead:
+// whatever the body has when it signals readyRead goes out as one chunk, and the
+// last chunk follows once it reaches its end. The response reads like that of any
+// other QNetworkReply: status and headers as attributes and raw headers, the body
+// through read().
+//
+// The request's transferTimeout() limits how long connecting may take and how long
+// queued body bytes may sit unsent; the reply then fails with TimeoutError. Waiting
+// for the response after the body is complete is up to the caller. One connection
+// per reply, no redirects, proxies only as the socket supports them.
+class ChunkedUploadReply : public QNetworkReply {
+    Q_OBJECT
+
+  public:
+    // Starts connecting once control returns to the event loop, so signals can be
+    // connected first
+    ChunkedUploadReply(const QNetworkRequest& request, StreamingUploadDevice* body,
+                       QObject* parent = nullptr);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+  private:
+    void connectToServer();
+    void sendHead();
+    void sendBody();
+    void handleBytesWritten(qint64 bytes);
+    void readResponse();
+    bool parseHead();
+    bool parseChunkedBody();
+    void handleDisconnected();
+    void complete();
+    void fail(NetworkError code, const QString& message);
+    void armStallTimer(bool progress);
+
+    QPointer<StreamingUploadDevice> m_body;
+    QTcpSocket* m_socket;
+    QTimer m_stallTimer;
+    bool m_headSent;
+    bool m_bodyDone;
+    bool m_requestSent;
+    qint64 m_bytesSent;
+
+    QByteArray m_incoming; // received, not yet parsed
+    QByteArray m_content;  // response body, not yet read
+    bool m_headParsed;
+    bool m_chunked;
+    qint64 m_contentLength; // -1 when the body runs until the connection closes
+    qint64 m_contentReceived;
+    qint64 m_chunkRemaining; // of the current chunk's data; 0 before the next size line
+    bool m_chunkEndPending;  // the CRLF that ends a chunk's data
+};
+
+#endif // CHUNKEDUPLOADREPLY_H
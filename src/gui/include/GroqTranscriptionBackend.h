@@ -0,0 +1,137 @@
+#ifndef GROQTRANSCRIPTIONBACKEND_H
+#define GROQTRANSCRIPTIONBACKEND_H
+
+#include "RequestPolicy.h"
+#include "TranscriptionBackend.h"
+#include <QHash>
+#include <QHttpMultiPart>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSet>
+#include <functional>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#endif
+
+// Transcribes through Groq's OpenAI-compatible Whisper endpoint, using the
+// API key and whisper-* model from Config.
+class GroqTranscriptionBackend : public TranscriptionBackend {
+    Q_OBJECT
+
+  public:
+    explicit GroqTranscriptionBackend(QObject* parent = nullptr);
+
+    QString name() const override {
+        return "groq";
+    }
+    QString modelName() const override {
+        return currentModel();
+    }
+
+    // Resolves the API host and opens the TLS connection (HTTP/2 if offered) ahead
+    // of the first request; the connection manager keeps it for later requests.
+    void prepare() override;
+
+    void transcribeFile(quint64 request, const QString& filePath) override;
+    void transcribeData(quint64 request, const QByteArray& data, const QString& fileName,
+                        const QString& contentType) override;
+    bool acceptsCompressedAudio() const override {
+        return true;
+    }
+
+    // Splits a long WAV recording at pauses and transcribes the pieces concurrently
+    // (up to Config::getMaxParallelUploads() at once), then emits one stitched
+    // result. Short or foreign-format files go through transcribeFile().
+    bool supportsSegmentation() const override {
+        return true;
+    }
+    void transcribeFileSegmented(quint64 request, const QString& filePath) override;
+    void transcribeDataSegmented(quint64 request, const QByteArray& wav,
+                                 const QString& fileName) override;
+
+    // Uploads straight from the device (e.g. a recording kept in memory); it is
+    // reopened through openDevice for every retry or hedge
+    void transcribeDevice(quint64 request, const DeviceFactory& openDevice, qint64 size,
+                          const QString& fileName, const QString& contentType) override;
+
+    // The request is opened before recording ends and the returned device is fed
+    // with audio bytes while capturing. header is sent first (the WAV header for raw
+    // PCM, empty for self-describing formats). The body goes out as it arrives, with
+    // chunked transfer over a connection of its own (see ChunkedUploadReply). Returns
+    // null if the request cannot be started (e.g. no API key).
+    bool supportsStreaming() const override {
+        return true;
+    }
+    QSharedPointer<StreamingUploadDevice> startStreaming(quint64 request, const QString& fileName,
+                                                         const QString& contentType,
+                                                         const QByteArray& header) override;
+    void finishStreaming(const QSharedPointer<StreamingUploadDevice>& device) override;
+
+    // Aborts the request's uploads, including retries, hedges and segments
+    void cancel(quint64 request) override;
+
+  private:
+    struct SegmentedJob;
+    struct StreamingUpload {
+        quint64 request = 0;
+        QByteArray boundary; // of the multipart body
+        QNetworkReply* reply = nullptr;
+    };
+    // Adds the audio part to a freshly built request body
+    using FilePartBuilder = std::function<void(QHttpMultiPart*)>;
+
+    QString currentModel() const;
+    // timestamp_granularities[] values to send; empty for the API default (segments)
+    static QList<QByteArray> timestampGranularities();
+    bool validateApiKey(quint64 request, const QString& apiKey);
+    QUrl apiUrl() const;
+
+    QNetworkRequest transcriptionRequest(const QString& apiKey) const;
+    void trackTiming(quint64 request, QNetworkReply* reply);
+    // Uploaded bytes plus upload and server time histograms
+    static void recordMetrics(const RequestTiming& timing);
+    // Sends through m_requestPolicy; done gets the winning or last failed reply.
+    // Returns the policy's id for cancelling.
+    int sendTranscriptionRequest(quint64 request, const QString& apiKey,
+                                 const FilePartBuilder& appendFilePart, qint64 payloadBytes,
+                                 const RequestPolicy::Handler& done);
+    // One upload answering the whole request, handled by handleTranscriptionResponse()
+    void sendSingleRequest(quint64 request, const QString& apiKey,
+                           const FilePartBuilder& appendFilePart, qint64 payloadBytes);
+    QNetworkReply* postTranscriptionRequest(quint64 request, const QString& apiKey,
+                                            QHttpMultiPart* multiPart);
+    static QHttpPart audioFilePart(const QString& fileName, const QString& contentType);
+    bool parseTranscriptionReply(QNetworkReply* reply, TranscriptionResult& result,
+                                 QString& error);
+    void handleTranscriptionResponse(quint64 request, QNetworkReply* reply);
+    // Loads the WAV and plans its segments on the thread pool, then starts the job
+    // back on the GUI thread, or calls fallback if the WAV can't be split (foreign
+    // format, or short enough already)
+    using WavLoader = std::function<QByteArray()>;
+    void startSegmentedJob(quint64 request, const QString& apiKey, const WavLoader& load,
+                           const QString& baseName, const std::function<void()>& fallback);
+    // Safe on any thread; null if the WAV can't be split
+    static QSharedPointer<SegmentedJob> planSegmentedJob(const QByteArray& wav);
+    void startPendingSegments(const QSharedPointer<SegmentedJob>& job);
+    void handleSegmentResponse(QNetworkReply* reply, const QSharedPointer<SegmentedJob>& job,
+                               int index);
+
+    QNetworkAccessManager* m_networkManager;
+    RequestPolicy* m_requestPolicy;
+#if QT_CONFIG(ssl)
+    QSslConfiguration m_sslConfiguration;
+#endif
+    double m_prewarmDnsMs; // lookup time from prepare(), until a request reports it
+    const QString API_URL = "https://api.groq.com/openai/v1/audio/transcriptions";
+    // Requests still waiting for an answer, so cancel() can find them: single
+    // uploads by their RequestPolicy id, segmented ones by their job, or while
+    // still being planned by request alone
+    QHash<quint64, int> m_policyIds;
+    QHash<quint64, QSharedPointer<SegmentedJob>> m_segmentedJobs;
+    QSet<quint64> m_planningRequests;
+    // Streaming uploads whose reply hasn't finished, by body device
+    QHash<const StreamingUploadDevice*, StreamingUpload> m_streamingUploads;
+};
+
+#endif // GROQTRANSCRIPTIONBACKEND_H
@@ -0,0 +1,54 @@
+#ifndef LOCALWHISPERBACKEND_H
+#define LOCALWHISPERBACKEND_H
+
+#include "TranscriptionBackend.h"
+#include <memory>
+
+// Transcribes in-process with whisper.cpp on the CPU, so dictation works offline
+// and without a network round trip.
+//
+// Inference runs on a worker thread shared by every instance (dictation and batch
+// transcription), so the ggml model is resident only once. It is loaded on first
+// use (or by preloadModel()) and stays until the model choice changes or the last
+// backend is destroyed; jobs from all instances queue up behind each other.
+// Input must be WAV (PCM16 or float); anything not 16 kHz mono is converted first.
+class LocalWhisperBackend : public TranscriptionBackend {
+    Q_OBJECT
+
+  public:
+    explicit LocalWhisperBackend(QObject* parent = nullptr);
+    ~LocalWhisperBackend() override;
+
+    QString name() const override {
+        return "local";
+    }
+    QString modelName() const override;
+
+    void transcribeFile(quint64 request, const QString& filePath) override;
+    void transcribeData(quint64 request, const QByteArray& data, const QString& fileName,
+                        const QString& contentType) override;
+    // Drops the job if it is still queued, or cuts its inference short
+    void cancel(quint64 request) override;
+
+    // Starts loading the configured model in the background so the first
+    // dictation doesn't pay for it
+    void preloadModel();
+    void prepare() override {
+        preloadModel();
+    }
+
+    // Quantized ggml models the settings offer, e.g. "base-q5_1"
+    static QStringList availableModels();
+    // ggml-<model>.bin under the app data "models" directory
+    static QString modelPath(const QString& model);
+
+  private:
+    struct Engine;
+    struct Worker;
+
+    void runJob(quint64 request, const QByteArray& wav, const QString& source);
+
+    std::shared_ptr<Worker> m_worker;
+};
+
+#endif // LOCALWHISPERBACKEND_H
@@ -0,0 +1,29 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+#include <QString>
+
+// Categories for qCDebug()/qCInfo()/qCWarning(); enable or silence them with
+// QT_LOGGING_RULES, e.g. "vibeco.audio.debug=false". Release builds define
+// QT_NO_DEBUG_OUTPUT, which compiles debug-level messages out entirely.
+Q_DECLARE_LOGGING_CATEGORY(lcAudio)
+Q_DECLARE_LOGGING_CATEGORY(lcTranscription)
+Q_DECLARE_LOGGING_CATEGORY(lcConfig)
+Q_DECLARE_LOGGING_CATEGORY(lcUi)
+Q_DECLARE_LOGGING_CATEGORY(lcHotkey)
+Q_DECLARE_LOGGING_CATEGORY(lcStartup)
+Q_DECLARE_LOGGING_CATEGORY(lcMetrics)
+
+// Routes all Qt log output through a background thread that formats it and
+// appends it to a rotating file (and stderr). Logging from any thread only
+// copies the message into a queue; past a sustained rate, or when the queue is
+// full, messages are dropped and the drop is noted in the log.
+namespace Logging {
+    // Starts writing to directory/vibeco.log, keeping a few rotated files
+    void install(const QString& directory);
+    // Writes out what is queued and restores Qt's default output
+    void shutdown();
+} // namespace Logging
+
+#endif // LOGGING_H
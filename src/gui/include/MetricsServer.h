@@ -0,0 +1,33 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+
+class QTcpServer;
+class QTcpSocket;
+
+// Serves Metrics::Registry in the Prometheus text format at GET /metrics, on the
+// loopback interface only. A scrape is one small GET, so every connection gets a
+// single response and is closed: no keep-alive, no request bodies.
+class MetricsServer : public QObject {
+    Q_OBJECT
+
+  public:
+    explicit MetricsServer(QObject* parent = nullptr);
+
+    // (Re)starts listening on 127.0.0.1:port; port 0 just stops the server.
+    // False if the port could not be bound.
+    bool listen(quint16 port);
+    void close();
+    bool isListening() const;
+
+  private:
+    void handleConnection();
+    void handleRequest(QTcpSocket* socket);
+    static void respond(QTcpSocket* socket, const QByteArray& status,
+                        const QByteArray& contentType, const QByteArray& body);
+
+    QTcpServer* m_server;
+};
+
+#endif // METRICSSERVER_H
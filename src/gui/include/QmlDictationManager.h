@@ -4,6 +4,7 @@
 #include <QObject>
 #include <QQmlApplicationEngine>
 #include <QQuickWindow>
+#include <QVariantList>
 
 class QmlDictationManager : public QObject
 {
@@ -14,9 +15,12 @@ public:
     ~QmlDictationManager();
 
     public slots:
-        void showDictationWidget();
+        // Builds the dictation window ahead of its first use
+        void preload();
+    void showDictationWidget();
     void hideDictationWidget();
     void setRecordingState(bool recording);
+    void setLevels(qreal level, const QVariantList& waveform);
 
     signals:
         void dictationWidgetClicked();
@@ -0,0 +1,84 @@
+#ifndef REQUESTPOLICY_H
+#define REQUESTPOLICY_H
+
+#include <QDeadlineTimer>
+#include <QHash>
+#include <QNetworkReply>
+#include <QObject>
+#include <QSharedPointer>
+#include <functional>
+#include <vector>
+
+// Sends a request with a deadline, retries and optional hedging.
+//
+// Every attempt gets a timeout scaled to the payload size, all within an overall
+// deadline. Transport errors, timeouts and retryable statuses (408, 429, 5xx) are
+// retried with exponential backoff and full jitter, honouring Retry-After. With
+// hedging on, a duplicate request goes out once an attempt has been running for
+// longer than the observed p95 latency for its payload size; the first good
+// response wins and the other request is aborted.
+//
+// The request body is rebuilt for every attempt by the Sender, since Qt consumes
+// it. The Handler sees exactly one reply: the winner, or the last failure.
+class RequestPolicy : public QObject {
+    Q_OBJECT
+
+  public:
+    using Sender = std::function<QNetworkReply*()>;
+    using Handler = std::function<void(QNetworkReply*)>;
+
+    // Set on a reply that was aborted because its attempt ran out of time
+    static constexpr const char* kTimedOutProperty = "vibecoTimedOut";
+
+    struct Stats {
+        quint64 requests = 0;
+        quint64 attempts = 0;
+        quint64 retries = 0;
+        quint64 timeouts = 0;
+        quint64 hedges = 0;
+        quint64 hedgeWins = 0; // the duplicate answered first
+        quint64 failures = 0;
+    };
+
+    explicit RequestPolicy(QObject* parent = nullptr);
+
+    void setHedgingEnabled(bool enabled) {
+        m_hedging = enabled;
+    }
+
+    // Starts a request carrying payloadBytes of body. Returns an id for cancel().
+    int send(const Sender& sender, qint64 payloadBytes, const Handler& done);
+    // Aborts everything in flight for the request; its Handler is not called
+    void cancel(int id);
+
+    const Stats& stats() const {
+        return m_stats;
+    }
+    // Latency after which a hedge of a request carrying payloadBytes is sent, or -1
+    // until enough requests were seen
+    qint64 hedgeDelayMs(qint64 payloadBytes) const;
+    // How long one attempt carrying payloadBytes may take; also the deadline for
+    // requests that can't be replayed and so don't go through send()
+    static qint64 attemptTimeoutMs(qint64 payloadBytes);
+
+  private:
+    struct Call;
+
+    void startAttempt(const QSharedPointer<Call>& call);
+    void launch(const QSharedPointer<Call>& call, bool hedge);
+    void handleFinished(const QSharedPointer<Call>& call, QNetworkReply* reply);
+    void finish(const QSharedPointer<Call>& call, QNetworkReply* reply);
+    void abortActive(const QSharedPointer<Call>& call);
+    static bool isRetryable(QNetworkReply* reply);
+    static qint64 retryAfterMs(QNetworkReply* reply);
+    void recordLatency(qint64 ms, qint64 payloadBytes);
+
+    QHash<int, QSharedPointer<Call>> m_calls;
+    int m_nextId;
+    bool m_hedging;
+    Stats m_stats;
+    std::vector<double> m_latencies; // ring of recent successful latencies, in ms per MiB
+    size_t m_latencyNext;
+};
+
+#endif // REQUESTPOLICY_H
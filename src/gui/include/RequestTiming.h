@@ -0,0 +1,37 @@
+#ifndef REQUESTTIMING_H
+#define REQUESTTIMING_H
+
+#include <QString>
+#include <functional>
+
+class QNetworkReply;
+
+// Where the time of one HTTP request went, in milliseconds (-1 if the phase
+// didn't happen, e.g. no handshake on a reused connection).
+//
+// Qt opens the socket and resolves the host in one step and does not report
+// TCP connect and TLS separately, so connectMs covers all of it. dnsMs is the
+// lookup done when the connection was pre-warmed, if it was.
+struct RequestTiming {
+    QString host;
+    bool reusedConnection = true; // no new socket was opened for this request
+    bool http2 = false;
+    double dnsMs = -1.0;
+    double connectMs = -1.0;   // socket connect + TLS handshake
+    double uploadMs = -1.0;    // until the whole body was handed to the socket
+    double firstByteMs = -1.0; // request sent -> response headers
+    double downloadMs = -1.0;  // response headers -> last byte
+    double totalMs = -1.0;
+    // Processing time the server reported in its response headers, if it did
+    double serverMs = -1.0;
+    qint64 bytesSent = 0; // request body handed to the socket, headers excluded
+
+    QString summary() const;
+};
+
+// Records the phases of reply as they happen and calls done once it finishes.
+// Attach right after QNetworkAccessManager::post().
+void trackRequestTiming(QNetworkReply* reply, double dnsMs,
+                        std::function<void(const RequestTiming&)> done);
+
+#endif // REQUESTTIMING_H
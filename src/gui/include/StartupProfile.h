@@ -0,0 +1,19 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+// Milestones of application startup, in milliseconds since main() began.
+//
+// Each milestone is logged once, when first reached. In benchmark mode (the
+// --startup-benchmark flag) the app also prints all of them on one stdout line,
+// "startup tray_icon_ms=... ready_to_record_ms=...", once it is ready to record,
+// and quits; benchmarks/StartupBenchmark.cpp runs it that way.
+namespace StartupProfile {
+    void begin(bool benchmark);
+
+    // name is a snake_case identifier, e.g. "tray_icon"
+    void mark(const char* name);
+    // The last milestone; ends the run in benchmark mode
+    void markReady();
+} // namespace StartupProfile
+
+#endif // STARTUPPROFILE_H
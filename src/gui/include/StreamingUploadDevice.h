@@ -0,0 +1,52 @@
+#ifndef STREAMINGUPLOADDEVICE_H
+#define STREAMINGUPLOADDEVICE_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+
+// Sequential request body that is filled while it is being uploaded.
+//
+// The audio writer thread appends captured bytes with appendData(); the network
+// stack reads them on the GUI thread. readData() reports "no data yet" until
+// finish() is called, after which the device reaches end-of-stream.
+class StreamingUploadDevice : public QIODevice {
+    Q_OBJECT
+
+  public:
+    explicit StreamingUploadDevice(QObject* parent = nullptr);
+
+    // Thread-safe producer side
+    void appendData(const QByteArray& data);
+    void finish();
+    // Gives up on the body: nothing more is read from it, and it is closed on its
+    // own thread, since close() must not run concurrently with the network stack
+    void abort();
+
+    bool isFinished() const;
+    // Closed or aborted; unlike isOpen(), true as soon as abort() returns
+    bool isClosed() const;
+    qint64 totalBytesAppended() const;
+
+    bool isSequential() const override {
+        return true;
+    }
+    bool atEnd() const override;
+    qint64 bytesAvailable() const override;
+    void close() override;
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+  private:
+    void notifyReadyRead();
+
+    mutable QMutex m_mutex;
+    QByteArray m_pending;
+    qint64 m_totalAppended;
+    bool m_finished;
+    bool m_closed;
+};
+
+#endif // STREAMINGUPLOADDEVICE_H
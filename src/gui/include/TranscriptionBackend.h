@@ -0,0 +1,104 @@
+#ifndef TRANSCRIPTIONBACKEND_H
+#define TRANSCRIPTIONBACKEND_H
+
+#include "RequestTiming.h"
+#include "TranscriptionResult.h"
+#include <QByteArray>
+#include <QIODevice>
+#include <QObject>
+#include <QSharedPointer>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class StreamingUploadDevice;
+
+// Something that turns a recording into text: the Groq API or an in-process model.
+//
+// Results are reported in the backend's own terms (times relative to the audio it
+// was given, duration negative if unknown); TranscriptionService maps them back to
+// the saved recording. Everything is called and signalled on the GUI thread.
+//
+// Any number of requests may be in flight at once. Each is named by an ID the
+// caller picks, and every signal about a request carries that ID, possibly before
+// the call that started it has returned.
+class TranscriptionBackend : public QObject {
+    Q_OBJECT
+
+  public:
+    explicit TranscriptionBackend(QObject* parent = nullptr) : QObject(parent) {}
+
+    virtual QString name() const = 0;
+    // Model that will handle the next request
+    virtual QString modelName() const = 0;
+
+    // Called when a recording starts, so slow setup (connections, model loading)
+    // is done by the time the audio is ready
+    virtual void prepare() {}
+
+    virtual void transcribeFile(quint64 request, const QString& filePath) = 0;
+    virtual void transcribeData(quint64 request, const QByteArray& data, const QString& fileName,
+                                const QString& contentType) = 0;
+
+    // Opens a new read-only device over the same bytes on every call
+    using DeviceFactory = std::function<QIODevice*(QObject* parent)>;
+    // Audio that only exists in memory but not as one contiguous buffer (see
+    // ChunkArenaDevice). By default it is read into a QByteArray for transcribeData().
+    virtual void transcribeDevice(quint64 request, const DeviceFactory& openDevice, qint64 size,
+                                  const QString& fileName, const QString& contentType) {
+        Q_UNUSED(size);
+        std::unique_ptr<QIODevice> device(openDevice(nullptr));
+        transcribeData(request, device->readAll(), fileName, contentType);
+    }
+
+    // Whether transcribeData() takes FLAC/Ogg Opus; otherwise it needs a WAV file
+    virtual bool acceptsCompressedAudio() const {
+        return false;
+    }
+
+    // Optional: splitting long recordings into concurrent requests
+    virtual bool supportsSegmentation() const {
+        return false;
+    }
+    virtual void transcribeFileSegmented(quint64 request, const QString& filePath) {
+        transcribeFile(request, filePath);
+    }
+    virtual void transcribeDataSegmented(quint64 request, const QByteArray& wav,
+                                         const QString& fileName) {
+        transcribeData(request, wav, fileName, "audio/wav");
+    }
+
+    // Optional: uploading while recording. Backends without it return null.
+    virtual bool supportsStreaming() const {
+        return false;
+    }
+    virtual QSharedPointer<StreamingUploadDevice> startStreaming(quint64 request,
+                                                                 const QString& fileName,
+                                                                 const QString& contentType,
+                                                                 const QByteArray& header) {
+        Q_UNUSED(request);
+        Q_UNUSED(fileName);
+        Q_UNUSED(contentType);
+        Q_UNUSED(header);
+        return {};
+    }
+    virtual void finishStreaming(const QSharedPointer<StreamingUploadDevice>& device) {
+        Q_UNUSED(device);
+    }
+
+    // Stops work on a request nobody is waiting for any more. Signals already on
+    // their way may still arrive; unknown and finished requests are ignored.
+    virtual void cancel(quint64 request) {
+        Q_UNUSED(request);
+    }
+
+  signals:
+    void transcriptionComplete(quint64 request, const TranscriptionResult& result);
+    void transcriptionError(quint64 request, const QString& error);
+    void uploadProgress(quint64 request, qint64 bytesSent, qint64 bytesTotal);
+    void requestTimed(quint64 request, const RequestTiming& timing);
+    void processingStarted(quint64 request);
+    void processingFinished(quint64 request);
+};
+
+#endif // TRANSCRIPTIONBACKEND_H
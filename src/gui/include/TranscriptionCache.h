@@ -0,0 +1,51 @@
+#ifndef TRANSCRIPTIONCACHE_H
+#define TRANSCRIPTIONCACHE_H
+
+#include "TranscriptionBackend.h"
+#include <QByteArray>
+#include <QHash>
+#include <QIODevice>
+#include <QString>
+
+// Persistent cache of transcription results, keyed by the content of the audio
+// that would be sent plus everything else that affects the answer (backend,
+// model, request format). Entries are small JSON files in one directory; the
+// least recently used ones are deleted once the directory outgrows maxBytes.
+// GUI thread only.
+class TranscriptionCache {
+  public:
+    struct Stats {
+        quint64 hits = 0;
+        quint64 misses = 0;
+        quint64 stores = 0;
+        quint64 evictions = 0;
+        qint64 bytes = 0;
+        int entries = 0;
+    };
+
+    TranscriptionCache(const QString& directory, qint64 maxBytes);
+
+    // XXH64 of the audio and of the parameters, as hex. Empty if the file can't be read.
+    static QString keyFor(const QByteArray& audio, const QString& parameters);
+    static QString keyForFile(const QString& filePath, const QString& parameters);
+    static QString keyForDevice(QIODevice* device, const QString& parameters);
+
+    bool lookup(const QString& key, TranscriptionResult& result);
+    void store(const QString& key, const TranscriptionResult& result);
+
+  private:
+    struct Entry {
+        qint64 size;
+        qint64 lastUsed; // ms since epoch, mirrored in the file's mtime
+    };
+
+    QString entryPath(const QString& key) const;
+    void evict();
+
+    QString m_directory;
+    qint64 m_maxBytes;
+    QHash<QString, Entry> m_entries;
+    Stats m_stats;
+};
+
+#endif // TRANSCRIPTIONCACHE_H
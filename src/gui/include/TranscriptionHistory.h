@@ -0,0 +1,97 @@
+#ifndef TRANSCRIPTIONHISTORY_H
+#define TRANSCRIPTIONHISTORY_H
+
+#include "HistoryLog.h"
+#include "TranscriptionResult.h"
+#include <QAbstractListModel>
+#include <QCache>
+#include <QVector>
+#include <vector>
+
+// Every transcription, newest first, kept on disk across restarts.
+//
+// Entries live in an append-only HistoryLog; deletions are a second log of
+// tombstones. Only row -> record numbers are held in memory. Rows are handed to
+// views a page at a time through canFetchMore()/fetchMore(), entry text is read
+// from disk when a row is first shown (a page of neighbours at once) and kept in
+// a bounded cache, and new entries are inserted as single rows at the top.
+class TranscriptionHistory : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+  public:
+    enum Role {
+        TextRole = Qt::UserRole + 1,
+        TimestampRole,
+        DurationRole,
+        LanguageRole,
+    };
+
+    struct Entry {
+        QString text;
+        QString language;
+        double duration = 0.0;
+        qint64 createdMs = 0;
+        bool valid = false;
+    };
+
+    // Keeps its files in directory
+    explicit TranscriptionHistory(const QString& directory, QObject* parent = nullptr);
+
+    QString logPath() const {
+        return m_directory + "/history.log";
+    }
+    QString directory() const {
+        return m_directory;
+    }
+    // Record numbers of the entries not deleted, oldest first
+    const std::vector<quint32>& records() const {
+        return m_records;
+    }
+    // Records in the log, deleted or not; the next entry gets this number
+    quint32 recordCount() const {
+        return static_cast<quint32>(m_log.size());
+    }
+    // A record as stored in the log; valid is false if it can't be read
+    static Entry decode(const std::string& payload);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex& parent) const override;
+    void fetchMore(const QModelIndex& parent) override;
+
+    // All entries, including rows not fetched yet
+    int count() const;
+
+    void append(const TranscriptionResult& result);
+    Q_INVOKABLE void remove(int row);
+    // Deletes an entry whether or not its row has been fetched
+    void removeRecord(quint32 record);
+    Q_INVOKABLE void clear();
+    Q_INVOKABLE void copyText(int row) const;
+
+  signals:
+    void countChanged();
+    void entryAdded(quint32 record, const QString& text);
+    void entryRemoved(quint32 record);
+    void cleared();
+
+  private:
+    using Page = QVector<Entry>;
+
+    static QByteArray encode(const TranscriptionResult& result, qint64 createdMs);
+
+    // Record number in m_log for a row; rows run newest first
+    quint32 recordForRow(int row) const;
+    const Entry& entry(int row) const;
+
+    QString m_directory;
+    mutable HistoryLog m_log;
+    HistoryLog m_tombstones; // Record numbers of deleted entries
+    std::vector<quint32> m_records; // Live entries, oldest first
+    int m_fetched;                  // Rows exposed to views so far
+    mutable QCache<quint32, Page> m_pages;
+};
+
+#endif // TRANSCRIPTIONHISTORY_H
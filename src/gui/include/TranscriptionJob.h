@@ -0,0 +1,42 @@
+#ifndef TRANSCRIPTIONJOB_H
+#define TRANSCRIPTIONJOB_H
+
+#include "SilenceTrimmer.h"
+#include "TranscriptionResult.h"
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QString>
+
+class TranscriptionBackend;
+
+// One request made through TranscriptionService, from submission until its result
+// or error has been delivered. Everything needed to turn the backend's answer into
+// a result for the right recording travels with the job, so any number of them can
+// be in flight without one's answer being read against another's recording.
+struct TranscriptionJob {
+    // What the caller knows about the audio, besides the audio itself
+    struct Metadata {
+        // Length of the recording, used when the backend doesn't report one
+        double recordingDuration = -1.0;
+        // From the uploaded (silence-trimmed) audio back to the saved recording
+        SilenceTrimmer::TimeMap trimMap;
+        // Latency trace the request belongs to; 0 for none
+        uint64_t traceDictation = 0;
+    };
+
+    enum class State { Running, Done, Failed };
+
+    quint64 id = 0;         // Increases in submission order
+    QString source;         // File path or upload name
+    QString mode;           // "file", "segmented" or "streaming"
+    Metadata metadata;
+    QPointer<TranscriptionBackend> backend;
+    QString cacheKey;       // Where the result is stored; empty if it can't be cached
+    State state = State::Running;
+    TranscriptionResult result{}; // Mapped onto the recording once Done
+    QString error;                // Once Failed
+    QElapsedTimer submitted;
+    qint64 answeredMs = -1; // From submission to the backend's answer
+};
+
+#endif // TRANSCRIPTIONJOB_H
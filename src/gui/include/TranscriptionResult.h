@@ -0,0 +1,26 @@
+#ifndef TRANSCRIPTIONRESULT_H
+#define TRANSCRIPTIONRESULT_H
+
+#include "TranscriptSegments.h"
+#include <QByteArray>
+#include <QString>
+
+struct TranscriptionResult {
+    QString text;           // The transcribed text
+    QString language;       // Detected language
+    double duration;        // Audio duration in seconds
+    QString task;          // Task type (e.g., "transcribe")
+    QString requestId;      // Request ID from Groq
+
+    // Every segment, and every word if word timestamps were requested
+    TranscriptSegments segments;
+
+    // From a verbose_json response (or a cache entry written by toVerboseJson()).
+    // False, with error set, if it isn't one.
+    static bool fromVerboseJson(const QByteArray& json, TranscriptionResult& result,
+                                QString& error);
+    // Compact verbose_json with only the fields fromVerboseJson() reads
+    QByteArray toVerboseJson() const;
+};
+
+#endif // TRANSCRIPTIONRESULT_H
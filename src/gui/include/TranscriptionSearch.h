@@ -0,0 +1,79 @@
+#ifndef TRANSCRIPTIONSEARCH_H
+#define TRANSCRIPTIONSEARCH_H
+
+#include "TranscriptionHistory.h"
+#include <QAbstractListModel>
+#include <QThread>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+// Full-text search over the transcription history, as a list model of the best
+// matches for query.
+//
+// The inverted index (SearchIndex) is saved next to the history as search.idx
+// and kept current as entries are added, deleted or cleared. At startup it is
+// loaded and only entries written since it was last saved are indexed; if it is
+// missing or damaged the whole history is indexed again. Loading, indexing and
+// queries all run on a worker thread; a query overtaken by a newer one is
+// dropped unanswered, so typing never queues up work.
+class TranscriptionSearch : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(QString query READ query WRITE setQuery NOTIFY queryChanged)
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+  public:
+    enum Role {
+        TextRole = Qt::UserRole + 1,
+        // The text as rich text, matched words in bold
+        HighlightedTextRole,
+        TimestampRole,
+        DurationRole,
+        LanguageRole,
+    };
+
+    explicit TranscriptionSearch(TranscriptionHistory* history, QObject* parent = nullptr);
+    ~TranscriptionSearch() override;
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    QString query() const {
+        return m_query;
+    }
+    void setQuery(const QString& query);
+    int count() const {
+        return m_results.size();
+    }
+
+    Q_INVOKABLE void remove(int row);
+    Q_INVOKABLE void copyText(int row) const;
+
+  signals:
+    void queryChanged();
+    void countChanged();
+
+  private:
+    struct Engine;
+    struct Result {
+        quint32 record = 0;
+        TranscriptionHistory::Entry entry;
+        QString highlighted;
+    };
+
+    void runQuery();
+    void showResults(quint64 generation, const QVector<Result>& results);
+    void handleEntryRemoved(quint32 record);
+
+    TranscriptionHistory* m_history;
+    QString m_query;
+    QVector<Result> m_results;
+    std::atomic<quint64> m_generation; // Of the latest query; older ones are dropped
+
+    QThread m_thread;
+    QObject* m_worker; // lives on m_thread; context for queued jobs
+    std::unique_ptr<Engine> m_engine; // only touched on m_thread
+};
+
+#endif // TRANSCRIPTIONSEARCH_H
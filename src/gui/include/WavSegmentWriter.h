@@ -0,0 +1,62 @@
+#ifndef WAVSEGMENTWRITER_H
+#define WAVSEGMENTWRITER_H
+
+#include "WavFile.h"
+#include <QFile>
+#include <QString>
+#include <QStringList>
+
+// Writes a recording as one or more WAV files whose headers stay valid while
+// they grow.
+//
+// The header is rewritten every few seconds of audio, so a crash or power loss
+// leaves a playable file that is at most that much short. A new segment file
+// ("<name>_002.wav", ...) is started when the current one reaches the size or
+// duration limit; with RF64 off, a segment also ends before it would outgrow
+// what a 32-bit RIFF header can describe. Nothing is buffered beyond QFile's
+// own write buffer, so memory use doesn't depend on how long the session runs.
+//
+// open() and close() are called with the writer thread stopped; write() runs on it.
+class WavSegmentWriter {
+  public:
+    struct Limits {
+        qint64 maxBytes = 0;   // 0 = no size limit
+        qint64 maxSeconds = 0; // 0 = no duration limit
+        bool rf64 = false;     // Allow files past 4 GiB instead of rolling over
+    };
+
+    WavSegmentWriter();
+    ~WavSegmentWriter();
+
+    bool open(const QString& path, const WavFile::Format& format, const Limits& limits);
+    // Returns the number of bytes written, which is less than size only on error
+    qint64 write(const char* data, qint64 size);
+    // Finalizes the header of the current segment
+    void close();
+
+    bool isOpen() const {
+        return m_file.isOpen();
+    }
+    // Every file of the recording, in order; still valid after close()
+    QStringList segmentPaths() const {
+        return m_segments;
+    }
+
+  private:
+    QString segmentPath(int index) const;
+    bool openSegment();
+    bool finishSegment();
+    bool writeHeader();
+
+    QFile m_file;
+    QString m_path;
+    WavFile::Format m_format;
+    Limits m_limits;
+    qint64 m_segmentLimit;
+    qint64 m_segmentBytes;
+    qint64 m_headerInterval;
+    qint64 m_sinceHeader;
+    QStringList m_segments;
+};
+
+#endif // WAVSEGMENTWRITER_H
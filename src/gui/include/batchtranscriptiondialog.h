@@ -0,0 +1,42 @@
+#ifndef BATCHTRANSCRIPTIONDIALOG_H
+#define BATCHTRANSCRIPTIONDIALOG_H
+
+#include <QComboBox>
+#include <QDialog>
+#include <QLabel>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTableView>
+#include <QTimer>
+
+class BatchTranscriber;
+
+// Queue of existing recordings to transcribe, with controls for it. Closing the
+// dialog doesn't stop the queue.
+class BatchTranscriptionDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit BatchTranscriptionDialog(BatchTranscriber* transcriber, QWidget *parent = nullptr);
+
+private slots:
+    void addFiles();
+    void addFolder();
+    void prioritizeSelected();
+    void updateStats();
+
+private:
+    void setupUi();
+    int selectedPriority() const;
+
+    BatchTranscriber* m_transcriber;
+    QTableView* m_jobsView;
+    QComboBox* m_priorityCombo;
+    QSpinBox* m_concurrencySpin;
+    QPushButton* m_pauseButton;
+    QLabel* m_statsLabel;
+    QTimer m_statsTimer; // Throughput keeps changing while jobs run
+};
+
+#endif // BATCHTRANSCRIPTIONDIALOG_H
@@ -6,35 +6,219 @@
 #include <QStandardPaths>
 #include <QDir>
 #include <QDebug>
+#include <QMutex>
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVariantMap>
+#include <atomic>
+#include <future>
+
+// Settings are read from disk once and served from an in-memory snapshot, so the
+// getters are cheap enough for hot paths and safe to call from any thread. Setters
+// swap in a new snapshot, emit changed() and queue the write; writes arriving close
+// together are coalesced and saved to disk on a worker thread.
+class Config : public QObject {
+    Q_OBJECT
 
-class Config {
 public:
     static Config& instance() {
         static Config instance;
         return instance;
     }
 
+    // Every setting at once, as typed values
+    struct Values {
+        QString apiKey; // Decrypted
+        QString model;
+        QString transcriptionBackend;
+        QString localModel;
+        bool streamingUpload;
+        QString uploadFormat;
+        bool trimSilence;
+        bool wordTimestamps;
+        bool segmentedTranscription;
+        int maxParallelUploads;
+        int batchConcurrency;
+        QString resultOrder;
+        bool hedgeRequests;
+        bool inMemoryRecording;
+        bool saveRecordings;
+        bool longSessionRecording;
+        int segmentMinutes;
+        int segmentMegabytes;
+        bool writeRf64;
+        QString inputDevice;
+        int inputLatencyMs;
+        int bufferFrames;
+        bool adaptiveBuffer;
+        bool alwaysArmed;
+        int preRollMs;
+        int armedIdleMinutes;
+        bool latencyTracing;
+        int metricsPort;
+    };
+
+    // A consistent view of all settings; later changes don't affect it
+    QSharedPointer<const Values> values() const;
+
+    // Setters return false only if the last write to disk failed
+
     QString getApiKey() const;
     bool setApiKey(const QString& key);
     
     QString getModel() const;
     bool setModel(const QString& model);
+
+    // Where transcription runs: "groq" (the API) or "local" (in-process whisper.cpp)
+    QString getTranscriptionBackend() const;
+    bool setTranscriptionBackend(const QString& backend);
+    // ggml model used by the local backend, e.g. "base-q5_1"
+    QString getLocalModel() const;
+    bool setLocalModel(const QString& model);
+
+    bool getStreamingUpload() const;
+    bool setStreamingUpload(bool enabled);
+
+    bool getTrimSilence() const;
+    bool setTrimSilence(bool enabled);
+
+    // Ask for per-word timings as well as per-segment ones (a larger response)
+    bool getWordTimestamps() const;
+    bool setWordTimestamps(bool enabled);
+
+    // Split long recordings at pauses and transcribe the pieces concurrently
+    bool getSegmentedTranscription() const;
+    bool setSegmentedTranscription(bool enabled);
+    int getMaxParallelUploads() const;
+    bool setMaxParallelUploads(int count);
+
+    // Files a batch transcription works on at once
+    int getBatchConcurrency() const;
+    bool setBatchConcurrency(int count);
+
+    // When several transcriptions are in flight, deliver results "submission" (in the
+    // order the recordings were made) or "completion" (as soon as each is back)
+    QString getResultOrder() const;
+    bool setResultOrder(const QString& order);
+
+    // Send a duplicate request when one is slower than usual, keep whichever answers first
+    bool getHedgeRequests() const;
+    bool setHedgeRequests(bool enabled);
+
+    // Keep recordings in memory and upload from there; saving a copy to disk is optional
+    bool getInMemoryRecording() const;
+    bool setInMemoryRecording(bool enabled);
+    bool getSaveRecordings() const;
+    bool setSaveRecordings(bool enabled);
+
+    // Multi-hour sessions: bounded memory, recording split into files of at most this
+    // many minutes / megabytes (0 = unlimited), optionally as RF64 past 4 GiB
+    bool getLongSessionRecording() const;
+    bool setLongSessionRecording(bool enabled);
+    int getSegmentMinutes() const;
+    bool setSegmentMinutes(int minutes);
+    int getSegmentMegabytes() const;
+    bool setSegmentMegabytes(int megabytes);
+    bool getWriteRf64() const;
+    bool setWriteRf64(bool enabled);
+
+    // Capture device by AudioHandler::inputDevices() name; empty for the system default
+    QString getInputDevice() const;
+    bool setInputDevice(const QString& device);
+    // Suggested input latency; 0 uses the device's low-latency default
+    int getInputLatencyMs() const;
+    bool setInputLatencyMs(int milliseconds);
+    // Frames per callback; 0 lets PortAudio pick (and vary) it
+    int getBufferFrames() const;
+    bool setBufferFrames(int frames);
+    // Enlarge the buffer after recordings that kept overflowing
+    bool getAdaptiveBuffer() const;
+    bool setAdaptiveBuffer(bool enabled);
+
+    // Keep the input stream open between recordings and start each one with the last
+    // PreRollMs of audio; the device is released after ArmedIdleMinutes (0: never)
+    bool getAlwaysArmed() const;
+    bool setAlwaysArmed(bool enabled);
+    int getPreRollMs() const;
+    bool setPreRollMs(int milliseconds);
+    int getArmedIdleMinutes() const;
+    bool setArmedIdleMinutes(int minutes);
+
+    // Record hotkey-to-text latency spans in memory, for export as a Chrome trace
+    bool getLatencyTracing() const;
+    bool setLatencyTracing(bool enabled);
+
+    // Localhost port for the Prometheus /metrics endpoint; 0 turns it off
+    int getMetricsPort() const;
+    bool setMetricsPort(int port);
+
+    // Upload encoding: "wav", "flac" or "opus"
+    QString getUploadFormat() const;
+    bool setUploadFormat(const QString& format);
     
     static QString getConfigPath();
 
+    // Writes pending changes to disk now and waits for them
+    void flush();
+
+    // Setting keys, as passed to changed()
+    static const QString KEY_API_KEY;
+    static const QString KEY_MODEL;
+    static const QString KEY_TRANSCRIPTION_BACKEND;
+    static const QString KEY_LOCAL_MODEL;
+    static const QString KEY_STREAMING_UPLOAD;
+    static const QString KEY_UPLOAD_FORMAT;
+    static const QString KEY_TRIM_SILENCE;
+    static const QString KEY_WORD_TIMESTAMPS;
+    static const QString KEY_SEGMENTED_TRANSCRIPTION;
+    static const QString KEY_MAX_PARALLEL_UPLOADS;
+    static const QString KEY_BATCH_CONCURRENCY;
+    static const QString KEY_RESULT_ORDER;
+    static const QString KEY_HEDGE_REQUESTS;
+    static const QString KEY_IN_MEMORY_RECORDING;
+    static const QString KEY_SAVE_RECORDINGS;
+    static const QString KEY_LONG_SESSION_RECORDING;
+    static const QString KEY_SEGMENT_MINUTES;
+    static const QString KEY_SEGMENT_MEGABYTES;
+    static const QString KEY_WRITE_RF64;
+    static const QString KEY_INPUT_DEVICE;
+    static const QString KEY_INPUT_LATENCY_MS;
+    static const QString KEY_BUFFER_FRAMES;
+    static const QString KEY_ADAPTIVE_BUFFER;
+    static const QString KEY_ALWAYS_ARMED;
+    static const QString KEY_PRE_ROLL_MS;
+    static const QString KEY_ARMED_IDLE_MINUTES;
+    static const QString KEY_LATENCY_TRACING;
+    static const QString KEY_METRICS_PORT;
+
+signals:
+    // A setter changed the value of key; emitted on the setter's thread
+    void changed(const QString& key);
+
 private:
     Config(); // Private constructor for singleton
+    ~Config() override;
     Config(const Config&) = delete;
     Config& operator=(const Config&) = delete;
 
-    QSettings m_settings;
-    
+    static Values load(const QSettings& settings);
+    template <typename T>
+    bool update(const QString& key, T Values::*field, const T& value, const QVariant& stored);
+    void writePending();
+
+    mutable QMutex m_mutex;
+    QSharedPointer<const Values> m_values; // Guarded by m_mutex
+    QVariantMap m_pendingWrites;           // Guarded by m_mutex; invalid value = remove
+    QTimer m_writeTimer;
+    std::future<void> m_writing;
+    std::atomic<bool> m_lastWriteOk;
+
     // Constants
     static const QString CONFIG_ORG;
     static const QString CONFIG_APP;
-    static const QString KEY_API_KEY;
-    static const QString KEY_MODEL;
     static const QString DEFAULT_MODEL;
+    static const QString DEFAULT_LOCAL_MODEL;
 };
 
 #endif // VIBECO_CONFIG_H 
\ No newline at end of file
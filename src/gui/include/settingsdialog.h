@@ -4,6 +4,8 @@
 #include <QDialog>
 #include <QLineEdit>
 #include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
 
 class SettingsDialog : public QDialog
 {
@@ -19,8 +21,33 @@ private slots:
 private:
     void setupUi();
     
+    QComboBox* m_backendCombo;
+    QComboBox* m_localModelCombo;
     QLineEdit* m_apiKeyEdit;
     QComboBox* m_modelCombo;
+    QComboBox* m_inputDeviceCombo;
+    QSpinBox* m_bufferFramesSpin;
+    QSpinBox* m_inputLatencySpin;
+    QCheckBox* m_adaptiveBufferCheck;
+    QCheckBox* m_alwaysArmedCheck;
+    QSpinBox* m_preRollSpin;
+    QSpinBox* m_armedIdleSpin;
+    QCheckBox* m_streamingUploadCheck;
+    QCheckBox* m_trimSilenceCheck;
+    QCheckBox* m_wordTimestampsCheck;
+    QCheckBox* m_segmentedCheck;
+    QSpinBox* m_parallelUploadsSpin;
+    QCheckBox* m_hedgeRequestsCheck;
+    QCheckBox* m_inMemoryCheck;
+    QCheckBox* m_saveRecordingsCheck;
+    QCheckBox* m_longSessionCheck;
+    QSpinBox* m_segmentMinutesSpin;
+    QSpinBox* m_segmentMegabytesSpin;
+    QCheckBox* m_rf64Check;
+    QCheckBox* m_latencyTracingCheck;
+    QSpinBox* m_metricsPortSpin;
+    QComboBox* m_uploadFormatCombo;
+    QComboBox* m_resultOrderCombo;
 };
 
 #endif // SETTINGSDIALOG_H 
\ No newline at end of file
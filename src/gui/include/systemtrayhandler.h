@@ -9,6 +9,11 @@
 
 class ShortcutManager;
 class AudioHandler;
+class BatchTranscriber;
+class BatchTranscriptionDialog;
+class MetricsServer;
+class TranscriptionHistory;
+class TranscriptionSearch;
 struct TranscriptionResult;
 
 class SystemTrayHandler : public QObject {
@@ -23,19 +28,34 @@ class SystemTrayHandler : public QObject {
     }
     void setQmlEngine(QQmlApplicationEngine* engine);
     void setMainWindow(QObject* mainWindow);
+    // Every transcription so far, for the main window's list
+    TranscriptionHistory* history() const {
+        return m_history;
+    }
+    TranscriptionSearch* search() const {
+        return m_search;
+    }
+    bool isRecording() const;
 
   public slots:
     void showTranscriptionComplete(const QString& text);
     void showTranscriptionComplete(const TranscriptionResult& result);
     void showSettings();
-    void startRecording();
+    void showBatchTranscription();
+    // traceDictation continues a dictation the caller already started tracing, if not 0
+    void startRecording(uint64_t traceDictation = 0);
     void stopRecording();
-    void handleTranscriptionReceived(const QString& text);
+    void handleTranscriptionReceived(const TranscriptionResult& result);
 
   private slots:
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
     void quit();
     void onDictationWidgetClicked();
+    void saveLatencyTrace();
+    // Startup work that would otherwise delay the first frame
+    void finishStartup();
+    // Re-applies settings that running components depend on
+    void handleConfigChanged(const QString& key);
 
   signals:
     void recordingStarted();
@@ -48,6 +68,7 @@ class SystemTrayHandler : public QObject {
     void showDictationWidget();
     void hideDictationWidget();
     void setupQmlDictationManager();
+    void applyDiagnosticsSettings();
 
     QSystemTrayIcon* m_trayIcon;
     QMenu* trayIconMenu;
@@ -60,6 +81,13 @@ class SystemTrayHandler : public QObject {
     QmlDictationManager* m_dictationManager;
     QQmlApplicationEngine* m_qmlEngine;
     QObject* m_mainWindow; // Reference to the main QML window
+    MetricsServer* m_metricsServer;
+    TranscriptionHistory* m_history;
+    TranscriptionSearch* m_search;
+    BatchTranscriber* m_batchTranscriber; // Created on first use
+    BatchTranscriptionDialog* m_batchDialog;
+    bool m_diagnosticsChanged; // Settings changes not yet applied
+    bool m_inputChanged;
 
     void handleApplicationStateChanged(Qt::ApplicationState state);
 };
@@ -0,0 +1,258 @@
+#include "AudioWriter.h"
+#include "Logging.h"
+#include "SimdKernels.h"
+#include "StreamingUploadDevice.h"
+#include <QDebug>
+#include <QElapsedTimer>
+
+namespace {
+    // Samples pulled from the ring buffer per read; about 93 ms at 44.1 kHz.
+    constexpr size_t kDrainChunkSamples = 4096;
+    // How long the writer sleeps when the ring buffer is empty.
+    constexpr unsigned long kIdleSleepMs = 10;
+    // Polling interval while waiting for the producer to stop, well under one buffer
+    constexpr unsigned long kHandoffPollUs = 500;
+} // namespace
+
+AudioWriter::AudioWriter(AudioRingBuffer* ringBuffer, int captureRate, int outputRate,
+                         QObject* parent)
+    : QThread(parent), m_ringBuffer(ringBuffer), m_outputFile(nullptr),
+      m_resampler(captureRate, outputRate), m_scratch(kDrainChunkSamples),
+      m_levelMeter(captureRate), m_trimSilence(false),
+      m_trimmer(outputRate), m_uploadFormat(AudioEncoder::Format::Wav), m_encodedForwarded(0), m_stopRequested(false),
+      m_producerActive(nullptr), m_handoffTimeoutMs(0), m_bytesWritten(0), m_reportedOverflows(0), m_outputRate(outputRate) {
+    m_resampled.reserve(kDrainChunkSamples);
+    m_pcm.reserve(kDrainChunkSamples);
+    m_trimmed.reserve(kDrainChunkSamples);
+    m_uploadPcm.reserve(kDrainChunkSamples);
+}
+
+AudioWriter::~AudioWriter() {
+    stopWriting();
+}
+
+bool AudioWriter::setUploadFormat(AudioEncoder::Format format) {
+    if (isRunning()) {
+        stopWriting();
+    }
+
+    m_encoder.reset();
+    m_uploadPayload.clear();
+    m_encodedForwarded = 0;
+    m_uploadFormat = AudioEncoder::Format::Wav;
+    if (format == AudioEncoder::Format::Wav) {
+        return true;
+    }
+
+    std::unique_ptr<AudioEncoder> encoder = AudioEncoder::create(format);
+    auto sink = [this](const uint8_t* data, size_t size) {
+        m_uploadPayload.append(reinterpret_cast<const char*>(data), static_cast<qsizetype>(size));
+    };
+    if (!encoder || !encoder->begin(m_outputRate, 1, sink)) {
+        qCWarning(lcAudio) << "Could not start" << AudioEncoder::formatName(format)
+                           << "encoder, uploading WAV instead";
+        m_uploadPayload.clear();
+        return false;
+    }
+
+    m_encoder = std::move(encoder);
+    m_uploadFormat = format;
+    return true;
+}
+
+void AudioWriter::setCaptureRate(int captureRate) {
+    if (isRunning()) {
+        stopWriting();
+    }
+    if (captureRate == m_resampler.inputRate()) {
+        return;
+    }
+    // Rebuilding the filter bank is cheap next to opening a stream
+    m_resampler = PolyphaseResampler(captureRate, m_outputRate);
+    m_levelMeter.setSampleRate(captureRate);
+}
+
+void AudioWriter::startWriting(WavSegmentWriter* outputFile,
+                               const QSharedPointer<StreamingUploadDevice>& streamingUpload) {
+    if (isRunning()) {
+        stopWriting();
+    }
+
+    m_outputFile = outputFile;
+    m_streamingUpload = streamingUpload;
+    m_bytesWritten.store(0, std::memory_order_relaxed);
+    m_reportedOverflows = 0;
+    m_resampler.reset();
+    m_levelMeter.reset();
+    m_trimmer.reset();
+    if (m_trimSilence && m_uploadFormat == AudioEncoder::Format::Wav) {
+        m_uploadPayload.clear();
+    }
+    m_stopRequested.store(false, std::memory_order_release);
+    start(QThread::HighPriority);
+}
+
+void AudioWriter::stopWriting(const std::atomic<bool>* producerActive, int handoffTimeoutMs) {
+    if (isRunning()) {
+        m_producerActive = producerActive;
+        m_handoffTimeoutMs = handoffTimeoutMs;
+        m_stopRequested.store(true, std::memory_order_release);
+        wait();
+    }
+    m_producerActive = nullptr;
+    m_streamingUpload.reset();
+}
+
+void AudioWriter::run() {
+    while (!m_stopRequested.load(std::memory_order_acquire)) {
+        if (drain() == 0) {
+            QThread::msleep(kIdleSleepMs);
+        }
+        checkOverflows();
+    }
+
+    // A stream that keeps running acknowledges within one buffer that it stopped feeding
+    // the ring; until then its last buffer may still be on the way
+    if (m_producerActive) {
+        QElapsedTimer timer;
+        timer.start();
+        while (m_producerActive->load(std::memory_order_acquire) &&
+               timer.elapsed() < m_handoffTimeoutMs) {
+            if (drain() == 0) {
+                QThread::usleep(kHandoffPollUs);
+            }
+        }
+        if (m_producerActive->load(std::memory_order_acquire)) {
+            qCWarning(lcAudio) << "Capture didn't stop within" << m_handoffTimeoutMs
+                               << "ms, the take may lose its last buffer";
+        }
+    }
+
+    // Otherwise the stream is stopped before we are asked to stop, so this picks up the tail.
+    drain();
+    flushResampler();
+    flushTrimmer();
+    finishEncoder();
+    checkOverflows();
+}
+
+size_t AudioWriter::drain() {
+    size_t total = 0;
+    m_resampled.clear();
+
+    size_t count;
+    while ((count = m_ringBuffer->read(m_scratch.data(), m_scratch.size())) > 0) {
+        m_levelMeter.process(m_scratch.data(), count);
+        m_resampler.process(m_scratch.data(), count, m_resampled);
+        total += count;
+    }
+
+    writeSamples(m_resampled);
+    return total;
+}
+
+void AudioWriter::flushResampler() {
+    m_resampled.clear();
+    m_resampler.flush(m_resampled);
+    writeSamples(m_resampled);
+}
+
+void AudioWriter::writeSamples(const std::vector<float>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+
+    m_pcm.resize(samples.size());
+    SimdKernels::floatToInt16(samples.data(), m_pcm.data(), samples.size());
+
+    const char* bytes = reinterpret_cast<const char*>(m_pcm.data());
+    const qint64 size = static_cast<qint64>(m_pcm.size() * sizeof(int16_t));
+
+    if (m_outputFile && m_outputFile->isOpen()) {
+        qint64 written = m_outputFile->write(bytes, size);
+        if (written > 0) {
+            m_bytesWritten.fetch_add(written, std::memory_order_relaxed);
+        }
+    } else if (m_arena) {
+        m_arena->append(bytes, static_cast<size_t>(size));
+        m_bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    }
+
+    if (m_trimSilence) {
+        m_trimmed.clear();
+        m_trimmer.process(samples.data(), samples.size(), m_trimmed);
+        uploadSamples(m_trimmed);
+    } else {
+        uploadPcm(m_pcm.data(), m_pcm.size());
+    }
+}
+
+void AudioWriter::uploadSamples(const std::vector<float>& samples) {
+    if (samples.empty()) {
+        return;
+    }
+    m_uploadPcm.resize(samples.size());
+    SimdKernels::floatToInt16(samples.data(), m_uploadPcm.data(), samples.size());
+    uploadPcm(m_uploadPcm.data(), m_uploadPcm.size());
+}
+
+void AudioWriter::uploadPcm(const int16_t* samples, size_t count) {
+    if (m_encoder) {
+        if (!m_encoder->encode(samples, count)) {
+            qCWarning(lcAudio) << "Audio encoder failed, dropping compressed upload";
+            m_encoder.reset();
+            m_uploadPayload.clear();
+            if (m_streamingUpload) {
+                m_streamingUpload->abort();
+            }
+        }
+        forwardEncodedData();
+        return;
+    }
+    if (m_uploadFormat != AudioEncoder::Format::Wav) {
+        return; // Encoder failed earlier; the file upload takes over
+    }
+
+    const QByteArray bytes(reinterpret_cast<const char*>(samples),
+                           static_cast<qsizetype>(count * sizeof(int16_t)));
+    if (m_trimSilence) {
+        m_uploadPayload.append(bytes);
+    }
+    if (m_streamingUpload) {
+        m_streamingUpload->appendData(bytes);
+    }
+}
+
+void AudioWriter::flushTrimmer() {
+    if (m_trimSilence) {
+        m_trimmed.clear();
+        m_trimmer.flush(m_trimmed);
+        uploadSamples(m_trimmed);
+    }
+}
+
+void AudioWriter::finishEncoder() {
+    if (m_encoder && !m_encoder->finish()) {
+        qCWarning(lcAudio) << "Audio encoder failed to finish, dropping compressed upload";
+        m_uploadPayload.clear();
+    }
+    forwardEncodedData();
+    m_encoder.reset();
+}
+
+void AudioWriter::forwardEncodedData() {
+    // Codecs emit output in frame/page sized bursts; pass on whatever is new since last time
+    if (m_streamingUpload && m_uploadPayload.size() > m_encodedForwarded) {
+        m_streamingUpload->appendData(m_uploadPayload.mid(m_encodedForwarded));
+    }
+    m_encodedForwarded = m_uploadPayload.size();
+}
+
+void AudioWriter::checkOverflows() {
+    const quint64 overflows = m_ringBuffer->overflowCount();
+    if (overflows != m_reportedOverflows) {
+        m_reportedOverflows = overflows;
+        qCWarning(lcAudio) << "Audio writer fell behind, capture buffers dropped:" << overflows;
+        emit captureOverflow(overflows, m_ringBuffer->droppedSamples());
+    }
+}
@@ -0,0 +1,439 @@
+#include "BatchTranscriber.h"
+#include "GroqTranscriptionBackend.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "config.h"
+#ifdef VIBECO_HAVE_WHISPER
+#include "LocalWhisperBackend.h"
+#endif
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+
+namespace {
+    // Upper bound for the setting; the API rate-limits well before this helps
+    constexpr int kMaxConcurrency = 8;
+    const QString kResultSuffix = ".transcript.json";
+
+    bool useLocalBackend() {
+#ifdef VIBECO_HAVE_WHISPER
+        return Config::instance().getTranscriptionBackend() == "local";
+#else
+        return false;
+#endif
+    }
+
+    int priorityRank(BatchTranscriber::Priority priority) {
+        return static_cast<int>(priority);
+    }
+
+    Metrics::Counter& filesCounter(const char* result) {
+        return Metrics::Registry::instance().counter(
+            "vibeco_batch_files_total", "Files handled by batch transcription",
+            std::string("result=\"") + result + "\"");
+    }
+} // namespace
+
+BatchTranscriber::BatchTranscriber(QObject* parent)
+    : QAbstractTableModel(parent), m_nextId(1), m_paused(false)
+{
+    // A higher limit applies at once; a lower one as running jobs finish
+    connect(&Config::instance(), &Config::changed, this, [this](const QString& key) {
+        if (key == Config::KEY_BATCH_CONCURRENCY || key == Config::KEY_TRANSCRIPTION_BACKEND) {
+            schedule();
+        }
+    });
+}
+
+BatchTranscriber::~BatchTranscriber() = default;
+
+QStringList BatchTranscriber::audioFileFilters()
+{
+    return {"*.wav", "*.flac", "*.ogg", "*.opus", "*.mp3", "*.m4a", "*.mp4", "*.webm"};
+}
+
+QString BatchTranscriber::resultPath(const QString& audioPath)
+{
+    const QFileInfo info(audioPath);
+    return info.dir().filePath(info.fileName() + kResultSuffix);
+}
+
+bool BatchTranscriber::hasResult(const QString& audioPath)
+{
+    const QFileInfo result(resultPath(audioPath));
+    return result.exists() && result.lastModified() >= QFileInfo(audioPath).lastModified();
+}
+
+int BatchTranscriber::addFiles(const QStringList& paths, Priority priority)
+{
+    QVector<Job> added;
+    for (const QString& path : paths) {
+        const QFileInfo info(path);
+        const QString absolute = info.absoluteFilePath();
+        const bool queued =
+            std::any_of(m_jobs.cbegin(), m_jobs.cend(), [&absolute](const Job& job) {
+                return job.path == absolute &&
+                       (job.state == State::Queued || job.state == State::Running);
+            });
+        if (!info.isFile() || queued) {
+            continue;
+        }
+
+        Job job;
+        job.id = m_nextId++;
+        job.path = absolute;
+        job.priority = priority;
+        job.bytes = info.size();
+        if (hasResult(absolute)) {
+            job.state = State::Skipped;
+            ++m_totals.skipped;
+            filesCounter("skipped").add();
+        }
+        added.append(job);
+    }
+    if (added.isEmpty()) {
+        return 0;
+    }
+
+    beginInsertRows(QModelIndex(), m_jobs.size(), m_jobs.size() + added.size() - 1);
+    m_jobs += added;
+    endInsertRows();
+
+    const int queued = static_cast<int>(std::count_if(
+        added.cbegin(), added.cend(), [](const Job& job) { return job.state == State::Queued; }));
+    qCDebug(lcTranscription) << "Batch: queued" << queued << "files, skipped"
+                             << added.size() - queued << "with results";
+    emit statsChanged();
+    schedule();
+    return queued;
+}
+
+int BatchTranscriber::addDirectory(const QString& directory, Priority priority)
+{
+    QStringList paths;
+    const QFileInfoList files =
+        QDir(directory).entryInfoList(audioFileFilters(), QDir::Files, QDir::Name);
+    for (const QFileInfo& info : files) {
+        paths.append(info.absoluteFilePath());
+    }
+    return addFiles(paths, priority);
+}
+
+void BatchTranscriber::setPriority(int row, Priority priority)
+{
+    if (row < 0 || row >= m_jobs.size() || m_jobs[row].priority == priority) {
+        return;
+    }
+    m_jobs[row].priority = priority;
+    jobChanged(row);
+    // May now go ahead of others; running jobs aren't interrupted
+}
+
+void BatchTranscriber::clearFinished()
+{
+    beginResetModel();
+    if (runningCount() == 0) {
+        // Nothing in flight: the next files start a new batch, with its own totals
+        m_totals = Stats{};
+    }
+    m_jobs.erase(std::remove_if(m_jobs.begin(), m_jobs.end(),
+                                [](const Job& job) {
+                                    return job.state != State::Queued &&
+                                           job.state != State::Running;
+                                }),
+                 m_jobs.end());
+    endResetModel();
+    emit statsChanged();
+}
+
+void BatchTranscriber::setPaused(bool paused)
+{
+    if (paused == m_paused) {
+        return;
+    }
+    m_paused = paused;
+    emit pausedChanged(paused);
+    schedule();
+}
+
+BatchTranscriber::Stats BatchTranscriber::stats() const
+{
+    Stats stats = m_totals;
+    for (const Job& job : m_jobs) {
+        if (job.state == State::Queued) {
+            ++stats.queued;
+        } else if (job.state == State::Running) {
+            ++stats.running;
+        }
+    }
+    if (m_activeTimer.isValid()) {
+        stats.activeSeconds += m_activeTimer.elapsed() / 1000.0;
+    }
+    return stats;
+}
+
+int BatchTranscriber::concurrency() const
+{
+    if (useLocalBackend()) {
+        return 1;
+    }
+    return qBound(1, Config::instance().getBatchConcurrency(), kMaxConcurrency);
+}
+
+TranscriptionBackend* BatchTranscriber::createBackend(int slot)
+{
+    TranscriptionBackend* backend = nullptr;
+#ifdef VIBECO_HAVE_WHISPER
+    if (useLocalBackend()) {
+        // Shares the loaded model and worker thread with dictation's backend
+        backend = new LocalWhisperBackend(this);
+    }
+#endif
+    if (!backend) {
+        backend = new GroqTranscriptionBackend(this);
+    }
+
+    // Requests carry the job's ID, which outlives the slot's interest in it
+    connect(backend, &TranscriptionBackend::transcriptionComplete, this,
+            [this, slot](quint64 job, const TranscriptionResult& result) {
+                finishJob(slot, job, &result, {});
+            });
+    connect(backend, &TranscriptionBackend::transcriptionError, this,
+            [this, slot](quint64 job, const QString& error) {
+                finishJob(slot, job, nullptr, error);
+            });
+    connect(backend, &TranscriptionBackend::uploadProgress, this,
+            [this](quint64 job, qint64 bytesSent, qint64 bytesTotal) {
+                const int row = rowOf(job);
+                if (row >= 0 && m_jobs[row].state == State::Running) {
+                    m_jobs[row].bytesSent = bytesSent;
+                    m_jobs[row].bytesTotal = bytesTotal;
+                    const QModelIndex cell = index(row, ProgressColumn);
+                    emit dataChanged(cell, cell, {Qt::DisplayRole});
+                }
+            });
+    return backend;
+}
+
+void BatchTranscriber::schedule()
+{
+    const int limit = concurrency();
+    if (m_slots.size() < limit) {
+        m_slots.resize(limit);
+    }
+
+    const bool local = useLocalBackend();
+    for (int slot = 0; slot < m_slots.size() && !m_paused && runningCount() < limit; ++slot) {
+        if (m_slots[slot].job != 0) {
+            continue;
+        }
+
+        // Highest priority first, then oldest
+        int next = -1;
+        for (int row = 0; row < m_jobs.size(); ++row) {
+            if (m_jobs[row].state == State::Queued &&
+                (next < 0 ||
+                 priorityRank(m_jobs[row].priority) > priorityRank(m_jobs[next].priority))) {
+                next = row;
+            }
+        }
+        if (next < 0) {
+            break;
+        }
+
+        // The backend setting may have changed since this slot's was made
+        TranscriptionBackend*& backend = m_slots[slot].backend;
+        if (backend && (backend->name() == "local") != local) {
+            backend->deleteLater();
+            backend = nullptr;
+        }
+        if (!backend) {
+            backend = createBackend(slot);
+        }
+
+        Job& job = m_jobs[next];
+        job.state = State::Running;
+        job.bytesSent = 0;
+        job.bytesTotal = 0;
+        m_slots[slot].job = job.id;
+        if (!m_activeTimer.isValid()) {
+            m_activeTimer.start();
+        }
+        jobChanged(next);
+
+        // The backend may report back before returning
+        const quint64 id = job.id;
+        const QString path = job.path;
+        qCDebug(lcTranscription) << "Batch: transcribing" << path << "on slot" << slot;
+        if (backend->supportsSegmentation() && Config::instance().getSegmentedTranscription()) {
+            backend->transcribeFileSegmented(id, path);
+        } else {
+            backend->transcribeFile(id, path);
+        }
+    }
+    emit statsChanged();
+}
+
+void BatchTranscriber::finishJob(int slot, quint64 id, const TranscriptionResult* result,
+                                 const QString& error)
+{
+    if (slot >= m_slots.size() || m_slots[slot].job != id) {
+        return; // Already finished
+    }
+    m_slots[slot].job = 0;
+    const int row = rowOf(id);
+    if (row < 0) {
+        return;
+    }
+
+    Job& job = m_jobs[row];
+    QString failure = error;
+    if (result) {
+        // Stored the way the transcription cache stores it, so it reads back the same way
+        const QByteArray json = result->toVerboseJson();
+        QSaveFile file(resultPath(job.path));
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size() ||
+            !file.commit()) {
+            failure = tr("Could not save %1").arg(QDir::toNativeSeparators(resultPath(job.path)));
+        }
+    }
+
+    if (failure.isEmpty()) {
+        job.state = State::Done;
+        ++m_totals.done;
+        m_totals.audioSeconds += qMax(0.0, result->duration);
+        m_totals.fileBytes += job.bytes;
+        filesCounter("done").add();
+    } else {
+        job.state = State::Failed;
+        job.error = failure;
+        ++m_totals.failed;
+        filesCounter("failed").add();
+        Metrics::countError("batch_transcription");
+        qCWarning(lcTranscription) << "Batch: failed on" << job.path << ":" << failure;
+    }
+    jobChanged(row);
+
+    if (result && failure.isEmpty()) {
+        emit jobFinished(job.path, *result);
+    }
+
+    if (runningCount() == 0 && m_activeTimer.isValid()) {
+        m_totals.activeSeconds += m_activeTimer.elapsed() / 1000.0;
+        m_activeTimer.invalidate();
+    }
+    // Queued: a backend may fail the next job before returning, which would recurse
+    QMetaObject::invokeMethod(this, &BatchTranscriber::schedule, Qt::QueuedConnection);
+
+    const Stats current = stats();
+    if (current.running == 0 && current.queued == 0 && current.activeSeconds > 0.0) {
+        qCDebug(lcTranscription) << "Batch finished:" << current.done << "done,"
+                                 << current.failed << "failed;" << current.audioSeconds
+                                 << "s of audio in" << current.activeSeconds << "s";
+    }
+}
+
+int BatchTranscriber::rowOf(quint64 id) const
+{
+    for (int row = 0; row < m_jobs.size(); ++row) {
+        if (m_jobs[row].id == id) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+int BatchTranscriber::runningCount() const
+{
+    return static_cast<int>(std::count_if(m_slots.cbegin(), m_slots.cend(),
+                                          [](const Slot& slot) { return slot.job != 0; }));
+}
+
+void BatchTranscriber::jobChanged(int row)
+{
+    emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
+    emit statsChanged();
+}
+
+int BatchTranscriber::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_jobs.size();
+}
+
+int BatchTranscriber::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant BatchTranscriber::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_jobs.size()) {
+        return QVariant();
+    }
+    const Job& job = m_jobs[index.row()];
+
+    if (role == Qt::ToolTipRole) {
+        return job.error.isEmpty() ? QDir::toNativeSeparators(job.path) : job.error;
+    }
+    if (role != Qt::DisplayRole) {
+        return QVariant();
+    }
+
+    switch (index.column()) {
+    case FileColumn:
+        return QFileInfo(job.path).fileName();
+    case StateColumn:
+        switch (job.state) {
+        case State::Queued:
+            return tr("Queued");
+        case State::Running:
+            return tr("Transcribing");
+        case State::Done:
+            return tr("Done");
+        case State::Skipped:
+            return tr("Already transcribed");
+        case State::Failed:
+            return tr("Failed");
+        }
+        break;
+    case ProgressColumn:
+        if (job.state == State::Done) {
+            return QStringLiteral("100%");
+        }
+        if (job.state == State::Running && job.bytesTotal > 0) {
+            // Upload progress; the server's share of the time isn't reported
+            return QString("%1%").arg(job.bytesSent * 100 / job.bytesTotal);
+        }
+        return QString();
+    case PriorityColumn:
+        switch (job.priority) {
+        case Priority::Low:
+            return tr("Low");
+        case Priority::Normal:
+            return tr("Normal");
+        case Priority::High:
+            return tr("High");
+        }
+        break;
+    }
+    return QVariant();
+}
+
+QVariant BatchTranscriber::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    switch (section) {
+    case FileColumn:
+        return tr("File");
+    case StateColumn:
+        return tr("Status");
+    case ProgressColumn:
+        return tr("Upload");
+    case PriorityColumn:
+        return tr("Priority");
+    }
+    return QVariant();
+}
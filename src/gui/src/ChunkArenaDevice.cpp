@@ -0,0 +1,39 @@
+#include "ChunkArenaDevice.h"
+#include <cstring>
+
+ChunkArenaDevice::ChunkArenaDevice(std::shared_ptr<const ChunkArena> arena,
+                                   const QByteArray& prefix, QObject* parent)
+    : QIODevice(parent), m_arena(std::move(arena)), m_prefix(prefix) {
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+qint64 ChunkArenaDevice::size() const {
+    return m_prefix.size() + static_cast<qint64>(m_arena->size());
+}
+
+qint64 ChunkArenaDevice::readData(char* data, qint64 maxSize) {
+    qint64 position = pos();
+    qint64 copied = 0;
+
+    if (position < m_prefix.size()) {
+        const qint64 take = qMin(maxSize, m_prefix.size() - position);
+        std::memcpy(data, m_prefix.constData() + position, static_cast<size_t>(take));
+        copied += take;
+        position += take;
+    }
+
+    if (copied < maxSize) {
+        copied += static_cast<qint64>(m_arena->read(static_cast<size_t>(position - m_prefix.size()),
+                                                    data + copied,
+                                                    static_cast<size_t>(maxSize - copied)));
+    }
+
+    // QIODevice reports end of data as -1
+    return copied > 0 || maxSize == 0 ? copied : -1;
+}
+
+qint64 ChunkArenaDevice::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -0,0 +1,426 @@
+#include "ChunkedUploadReply.h"
+#include "Logging.h"
+#include "StreamingUploadDevice.h"
+#include <QDebug>
+#include <QTcpSocket>
+#include <QUrl>
+#include <cstring>
+#if QT_CONFIG(ssl)
+#include <QSslConfiguration>
+#include <QSslSocket>
+#endif
+
+namespace {
+    // A response head this large isn't from the transcription API
+    constexpr qsizetype kMaxHeadBytes = 64 * 1024;
+
+    // Framing of the request that this reply writes itself
+    bool isFramingHeader(const QByteArray& name) {
+        return name.compare("Host", Qt::CaseInsensitive) == 0 ||
+               name.compare("Content-Length", Qt::CaseInsensitive) == 0 ||
+               name.compare("Transfer-Encoding", Qt::CaseInsensitive) == 0 ||
+               name.compare("Connection", Qt::CaseInsensitive) == 0;
+    }
+
+    // What QNetworkAccessManager reports for the same status
+    QNetworkReply::NetworkError httpError(int status) {
+        switch (status) {
+        case 401:
+            return QNetworkReply::AuthenticationRequiredError;
+        case 403:
+            return QNetworkReply::ContentAccessDenied;
+        case 404:
+            return QNetworkReply::ContentNotFoundError;
+        case 405:
+            return QNetworkReply::ContentOperationNotPermittedError;
+        case 409:
+            return QNetworkReply::ContentConflictError;
+        case 410:
+            return QNetworkReply::ContentGoneError;
+        case 500:
+            return QNetworkReply::InternalServerError;
+        case 501:
+            return QNetworkReply::OperationNotImplementedError;
+        case 503:
+            return QNetworkReply::ServiceUnavailableError;
+        default:
+            return status >= 500 ? QNetworkReply::UnknownServerError
+                                 : QNetworkReply::UnknownContentError;
+        }
+    }
+
+    QNetworkReply::NetworkError socketError(QAbstractSocket::SocketError error) {
+        switch (error) {
+        case QAbstractSocket::ConnectionRefusedError:
+            return QNetworkReply::ConnectionRefusedError;
+        case QAbstractSocket::RemoteHostClosedError:
+            return QNetworkReply::RemoteHostClosedError;
+        case QAbstractSocket::HostNotFoundError:
+            return QNetworkReply::HostNotFoundError;
+        case QAbstractSocket::SocketTimeoutError:
+            return QNetworkReply::TimeoutError;
+        case QAbstractSocket::SslHandshakeFailedError:
+            return QNetworkReply::SslHandshakeFailedError;
+        case QAbstractSocket::ProxyConnectionRefusedError:
+        case QAbstractSocket::ProxyConnectionClosedError:
+        case QAbstractSocket::ProxyNotFoundError:
+        case QAbstractSocket::ProxyProtocolError:
+            return QNetworkReply::ProxyConnectionRefusedError;
+        case QAbstractSocket::ProxyAuthenticationRequiredError:
+            return QNetworkReply::ProxyAuthenticationRequiredError;
+        default:
+            return QNetworkReply::UnknownNetworkError;
+        }
+    }
+} // namespace
+
+ChunkedUploadReply::ChunkedUploadReply(const QNetworkRequest& request,
+                                       StreamingUploadDevice* body, QObject* parent)
+    : QNetworkReply(parent), m_body(body), m_socket(nullptr), m_headSent(false),
+      m_bodyDone(false), m_requestSent(false), m_bytesSent(0), m_headParsed(false),
+      m_chunked(false), m_contentLength(-1), m_contentReceived(0), m_chunkRemaining(0),
+      m_chunkEndPending(false) {
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::PostOperation);
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+
+    m_stallTimer.setSingleShot(true);
+    connect(&m_stallTimer, &QTimer::timeout, this, [this]() {
+        fail(TimeoutError, m_headSent ? QStringLiteral("Upload stalled")
+                                      : QStringLiteral("Connection timed out"));
+    });
+
+    QMetaObject::invokeMethod(this, &ChunkedUploadReply::connectToServer, Qt::QueuedConnection);
+}
+
+void ChunkedUploadReply::abort() {
+    fail(OperationCanceledError, QStringLiteral("Operation canceled"));
+}
+
+qint64 ChunkedUploadReply::bytesAvailable() const {
+    return m_content.size() + QNetworkReply::bytesAvailable();
+}
+
+qint64 ChunkedUploadReply::readData(char* data, qint64 maxSize) {
+    const qint64 count = qMin<qint64>(maxSize, m_content.size());
+    std::memcpy(data, m_content.constData(), count);
+    m_content.remove(0, count);
+    return count;
+}
+
+void ChunkedUploadReply::connectToServer() {
+    if (isFinished()) {
+        return; // aborted before it started
+    }
+
+    const QUrl target = url();
+    const bool secure = target.scheme() == "https";
+#if QT_CONFIG(ssl)
+    if (secure) {
+        auto* socket = new QSslSocket(this);
+        QSslConfiguration configuration = request().sslConfiguration();
+        // Chunked transfer is HTTP/1.1 only
+        configuration.setAllowedNextProtocols({QSslConfiguration::NextProtocolHttp1_1});
+        socket->setSslConfiguration(configuration);
+        connect(socket, &QSslSocket::encrypted, this, [this]() {
+            emit encrypted();
+            sendHead();
+        });
+        m_socket = socket;
+    }
+#endif
+    if (!m_socket) {
+        if (secure) {
+            fail(ProtocolUnknownError, QStringLiteral("TLS is not available"));
+            return;
+        }
+        m_socket = new QTcpSocket(this);
+        connect(m_socket, &QTcpSocket::connected, this, &ChunkedUploadReply::sendHead);
+    }
+
+    connect(m_socket, &QTcpSocket::readyRead, this, &ChunkedUploadReply::readResponse);
+    connect(m_socket, &QTcpSocket::bytesWritten, this, &ChunkedUploadReply::handleBytesWritten);
+    connect(m_socket, &QTcpSocket::disconnected, this, &ChunkedUploadReply::handleDisconnected);
+    connect(m_socket, &QTcpSocket::errorOccurred, this,
+            [this](QAbstractSocket::SocketError error) {
+                // A response that runs until the connection closes ends this way
+                if (error != QAbstractSocket::RemoteHostClosedError) {
+                    fail(socketError(error), m_socket->errorString());
+                }
+            });
+    if (m_body) {
+        connect(m_body, &QIODevice::readyRead, this, &ChunkedUploadReply::sendBody);
+    }
+
+    if (request().transferTimeout() > 0) {
+        m_stallTimer.start(request().transferTimeout());
+    }
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    emit socketStartedConnecting();
+#endif
+    const quint16 port = static_cast<quint16>(target.port(secure ? 443 : 80));
+#if QT_CONFIG(ssl)
+    if (secure) {
+        static_cast<QSslSocket*>(m_socket)->connectToHostEncrypted(target.host(), port);
+        return;
+    }
+#endif
+    m_socket->connectToHost(target.host(), port);
+}
+
+void ChunkedUploadReply::sendHead() {
+    const QUrl target = url();
+    QByteArray path = target.toEncoded(QUrl::RemoveScheme | QUrl::RemoveAuthority |
+                                       QUrl::RemoveFragment);
+    if (path.isEmpty()) {
+        path = "/";
+    }
+    QByteArray host = target.host(QUrl::FullyEncoded).toLatin1();
+    const int defaultPort = target.scheme() == "https" ? 443 : 80;
+    if (target.port(defaultPort) != defaultPort) {
+        host += ':' + QByteArray::number(target.port());
+    }
+
+    QByteArray head = "POST " + path + " HTTP/1.1\r\nHost: " + host + "\r\n";
+    for (const QByteArray& name : request().rawHeaderList()) {
+        if (!isFramingHeader(name)) {
+            head += name + ": " + request().rawHeader(name) + "\r\n";
+        }
+    }
+    head += "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n";
+
+    m_stallTimer.stop();
+    m_headSent = true;
+    m_socket->write(head);
+    armStallTimer(false);
+    sendBody();
+}
+
+void ChunkedUploadReply::sendBody() {
+    if (!m_headSent || m_bodyDone || isFinished()) {
+        return;
+    }
+    if (!m_body) {
+        fail(OperationCanceledError, QStringLiteral("Upload body was deleted"));
+        return;
+    }
+
+    const QByteArray data = m_body->readAll();
+    if (!data.isEmpty()) {
+        m_socket->write(QByteArray::number(data.size(), 16) + "\r\n" + data + "\r\n");
+    }
+    if (m_body->atEnd()) {
+        m_socket->write("0\r\n\r\n");
+        m_bodyDone = true;
+    } else if (m_body->isClosed()) {
+        fail(OperationCanceledError, QStringLiteral("Upload was aborted"));
+        return;
+    }
+    armStallTimer(false);
+}
+
+void ChunkedUploadReply::handleBytesWritten(qint64 bytes) {
+    m_bytesSent += bytes;
+    emit uploadProgress(m_bytesSent, -1);
+    if (m_bodyDone && !m_requestSent && m_socket->bytesToWrite() == 0) {
+        m_requestSent = true;
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+        emit requestSent();
+#endif
+    }
+    armStallTimer(true);
+}
+
+void ChunkedUploadReply::armStallTimer(bool progress) {
+    if (request().transferTimeout() <= 0 || isFinished()) {
+        return;
+    }
+    // Only bytes waiting to be sent can stall; a quiet body (e.g. a pause) doesn't
+    if (m_socket->bytesToWrite() == 0) {
+        m_stallTimer.stop();
+    } else if (progress || !m_stallTimer.isActive()) {
+        m_stallTimer.start(request().transferTimeout());
+    }
+}
+
+void ChunkedUploadReply::readResponse() {
+    if (isFinished()) {
+        return;
+    }
+    m_incoming += m_socket->readAll();
+    if (!m_headParsed && !parseHead()) {
+        return;
+    }
+
+    const qint64 before = m_content.size();
+    if (m_chunked) {
+        if (parseChunkedBody()) {
+            complete();
+            return;
+        }
+    } else {
+        qint64 take = m_incoming.size();
+        if (m_contentLength >= 0) {
+            take = qMin(take, m_contentLength - m_contentReceived);
+        }
+        m_content += m_incoming.left(take);
+        m_incoming.clear();
+        m_contentReceived += take;
+    }
+    if (m_content.size() > before) {
+        emit downloadProgress(m_contentReceived, m_contentLength);
+        emit readyRead();
+    }
+    if (!m_chunked && m_contentLength >= 0 && m_contentReceived >= m_contentLength) {
+        complete();
+    }
+}
+
+bool ChunkedUploadReply::parseHead() {
+    for (;;) {
+        const qsizetype end = m_incoming.indexOf("\r\n\r\n");
+        if (end < 0) {
+            if (m_incoming.size() > kMaxHeadBytes) {
+                fail(ProtocolFailure, QStringLiteral("Response header too large"));
+            }
+            return false;
+        }
+        const QList<QByteArray> lines = m_incoming.left(end).split('\n');
+        m_incoming.remove(0, end + 4);
+
+        // HTTP/1.1 200 OK
+        const QByteArray statusLine = lines.first().trimmed();
+        const qsizetype space = statusLine.indexOf(' ');
+        bool ok = statusLine.startsWith("HTTP/1.") && space > 0;
+        const int status = ok ? statusLine.mid(space + 1, 3).toInt(&ok) : 0;
+        if (!ok) {
+            fail(ProtocolFailure, QStringLiteral("Malformed response status line"));
+            return false;
+        }
+        if (status / 100 == 1) {
+            continue; // 100 Continue and friends precede the real response
+        }
+
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+        setAttribute(QNetworkRequest::HttpReasonPhraseAttribute,
+                     QString::fromLatin1(statusLine.mid(space + 5).trimmed()));
+        for (qsizetype i = 1; i < lines.size(); ++i) {
+            const QByteArray line = lines[i].trimmed();
+            const qsizetype colon = line.indexOf(':');
+            if (colon <= 0) {
+                continue;
+            }
+            const QByteArray name = line.left(colon).trimmed();
+            const QByteArray value = line.mid(colon + 1).trimmed();
+            setRawHeader(name, value);
+            if (name.compare("Content-Length", Qt::CaseInsensitive) == 0) {
+                m_contentLength = value.toLongLong();
+            } else if (name.compare("Transfer-Encoding", Qt::CaseInsensitive) == 0) {
+                m_chunked = value.toLower().contains("chunked");
+            } else if (name.compare("Content-Type", Qt::CaseInsensitive) == 0) {
+                setHeader(QNetworkRequest::ContentTypeHeader, QString::fromLatin1(value));
+            }
+        }
+        if (m_chunked) {
+            m_contentLength = -1;
+        }
+        m_headParsed = true;
+        emit metaDataChanged();
+        return true;
+    }
+}
+
+bool ChunkedUploadReply::parseChunkedBody() {
+    for (;;) {
+        if (m_chunkEndPending) {
+            if (m_incoming.size() < 2) {
+                return false;
+            }
+            m_incoming.remove(0, 2); // CRLF after the chunk's data
+            m_chunkEndPending = false;
+        }
+        if (m_chunkRemaining == 0) {
+            const qsizetype lineEnd = m_incoming.indexOf("\r\n");
+            if (lineEnd < 0) {
+                return false;
+            }
+            // Chunk extensions after ';' are ignored
+            const QByteArray sizeField = m_incoming.left(lineEnd).split(';').first().trimmed();
+            m_incoming.remove(0, lineEnd + 2);
+            bool ok = false;
+            m_chunkRemaining = sizeField.toLongLong(&ok, 16);
+            if (!ok || m_chunkRemaining < 0) {
+                fail(ProtocolFailure, QStringLiteral("Malformed response chunk"));
+                return false;
+            }
+            if (m_chunkRemaining == 0) {
+                return true; // the last chunk; trailers, if any, aren't needed
+            }
+        }
+
+        const qint64 take = qMin<qint64>(m_chunkRemaining, m_incoming.size());
+        m_content += m_incoming.left(take);
+        m_incoming.remove(0, take);
+        m_contentReceived += take;
+        m_chunkRemaining -= take;
+        if (m_chunkRemaining > 0) {
+            return false;
+        }
+        m_chunkEndPending = true;
+    }
+}
+
+void ChunkedUploadReply::handleDisconnected() {
+    if (isFinished()) {
+        return;
+    }
+    // Without a length, the body is whatever arrived until the server hung up
+    if (m_headParsed && !m_chunked && m_contentLength < 0) {
+        complete();
+        return;
+    }
+    fail(RemoteHostClosedError, QStringLiteral("Connection closed before the response ended"));
+}
+
+void ChunkedUploadReply::complete() {
+    if (isFinished()) {
+        return;
+    }
+    m_stallTimer.stop();
+    setFinished(true);
+    if (m_body) {
+        disconnect(m_body, nullptr, this, nullptr);
+    }
+    m_socket->disconnect(this);
+    m_socket->abort();
+
+    const int status = attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status >= 400) {
+        const NetworkError code = httpError(status);
+        setError(code, QStringLiteral("Server replied: %1 %2")
+                           .arg(status)
+                           .arg(attribute(QNetworkRequest::HttpReasonPhraseAttribute).toString()));
+        emit errorOccurred(code);
+    }
+    emit finished();
+}
+
+void ChunkedUploadReply::fail(NetworkError code, const QString& message) {
+    if (isFinished()) {
+        return;
+    }
+    qCDebug(lcTranscription) << "Chunked upload to" << url().host() << "failed:" << message;
+    m_stallTimer.stop();
+    setFinished(true);
+    if (m_body) {
+        disconnect(m_body, nullptr, this, nullptr);
+    }
+    if (m_socket) {
+        m_socket->disconnect(this);
+        m_socket->abort();
+    }
+    setError(code, message);
+    emit errorOccurred(code);
+    emit finished();
+}
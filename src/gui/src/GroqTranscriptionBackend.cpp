@@ -0,0 +1,720 @@
+#include "GroqTranscriptionBackend.h"
+#include "Logging.h"
+#include "config.h"
+#include "ChunkedUploadReply.h"
+#include "StreamingUploadDevice.h"
+#include "AudioSegmenter.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include "WavFile.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QHostInfo>
+#include <QHttpMultiPart>
+#include <QDebug>
+#include <QPromise>
+#include <QRandomGenerator>
+#include <QThreadPool>
+#include <QTimer>
+#include <QUrl>
+#include <QElapsedTimer>
+#include <vector>
+
+namespace {
+    // Upper bound on one piece of a segmented transcription
+    constexpr double kSegmentSeconds = 30.0;
+    // Enough of an error response to see what the API objected to
+    constexpr qsizetype kLoggedErrorBodyBytes = 512;
+    // A streamed body that can't get out for this long fails, and the recording is
+    // uploaded as a file instead once it stops
+    constexpr int kStreamingStallTimeoutMs = 10000;
+} // namespace
+
+// A long recording being transcribed as several concurrent requests
+struct GroqTranscriptionBackend::SegmentedJob {
+    quint64 request = 0;
+    QString apiKey;
+    QString baseName;
+    QByteArray wav; // the whole file; segments point into its sample data
+    WavFile::Format format;
+    size_t dataOffset = 0;
+    std::vector<AudioSegmenter::Segment> segments;
+    QVector<TranscriptionResult> results;
+    QList<int> inFlight;      // segment indices with a request outstanding
+    QVector<int> requestIds;  // RequestPolicy id per segment
+    int maxParallel = 1;
+    int next = 0;
+    int completed = 0;
+    bool failed = false;
+};
+
+GroqTranscriptionBackend::GroqTranscriptionBackend(QObject *parent)
+    : TranscriptionBackend(parent)
+    , m_networkManager(new QNetworkAccessManager(this))
+    , m_requestPolicy(new RequestPolicy(this))
+    , m_prewarmDnsMs(-1.0)
+{
+#if QT_CONFIG(ssl)
+    // Offer HTTP/2 so uploads multiplex over the one pre-warmed connection. Requests
+    // must carry the same configuration as the pre-connect to be able to reuse it.
+    m_sslConfiguration = QSslConfiguration::defaultConfiguration();
+    m_sslConfiguration.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                                QSslConfiguration::NextProtocolHttp1_1});
+#endif
+}
+
+void GroqTranscriptionBackend::prepare()
+{
+    const QUrl url = apiUrl();
+    const quint16 port = static_cast<quint16>(url.port(url.scheme() == "https" ? 443 : 80));
+
+    // Resolve first so the lookup can be timed; the socket then hits the host cache
+    QElapsedTimer timer;
+    timer.start();
+    QHostInfo::lookupHost(url.host(), this, [this, url, port, timer](const QHostInfo& info) {
+        if (info.error() != QHostInfo::NoError) {
+            qCDebug(lcTranscription) << "Pre-warm lookup failed for" << url.host() << ":"
+                                     << info.errorString();
+            return;
+        }
+        m_prewarmDnsMs = timer.nsecsElapsed() / 1e6;
+
+#if QT_CONFIG(ssl)
+        if (url.scheme() == "https") {
+            m_networkManager->connectToHostEncrypted(url.host(), port, m_sslConfiguration);
+            return;
+        }
+#endif
+        m_networkManager->connectToHost(url.host(), port);
+    });
+}
+
+QNetworkRequest GroqTranscriptionBackend::transcriptionRequest(const QString& apiKey) const
+{
+    QNetworkRequest request(apiUrl());
+    request.setRawHeader("Authorization", "Bearer " + apiKey.toUtf8());
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#if QT_CONFIG(ssl)
+    request.setSslConfiguration(m_sslConfiguration);
+#endif
+    return request;
+}
+
+void GroqTranscriptionBackend::trackTiming(quint64 request, QNetworkReply* reply)
+{
+    // The lookup only happened once, for the first request after pre-warming
+    const double dnsMs = m_prewarmDnsMs;
+    m_prewarmDnsMs = -1.0;
+
+    trackRequestTiming(reply, dnsMs, [this, request](const RequestTiming& timing) {
+        qCDebug(lcTranscription) << "Request" << request << "timing:" << timing.summary();
+        recordMetrics(timing);
+        emit requestTimed(request, timing);
+    });
+}
+
+void GroqTranscriptionBackend::recordMetrics(const RequestTiming& timing)
+{
+    static Metrics::Counter& uploaded = Metrics::Registry::instance().counter(
+        "vibeco_uploaded_bytes_total", "Request body bytes sent to the transcription API");
+    static Metrics::Histogram& upload = Metrics::Registry::instance().histogram(
+        "vibeco_upload_seconds", "Time to hand a transcription request body to the socket");
+    static Metrics::Histogram& server = Metrics::Registry::instance().histogram(
+        "vibeco_server_seconds",
+        "Server processing time as reported in its response headers, else time to first byte");
+
+    uploaded.add(static_cast<uint64_t>(timing.bytesSent));
+    if (timing.uploadMs >= 0.0) {
+        upload.record(timing.uploadMs);
+    }
+    const double serverMs = timing.serverMs >= 0.0 ? timing.serverMs : timing.firstByteMs;
+    if (serverMs >= 0.0) {
+        server.record(serverMs);
+    }
+}
+
+QList<QByteArray> GroqTranscriptionBackend::timestampGranularities()
+{
+    // Asking for words alone would drop the segments
+    if (Config::instance().getWordTimestamps()) {
+        return {"segment", "word"};
+    }
+    return {};
+}
+
+QString GroqTranscriptionBackend::currentModel() const
+{
+    return Config::instance().getModel();
+}
+
+QUrl GroqTranscriptionBackend::apiUrl() const
+{
+    // Allows pointing the client at a local stand-in server during development
+    return QUrl(qEnvironmentVariable("VIBECO_API_URL", API_URL));
+}
+
+bool GroqTranscriptionBackend::validateApiKey(quint64 request, const QString& apiKey)
+{
+    if (apiKey.isEmpty()) {
+        Metrics::countError("api_key");
+        emit transcriptionError(request,
+                                "API key not set. Please set your Groq API key in Settings.");
+        return false;
+    }
+
+    // Basic validation of API key format
+    if (!apiKey.startsWith("gsk_") || apiKey.length() < 20) {
+        Metrics::countError("api_key");
+        emit transcriptionError(request,
+                                "Invalid API key format. Please check your API key in Settings.");
+        return false;
+    }
+    return true;
+}
+
+QHttpPart GroqTranscriptionBackend::audioFilePart(const QString& fileName,
+                                                  const QString& contentType)
+{
+    QHttpPart filePart;
+    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant(contentType));
+    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                      QVariant("form-data; name=\"file\"; filename=\"" + fileName + "\""));
+    return filePart;
+}
+
+void GroqTranscriptionBackend::transcribeFile(quint64 request, const QString& filePath)
+{
+    QString apiKey = Config::instance().getApiKey();
+    qCDebug(lcTranscription) << "Starting transcription" << request
+                             << "API key exists:" << !apiKey.isEmpty();
+
+    if (!validateApiKey(request, apiKey)) {
+        return;
+    }
+
+    QFileInfo info(filePath);
+    if (!info.isReadable()) {
+        emit transcriptionError(request, "Could not open audio file");
+        return;
+    }
+
+    // The file is reopened for every attempt, since each upload consumes it
+    const QString fileName = info.fileName();
+    auto appendFilePart = [filePath, fileName](QHttpMultiPart* multiPart) {
+        QFile* file = new QFile(filePath, multiPart); // Delete file with multiPart
+        QHttpPart filePart = audioFilePart(fileName, "audio/wav");
+        if (file->open(QIODevice::ReadOnly)) {
+            filePart.setBodyDevice(file);
+        }
+        multiPart->append(filePart);
+    };
+    sendSingleRequest(request, apiKey, appendFilePart, info.size());
+
+    emit processingStarted(request);
+}
+
+void GroqTranscriptionBackend::transcribeData(quint64 request, const QByteArray& data,
+                                              const QString& fileName, const QString& contentType)
+{
+    QString apiKey = Config::instance().getApiKey();
+    if (!validateApiKey(request, apiKey)) {
+        return;
+    }
+
+    qCDebug(lcTranscription) << "Uploading" << contentType << "payload," << data.size()
+                             << "bytes for request" << request;
+    auto appendFilePart = [data, fileName, contentType](QHttpMultiPart* multiPart) {
+        QHttpPart filePart = audioFilePart(fileName, contentType);
+        filePart.setBody(data);
+        multiPart->append(filePart);
+    };
+    sendSingleRequest(request, apiKey, appendFilePart, data.size());
+
+    emit processingStarted(request);
+}
+
+void GroqTranscriptionBackend::transcribeFileSegmented(quint64 request, const QString& filePath)
+{
+    QString apiKey = Config::instance().getApiKey();
+    if (!validateApiKey(request, apiKey)) {
+        return;
+    }
+
+    // An unreadable file yields no WAV, and transcribeFile() reports it
+    auto load = [filePath]() {
+        QFile file(filePath);
+        return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    };
+    startSegmentedJob(request, apiKey, load, QFileInfo(filePath).completeBaseName(),
+                      [this, request, filePath]() { transcribeFile(request, filePath); });
+}
+
+void GroqTranscriptionBackend::transcribeDataSegmented(quint64 request, const QByteArray& wav,
+                                                       const QString& fileName)
+{
+    QString apiKey = Config::instance().getApiKey();
+    if (!validateApiKey(request, apiKey)) {
+        return;
+    }
+
+    startSegmentedJob(request, apiKey, [wav]() { return wav; },
+                      QFileInfo(fileName).completeBaseName(), [this, request, wav, fileName]() {
+                          transcribeData(request, wav, fileName, "audio/wav");
+                      });
+}
+
+void GroqTranscriptionBackend::transcribeDevice(quint64 request, const DeviceFactory& openDevice,
+                                                qint64 size, const QString& fileName,
+                                                const QString& contentType)
+{
+    QString apiKey = Config::instance().getApiKey();
+    if (!validateApiKey(request, apiKey)) {
+        return;
+    }
+
+    qCDebug(lcTranscription) << "Uploading" << contentType << "from memory," << size
+                             << "bytes for request" << request;
+    auto appendFilePart = [openDevice, fileName, contentType](QHttpMultiPart* multiPart) {
+        QHttpPart filePart = audioFilePart(fileName, contentType);
+        filePart.setBodyDevice(openDevice(multiPart)); // Delete device with multiPart
+        multiPart->append(filePart);
+    };
+    sendSingleRequest(request, apiKey, appendFilePart, size);
+
+    emit processingStarted(request);
+}
+
+void GroqTranscriptionBackend::startSegmentedJob(quint64 request, const QString& apiKey,
+                                                 const WavLoader& load, const QString& baseName,
+                                                 const std::function<void()>& fallback)
+{
+    // Reading a long recording and finding its pauses takes a while; not on the GUI thread
+    using Plan = QSharedPointer<SegmentedJob>;
+    auto promise = std::make_shared<QPromise<Plan>>();
+    auto* watcher = new QFutureWatcher<Plan>(this);
+    m_planningRequests.insert(request);
+    connect(watcher, &QFutureWatcher<Plan>::finished, this,
+            [this, watcher, request, apiKey, baseName, fallback]() {
+                watcher->deleteLater();
+                if (!m_planningRequests.remove(request)) {
+                    return; // Cancelled meanwhile
+                }
+                const Plan job = watcher->result();
+                if (!job) {
+                    fallback();
+                    return;
+                }
+
+                job->request = request;
+                job->apiKey = apiKey;
+                job->baseName = baseName;
+                job->results.resize(static_cast<int>(job->segments.size()));
+                job->requestIds.resize(static_cast<int>(job->segments.size()));
+                job->maxParallel = qBound(1, Config::instance().getMaxParallelUploads(), 8);
+
+                qCDebug(lcTranscription) << "Transcribing" << baseName << "as"
+                                         << job->segments.size() << "segments, up to"
+                                         << job->maxParallel << "at a time";
+
+                m_segmentedJobs.insert(request, job);
+                emit processingStarted(request);
+                startPendingSegments(job);
+            });
+    watcher->setFuture(promise->future());
+
+    QThreadPool::globalInstance()->start([promise, load]() {
+        promise->start();
+        promise->addResult(planSegmentedJob(load()));
+        promise->finish();
+    });
+}
+
+QSharedPointer<GroqTranscriptionBackend::SegmentedJob>
+GroqTranscriptionBackend::planSegmentedJob(const QByteArray& wav)
+{
+    auto job = QSharedPointer<SegmentedJob>::create();
+    job->wav = wav;
+
+    // Only the app's own mono PCM16 recordings can be cut up sample-accurately
+    size_t dataSize = 0;
+    if (!WavFile::parse(job->wav.constData(), static_cast<size_t>(job->wav.size()), job->format,
+                        job->dataOffset, dataSize) ||
+        job->format.audioFormat != WavFile::kFormatPcm || job->format.bitsPerSample != 16 ||
+        job->format.channels != 1) {
+        return {};
+    }
+
+    const auto* samples = reinterpret_cast<const int16_t*>(job->wav.constData() + job->dataOffset);
+    job->segments = AudioSegmenter::plan(samples, dataSize / sizeof(int16_t),
+                                         static_cast<int>(job->format.sampleRate), kSegmentSeconds);
+    if (job->segments.size() <= 1) {
+        return {};
+    }
+    return job;
+}
+
+void GroqTranscriptionBackend::startPendingSegments(const QSharedPointer<SegmentedJob>& job)
+{
+    while (!job->failed && job->inFlight.size() < job->maxParallel &&
+           job->next < static_cast<int>(job->segments.size())) {
+        const int index = job->next++;
+        const AudioSegmenter::Segment& segment = job->segments[index];
+        const quint32 byteCount = static_cast<quint32>(segment.length * sizeof(int16_t));
+
+        const auto header = WavFile::header(job->format, byteCount);
+        QByteArray body(header.data(), static_cast<qsizetype>(header.size()));
+        body.append(job->wav.constData() + job->dataOffset + segment.start * sizeof(int16_t),
+                    byteCount);
+
+        const QString fileName = QString("%1_part%2.wav").arg(job->baseName).arg(index + 1);
+
+        job->inFlight.append(index);
+        job->requestIds[index] = sendTranscriptionRequest(
+            job->request, job->apiKey,
+            [body, fileName](QHttpMultiPart* multiPart) {
+                QHttpPart filePart = audioFilePart(fileName, "audio/wav");
+                filePart.setBody(body);
+                multiPart->append(filePart);
+            },
+            body.size(),
+            [this, job, index](QNetworkReply* reply) { handleSegmentResponse(reply, job, index); });
+    }
+}
+
+int GroqTranscriptionBackend::sendTranscriptionRequest(quint64 request, const QString& apiKey,
+                                                       const FilePartBuilder& appendFilePart,
+                                                       qint64 payloadBytes,
+                                                       const RequestPolicy::Handler& done)
+{
+    m_requestPolicy->setHedgingEnabled(Config::instance().getHedgeRequests());
+    return m_requestPolicy->send([this, request, apiKey, appendFilePart]() {
+        // Qt consumes the body, so every attempt gets a fresh one
+        QHttpMultiPart* multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+        appendFilePart(multiPart);
+        return postTranscriptionRequest(request, apiKey, multiPart);
+    }, payloadBytes, done);
+}
+
+void GroqTranscriptionBackend::sendSingleRequest(quint64 request, const QString& apiKey,
+                                                 const FilePartBuilder& appendFilePart,
+                                                 qint64 payloadBytes)
+{
+    const int policyId = sendTranscriptionRequest(request, apiKey, appendFilePart, payloadBytes,
+                                                  [this, request](QNetworkReply* reply) {
+                                                      handleTranscriptionResponse(request, reply);
+                                                  });
+    m_policyIds.insert(request, policyId);
+}
+
+QNetworkReply* GroqTranscriptionBackend::postTranscriptionRequest(quint64 request,
+                                                                  const QString& apiKey,
+                                                                  QHttpMultiPart* multiPart)
+{
+    // Add model part
+    QHttpPart modelPart;
+    modelPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                       QVariant("form-data; name=\"model\""));
+    modelPart.setBody(currentModel().toUtf8());
+    multiPart->append(modelPart);
+
+    // Add response_format part
+    QHttpPart formatPart;
+    formatPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                        QVariant("form-data; name=\"response_format\""));
+    formatPart.setBody("verbose_json");
+    multiPart->append(formatPart);
+
+    for (const QByteArray& granularity : timestampGranularities()) {
+        QHttpPart granularityPart;
+        granularityPart.setHeader(QNetworkRequest::ContentDispositionHeader,
+                                  QVariant("form-data; name=\"timestamp_granularities[]\""));
+        granularityPart.setBody(granularity);
+        multiPart->append(granularityPart);
+    }
+
+    // Create request
+    QNetworkRequest networkRequest = transcriptionRequest(apiKey);
+
+    qCDebug(lcTranscription) << "Sending transcription request" << request << "to:"
+                             << networkRequest.url().toString() << "model" << currentModel();
+
+    // Send request
+    QNetworkReply* reply = m_networkManager->post(networkRequest, multiPart);
+    multiPart->setParent(reply); // Delete multiPart with reply
+    trackTiming(request, reply);
+
+    // Connect signals for progress reporting
+    connect(reply, &QNetworkReply::uploadProgress, this,
+            [this, request](qint64 bytesSent, qint64 bytesTotal) {
+                emit uploadProgress(request, bytesSent, bytesTotal);
+            });
+
+    return reply;
+}
+
+QSharedPointer<StreamingUploadDevice> GroqTranscriptionBackend::startStreaming(
+    quint64 request, const QString& fileName, const QString& contentType, const QByteArray& header)
+{
+    QString apiKey = Config::instance().getApiKey();
+    if (!validateApiKey(request, apiKey)) {
+        return {};
+    }
+
+    // The multipart body is written by hand because QHttpMultiPart needs to know
+    // the size of every part up front. The text fields go first so the audio
+    // part can stay open until recording stops.
+    const QByteArray boundary =
+        "boundary_.oOo._" + QByteArray::number(QRandomGenerator::global()->generate64(), 16);
+
+    QByteArray prologue;
+    prologue += "--" + boundary + "\r\n";
+    prologue += "Content-Disposition: form-data; name=\"model\"\r\n\r\n";
+    prologue += currentModel().toUtf8() + "\r\n";
+    prologue += "--" + boundary + "\r\n";
+    prologue += "Content-Disposition: form-data; name=\"response_format\"\r\n\r\n";
+    prologue += "verbose_json\r\n";
+    for (const QByteArray& granularity : timestampGranularities()) {
+        prologue += "--" + boundary + "\r\n";
+        prologue += "Content-Disposition: form-data; name=\"timestamp_granularities[]\"\r\n\r\n";
+        prologue += granularity + "\r\n";
+    }
+    prologue += "--" + boundary + "\r\n";
+    prologue += "Content-Type: " + contentType.toUtf8() + "\r\n";
+    prologue += "Content-Disposition: form-data; name=\"file\"; filename=\""
+                + QFileInfo(fileName).fileName().toUtf8() + "\"\r\n\r\n";
+    prologue += header;
+
+    QSharedPointer<StreamingUploadDevice> device(new StreamingUploadDevice,
+                                                 &QObject::deleteLater);
+    device->appendData(prologue);
+
+    QNetworkRequest networkRequest = transcriptionRequest(apiKey);
+    networkRequest.setHeader(QNetworkRequest::ContentTypeHeader,
+                             "multipart/form-data; boundary=\"" + boundary + "\"");
+    networkRequest.setTransferTimeout(kStreamingStallTimeoutMs);
+
+    qCDebug(lcTranscription) << "Opening streaming transcription request" << request << "to:"
+                             << networkRequest.url().toString() << "model" << currentModel();
+
+    // Not through m_networkManager: without a Content-Length it would buffer the
+    // whole body before sending any of it
+    QNetworkReply* reply = new ChunkedUploadReply(networkRequest, device.data(), this);
+    trackTiming(request, reply);
+    m_streamingUploads.insert(device.data(), StreamingUpload{request, boundary, reply});
+
+    connect(reply, &QNetworkReply::uploadProgress, this,
+            [this, request](qint64 bytesSent, qint64 bytesTotal) {
+                emit uploadProgress(request, bytesSent, bytesTotal);
+            });
+
+    // The lambda keeps the body device alive for as long as the reply exists
+    connect(reply, &QNetworkReply::finished, this, [this, request, reply, device]() {
+        // Already gone if cancel() aborted the reply
+        const bool cancelled = !m_streamingUploads.remove(device.data());
+        if (!device->isFinished()) {
+            // Request ended before recording stopped; tell the producer to stop feeding it
+            device->close();
+        }
+        if (cancelled) {
+            reply->deleteLater();
+            return;
+        }
+        handleTranscriptionResponse(request, reply);
+    });
+
+    return device;
+}
+
+void GroqTranscriptionBackend::finishStreaming(
+    const QSharedPointer<StreamingUploadDevice>& device)
+{
+    if (!device || device->isClosed() || !m_streamingUploads.contains(device.data())) {
+        return;
+    }
+
+    const StreamingUpload upload = m_streamingUploads.value(device.data());
+    device->appendData("\r\n--" + upload.boundary + "--\r\n");
+    device->finish();
+    qCDebug(lcTranscription) << "Streaming upload" << upload.request
+                             << "finished, body bytes:" << device->totalBytesAppended();
+
+    // The body can't be replayed, so there is no RequestPolicy retry or hedge; the
+    // request still gets the deadline of a single attempt, counted from here
+    QNetworkReply* reply = upload.reply;
+    QTimer::singleShot(RequestPolicy::attemptTimeoutMs(device->totalBytesAppended()), reply,
+                       [reply, request = upload.request]() {
+                           if (reply->isRunning()) {
+                               qCDebug(lcTranscription) << "Streaming request" << request
+                                                        << "timed out";
+                               reply->setProperty(RequestPolicy::kTimedOutProperty, true);
+                               reply->abort();
+                           }
+                       });
+
+    emit processingStarted(upload.request);
+}
+
+void GroqTranscriptionBackend::cancel(quint64 request)
+{
+    if (m_planningRequests.remove(request)) {
+        // Nothing sent yet, and processing hadn't started
+        qCDebug(lcTranscription) << "Cancelled segmented transcription" << request
+                                 << "before it was planned";
+        return;
+    }
+
+    if (m_policyIds.contains(request)) {
+        m_requestPolicy->cancel(m_policyIds.take(request));
+        qCDebug(lcTranscription) << "Cancelled transcription request" << request;
+        emit processingFinished(request);
+        return;
+    }
+
+    if (const QSharedPointer<SegmentedJob> job = m_segmentedJobs.take(request)) {
+        job->failed = true;
+        for (int index : std::as_const(job->inFlight)) {
+            m_requestPolicy->cancel(job->requestIds[index]);
+        }
+        job->inFlight.clear();
+        qCDebug(lcTranscription) << "Cancelled segmented transcription" << request;
+        emit processingFinished(request);
+        return;
+    }
+
+    for (auto it = m_streamingUploads.cbegin(); it != m_streamingUploads.cend(); ++it) {
+        if (it->request == request) {
+            QNetworkReply* reply = it->reply;
+            // Processing only started once the upload was finished
+            const bool started = it.key()->isFinished();
+            m_streamingUploads.erase(it);
+            reply->abort(); // Finishes synchronously; the handler sees it was cancelled
+            qCDebug(lcTranscription) << "Cancelled streaming upload" << request;
+            if (started) {
+                emit processingFinished(request);
+            }
+            return;
+        }
+    }
+}
+
+bool GroqTranscriptionBackend::parseTranscriptionReply(QNetworkReply* reply,
+                                                       TranscriptionResult& result,
+                                                       QString& error) {
+    Trace::Span span("parse response");
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        const bool timedOut = reply->property(RequestPolicy::kTimedOutProperty).toBool();
+        QString errorString = timedOut ? QString("Transcription request timed out")
+                                       : reply->errorString();
+        Metrics::countError(timedOut ? "timeout" : status >= 400 ? "http" : "network");
+        // The API explains rejections in a short JSON body
+        qCWarning(lcTranscription) << "Transcription failed:" << errorString << "status" << status
+                                   << reply->readAll().left(kLoggedErrorBodyBytes);
+
+        error = errorString;
+        return false;
+    }
+
+    const QByteArray data = reply->readAll();
+    qCDebug(lcTranscription) << "Response: status" << status << "," << data.size() << "bytes";
+
+    // Negative duration when the API didn't say; callers fill in what they know
+    QString parseError;
+    if (!TranscriptionResult::fromVerboseJson(data, result, parseError)) {
+        qCWarning(lcTranscription) << "Unusable transcription response:" << parseError;
+        Metrics::countError("parse");
+        error = "Invalid response format";
+        return false;
+    }
+    qCDebug(lcTranscription) << "Parsed" << result.segments.size() << "segments,"
+                             << result.segments.wordCount() << "words";
+
+    return true;
+}
+
+void GroqTranscriptionBackend::handleTranscriptionResponse(quint64 request,
+                                                           QNetworkReply* reply) {
+    reply->deleteLater();
+    m_policyIds.remove(request);
+
+    TranscriptionResult result{};
+    QString error;
+    if (!parseTranscriptionReply(reply, result, error)) {
+        emit transcriptionError(request, error);
+        emit processingFinished(request);
+        return;
+    }
+
+    emit transcriptionComplete(request, result);
+    emit processingFinished(request);
+}
+
+void GroqTranscriptionBackend::handleSegmentResponse(QNetworkReply* reply,
+                                                     const QSharedPointer<SegmentedJob>& job,
+                                                     int index) {
+    reply->deleteLater();
+    job->inFlight.removeOne(index);
+    if (job->failed) {
+        return;
+    }
+
+    TranscriptionResult result{};
+    QString error;
+    if (!parseTranscriptionReply(reply, result, error)) {
+        job->failed = true;
+        for (int other : std::as_const(job->inFlight)) {
+            m_requestPolicy->cancel(job->requestIds[other]);
+        }
+        job->inFlight.clear();
+        m_segmentedJobs.remove(job->request);
+        emit transcriptionError(job->request, QString("Segment %1 of %2: %3")
+                                                  .arg(index + 1)
+                                                  .arg(job->segments.size())
+                                                  .arg(error));
+        emit processingFinished(job->request);
+        return;
+    }
+
+    job->results[index] = result;
+    if (++job->completed < static_cast<int>(job->segments.size())) {
+        startPendingSegments(job);
+        return;
+    }
+
+    // Stitch the pieces back together, with times relative to the whole recording
+    const double sampleRate = job->format.sampleRate;
+    TranscriptionResult stitched{};
+    QStringList texts;
+    QStringList requestIds;
+    for (const TranscriptionResult& part : job->results) {
+        const QString text = part.text.trimmed();
+        if (!text.isEmpty()) {
+            texts.append(text);
+        }
+        if (!part.requestId.isEmpty()) {
+            requestIds.append(part.requestId);
+        }
+        if (stitched.language.isEmpty()) {
+            stitched.language = part.language;
+        }
+    }
+    stitched.text = texts.join(' ');
+    stitched.requestId = requestIds.join(',');
+    stitched.task = job->results.first().task;
+
+    const size_t dataBytes = static_cast<size_t>(job->wav.size()) - job->dataOffset;
+    stitched.duration = dataBytes / sizeof(int16_t) / sampleRate;
+
+    for (size_t i = 0; i < job->segments.size(); ++i) {
+        stitched.segments.append(job->results[i].segments, job->segments[i].start / sampleRate);
+    }
+
+    m_segmentedJobs.remove(job->request);
+    qCDebug(lcTranscription) << "Segmented transcription finished:" << job->segments.size()
+                             << "segments";
+    emit transcriptionComplete(job->request, stitched);
+    emit processingFinished(job->request);
+}
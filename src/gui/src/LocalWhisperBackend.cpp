@@ -0,0 +1,398 @@
+#include "LocalWhisperBackend.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "config.h"
+#include "PolyphaseResampler.h"
+#include "WavFile.h"
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QPair>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <cstring>
+#include <vector>
+#include <whisper.h>
+
+namespace {
+    // whisper.cpp works on 16 kHz mono float samples
+    constexpr int kWhisperSampleRate = 16000;
+    // Beyond this the encoder is memory-bound and extra threads only add contention
+    constexpr int kMaxThreads = 8;
+
+    // Quantized builds of the multilingual and English-only checkpoints, smallest last
+    const QStringList LOCAL_MODELS = {
+        "large-v3-turbo-q5_0",
+        "medium-q5_0",
+        "small-q5_1",
+        "base-q5_1",
+        "base.en-q5_1",
+        "tiny-q5_1"
+    };
+} // namespace
+
+// Whisper state owned by the worker thread
+struct LocalWhisperBackend::Engine {
+    whisper_context* context = nullptr;
+    QString loadedPath;
+    // Set from the GUI thread to cut the running inference short, on shutdown or
+    // when its request is cancelled
+    std::atomic<bool> cancelled{false};
+
+    ~Engine() {
+        if (context) {
+            whisper_free(context);
+        }
+    }
+
+    bool ensureModel(const QString& path, QString& error);
+    static bool decode(const QByteArray& wav, std::vector<float>& samples, QString& error);
+    bool transcribe(const std::vector<float>& samples, TranscriptionResult& result,
+                    QString& error);
+};
+
+bool LocalWhisperBackend::Engine::ensureModel(const QString& path, QString& error)
+{
+    if (context && loadedPath == path) {
+        return true;
+    }
+
+    if (context) {
+        whisper_free(context);
+        context = nullptr;
+        loadedPath.clear();
+    }
+
+    if (!QFileInfo::exists(path)) {
+        error = QString("Local model not found at %1. Download %2 from "
+                        "https://huggingface.co/ggerganov/whisper.cpp")
+                    .arg(QDir::toNativeSeparators(path), QFileInfo(path).fileName());
+        return false;
+    }
+
+    qCDebug(lcTranscription) << "Loading whisper model" << path;
+    qCDebug(lcTranscription) << "whisper.cpp system info:" << whisper_print_system_info();
+
+    whisper_context_params params = whisper_context_default_params();
+    context = whisper_init_from_file_with_params(QFile::encodeName(path).constData(), params);
+    if (!context) {
+        error = "Failed to load local model " + QFileInfo(path).fileName();
+        return false;
+    }
+
+    loadedPath = path;
+    return true;
+}
+
+bool LocalWhisperBackend::Engine::decode(const QByteArray& wav, std::vector<float>& samples,
+                                         QString& error)
+{
+    WavFile::Format format;
+    size_t dataOffset = 0;
+    size_t dataSize = 0;
+    if (!WavFile::parse(wav.constData(), static_cast<size_t>(wav.size()), format, dataOffset,
+                        dataSize)) {
+        error = "Local transcription needs a WAV recording";
+        return false;
+    }
+
+    const bool pcm16 = format.audioFormat == WavFile::kFormatPcm && format.bitsPerSample == 16;
+    const bool float32 =
+        format.audioFormat == WavFile::kFormatIeeeFloat && format.bitsPerSample == 32;
+    if ((!pcm16 && !float32) || format.channels == 0 || format.sampleRate == 0) {
+        error = "Unsupported WAV sample format for local transcription";
+        return false;
+    }
+
+    // Downmix to mono float
+    const size_t channels = format.channels;
+    const size_t frames = dataSize / (channels * format.bitsPerSample / 8);
+    const char* data = wav.constData() + dataOffset;
+    std::vector<float> mono(frames);
+    for (size_t frame = 0; frame < frames; ++frame) {
+        float sum = 0.0f;
+        for (size_t channel = 0; channel < channels; ++channel) {
+            const size_t index = frame * channels + channel;
+            if (pcm16) {
+                int16_t value;
+                std::memcpy(&value, data + index * sizeof(int16_t), sizeof(value));
+                sum += value / 32768.0f;
+            } else {
+                float value;
+                std::memcpy(&value, data + index * sizeof(float), sizeof(value));
+                sum += value;
+            }
+        }
+        mono[frame] = sum / static_cast<float>(channels);
+    }
+
+    if (static_cast<int>(format.sampleRate) == kWhisperSampleRate) {
+        samples = std::move(mono);
+        return true;
+    }
+
+    PolyphaseResampler resampler(static_cast<int>(format.sampleRate), kWhisperSampleRate);
+    samples.clear();
+    samples.reserve(frames * kWhisperSampleRate / format.sampleRate + resampler.tapsPerPhase());
+    resampler.process(mono.data(), mono.size(), samples);
+    resampler.flush(samples);
+    return true;
+}
+
+bool LocalWhisperBackend::Engine::transcribe(const std::vector<float>& samples,
+                                             TranscriptionResult& result, QString& error)
+{
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = qBound(1, QThread::idealThreadCount(), kMaxThreads);
+    params.language = "auto";
+    params.translate = false;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.print_special = false;
+    params.abort_callback = [](void* userData) {
+        return static_cast<std::atomic<bool>*>(userData)->load(std::memory_order_relaxed);
+    };
+    params.abort_callback_user_data = &cancelled;
+
+    if (whisper_full(context, params, samples.data(), static_cast<int>(samples.size())) != 0) {
+        error = "Local transcription failed";
+        return false;
+    }
+
+    // Token ids from end-of-text upwards are timestamps and other special tokens
+    const whisper_token firstSpecial = whisper_token_eot(context);
+    const int segmentCount = whisper_full_n_segments(context);
+
+    QString text;
+    result.segments.clear();
+    for (int i = 0; i < segmentCount; ++i) {
+        const char* segmentText = whisper_full_get_segment_text(context, i);
+        text += QString::fromUtf8(segmentText);
+
+        double logProbSum = 0.0;
+        int tokenCount = 0;
+        const int tokens = whisper_full_n_tokens(context, i);
+        for (int j = 0; j < tokens; ++j) {
+            const whisper_token_data token = whisper_full_get_token_data(context, i, j);
+            if (token.id < firstSpecial) {
+                logProbSum += token.plog;
+                ++tokenCount;
+            }
+        }
+        // Segment times come in units of 10 ms; whisper.cpp has no no-speech probability
+        result.segments.appendSegment(whisper_full_get_segment_t0(context, i) / 100.0,
+                                      whisper_full_get_segment_t1(context, i) / 100.0,
+                                      tokenCount > 0 ? logProbSum / tokenCount : 0.0, 0.0,
+                                      segmentText);
+    }
+
+    result.text = text.trimmed();
+    result.language = QString::fromUtf8(whisper_lang_str(whisper_full_lang_id(context)));
+    result.duration = static_cast<double>(samples.size()) / kWhisperSampleRate;
+    result.task = "transcribe";
+
+    return true;
+}
+
+// The whisper thread and model, shared by every backend instance
+struct LocalWhisperBackend::Worker {
+    using Job = QPair<const LocalWhisperBackend*, quint64>; // backend, request
+
+    QThread thread;
+    QObject* context; // lives on thread; context for queued jobs
+    Engine engine;    // only touched on thread, except Engine::cancelled
+
+    // Which jobs are waiting and which one is running, shared with the thread
+    QMutex jobsMutex;
+    QWaitCondition jobEnded;
+    QSet<Job> queued;
+    Job running{nullptr, 0}; // null backend while idle
+
+    Worker();
+    ~Worker();
+    // The running worker, or a new one if no backend holds it any more
+    static std::shared_ptr<Worker> acquire();
+};
+
+LocalWhisperBackend::Worker::Worker()
+    : context(new QObject)
+{
+    thread.setObjectName("WhisperWorker");
+    context->moveToThread(&thread);
+    thread.start();
+}
+
+LocalWhisperBackend::Worker::~Worker()
+{
+    // Stop a running inference, drop queued jobs and free the model with the thread idle
+    {
+        QMutexLocker lock(&jobsMutex);
+        thread.requestInterruption();
+        engine.cancelled = true;
+    }
+    thread.quit();
+    thread.wait();
+    delete context;
+}
+
+std::shared_ptr<LocalWhisperBackend::Worker> LocalWhisperBackend::Worker::acquire()
+{
+    // Backends are only made and destroyed on the GUI thread
+    static std::weak_ptr<Worker> shared;
+    std::shared_ptr<Worker> worker = shared.lock();
+    if (!worker) {
+        worker = std::make_shared<Worker>();
+        shared = worker;
+    }
+    return worker;
+}
+
+LocalWhisperBackend::LocalWhisperBackend(QObject* parent)
+    : TranscriptionBackend(parent)
+    , m_worker(Worker::acquire())
+{
+}
+
+LocalWhisperBackend::~LocalWhisperBackend()
+{
+    // Other backends may still use the worker: drop only this one's jobs, and wait
+    // for its running inference to stop so nothing is reported to it afterwards
+    QMutexLocker lock(&m_worker->jobsMutex);
+    for (auto it = m_worker->queued.begin(); it != m_worker->queued.end();) {
+        it = it->first == this ? m_worker->queued.erase(it) : std::next(it);
+    }
+    if (m_worker->running.first == this) {
+        m_worker->engine.cancelled = true;
+        while (m_worker->running.first == this) {
+            m_worker->jobEnded.wait(&m_worker->jobsMutex);
+        }
+    }
+}
+
+QString LocalWhisperBackend::modelName() const
+{
+    return Config::instance().getLocalModel();
+}
+
+QStringList LocalWhisperBackend::availableModels()
+{
+    return LOCAL_MODELS;
+}
+
+QString LocalWhisperBackend::modelPath(const QString& model)
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dir).filePath("models/ggml-" + model + ".bin");
+}
+
+void LocalWhisperBackend::preloadModel()
+{
+    const QString path = modelPath(Config::instance().getLocalModel());
+    Worker* worker = m_worker.get();
+    QMetaObject::invokeMethod(worker->context, [worker, path]() {
+        QString error;
+        if (!worker->engine.ensureModel(path, error)) {
+            qCDebug(lcTranscription) << "Model preload skipped:" << error;
+        }
+    }, Qt::QueuedConnection);
+}
+
+void LocalWhisperBackend::transcribeFile(quint64 request, const QString& filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        emit transcriptionError(request, "Could not open audio file");
+        return;
+    }
+    runJob(request, file.readAll(), filePath);
+}
+
+void LocalWhisperBackend::transcribeData(quint64 request, const QByteArray& data,
+                                         const QString& fileName, const QString& contentType)
+{
+    Q_UNUSED(contentType);
+    runJob(request, data, fileName);
+}
+
+void LocalWhisperBackend::cancel(quint64 request)
+{
+    QMutexLocker lock(&m_worker->jobsMutex);
+    const Worker::Job job(this, request);
+    if (m_worker->queued.remove(job)) {
+        qCDebug(lcTranscription) << "Dropped queued local transcription" << request;
+    } else if (m_worker->running == job) {
+        qCDebug(lcTranscription) << "Stopping local transcription" << request;
+        m_worker->engine.cancelled = true;
+    } else {
+        return;
+    }
+    lock.unlock();
+    emit processingFinished(request);
+}
+
+void LocalWhisperBackend::runJob(quint64 request, const QByteArray& wav, const QString& source)
+{
+    const QString path = modelPath(Config::instance().getLocalModel());
+    Worker* worker = m_worker.get();
+    const Worker::Job job(this, request);
+    {
+        QMutexLocker lock(&worker->jobsMutex);
+        worker->queued.insert(job);
+    }
+    emit processingStarted(request);
+
+    // Runs after this backend is gone if it was destroyed meanwhile; its jobs are
+    // no longer queued then, so `this` is only compared, never used
+    QMetaObject::invokeMethod(worker->context, [this, worker, job, request, wav, source, path]() {
+        {
+            QMutexLocker lock(&worker->jobsMutex);
+            if (!worker->queued.remove(job) || worker->thread.isInterruptionRequested()) {
+                return; // Cancelled while queued
+            }
+            worker->running = job;
+            worker->engine.cancelled = false;
+        }
+
+        TranscriptionResult result{};
+        QString error;
+        std::vector<float> samples;
+
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = worker->engine.ensureModel(path, error) &&
+                        Engine::decode(wav, samples, error) &&
+                        worker->engine.transcribe(samples, result, error);
+
+        // Posted under the lock: a backend being destroyed waits for it, and its
+        // pending events go with it
+        QMutexLocker lock(&worker->jobsMutex);
+        worker->running = Worker::Job(nullptr, 0);
+        worker->jobEnded.wakeAll();
+        if (worker->engine.cancelled) {
+            return; // cancel() has already reported it finished, or the backend is gone
+        }
+        if (ok) {
+            qCDebug(lcTranscription) << "Local transcription of" << source << "took"
+                                     << timer.elapsed() << "ms for" << result.duration
+                                     << "s of audio";
+        }
+
+        // Hand the outcome back to the GUI thread
+        QMetaObject::invokeMethod(this, [this, request, ok, result, error]() {
+            if (ok) {
+                emit transcriptionComplete(request, result);
+            } else {
+                Metrics::countError("local_whisper");
+                emit transcriptionError(request, error);
+            }
+            emit processingFinished(request);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
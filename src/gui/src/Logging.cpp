@@ -0,0 +1,197 @@
+#include "Logging.h"
+#include "Metrics.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+Q_LOGGING_CATEGORY(lcAudio, "vibeco.audio")
+Q_LOGGING_CATEGORY(lcTranscription, "vibeco.transcription")
+Q_LOGGING_CATEGORY(lcConfig, "vibeco.config")
+Q_LOGGING_CATEGORY(lcUi, "vibeco.ui")
+Q_LOGGING_CATEGORY(lcHotkey, "vibeco.hotkey")
+Q_LOGGING_CATEGORY(lcStartup, "vibeco.startup")
+Q_LOGGING_CATEGORY(lcMetrics, "vibeco.metrics")
+
+namespace {
+    constexpr qint64 kMaxFileBytes = 4 * 1024 * 1024;
+    constexpr int kKeptFiles = 3; // vibeco.log plus two rotated ones
+    // Token bucket: sustained messages per second, and how many may arrive at once
+    constexpr double kMessagesPerSecond = 200.0;
+    constexpr double kBurstMessages = 1000.0;
+    constexpr size_t kMaxQueued = 10000;
+
+    struct Entry {
+        qint64 msecsSinceEpoch;
+        QtMsgType type;
+        QByteArray category;
+        QString message;
+        uint64_t droppedBefore; // Messages dropped since the previous entry
+    };
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::deque<Entry> queue;
+    std::thread writer;
+    bool running = false;
+    QString logDirectory;
+    double tokens = kBurstMessages;
+    std::chrono::steady_clock::time_point lastRefill;
+    uint64_t dropped = 0;
+
+    char levelLetter(QtMsgType type) {
+        switch (type) {
+        case QtDebugMsg:
+            return 'D';
+        case QtInfoMsg:
+            return 'I';
+        case QtWarningMsg:
+            return 'W';
+        case QtCriticalMsg:
+            return 'C';
+        case QtFatalMsg:
+            return 'F';
+        }
+        return '?';
+    }
+
+    QByteArray format(const Entry& entry) {
+        QByteArray line;
+        const QByteArray time = QDateTime::fromMSecsSinceEpoch(entry.msecsSinceEpoch)
+                                    .toString("yyyy-MM-dd hh:mm:ss.zzz")
+                                    .toLatin1();
+        if (entry.droppedBefore > 0) {
+            line += time + " W vibeco.log: " + QByteArray::number(entry.droppedBefore) +
+                    " messages dropped (rate limit)\n";
+        }
+        line += time + ' ' + levelLetter(entry.type) + ' ' + entry.category + ": " +
+                entry.message.toUtf8() + '\n';
+        return line;
+    }
+
+    QString logPath(int index) {
+        return logDirectory + (index == 0 ? QString("/vibeco.log")
+                                          : QString("/vibeco.%1.log").arg(index));
+    }
+
+    void openLogFile(QFile& file) {
+        file.setFileName(logPath(0));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            std::fprintf(stderr, "Could not open log file %s\n", qPrintable(file.fileName()));
+        }
+    }
+
+    void rotate(QFile& file) {
+        file.close();
+        QFile::remove(logPath(kKeptFiles - 1));
+        for (int i = kKeptFiles - 2; i >= 0; --i) {
+            QFile::rename(logPath(i), logPath(i + 1));
+        }
+        openLogFile(file);
+    }
+
+    void writeLoop() {
+        QFile file;
+        openLogFile(file);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [] { return !running || !queue.empty(); });
+            if (queue.empty()) {
+                break;
+            }
+            std::deque<Entry> batch;
+            batch.swap(queue);
+            lock.unlock();
+
+            for (const Entry& entry : batch) {
+                const QByteArray line = format(entry);
+                std::fwrite(line.constData(), 1, line.size(), stderr);
+                if (file.isOpen()) {
+                    file.write(line);
+                }
+            }
+            if (file.isOpen()) {
+                file.flush();
+                if (file.size() > kMaxFileBytes) {
+                    rotate(file);
+                }
+            }
+
+            lock.lock();
+        }
+    }
+
+    void handleMessage(QtMsgType type, const QMessageLogContext& context, const QString& message) {
+        static Metrics::Counter& droppedMessages = Metrics::Registry::instance().counter(
+            "vibeco_log_messages_dropped_total", "Log messages dropped by the rate limit");
+
+        if (type == QtFatalMsg) {
+            // Qt aborts right after this returns; get everything out first
+            Logging::shutdown();
+            std::fprintf(stderr, "%s\n", qPrintable(qFormatLogMessage(type, context, message)));
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) {
+                return;
+            }
+            tokens = std::min(kBurstMessages,
+                              tokens + std::chrono::duration<double>(now - lastRefill).count() *
+                                           kMessagesPerSecond);
+            lastRefill = now;
+            if (tokens < 1.0 || queue.size() >= kMaxQueued) {
+                ++dropped;
+                droppedMessages.add();
+                return;
+            }
+            tokens -= 1.0;
+            queue.push_back({QDateTime::currentMSecsSinceEpoch(), type,
+                             context.category ? QByteArray(context.category) : "default",
+                             message, dropped});
+            dropped = 0;
+        }
+        wake.notify_one();
+    }
+} // namespace
+
+namespace Logging {
+    void install(const QString& directory) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (running) {
+                return;
+            }
+            QDir().mkpath(directory);
+            logDirectory = directory;
+            lastRefill = std::chrono::steady_clock::now();
+            running = true;
+        }
+        writer = std::thread(writeLoop);
+        qInstallMessageHandler(handleMessage);
+    }
+
+    void shutdown() {
+        qInstallMessageHandler(nullptr);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) {
+                return;
+            }
+            running = false;
+        }
+        wake.notify_one();
+        if (writer.joinable() && writer.get_id() != std::this_thread::get_id()) {
+            writer.join();
+        }
+    }
+} // namespace Logging
@@ -0,0 +1,90 @@
+#include "MetricsServer.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+namespace {
+    // Request line and headers of a scrape fit comfortably; anything bigger is not one
+    constexpr qint64 kMaxRequestBytes = 8 * 1024;
+    // Drop clients that connect and never finish their request
+    constexpr int kRequestTimeoutMs = 5000;
+} // namespace
+
+MetricsServer::MetricsServer(QObject* parent) : QObject(parent), m_server(new QTcpServer(this)) {
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsServer::handleConnection);
+}
+
+bool MetricsServer::listen(quint16 port) {
+    close();
+    if (port == 0) {
+        return true;
+    }
+    if (!m_server->listen(QHostAddress::LocalHost, port)) {
+        qCWarning(lcMetrics) << "Metrics endpoint could not listen on port" << port << ":"
+                             << m_server->errorString();
+        return false;
+    }
+    qCDebug(lcMetrics) << "Serving metrics at http://127.0.0.1:" << port << "/metrics";
+    return true;
+}
+
+void MetricsServer::close() {
+    m_server->close();
+}
+
+bool MetricsServer::isListening() const {
+    return m_server->isListening();
+}
+
+void MetricsServer::handleConnection() {
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() { handleRequest(socket); });
+        QTimer::singleShot(kRequestTimeoutMs, socket, &QTcpSocket::abort);
+    }
+}
+
+void MetricsServer::handleRequest(QTcpSocket* socket) {
+    // Wait for the end of the headers; peek so partial requests stay buffered
+    const QByteArray pending = socket->peek(kMaxRequestBytes);
+    if (!pending.contains("\r\n\r\n")) {
+        if (pending.size() >= kMaxRequestBytes) {
+            respond(socket, "431 Request Header Fields Too Large", "text/plain", {});
+        }
+        return;
+    }
+    socket->readAll();
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    const QList<QByteArray> requestLine = pending.left(pending.indexOf("\r\n")).split(' ');
+    if (requestLine.size() != 3) {
+        respond(socket, "400 Bad Request", "text/plain", "Bad request\n");
+        return;
+    }
+    const QByteArray& method = requestLine[0];
+    const QByteArray path = requestLine[1].left(requestLine[1].indexOf('?'));
+    if (path != "/metrics") {
+        respond(socket, "404 Not Found", "text/plain", "Not found; try /metrics\n");
+    } else if (method != "GET") {
+        respond(socket, "405 Method Not Allowed", "text/plain", "Use GET\n");
+    } else {
+        const std::string text = Metrics::Registry::instance().renderPrometheus();
+        respond(socket, "200 OK", "text/plain; version=0.0.4; charset=utf-8",
+                QByteArray(text.data(), static_cast<qsizetype>(text.size())));
+    }
+}
+
+void MetricsServer::respond(QTcpSocket* socket, const QByteArray& status,
+                            const QByteArray& contentType, const QByteArray& body) {
+    QByteArray response = "HTTP/1.1 " + status + "\r\n";
+    response += "Content-Type: " + contentType + "\r\n";
+    response += "Content-Length: " + QByteArray::number(body.size()) + "\r\n";
+    response += "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
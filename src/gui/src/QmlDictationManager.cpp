@@ -1,4 +1,6 @@
 #include "QmlDictationManager.h"
+#include "Logging.h"
+#include "Trace.h"
 #include <QQmlComponent>
 #include <QDebug>
 
@@ -7,7 +9,7 @@ QmlDictationManager::QmlDictationManager(QQmlApplicationEngine *engine, QObject
     , m_engine(engine)
     , m_dictationWindow(nullptr)
 {
-    createDictationWindow();
+    // The window is created on first use or by preload(), not during startup
 }
 
 QmlDictationManager::~QmlDictationManager()
@@ -15,24 +17,33 @@ QmlDictationManager::~QmlDictationManager()
     // The m_dictationWindow is owned by QML and will be destroyed automatically
 }
 
+void QmlDictationManager::preload()
+{
+    createDictationWindow();
+}
+
 void QmlDictationManager::createDictationWindow()
 {
+    if (m_dictationWindow) {
+        return;
+    }
+
     QQmlComponent component(m_engine, QUrl("qrc:/DictationWindow.qml"));
 
     if (component.isError()) {
-        qWarning() << "Error loading DictationWindow.qml:" << component.errors();
+        qCWarning(lcUi) << "Error loading DictationWindow.qml:" << component.errors();
         return;
     }
 
     QObject *object = component.create();
     if (!object) {
-        qWarning() << "Failed to create DictationWindow object";
+        qCWarning(lcUi) << "Failed to create DictationWindow object";
         return;
     }
 
     m_dictationWindow = qobject_cast<QQuickWindow*>(object);
     if (!m_dictationWindow) {
-        qWarning() << "Created object is not a QQuickWindow";
+        qCWarning(lcUi) << "Created object is not a QQuickWindow";
         delete object;
         return;
     }
@@ -41,16 +52,17 @@ void QmlDictationManager::createDictationWindow()
     QObject::connect(object, SIGNAL(dictationClicked()),
                      this, SIGNAL(dictationWidgetClicked()));
 
-    qDebug() << "Dictation window created successfully";
+    qCDebug(lcUi) << "Dictation window created successfully";
 }
 
 void QmlDictationManager::showDictationWidget()
 {
+    createDictationWindow();
     if (m_dictationWindow) {
         QMetaObject::invokeMethod(m_dictationWindow, "show");
-        qDebug() << "Showing dictation widget";
+        qCDebug(lcUi) << "Showing dictation widget";
     } else {
-        qWarning() << "Cannot show dictation widget: window not created";
+        qCWarning(lcUi) << "Cannot show dictation widget: window not created";
     }
 }
 
@@ -58,15 +70,25 @@ void QmlDictationManager::hideDictationWidget()
 {
     if (m_dictationWindow) {
         QMetaObject::invokeMethod(m_dictationWindow, "hide");
-        qDebug() << "Hiding dictation widget";
+        qCDebug(lcUi) << "Hiding dictation widget";
     }
 }
 
 void QmlDictationManager::setRecordingState(bool recording)
 {
+    Trace::Span span("qml recording state");
     if (m_dictationWindow) {
         QMetaObject::invokeMethod(m_dictationWindow, "setRecording",
                                   Q_ARG(QVariant, recording));
-        qDebug() << "Setting dictation widget recording state:" << recording;
+        qCDebug(lcUi) << "Setting dictation widget recording state:" << recording;
+    }
+}
+
+void QmlDictationManager::setLevels(qreal level, const QVariantList& waveform)
+{
+    // ~30 times a second while recording, so no logging here
+    if (m_dictationWindow) {
+        QMetaObject::invokeMethod(m_dictationWindow, "setLevels",
+                                  Q_ARG(QVariant, level), Q_ARG(QVariant, waveform));
     }
 }
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include "RequestPolicy.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTimer>
+#include <algorithm>
+
+namespace {
+    // Every attempt gets this long plus the time to send the body at a slow uplink rate
+    constexpr qint64 kBaseTimeoutMs = 15000;
+    constexpr qint64 kMinBytesPerSecond = 32 * 1024;
+    constexpr int kMaxAttempts = 3;
+    constexpr qint64 kBackoffBaseMs = 250;
+    constexpr qint64 kBackoffCapMs = 4000;
+    // Recent successful latencies kept for the hedging threshold
+    constexpr size_t kLatencyWindow = 64;
+    constexpr size_t kMinLatencySamples = 8;
+    constexpr qint64 kMinHedgeDelayMs = 500;
+    // Upload and server time both grow with the audio sent, so latencies are compared
+    // per MiB. Smaller requests count as this size, where the round trip dominates.
+    constexpr qint64 kMinNormalisedBytes = 256 * 1024;
+    constexpr double kBytesPerMiB = 1024.0 * 1024.0;
+
+    double normalisedMiB(qint64 payloadBytes) {
+        return std::max(payloadBytes, kMinNormalisedBytes) / kBytesPerMiB;
+    }
+
+    // Mirrors RequestPolicy::Stats for the metrics endpoint
+    Metrics::Counter& policyCounter(const char* name, const char* help) {
+        return Metrics::Registry::instance().counter(name, help);
+    }
+} // namespace
+
+// One logical request and the attempts made for it
+struct RequestPolicy::Call {
+    int id = 0;
+    Sender sender;
+    Handler done;
+    qint64 payloadBytes = 0;
+    qint64 attemptTimeoutMs = 0;
+    QDeadlineTimer deadline;
+    int attempt = 0;
+    QList<QNetworkReply*> active; // the attempt and, once sent, its hedge
+    QNetworkReply* hedgeReply = nullptr;
+    QElapsedTimer attemptClock;
+    QTimer attemptTimer;
+    QTimer hedgeTimer;
+    QTimer retryTimer;
+    bool finished = false;
+};
+
+RequestPolicy::RequestPolicy(QObject* parent)
+    : QObject(parent), m_nextId(1), m_hedging(false), m_latencyNext(0) {}
+
+int RequestPolicy::send(const Sender& sender, qint64 payloadBytes, const Handler& done)
+{
+    auto call = QSharedPointer<Call>::create();
+    call->id = m_nextId++;
+    call->sender = sender;
+    call->done = done;
+    call->payloadBytes = payloadBytes;
+    call->attemptTimeoutMs = attemptTimeoutMs(payloadBytes);
+    // Enough for one attempt to time out and another to run in full
+    call->deadline = QDeadlineTimer(call->attemptTimeoutMs * 2);
+
+    call->attemptTimer.setSingleShot(true);
+    call->hedgeTimer.setSingleShot(true);
+    call->retryTimer.setSingleShot(true);
+
+    // The timers live in the call, so their slots must not keep it alive
+    const QWeakPointer<Call> weak = call;
+    connect(&call->attemptTimer, &QTimer::timeout, this, [this, weak]() {
+        if (auto call = weak.toStrongRef()) {
+            ++m_stats.timeouts;
+            static Metrics::Counter& timeouts = policyCounter(
+                "vibeco_request_timeouts_total", "Request attempts aborted for taking too long");
+            timeouts.add();
+            qCDebug(lcTranscription) << "Request attempt" << call->attempt << "timed out after"
+                                     << call->attemptClock.elapsed() << "ms";
+            // abort() finishes the reply synchronously, which edits active; iterate a copy
+            const QList<QNetworkReply*> replies = call->active;
+            for (QNetworkReply* reply : replies) {
+                reply->setProperty(kTimedOutProperty, true);
+                reply->abort();
+            }
+        }
+    });
+    connect(&call->hedgeTimer, &QTimer::timeout, this, [this, weak]() {
+        auto call = weak.toStrongRef();
+        if (call && !call->finished && call->active.size() == 1 && !call->hedgeReply) {
+            ++m_stats.hedges;
+            static Metrics::Counter& hedges = policyCounter(
+                "vibeco_request_hedges_total", "Duplicate requests sent because one was slow");
+            hedges.add();
+            qCDebug(lcTranscription) << "Request slower than p95 ("
+                                     << hedgeDelayMs(call->payloadBytes)
+                                     << "ms for its size), sending a hedge";
+            launch(call, true);
+        }
+    });
+    connect(&call->retryTimer, &QTimer::timeout, this, [this, weak]() {
+        if (auto call = weak.toStrongRef()) {
+            startAttempt(call);
+        }
+    });
+
+    ++m_stats.requests;
+    static Metrics::Counter& requests =
+        policyCounter("vibeco_requests_total", "Transcription requests, however many attempts");
+    requests.add();
+    m_calls.insert(call->id, call);
+    startAttempt(call);
+    return call->id;
+}
+
+void RequestPolicy::cancel(int id)
+{
+    QSharedPointer<Call> call = m_calls.take(id);
+    if (!call) {
+        return;
+    }
+    call->finished = true;
+    call->attemptTimer.stop();
+    call->hedgeTimer.stop();
+    call->retryTimer.stop();
+    abortActive(call);
+}
+
+qint64 RequestPolicy::hedgeDelayMs(qint64 payloadBytes) const
+{
+    if (m_latencies.size() < kMinLatencySamples) {
+        return -1;
+    }
+    std::vector<double> sorted = m_latencies;
+    const size_t index = sorted.size() * 95 / 100;
+    std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    const auto delay = static_cast<qint64>(sorted[index] * normalisedMiB(payloadBytes));
+    return std::max(delay, kMinHedgeDelayMs);
+}
+
+qint64 RequestPolicy::attemptTimeoutMs(qint64 payloadBytes)
+{
+    return kBaseTimeoutMs + payloadBytes * 1000 / kMinBytesPerSecond;
+}
+
+void RequestPolicy::startAttempt(const QSharedPointer<Call>& call)
+{
+    ++call->attempt;
+    call->hedgeReply = nullptr;
+    call->attemptClock.start();
+
+    const qint64 remaining = call->deadline.remainingTime();
+    call->attemptTimer.start(static_cast<int>(std::min(call->attemptTimeoutMs, remaining)));
+    launch(call, false);
+
+    const qint64 hedgeDelay = hedgeDelayMs(call->payloadBytes);
+    if (m_hedging && hedgeDelay >= 0 && hedgeDelay < remaining) {
+        call->hedgeTimer.start(static_cast<int>(hedgeDelay));
+    }
+}
+
+void RequestPolicy::launch(const QSharedPointer<Call>& call, bool hedge)
+{
+    ++m_stats.attempts;
+    QNetworkReply* reply = call->sender();
+    call->active.append(reply);
+    if (hedge) {
+        call->hedgeReply = reply;
+    }
+    connect(reply, &QNetworkReply::finished, this,
+            [this, call, reply]() { handleFinished(call, reply); });
+}
+
+void RequestPolicy::handleFinished(const QSharedPointer<Call>& call, QNetworkReply* reply)
+{
+    call->active.removeOne(reply);
+    if (call->finished) {
+        reply->deleteLater(); // cancelled, or lost the race
+        return;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() == QNetworkReply::NoError && (status == 0 || status / 100 == 2)) {
+        if (reply == call->hedgeReply) {
+            ++m_stats.hedgeWins;
+            static Metrics::Counter& hedgeWins = policyCounter(
+                "vibeco_request_hedge_wins_total", "Hedged requests where the duplicate won");
+            hedgeWins.add();
+        }
+        recordLatency(call->attemptClock.elapsed(), call->payloadBytes);
+        finish(call, reply);
+        return;
+    }
+
+    if (!call->active.isEmpty()) {
+        reply->deleteLater(); // the other copy of this attempt may still succeed
+        return;
+    }
+
+    const qint64 remaining = call->deadline.remainingTime();
+    if (isRetryable(reply) && call->attempt < kMaxAttempts) {
+        // Full jitter: anywhere between zero and the exponential cap
+        const qint64 cap = std::min(kBackoffCapMs, kBackoffBaseMs << (call->attempt - 1));
+        const qint64 delay = std::max(QRandomGenerator::global()->bounded(cap + 1),
+                                      retryAfterMs(reply));
+        if (delay < remaining) {
+            ++m_stats.retries;
+            static Metrics::Counter& retries = policyCounter(
+                "vibeco_request_retries_total", "Request attempts repeated after a failure");
+            retries.add();
+            qCDebug(lcTranscription) << "Retrying request after" << reply->errorString() << "(HTTP"
+                                     << status << ") in" << delay << "ms, attempt"
+                                     << call->attempt + 1;
+            call->attemptTimer.stop();
+            call->hedgeTimer.stop();
+            reply->deleteLater();
+            call->retryTimer.start(static_cast<int>(delay));
+            return;
+        }
+    }
+
+    ++m_stats.failures;
+    finish(call, reply);
+}
+
+void RequestPolicy::finish(const QSharedPointer<Call>& call, QNetworkReply* reply)
+{
+    call->finished = true;
+    call->attemptTimer.stop();
+    call->hedgeTimer.stop();
+    call->retryTimer.stop();
+    abortActive(call);
+    m_calls.remove(call->id);
+
+    qCDebug(lcTranscription) << "Request done after" << call->attempt
+                             << "attempt(s); totals: retries" << m_stats.retries << "timeouts"
+                             << m_stats.timeouts << "hedges" << m_stats.hedges << "hedge wins"
+                             << m_stats.hedgeWins;
+    call->done(reply);
+}
+
+void RequestPolicy::abortActive(const QSharedPointer<Call>& call)
+{
+    const QList<QNetworkReply*> replies = call->active;
+    for (QNetworkReply* reply : replies) {
+        reply->abort();
+    }
+}
+
+bool RequestPolicy::isRetryable(QNetworkReply* reply)
+{
+    if (reply->property(kTimedOutProperty).toBool()) {
+        return true;
+    }
+
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    switch (status) {
+    case 408: // Request Timeout
+    case 429: // Too Many Requests
+    case 500:
+    case 502:
+    case 503:
+    case 504:
+        return true;
+    case 0:
+        break;
+    default:
+        return false; // The server answered; asking again won't change it
+    }
+
+    switch (reply->error()) {
+    case QNetworkReply::ConnectionRefusedError:
+    case QNetworkReply::RemoteHostClosedError:
+    case QNetworkReply::HostNotFoundError:
+    case QNetworkReply::TimeoutError:
+    case QNetworkReply::TemporaryNetworkFailureError:
+    case QNetworkReply::NetworkSessionFailedError:
+    case QNetworkReply::ProxyTimeoutError:
+    case QNetworkReply::UnknownNetworkError:
+        return true;
+    default:
+        return false;
+    }
+}
+
+qint64 RequestPolicy::retryAfterMs(QNetworkReply* reply)
+{
+    // Only the delta-seconds form; Groq doesn't send HTTP dates here
+    bool ok = false;
+    const qint64 seconds = reply->rawHeader("Retry-After").trimmed().toLongLong(&ok);
+    return ok && seconds > 0 ? seconds * 1000 : 0;
+}
+
+void RequestPolicy::recordLatency(qint64 ms, qint64 payloadBytes)
+{
+    const double msPerMiB = ms / normalisedMiB(payloadBytes);
+    if (m_latencies.size() < kLatencyWindow) {
+        m_latencies.push_back(msPerMiB);
+    } else {
+        m_latencies[m_latencyNext] = msPerMiB;
+    }
+    m_latencyNext = (m_latencyNext + 1) % kLatencyWindow;
+}
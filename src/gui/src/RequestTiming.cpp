@@ -0,0 +1,115 @@
+#include "RequestTiming.h"
+#include <QElapsedTimer>
+#include <QNetworkReply>
+#include <QSharedPointer>
+#include <QUrl>
+
+namespace {
+    // Nanosecond timestamps relative to the post() call; -1 until reached
+    struct Marks {
+        QElapsedTimer clock;
+        qint64 connectStarted = -1;
+        qint64 encrypted = -1;
+        qint64 requestSent = -1;
+        qint64 firstByte = -1;
+        qint64 bytesSent = 0;
+    };
+
+    double spanMs(qint64 from, qint64 to) {
+        if (from < 0 || to < 0) {
+            return -1.0;
+        }
+        return (to - from) / 1e6;
+    }
+
+    // OpenAI-style APIs send openai-processing-ms; others use Server-Timing's dur=
+    double serverProcessingMs(const QNetworkReply* reply) {
+        bool ok = false;
+        const double processing = reply->rawHeader("openai-processing-ms").toDouble(&ok);
+        if (ok) {
+            return processing;
+        }
+
+        const QList<QByteArray> metrics = reply->rawHeader("server-timing").split(',');
+        for (const QByteArray& metric : metrics) {
+            for (const QByteArray& param : metric.split(';')) {
+                const QByteArray trimmed = param.trimmed();
+                if (trimmed.startsWith("dur=")) {
+                    const double duration = trimmed.mid(4).toDouble(&ok);
+                    if (ok) {
+                        return duration;
+                    }
+                }
+            }
+        }
+        return -1.0;
+    }
+} // namespace
+
+QString RequestTiming::summary() const
+{
+    auto field = [](double ms) {
+        return ms < 0.0 ? QStringLiteral("-") : QString::number(ms, 'f', 1);
+    };
+    return QString("%1 %2%3: dns %4, connect %5, upload %6, ttfb %7 (server %8), download %9, "
+                   "total %10 ms")
+        .arg(host, http2 ? "h2" : "http/1.1", reusedConnection ? " (reused)" : "")
+        .arg(field(dnsMs), field(connectMs), field(uploadMs), field(firstByteMs), field(serverMs),
+             field(downloadMs), field(totalMs));
+}
+
+void trackRequestTiming(QNetworkReply* reply, double dnsMs,
+                        std::function<void(const RequestTiming&)> done)
+{
+    auto marks = QSharedPointer<Marks>::create();
+    marks->clock.start();
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 3, 0)
+    QObject::connect(reply, &QNetworkReply::socketStartedConnecting, reply, [marks]() {
+        if (marks->connectStarted < 0) {
+            marks->connectStarted = marks->clock.nsecsElapsed();
+        }
+    });
+    QObject::connect(reply, &QNetworkReply::requestSent, reply, [marks]() {
+        marks->requestSent = marks->clock.nsecsElapsed();
+    });
+#endif
+#if QT_CONFIG(ssl)
+    QObject::connect(reply, &QNetworkReply::encrypted, reply, [marks]() {
+        marks->encrypted = marks->clock.nsecsElapsed();
+    });
+#endif
+    QObject::connect(reply, &QNetworkReply::uploadProgress, reply, [marks](qint64 sent, qint64) {
+        marks->bytesSent = sent;
+    });
+    QObject::connect(reply, &QNetworkReply::metaDataChanged, reply, [marks]() {
+        if (marks->firstByte < 0) {
+            marks->firstByte = marks->clock.nsecsElapsed();
+        }
+    });
+
+    QObject::connect(reply, &QNetworkReply::finished, reply, [reply, marks, dnsMs, done]() {
+        const qint64 finished = marks->clock.nsecsElapsed();
+
+        RequestTiming timing;
+        timing.host = reply->url().host();
+        timing.http2 = reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool();
+        timing.reusedConnection = marks->connectStarted < 0;
+        timing.dnsMs = dnsMs;
+
+        // Plain HTTP has no handshake; the connection is up once sending starts
+        const qint64 connected = marks->encrypted >= 0 ? marks->encrypted : -1;
+        if (!timing.reusedConnection) {
+            timing.connectMs = spanMs(marks->connectStarted, connected);
+        }
+        const qint64 uploadStart =
+            timing.reusedConnection || connected < 0 ? 0 : connected;
+        timing.uploadMs = spanMs(uploadStart, marks->requestSent);
+        timing.firstByteMs = spanMs(marks->requestSent, marks->firstByte);
+        timing.downloadMs = spanMs(marks->firstByte, finished);
+        timing.totalMs = spanMs(0, finished);
+        timing.serverMs = serverProcessingMs(reply);
+        timing.bytesSent = marks->bytesSent;
+        done(timing);
+    });
+}
@@ -1,5 +1,7 @@
 #include "ShortcutManager.h"
+#include "Logging.h"
 #include "systemtrayhandler.h"
+#include "Trace.h"
 #include <QDebug>
 
 #ifdef Q_OS_MAC
@@ -13,12 +15,12 @@ ShortcutManager::ShortcutManager(SystemTrayHandler* trayHandler, QObject *parent
 
 #ifdef Q_OS_MAC
     if (!checkAccessibilityPermissions()) {
-        qDebug() << "Accessibility permissions not granted!";
+        qCDebug(lcHotkey) << "Accessibility permissions not granted!";
         return;
     }
 
     if (!isFnKeyAvailable()) {
-        qDebug() << "Fn key is not available on this system!";
+        qCDebug(lcHotkey) << "Fn key is not available on this system!";
         return;
     }
 #endif
@@ -46,11 +48,12 @@ ShortcutManager::ShortcutManager(SystemTrayHandler* trayHandler, QObject *parent
         const auto& sequence = sequences[i];
         m_hotkey = new QHotkey(sequence, true, this);
         if (m_hotkey->isRegistered()) {
-            qDebug() << "Hotkey registered successfully with sequence:" << sequence.toString();
+            qCDebug(lcHotkey) << "Hotkey registered successfully with sequence:"
+                              << sequence.toString();
             registered = true;
             break;
         }
-        qDebug() << "Failed to register hotkey with sequence:" << sequence.toString();
+        qCDebug(lcHotkey) << "Failed to register hotkey with sequence:" << sequence.toString();
         delete m_hotkey;
         m_hotkey = nullptr;
     }
@@ -58,7 +61,7 @@ ShortcutManager::ShortcutManager(SystemTrayHandler* trayHandler, QObject *parent
     if (registered) {
         connect(m_hotkey, &QHotkey::activated, this, &ShortcutManager::onHotkeyActivated);
     } else {
-        qDebug() << "Failed to register hotkey with any sequence!";
+        qCDebug(lcHotkey) << "Failed to register hotkey with any sequence!";
     }
 }
 
@@ -69,30 +72,26 @@ ShortcutManager::~ShortcutManager()
 
 void ShortcutManager::onHotkeyActivated()
 {
-    qDebug() << "Hotkey activated!";
-
-    if (m_trayHandler && m_trayHandler->trayIcon()) {
-        QString message;
-#ifdef Q_OS_MAC
-        message = "You pressed Command+Space!";  // Update based on which shortcut gets registered
-#else
-        message = "You pressed Ctrl+Space!";
-#endif
+    qCDebug(lcHotkey) << "Hotkey activated!";
+    if (!m_trayHandler) {
+        return;
+    }
 
-        m_trayHandler->trayIcon()->showMessage(
-            "Shortcut Activated", 
-            message,
-            QSystemTrayIcon::Information,
-            3000
-        );
+    // Toggles dictation; the tray handler reports the result
+    if (m_trayHandler->isRecording()) {
+        Trace::instant("hotkey", Trace::currentDictation());
+        m_trayHandler->stopRecording();
     } else {
-        qDebug() << "Tray icon not available!";
+        // The dictation begins at the key press, so its trace includes starting the capture
+        const uint64_t dictation = Trace::beginDictation();
+        Trace::instant("hotkey", dictation);
+        m_trayHandler->startRecording(dictation);
     }
 }
 
 void ShortcutManager::testNotification()
 {
-    qDebug() << "Testing notification system";
+    qCDebug(lcHotkey) << "Testing notification system";
     if (m_trayHandler && m_trayHandler->trayIcon()) {
         m_trayHandler->trayIcon()->showMessage(
             "Test Notification", 
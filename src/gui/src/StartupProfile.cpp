@@ -0,0 +1,58 @@
+#include "StartupProfile.h"
+#include "Logging.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QList>
+#include <QPair>
+#include <QTimer>
+#include <cstdio>
+
+namespace {
+    QElapsedTimer clock;
+    bool benchmark = false;
+    QList<QPair<QByteArray, double>> milestones;
+
+    // False if the milestone was already reached (or profiling never began)
+    bool record(const char* name) {
+        if (!clock.isValid()) {
+            return false;
+        }
+        for (const auto& milestone : std::as_const(milestones)) {
+            if (milestone.first == name) {
+                return false;
+            }
+        }
+        const double ms = clock.nsecsElapsed() / 1e6;
+        milestones.append({name, ms});
+        qCDebug(lcStartup) << "Startup:" << name << "after" << ms << "ms";
+        return true;
+    }
+} // namespace
+
+namespace StartupProfile {
+    void begin(bool benchmarkMode) {
+        clock.start();
+        benchmark = benchmarkMode;
+        milestones.clear();
+    }
+
+    void mark(const char* name) {
+        record(name);
+    }
+
+    void markReady() {
+        if (!record("ready_to_record") || !benchmark) {
+            return;
+        }
+
+        QByteArray line = "startup";
+        for (const auto& [name, ms] : std::as_const(milestones)) {
+            line += ' ' + name + "_ms=" + QByteArray::number(ms, 'f', 1);
+        }
+        std::printf("%s\n", line.constData());
+        std::fflush(stdout);
+        // Let the current event finish before tearing everything down
+        QTimer::singleShot(0, qApp, &QCoreApplication::quit);
+    }
+} // namespace StartupProfile
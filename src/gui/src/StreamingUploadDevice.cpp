@@ -0,0 +1,102 @@
+#include "StreamingUploadDevice.h"
+#include <QMutexLocker>
+#include <cstring>
+
+StreamingUploadDevice::StreamingUploadDevice(QObject* parent)
+    : QIODevice(parent), m_totalAppended(0), m_finished(false), m_closed(false) {
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void StreamingUploadDevice::appendData(const QByteArray& data) {
+    if (data.isEmpty()) {
+        return;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_finished || m_closed) {
+            return;
+        }
+        m_pending.append(data);
+        m_totalAppended += data.size();
+    }
+    notifyReadyRead();
+}
+
+void StreamingUploadDevice::finish() {
+    {
+        QMutexLocker locker(&m_mutex);
+        if (m_finished) {
+            return;
+        }
+        m_finished = true;
+    }
+    notifyReadyRead();
+}
+
+void StreamingUploadDevice::abort() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_pending.clear();
+    }
+    QMetaObject::invokeMethod(this, [this]() { close(); }, Qt::QueuedConnection);
+}
+
+bool StreamingUploadDevice::isFinished() const {
+    QMutexLocker locker(&m_mutex);
+    return m_finished;
+}
+
+bool StreamingUploadDevice::isClosed() const {
+    QMutexLocker locker(&m_mutex);
+    return m_closed;
+}
+
+qint64 StreamingUploadDevice::totalBytesAppended() const {
+    QMutexLocker locker(&m_mutex);
+    return m_totalAppended;
+}
+
+bool StreamingUploadDevice::atEnd() const {
+    QMutexLocker locker(&m_mutex);
+    return m_finished && m_pending.isEmpty();
+}
+
+qint64 StreamingUploadDevice::bytesAvailable() const {
+    QMutexLocker locker(&m_mutex);
+    return m_pending.size() + QIODevice::bytesAvailable();
+}
+
+void StreamingUploadDevice::close() {
+    {
+        QMutexLocker locker(&m_mutex);
+        m_closed = true;
+        m_pending.clear();
+    }
+    QIODevice::close();
+}
+
+qint64 StreamingUploadDevice::readData(char* data, qint64 maxSize) {
+    QMutexLocker locker(&m_mutex);
+    if (m_pending.isEmpty()) {
+        // -1 signals end-of-stream to the network stack, 0 means "come back later"
+        return m_finished || m_closed ? -1 : 0;
+    }
+
+    const qint64 count = qMin<qint64>(maxSize, m_pending.size());
+    std::memcpy(data, m_pending.constData(), count);
+    m_pending.remove(0, count);
+    return count;
+}
+
+qint64 StreamingUploadDevice::writeData(const char* data, qint64 maxSize) {
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
+
+void StreamingUploadDevice::notifyReadyRead() {
+    // readyRead must be emitted from the thread the device lives in
+    QMetaObject::invokeMethod(this, [this]() { emit readyRead(); }, Qt::QueuedConnection);
+}
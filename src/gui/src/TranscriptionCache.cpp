@@ -0,0 +1,178 @@
+#include "TranscriptionCache.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "XxHash64.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <vector>
+
+namespace {
+    constexpr qint64 kReadChunk = 1 << 20;
+    const QString kSuffix = ".json";
+
+    QString hex(uint64_t value) {
+        return QString("%1").arg(static_cast<qulonglong>(value), 16, 16, QChar('0'));
+    }
+
+    Metrics::Counter& lookupCounter(const char* result) {
+        return Metrics::Registry::instance().counter(
+            "vibeco_cache_lookups_total", "Transcription cache lookups",
+            std::string("result=\"") + result + "\"");
+    }
+} // namespace
+
+TranscriptionCache::TranscriptionCache(const QString& directory, qint64 maxBytes)
+    : m_directory(directory), m_maxBytes(maxBytes)
+{
+    QDir().mkpath(m_directory);
+
+    const QFileInfoList files =
+        QDir(m_directory).entryInfoList({"*" + kSuffix}, QDir::Files);
+    for (const QFileInfo& info : files) {
+        m_entries.insert(info.completeBaseName(),
+                         {info.size(), info.lastModified().toMSecsSinceEpoch()});
+        m_stats.bytes += info.size();
+    }
+    m_stats.entries = m_entries.size();
+    evict();
+
+    qCDebug(lcTranscription) << "Transcription cache:" << m_stats.entries << "entries,"
+                             << m_stats.bytes << "bytes in" << m_directory;
+}
+
+QString TranscriptionCache::keyFor(const QByteArray& audio, const QString& parameters)
+{
+    const QByteArray params = parameters.toUtf8();
+    return hex(XxHash64::hash(audio.constData(), static_cast<size_t>(audio.size()))) + '-' +
+           hex(XxHash64::hash(params.constData(), static_cast<size_t>(params.size())));
+}
+
+QString TranscriptionCache::keyForFile(const QString& filePath, const QString& parameters)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return keyForDevice(&file, parameters);
+}
+
+QString TranscriptionCache::keyForDevice(QIODevice* device, const QString& parameters)
+{
+    XxHash64 state;
+    while (!device->atEnd()) {
+        const QByteArray chunk = device->read(kReadChunk);
+        if (chunk.isEmpty()) {
+            return {}; // read error
+        }
+        state.update(chunk.constData(), static_cast<size_t>(chunk.size()));
+    }
+
+    const QByteArray params = parameters.toUtf8();
+    return hex(state.digest()) + '-' +
+           hex(XxHash64::hash(params.constData(), static_cast<size_t>(params.size())));
+}
+
+QString TranscriptionCache::entryPath(const QString& key) const
+{
+    return QDir(m_directory).filePath(key + kSuffix);
+}
+
+bool TranscriptionCache::lookup(const QString& key, TranscriptionResult& result)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        ++m_stats.misses;
+        lookupCounter("miss").add();
+        qCDebug(lcTranscription) << "Transcription cache miss; hits" << m_stats.hits << "misses"
+                                 << m_stats.misses;
+        return false;
+    }
+
+    // Entries are stored in the API's own verbose_json shape
+    QFile file(entryPath(key));
+    QString error;
+    if (!file.open(QIODevice::ReadWrite) ||
+        !TranscriptionResult::fromVerboseJson(file.readAll(), result, error)) {
+        // Deleted or damaged behind our back; forget it
+        file.close();
+        QFile::remove(entryPath(key));
+        m_stats.bytes -= it->size;
+        m_entries.erase(it);
+        m_stats.entries = m_entries.size();
+        ++m_stats.misses;
+        lookupCounter("miss").add();
+        return false;
+    }
+
+    // Bump recency in memory and on disk, so the order survives restarts
+    const QDateTime now = QDateTime::currentDateTime();
+    file.setFileTime(now, QFileDevice::FileModificationTime);
+    it->lastUsed = now.toMSecsSinceEpoch();
+
+    ++m_stats.hits;
+    lookupCounter("hit").add();
+    qCDebug(lcTranscription) << "Transcription cache hit; hits" << m_stats.hits << "misses"
+                             << m_stats.misses;
+    return true;
+}
+
+void TranscriptionCache::store(const QString& key, const TranscriptionResult& result)
+{
+    if (key.isEmpty()) {
+        return;
+    }
+
+    const QByteArray data = result.toVerboseJson();
+    QSaveFile file(entryPath(key));
+    if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit()) {
+        qCWarning(lcTranscription) << "Could not write transcription cache entry" << entryPath(key)
+                                   << file.errorString();
+        return;
+    }
+
+    auto it = m_entries.find(key);
+    if (it != m_entries.end()) {
+        m_stats.bytes -= it->size;
+    }
+    m_entries.insert(key, {data.size(), QDateTime::currentMSecsSinceEpoch()});
+    m_stats.bytes += data.size();
+    m_stats.entries = m_entries.size();
+    ++m_stats.stores;
+
+    evict();
+}
+
+void TranscriptionCache::evict()
+{
+    static Metrics::Counter& evictions = Metrics::Registry::instance().counter(
+        "vibeco_cache_evictions_total", "Transcription cache entries deleted to stay in budget");
+
+    if (m_stats.bytes <= m_maxBytes) {
+        return;
+    }
+
+    std::vector<std::pair<qint64, QString>> byAge;
+    byAge.reserve(m_entries.size());
+    for (auto it = m_entries.cbegin(); it != m_entries.cend(); ++it) {
+        byAge.emplace_back(it->lastUsed, it.key());
+    }
+    std::sort(byAge.begin(), byAge.end());
+
+    for (const auto& entry : byAge) {
+        if (m_stats.bytes <= m_maxBytes) {
+            break;
+        }
+        const QString& key = entry.second;
+        QFile::remove(entryPath(key));
+        m_stats.bytes -= m_entries.value(key).size;
+        m_entries.remove(key);
+        ++m_stats.evictions;
+        evictions.add();
+    }
+    m_stats.entries = m_entries.size();
+}
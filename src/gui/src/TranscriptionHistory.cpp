@@ -0,0 +1,242 @@
+#include "TranscriptionHistory.h"
+#include "Logging.h"
+#include <QClipboard>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QGuiApplication>
+#include <QtEndian>
+#include <algorithm>
+
+namespace {
+    // Rows handed to a view per fetchMore(), and entries read from disk at once
+    constexpr int kPageSize = 64;
+    constexpr int kCachedPages = 32;
+} // namespace
+
+TranscriptionHistory::TranscriptionHistory(const QString& directory, QObject* parent)
+    : QAbstractListModel(parent), m_directory(directory), m_fetched(0), m_pages(kCachedPages)
+{
+    QDir().mkpath(directory);
+    if (!m_log.open(QFile::encodeName(logPath()).toStdString())) {
+        qCWarning(lcUi) << "Could not open transcription history" << logPath();
+    }
+    if (!m_tombstones.open(QFile::encodeName(directory + "/deleted.log").toStdString())) {
+        qCWarning(lcUi) << "Could not open transcription history tombstones in" << directory;
+    }
+
+    std::vector<bool> deleted(m_log.size(), false);
+    std::string payload;
+    for (size_t i = 0; i < m_tombstones.size(); ++i) {
+        if (m_tombstones.read(i, payload) && payload.size() == sizeof(quint32)) {
+            const quint32 record = qFromLittleEndian<quint32>(payload.data());
+            if (record < deleted.size()) {
+                deleted[record] = true;
+            }
+        }
+    }
+
+    m_records.reserve(m_log.size());
+    for (size_t i = 0; i < m_log.size(); ++i) {
+        if (!deleted[i]) {
+            m_records.push_back(static_cast<quint32>(i));
+        }
+    }
+    qCDebug(lcUi) << "Transcription history:" << m_records.size() << "entries";
+}
+
+int TranscriptionHistory::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_fetched;
+}
+
+int TranscriptionHistory::count() const
+{
+    return static_cast<int>(m_records.size());
+}
+
+bool TranscriptionHistory::canFetchMore(const QModelIndex& parent) const
+{
+    return !parent.isValid() && m_fetched < count();
+}
+
+void TranscriptionHistory::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+    const int more = std::min(kPageSize, count() - m_fetched);
+    if (more <= 0) {
+        return;
+    }
+    beginInsertRows(QModelIndex(), m_fetched, m_fetched + more - 1);
+    m_fetched += more;
+    endInsertRows();
+}
+
+QHash<int, QByteArray> TranscriptionHistory::roleNames() const
+{
+    return {
+        {TextRole, "text"},
+        {TimestampRole, "timestamp"},
+        {DurationRole, "duration"},
+        {LanguageRole, "language"},
+    };
+}
+
+quint32 TranscriptionHistory::recordForRow(int row) const
+{
+    return m_records[m_records.size() - 1 - static_cast<size_t>(row)];
+}
+
+const TranscriptionHistory::Entry& TranscriptionHistory::entry(int row) const
+{
+    // Pages are groups of consecutive records, so deleting rows never invalidates one
+    const quint32 record = recordForRow(row);
+    const quint32 pageNumber = record / kPageSize;
+    Page* page = m_pages.object(pageNumber);
+    if (!page) {
+        page = new Page(kPageSize);
+        const size_t first = static_cast<size_t>(pageNumber) * kPageSize;
+        const size_t last = std::min(first + kPageSize, m_log.size());
+        std::string payload;
+        for (size_t i = first; i < last; ++i) {
+            if (m_log.read(i, payload)) {
+                (*page)[static_cast<int>(i - first)] = decode(payload);
+            }
+        }
+        m_pages.insert(pageNumber, page);
+    }
+    return (*page)[static_cast<int>(record % kPageSize)];
+}
+
+QVariant TranscriptionHistory::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_fetched) {
+        return QVariant();
+    }
+
+    const Entry& item = entry(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case TextRole:
+        return item.valid ? item.text : tr("(unreadable entry)");
+    case TimestampRole:
+        return item.valid ? QDateTime::fromMSecsSinceEpoch(item.createdMs)
+                                .toString("yyyy-MM-dd hh:mm:ss")
+                          : QString();
+    case DurationRole:
+        return item.duration;
+    case LanguageRole:
+        return item.language;
+    }
+    return QVariant();
+}
+
+QByteArray TranscriptionHistory::encode(const TranscriptionResult& result, qint64 createdMs)
+{
+    // Creation time, then the result as verbose_json (segments included, for later use)
+    QByteArray payload(sizeof(qint64), Qt::Uninitialized);
+    qToLittleEndian<qint64>(createdMs, payload.data());
+    payload += result.toVerboseJson();
+    return payload;
+}
+
+TranscriptionHistory::Entry TranscriptionHistory::decode(const std::string& payload)
+{
+    Entry entry;
+    if (payload.size() < sizeof(qint64)) {
+        return entry;
+    }
+    TranscriptionResult result{};
+    QString error;
+    const QByteArray json = QByteArray::fromRawData(payload.data() + sizeof(qint64),
+                                                    payload.size() - sizeof(qint64));
+    if (!TranscriptionResult::fromVerboseJson(json, result, error)) {
+        return entry;
+    }
+    entry.text = result.text;
+    entry.language = result.language;
+    entry.duration = qMax(0.0, result.duration);
+    entry.createdMs = qFromLittleEndian<qint64>(payload.data());
+    entry.valid = true;
+    return entry;
+}
+
+void TranscriptionHistory::append(const TranscriptionResult& result)
+{
+    const QByteArray payload = encode(result, QDateTime::currentMSecsSinceEpoch());
+    if (!m_log.append(std::string_view(payload.constData(), payload.size()))) {
+        qCWarning(lcUi) << "Could not save transcription to history";
+        return;
+    }
+    const quint32 record = static_cast<quint32>(m_log.size() - 1);
+    // A page read before this record existed is missing it
+    m_pages.remove(record / kPageSize);
+
+    beginInsertRows(QModelIndex(), 0, 0);
+    m_records.push_back(record);
+    ++m_fetched;
+    endInsertRows();
+    emit countChanged();
+    emit entryAdded(record, result.text);
+}
+
+void TranscriptionHistory::remove(int row)
+{
+    if (row >= 0 && row < m_fetched) {
+        removeRecord(recordForRow(row));
+    }
+}
+
+void TranscriptionHistory::removeRecord(quint32 record)
+{
+    const auto it = std::lower_bound(m_records.begin(), m_records.end(), record);
+    if (it == m_records.end() || *it != record) {
+        return;
+    }
+    char payload[sizeof(quint32)];
+    qToLittleEndian<quint32>(record, payload);
+    if (!m_tombstones.append(std::string_view(payload, sizeof(payload)))) {
+        qCWarning(lcUi) << "Could not delete transcription from history";
+        return;
+    }
+
+    // Rows run newest first; only the newest m_fetched entries are shown
+    const int row = static_cast<int>(m_records.end() - it) - 1;
+    if (row < m_fetched) {
+        beginRemoveRows(QModelIndex(), row, row);
+        m_records.erase(it);
+        --m_fetched;
+        endRemoveRows();
+    } else {
+        m_records.erase(it);
+    }
+    emit countChanged();
+    emit entryRemoved(record);
+}
+
+void TranscriptionHistory::clear()
+{
+    beginResetModel();
+    if (!m_log.clear() || !m_tombstones.clear()) {
+        qCWarning(lcUi) << "Could not clear transcription history";
+    }
+    m_records.clear();
+    m_fetched = 0;
+    m_pages.clear();
+    endResetModel();
+    emit countChanged();
+    emit cleared();
+}
+
+void TranscriptionHistory::copyText(int row) const
+{
+    if (row < 0 || row >= m_fetched) {
+        return;
+    }
+    const Entry& item = entry(row);
+    if (item.valid) {
+        QGuiApplication::clipboard()->setText(item.text);
+    }
+}
@@ -0,0 +1,62 @@
+#include "TranscriptionResult.h"
+#include "VerboseJson.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+namespace {
+    QString toQString(std::string_view text) {
+        return QString::fromUtf8(text.data(), static_cast<qsizetype>(text.size()));
+    }
+} // namespace
+
+bool TranscriptionResult::fromVerboseJson(const QByteArray& json, TranscriptionResult& result,
+                                          QString& error) {
+    VerboseTranscript transcript;
+    std::string parseError;
+    if (!VerboseJson::parse(std::string_view(json.constData(), json.size()), transcript,
+                            parseError)) {
+        error = QString::fromStdString(parseError);
+        return false;
+    }
+
+    result.text = toQString(transcript.text);
+    result.language = toQString(transcript.language);
+    result.duration = transcript.duration;
+    result.task = toQString(transcript.task);
+    result.requestId = toQString(transcript.requestId);
+    result.segments = std::move(transcript.segments);
+    return true;
+}
+
+QByteArray TranscriptionResult::toVerboseJson() const {
+    QJsonArray segmentArray;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        QJsonObject segment;
+        segment["start"] = segments.start(i);
+        segment["end"] = segments.end(i);
+        segment["avg_logprob"] = segments.avgLogProb(i);
+        segment["no_speech_prob"] = segments.noSpeechProb(i);
+        segment["text"] = toQString(segments.text(i));
+        segmentArray.append(segment);
+    }
+
+    QJsonObject obj;
+    obj["text"] = text;
+    obj["language"] = language;
+    obj["duration"] = duration;
+    obj["task"] = task;
+    obj["x_groq"] = QJsonObject{{"id", requestId}};
+    obj["segments"] = segmentArray;
+
+    if (segments.wordCount() > 0) {
+        QJsonArray wordArray;
+        for (size_t i = 0; i < segments.wordCount(); ++i) {
+            wordArray.append(QJsonObject{{"word", toQString(segments.wordText(i))},
+                                         {"start", segments.wordStart(i)},
+                                         {"end", segments.wordEnd(i)}});
+        }
+        obj["words"] = wordArray;
+    }
+    return QJsonDocument(obj).toJson(QJsonDocument::Compact);
+}
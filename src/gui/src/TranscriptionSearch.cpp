@@ -0,0 +1,309 @@
+#include "TranscriptionSearch.h"
+#include "HistoryLog.h"
+#include "Logging.h"
+#include "SearchIndex.h"
+#include <QClipboard>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <algorithm>
+
+namespace {
+    // Matches shown for a query
+    constexpr size_t kMaxResults = 200;
+    // Entries indexed between saves; anything unsaved is re-indexed at the next start
+    constexpr int kSaveEvery = 16;
+
+    std::string localPath(const QString& path) {
+        return QFile::encodeName(path).toStdString();
+    }
+} // namespace
+
+// Index and history reader owned by the worker thread
+struct TranscriptionSearch::Engine {
+    SearchIndex index;
+    HistoryLog log; // Read-only; the history model does the writing
+    std::string logPath;
+    std::string indexPath;
+    int unsaved = 0;
+
+    bool openLog() {
+        return log.isOpen() || log.open(logPath, HistoryLog::Mode::ReadOnly);
+    }
+    // live lists the entries not deleted among the first `known` records
+    void catchUp(const std::vector<quint32>& live, quint32 known);
+    void add(quint32 record, const QString& text);
+    void save();
+    QVector<Result> search(const QString& query);
+};
+
+void TranscriptionSearch::Engine::catchUp(const std::vector<quint32>& live, quint32 known)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const bool loaded = index.load(indexPath);
+    if (!openLog() || index.documentCount() > log.size()) {
+        // The history was cleared or replaced behind the index's back
+        index.clear();
+    }
+
+    const uint32_t from = index.documentCount();
+    std::string payload;
+    for (size_t record = from; record < log.size(); ++record) {
+        if (log.read(record, payload)) {
+            const TranscriptionHistory::Entry entry = TranscriptionHistory::decode(payload);
+            if (entry.valid) {
+                index.add(static_cast<uint32_t>(record), entry.text.toUtf8().toStdString());
+            }
+        }
+    }
+
+    // Deletions aren't saved with the index; the history's tombstones are the record.
+    // Entries appended since live was taken are indexed above and aren't in it.
+    auto next = live.begin();
+    const uint32_t end = std::min<uint32_t>(known, index.documentCount());
+    for (uint32_t record = 0; record < end; ++record) {
+        while (next != live.end() && *next < record) {
+            ++next;
+        }
+        if (next == live.end() || *next != record) {
+            index.remove(record);
+        }
+    }
+
+    if (index.documentCount() != from) {
+        save();
+    }
+    qCDebug(lcUi) << "Search index" << (loaded ? "loaded" : "rebuilt") << "with"
+                  << index.termCount() << "terms; indexed" << index.documentCount() - from
+                  << "new entries in" << timer.elapsed() << "ms";
+}
+
+void TranscriptionSearch::Engine::add(quint32 record, const QString& text)
+{
+    index.add(record, text.toUtf8().toStdString());
+    if (++unsaved >= kSaveEvery) {
+        save();
+    }
+}
+
+void TranscriptionSearch::Engine::save()
+{
+    if (!index.save(indexPath)) {
+        qCWarning(lcUi) << "Could not save search index" << QString::fromStdString(indexPath);
+    }
+    unsaved = 0;
+}
+
+QVector<TranscriptionSearch::Result> TranscriptionSearch::Engine::search(const QString& query)
+{
+    const std::string utf8Query = query.toUtf8().toStdString();
+    const std::vector<SearchIndex::Hit> hits = index.search(utf8Query, kMaxResults);
+
+    QVector<Result> results;
+    results.reserve(static_cast<int>(hits.size()));
+    std::string payload;
+    for (const SearchIndex::Hit& hit : hits) {
+        if (!openLog()) {
+            break;
+        }
+        if (hit.document >= log.size()) {
+            // Added since the reader last looked
+            log.refresh();
+        }
+        if (!log.read(hit.document, payload)) {
+            continue;
+        }
+        Result result;
+        result.record = hit.document;
+        result.entry = TranscriptionHistory::decode(payload);
+        if (!result.entry.valid) {
+            continue;
+        }
+
+        // Ranges are in UTF-8 bytes; build the rich text from the same bytes
+        const QByteArray text = result.entry.text.toUtf8();
+        const std::string_view view(text.constData(), static_cast<size_t>(text.size()));
+        qsizetype at = 0;
+        for (const SearchIndex::Range& range : SearchIndex::highlights(view, utf8Query)) {
+            const QByteArray before = text.mid(at, range.offset - at);
+            const QByteArray match = text.mid(range.offset, range.length);
+            result.highlighted += QString::fromUtf8(before).toHtmlEscaped() + "<b>" +
+                                  QString::fromUtf8(match).toHtmlEscaped() + "</b>";
+            at = range.offset + range.length;
+        }
+        result.highlighted += QString::fromUtf8(text.mid(at)).toHtmlEscaped();
+        results.append(result);
+    }
+    return results;
+}
+
+TranscriptionSearch::TranscriptionSearch(TranscriptionHistory* history, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_history(history)
+    , m_generation(0)
+    , m_worker(new QObject)
+    , m_engine(std::make_unique<Engine>())
+{
+    m_engine->logPath = localPath(history->logPath());
+    m_engine->indexPath = localPath(history->directory() + "/search.idx");
+
+    m_thread.setObjectName("SearchWorker");
+    m_worker->moveToThread(&m_thread);
+    m_thread.start(QThread::LowPriority);
+
+    const std::vector<quint32> live = history->records();
+    const quint32 known = history->recordCount();
+    QMetaObject::invokeMethod(m_worker, [this, live, known]() { m_engine->catchUp(live, known); },
+                              Qt::QueuedConnection);
+
+    connect(history, &TranscriptionHistory::entryAdded, this,
+            [this](quint32 record, const QString& text) {
+                QMetaObject::invokeMethod(m_worker, [this, record, text]() {
+                    m_engine->add(record, text);
+                }, Qt::QueuedConnection);
+                if (!m_query.isEmpty()) {
+                    runQuery();
+                }
+            });
+    connect(history, &TranscriptionHistory::entryRemoved, this,
+            &TranscriptionSearch::handleEntryRemoved);
+    connect(history, &TranscriptionHistory::cleared, this, [this]() {
+        QMetaObject::invokeMethod(m_worker, [this]() {
+            m_engine->index.clear();
+            m_engine->log.close();
+            m_engine->save();
+        }, Qt::QueuedConnection);
+        ++m_generation;
+        showResults(m_generation, {});
+    });
+}
+
+TranscriptionSearch::~TranscriptionSearch()
+{
+    // Skip queries still queued; once the worker is idle, save what it indexed
+    ++m_generation;
+    m_thread.quit();
+    m_thread.wait();
+    delete m_worker;
+    if (m_engine->unsaved > 0) {
+        m_engine->save();
+    }
+}
+
+void TranscriptionSearch::setQuery(const QString& query)
+{
+    if (query == m_query) {
+        return;
+    }
+    m_query = query;
+    emit queryChanged();
+    runQuery();
+}
+
+void TranscriptionSearch::runQuery()
+{
+    const quint64 generation = ++m_generation;
+    if (m_query.trimmed().isEmpty()) {
+        showResults(generation, {});
+        return;
+    }
+
+    const QString query = m_query;
+    QMetaObject::invokeMethod(m_worker, [this, generation, query]() {
+        if (generation != m_generation.load()) {
+            return; // Overtaken while queued
+        }
+        QElapsedTimer timer;
+        timer.start();
+        const QVector<Result> results = m_engine->search(query);
+        qCDebug(lcUi) << "Search for" << query << "found" << results.size() << "in"
+                      << timer.nsecsElapsed() / 1e6 << "ms";
+        QMetaObject::invokeMethod(this, [this, generation, results]() {
+            showResults(generation, results);
+        }, Qt::QueuedConnection);
+    }, Qt::QueuedConnection);
+}
+
+void TranscriptionSearch::showResults(quint64 generation, const QVector<Result>& results)
+{
+    if (generation != m_generation.load()) {
+        return;
+    }
+    beginResetModel();
+    m_results = results;
+    endResetModel();
+    emit countChanged();
+}
+
+void TranscriptionSearch::handleEntryRemoved(quint32 record)
+{
+    QMetaObject::invokeMethod(m_worker, [this, record]() { m_engine->index.remove(record); },
+                              Qt::QueuedConnection);
+
+    for (int row = 0; row < m_results.size(); ++row) {
+        if (m_results[row].record == record) {
+            beginRemoveRows(QModelIndex(), row, row);
+            m_results.removeAt(row);
+            endRemoveRows();
+            emit countChanged();
+            return;
+        }
+    }
+}
+
+int TranscriptionSearch::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : m_results.size();
+}
+
+QHash<int, QByteArray> TranscriptionSearch::roleNames() const
+{
+    return {
+        {TextRole, "text"},
+        {HighlightedTextRole, "highlightedText"},
+        {TimestampRole, "timestamp"},
+        {DurationRole, "duration"},
+        {LanguageRole, "language"},
+    };
+}
+
+QVariant TranscriptionSearch::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_results.size()) {
+        return QVariant();
+    }
+
+    const Result& result = m_results[index.row()];
+    switch (role) {
+    case Qt::DisplayRole:
+    case TextRole:
+        return result.entry.text;
+    case HighlightedTextRole:
+        return result.highlighted;
+    case TimestampRole:
+        return QDateTime::fromMSecsSinceEpoch(result.entry.createdMs)
+            .toString("yyyy-MM-dd hh:mm:ss");
+    case DurationRole:
+        return result.entry.duration;
+    case LanguageRole:
+        return result.entry.language;
+    }
+    return QVariant();
+}
+
+void TranscriptionSearch::remove(int row)
+{
+    // The history's entryRemoved takes the row out of the results too
+    if (row >= 0 && row < m_results.size()) {
+        m_history->removeRecord(m_results[row].record);
+    }
+}
+
+void TranscriptionSearch::copyText(int row) const
+{
+    if (row >= 0 && row < m_results.size()) {
+        QGuiApplication::clipboard()->setText(m_results[row].entry.text);
+    }
+}
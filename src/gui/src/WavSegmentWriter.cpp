@@ -0,0 +1,139 @@
+#include "WavSegmentWriter.h"
+#include "Logging.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <algorithm>
+#include <limits>
+
+namespace {
+    // How much audio a crash can cost: the header is refreshed this often
+    constexpr qint64 kHeaderIntervalSeconds = 5;
+} // namespace
+
+WavSegmentWriter::WavSegmentWriter()
+    : m_segmentLimit(0), m_segmentBytes(0), m_headerInterval(0), m_sinceHeader(0) {}
+
+WavSegmentWriter::~WavSegmentWriter() {
+    close();
+}
+
+bool WavSegmentWriter::open(const QString& path, const WavFile::Format& format,
+                            const Limits& limits) {
+    close();
+
+    m_path = path;
+    m_format = format;
+    m_limits = limits;
+    m_segments.clear();
+
+    const qint64 blockAlign = std::max(1, format.channels * (format.bitsPerSample / 8));
+    const qint64 byteRate = static_cast<qint64>(format.sampleRate) * blockAlign;
+
+    m_segmentLimit = std::numeric_limits<qint64>::max();
+    if (!limits.rf64) {
+        m_segmentLimit = static_cast<qint64>(WavFile::kMaxRiffDataSize);
+    }
+    if (limits.maxBytes > 0) {
+        m_segmentLimit = std::min(m_segmentLimit, limits.maxBytes);
+    }
+    if (limits.maxSeconds > 0) {
+        m_segmentLimit = std::min(m_segmentLimit, limits.maxSeconds * byteRate);
+    }
+    // Never split a sample frame across files
+    m_segmentLimit = std::max(blockAlign, m_segmentLimit - m_segmentLimit % blockAlign);
+    m_headerInterval = kHeaderIntervalSeconds * byteRate;
+
+    return openSegment();
+}
+
+qint64 WavSegmentWriter::write(const char* data, qint64 size) {
+    qint64 total = 0;
+    while (size > 0 && m_file.isOpen()) {
+        if (m_segmentBytes >= m_segmentLimit) {
+            if (!finishSegment() || !openSegment()) {
+                break;
+            }
+        }
+
+        const qint64 take = std::min(size, m_segmentLimit - m_segmentBytes);
+        const qint64 written = m_file.write(data, take);
+        if (written <= 0) {
+            qCWarning(lcAudio) << "Failed to write recording:" << m_file.errorString();
+            break;
+        }
+        m_segmentBytes += written;
+        m_sinceHeader += written;
+        total += written;
+        data += written;
+        size -= written;
+
+        if (m_sinceHeader >= m_headerInterval) {
+            writeHeader();
+        }
+    }
+    return total;
+}
+
+void WavSegmentWriter::close() {
+    if (m_file.isOpen()) {
+        finishSegment();
+    }
+}
+
+QString WavSegmentWriter::segmentPath(int index) const {
+    if (index == 0) {
+        return m_path;
+    }
+    const QFileInfo info(m_path);
+    return info.path() + "/" + info.completeBaseName() +
+           QString("_%1.").arg(index + 1, 3, 10, QChar('0')) + info.suffix();
+}
+
+bool WavSegmentWriter::openSegment() {
+    const QString path = segmentPath(m_segments.size());
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        qCWarning(lcAudio) << "Failed to open recording segment:" << path << m_file.errorString();
+        return false;
+    }
+
+    m_segments.append(path);
+    m_segmentBytes = 0;
+    if (!writeHeader()) {
+        m_file.close();
+        return false;
+    }
+    return true;
+}
+
+bool WavSegmentWriter::finishSegment() {
+    const bool ok = writeHeader();
+    m_file.close();
+    return ok;
+}
+
+bool WavSegmentWriter::writeHeader() {
+    // Overwrites the header in place, then carries on appending where we were
+    const qint64 position = m_file.pos();
+    bool ok = m_file.seek(0);
+    if (m_limits.rf64) {
+        const auto header = WavFile::rf64Header(m_format, static_cast<uint64_t>(m_segmentBytes));
+        ok = ok && m_file.write(header.data(), header.size()) ==
+                       static_cast<qint64>(header.size());
+    } else {
+        const auto header = WavFile::header(m_format, static_cast<uint32_t>(m_segmentBytes));
+        ok = ok && m_file.write(header.data(), header.size()) ==
+                       static_cast<qint64>(header.size());
+    }
+    if (position > 0) {
+        ok = ok && m_file.seek(position);
+    }
+    // Get it to the OS, so it survives the app dying (not necessarily the machine)
+    ok = ok && m_file.flush();
+
+    m_sinceHeader = 0;
+    if (!ok) {
+        qCWarning(lcAudio) << "Failed to update recording header:" << m_file.errorString();
+    }
+    return ok;
+}
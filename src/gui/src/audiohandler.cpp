@@ -1,107 +1,273 @@
 #include "audiohandler.h"
+#include "AudioWriter.h"
+#include "ChunkArenaDevice.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include "StreamingUploadDevice.h"
+#include "Trace.h"
+#include "WavFile.h"
+#include "config.h"
 #include <QDebug>
 #include <QStandardPaths>
 #include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QThread>
+#include <QThreadPool>
+#include <algorithm>
+#include <cmath>
 #include "transcriptionservice.h"
 
+namespace {
+    // About six seconds of mono 44.1 kHz audio (5.5 at 48 kHz); the writer drains it every
+    // few milliseconds.
+    constexpr size_t kRingBufferSamples = 1 << 18;
+    // Below this a single request is already about as fast as splitting would get
+    constexpr double kSegmentedMinSeconds = 45.0;
+    // Adaptive buffering: after this many device overflows in one recording the next
+    // one gets twice the buffer, up to kMaxBufferScale times the configured size
+    constexpr quint32 kOverflowsBeforeGrowing = 3;
+    constexpr int kMaxBufferScale = 8;
+    constexpr int kMaxBufferFrames = 8192;
+    // How long stopping an armed stream waits for the callback to stop feeding the take
+    constexpr int kCaptureHandoffTimeoutMs = 250;
+    // Matches the meter's column rate; faster would only repeat snapshots
+    constexpr int kLevelIntervalMs = 33;
+    constexpr double kLevelFloorDb = -60.0;
+} // namespace
+
 AudioHandler::AudioHandler(QObject *parent)
     : QObject(parent)
     , m_stream(nullptr)
     , m_isRecording(false)
     , m_isInitialized(false)
-    , m_dataSize(0)
+    , m_recordingSaved(false)
+    , m_traceDictation(0)
+    , m_bufferScale(1)
+    , m_inputOverflowEvents(0)
+    , m_inputUnderflowEvents(0)
+    , m_capturing(false)
+    , m_callbackCapturing(false)
+    , m_ringBuffer(kRingBufferSamples)
+    , m_writer(new AudioWriter(&m_ringBuffer, m_captureSampleRate, m_sampleRate, this))
     , m_transcriptionService(new TranscriptionService(this))
     , m_autoTranscribe(false)
+    , m_streamingJob(0)
     , m_lastRecordingDuration(0.0)
 {
-    connect(m_transcriptionService,
-           static_cast<void (TranscriptionService::*)(const QString&)>(&TranscriptionService::transcriptionComplete),
-           this, &AudioHandler::transcriptionReceived);
+    m_idleTimer.setSingleShot(true);
+    connect(&m_idleTimer, &QTimer::timeout, this, [this]() {
+        if (!m_isRecording) {
+            qCDebug(lcAudio) << "Input idle, releasing the device";
+            closeInputStream();
+        }
+    });
+    m_levelTimer.setInterval(kLevelIntervalMs);
+    connect(&m_levelTimer, &QTimer::timeout, this, &AudioHandler::publishLevels);
+    connect(m_writer, &AudioWriter::captureOverflow, this, &AudioHandler::captureOverflow);
+    connect(m_transcriptionService, &TranscriptionService::transcriptionComplete,
+            this, &AudioHandler::handleTranscription);
     connect(m_transcriptionService, &TranscriptionService::transcriptionError,
-            [this](const QString& error) {
-                qDebug() << "Transcription error:" << error;
-            });
+            this, &AudioHandler::handleTranscriptionError);
 }
 
 AudioHandler::~AudioHandler()
 {
+    if (m_pendingInit.valid() && m_pendingInit.get() == paNoError) {
+        m_isInitialized = true; // still needs the matching Pa_Terminate()
+    }
+    closeInputStream();
     if (m_isInitialized) {
         Pa_Terminate();
     }
-    if (m_outputFile.isOpen()) {
-        updateWavHeader();
-        m_outputFile.close();
-    }
+    m_writer->stopWriting();
+    m_outputFile.close();
 }
 
 bool AudioHandler::initialize()
 {
-    PaError err = Pa_Initialize();
+    if (m_isInitialized) {
+        return true;
+    }
+    // If it was started in the background, wait for that rather than probing twice
+    return completeInitialization(m_pendingInit.valid() ? m_pendingInit.get() : Pa_Initialize());
+}
+
+void AudioHandler::initializeInBackground()
+{
+    if (m_isInitialized || m_pendingInit.valid()) {
+        return;
+    }
+    // Pa_Initialize probes every host API, which can take hundreds of milliseconds.
+    // Nothing else calls into PortAudio until the result has been collected.
+    m_pendingInit = std::async(std::launch::async, [this]() {
+        const PaError err = Pa_Initialize();
+        QMetaObject::invokeMethod(this, [this]() {
+            if (m_pendingInit.valid()) { // not already collected by initialize()
+                completeInitialization(m_pendingInit.get());
+            }
+        }, Qt::QueuedConnection);
+        return err;
+    });
+}
+
+bool AudioHandler::completeInitialization(PaError err)
+{
     if (err != paNoError) {
-        qDebug() << "PortAudio error:" << Pa_GetErrorText(err);
+        qCDebug(lcAudio) << "PortAudio error:" << Pa_GetErrorText(err);
+        emit initialized(false);
         return false;
     }
 
     m_isInitialized = true;
+    updateArming();
+    emit initialized(true);
+    return true;
+}
+
+void AudioHandler::updateArming()
+{
+    if (!m_isInitialized || m_isRecording) {
+        // Picked up when the recording stops
+        return;
+    }
+
+    // Reopen even if already armed: device, buffering or pre-roll length may have changed
+    closeInputStream();
+    if (Config::instance().getAlwaysArmed()) {
+        armInput();
+    }
+}
+
+bool AudioHandler::armInput()
+{
+    PaStreamParameters inputParameters;
+    unsigned long framesPerBuffer = paFramesPerBufferUnspecified;
+    if (!configureInput(inputParameters, framesPerBuffer) ||
+        !openInputStream(inputParameters, framesPerBuffer)) {
+        return false;
+    }
+    qCDebug(lcAudio) << "Input armed with" << m_preRoll.capacity() << "samples of pre-roll";
+    restartIdleTimer();
     return true;
 }
 
-bool AudioHandler::startRecording()
+bool AudioHandler::startRecording(uint64_t traceDictation)
 {
-    if (!m_isInitialized) {
+    // First use before the background initialization finished: wait for it here
+    if (!initialize()) {
         return false;
     }
 
+    m_traceDictation = traceDictation != 0 ? traceDictation : Trace::beginDictation();
+    Trace::asyncBegin("dictation", m_traceDictation);
+    Trace::Span span("start recording", m_traceDictation);
+
+    // When armed the stream is already running into the pre-roll buffer and the take
+    // starts with the next callback; otherwise it is opened once everything is ready
+    const bool armed = m_stream && Pa_IsStreamActive(m_stream) == 1;
+    PaStreamParameters inputParameters;
+    unsigned long framesPerBuffer = paFramesPerBufferUnspecified;
+    if (!armed) {
+        closeInputStream(); // one that stopped by itself, e.g. the device was unplugged
+        if (!configureInput(inputParameters, framesPerBuffer)) {
+            Metrics::countError("portaudio");
+            return false;
+        }
+    }
+
     // Create recordings directory if it doesn't exist
-    QString recordingsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation)
-                           + "/Vibeco/Recordings";
+    const QString recordingsPath = recordingsDirectory();
     QDir().mkpath(recordingsPath);
 
     // Create filename with timestamp
     QString timestamp = QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
     m_currentFilePath = recordingsPath + "/recording_" + timestamp + ".wav";
 
-    m_outputFile.setFileName(m_currentFilePath);
-    if (!m_outputFile.open(QIODevice::WriteOnly)) {
-        qDebug() << "Failed to open output file:" << m_currentFilePath;
-        return false;
-    }
-
-    // Write WAV header
-    if (!writeWavHeader()) {
-        m_outputFile.close();
-        return false;
+    // Long sessions only ever hold a few seconds of audio in memory: the file is the
+    // single copy, and whatever would accumulate (in-memory recording, trimmed or
+    // compressed upload payloads) is switched off
+    const bool longSession = Config::instance().getLongSessionRecording();
+
+    if (!longSession && Config::instance().getInMemoryRecording()) {
+        // Nothing touches the disk until the upload is under way (see saveRecordingInBackground)
+        m_recordingArena = std::make_shared<ChunkArena>();
+        m_recordingSaved = false;
+    } else {
+        m_recordingArena.reset();
+        WavSegmentWriter::Limits limits;
+        if (longSession) {
+            limits.maxSeconds = Config::instance().getSegmentMinutes() * qint64(60);
+            limits.maxBytes = Config::instance().getSegmentMegabytes() * qint64(1024 * 1024);
+            limits.rf64 = Config::instance().getWriteRf64();
+        }
+        if (!m_outputFile.open(m_currentFilePath, recordingFormat(), limits)) {
+            qCDebug(lcAudio) << "Failed to open output file:" << m_currentFilePath;
+            Metrics::countError("recording_file");
+            return false;
+        }
+        m_recordingSaved = true;
     }
 
-    m_dataSize = 0;
-
-    PaError err = Pa_OpenDefaultStream(&m_stream,
-                                     m_numChannels,  // input channels
-                                     0,              // output channels
-                                     paFloat32,      // sample format
-                                     m_sampleRate,   // sample rate
-                                     256,           // frames per buffer
-                                     recordCallback,
-                                     this);
+    // Not reset(): a callback that missed the last handoff may still be writing. What it
+    // left from the previous take is dropped here, before the writer starts reading.
+    m_ringBuffer.discard();
 
-    if (err != paNoError) {
-        qDebug() << "PortAudio error:" << Pa_GetErrorText(err);
-        m_outputFile.close();
-        return false;
+    // Compress on the writer thread while recording, so the payload is ready at stop
+    AudioEncoder::Format uploadFormat = AudioEncoder::Format::Wav;
+    if (!longSession && m_autoTranscribe && m_transcriptionService->acceptsCompressedAudio()) {
+        uploadFormat = AudioEncoder::formatFromName(
+            Config::instance().getUploadFormat().toLatin1().constData());
     }
-
-    err = Pa_StartStream(m_stream);
-    if (err != paNoError) {
-        qDebug() << "PortAudio error:" << Pa_GetErrorText(err);
-        m_outputFile.close();
-        return false;
+    m_writer->setUploadFormat(uploadFormat);
+    m_writer->setTrimSilence(!longSession && m_autoTranscribe &&
+                             Config::instance().getTrimSilence());
+
+    // Open the upload now so that only the tail is left to send when recording stops
+    if (!longSession && m_autoTranscribe && Config::instance().getStreamingUpload() &&
+        m_transcriptionService->supportsStreaming()) {
+        const AudioEncoder::Format format = m_writer->uploadFormat();
+        const QByteArray header =
+            format == AudioEncoder::Format::Wav ? wavHeader(WavFile::kUnknownSize) : QByteArray();
+        m_streamingUpload = m_transcriptionService->startStreamingTranscription(
+            uploadFileName(), AudioEncoder::contentType(format), header, m_streamingJob);
+    }
+    if (m_autoTranscribe && !m_streamingUpload) {
+        // Handshake (or model load) now, rather than after the user stops talking
+        m_transcriptionService->prepare();
+    }
+    m_writer->setRecordingArena(m_recordingArena);
+    m_writer->setCaptureRate(m_captureSampleRate);
+    m_inputOverflowEvents.store(0, std::memory_order_relaxed);
+    m_inputUnderflowEvents.store(0, std::memory_order_relaxed);
+    m_writer->startWriting(m_recordingArena ? nullptr : &m_outputFile, m_streamingUpload);
+
+    m_idleTimer.stop();
+    m_capturing.store(true, std::memory_order_release);
+    if (!armed) {
+        const int64_t streamOpenStart = Trace::nowUs();
+        if (!openInputStream(inputParameters, framesPerBuffer)) {
+            m_capturing.store(false, std::memory_order_release);
+            m_writer->stopWriting();
+            abortStreamingUpload();
+            m_outputFile.close();
+            return false;
+        }
+        Trace::complete("open stream", streamOpenStart, Trace::nowUs() - streamOpenStart,
+                        m_traceDictation);
     }
+    Trace::asyncBegin("capture", m_traceDictation);
 
     // Start recording timer
     m_recordingTimer.start();
     m_lastRecordingDuration = 0.0;
 
+    static Metrics::Counter& dictations =
+        Metrics::Registry::instance().counter("vibeco_dictations_total", "Recordings started");
+    dictations.add();
+
     m_isRecording = true;
+    m_levelTimer.start();
     emit recordingStarted();
     return true;
 }
@@ -114,29 +280,130 @@ bool AudioHandler::stopRecording()
 
     // Save the recording duration
     m_lastRecordingDuration = m_recordingTimer.elapsed() / 1000.0;
-
-    PaError err = Pa_StopStream(m_stream);
-    if (err != paNoError) {
-        qDebug() << "PortAudio error:" << Pa_GetErrorText(err);
-        return false;
+    Trace::asyncEnd("capture", m_traceDictation);
+    Trace::Span span("stop recording", m_traceDictation);
+
+    // Stay armed only if the stream was opened for it (it has a pre-roll buffer)
+    const bool stayArmed = Config::instance().getAlwaysArmed() && m_preRoll.capacity() > 0;
+    m_capturing.store(false, std::memory_order_release);
+    // A stream left running hands off to the writer thread, which waits for it (see below)
+    const bool handoff = stayArmed && Pa_IsStreamActive(m_stream) == 1;
+    if (!stayArmed) {
+        PaError err = Pa_StopStream(m_stream);
+        if (err != paNoError) {
+            qCDebug(lcAudio) << "PortAudio error:" << Pa_GetErrorText(err);
+            return false;
+        }
+
+        err = Pa_CloseStream(m_stream);
+        if (err != paNoError) {
+            qCDebug(lcAudio) << "PortAudio error:" << Pa_GetErrorText(err);
+            return false;
+        }
+        m_stream = nullptr;
+    }
+    if (adaptToInputErrors() && stayArmed) {
+        // Reopen with the larger buffer; the take no longer needs the stream
+        closeInputStream();
+        armInput();
+    } else if (stayArmed) {
+        restartIdleTimer();
+    } else if (Config::instance().getAlwaysArmed()) {
+        // Switched on during the recording
+        armInput();
     }
 
-    err = Pa_CloseStream(m_stream);
-    if (err != paNoError) {
-        qDebug() << "PortAudio error:" << Pa_GetErrorText(err);
-        return false;
+    // Once the callback no longer feeds the take, the writer flushes what is left in the ring
+    const int64_t finalizeStart = Trace::nowUs();
+    m_writer->stopWriting(handoff ? &m_callbackCapturing : nullptr, kCaptureHandoffTimeoutMs);
+    static Metrics::Counter& captured = Metrics::Registry::instance().counter(
+        "vibeco_captured_bytes_total", "PCM bytes recorded, after resampling");
+    captured.add(static_cast<uint64_t>(m_writer->bytesWritten()));
+    if (m_ringBuffer.overflowCount() > 0) {
+        qCWarning(lcAudio) << "Recording lost" << m_ringBuffer.droppedSamples() << "samples in"
+                           << m_ringBuffer.overflowCount() << "capture overflows";
+        static Metrics::Counter& dropped = Metrics::Registry::instance().counter(
+            "vibeco_dropped_samples_total", "Samples lost because the writer fell behind");
+        dropped.add(m_ringBuffer.droppedSamples());
+        Metrics::countError("capture_overflow");
     }
 
-    // Update WAV header with final size
-    updateWavHeader();
-    m_outputFile.close();
+    if (m_recordingArena) {
+        if (Config::instance().getSaveRecordings()) {
+            saveRecordingInBackground();
+        }
+    } else {
+        // Final sizes go into the header
+        m_outputFile.close();
+    }
+    Trace::complete("finalize", finalizeStart, Trace::nowUs() - finalizeStart, m_traceDictation);
 
     m_isRecording = false;
+    m_levelTimer.stop();
+    emit levelsChanged(0.0, QVariantList());
     emit recordingStopped();
 
     if (m_autoTranscribe) {
-        m_transcriptionService->transcribeAudioFile(m_currentFilePath);
+        auto dictation = QSharedPointer<Dictation>::create();
+        dictation->traceDictation = m_traceDictation;
+        dictation->stopToText.start();
+
+        // Travels with the job, so a later recording can't change how this one is read
+        TranscriptionJob::Metadata metadata;
+        metadata.recordingDuration = m_lastRecordingDuration;
+        metadata.traceDictation = m_traceDictation;
+
+        const QByteArray payload = m_writer->uploadPayload();
+        const AudioEncoder::Format format = m_writer->uploadFormat();
+        const QStringList segmentFiles = m_outputFile.segmentPaths();
+        QList<quint64> jobs;
+        if (!m_recordingArena && segmentFiles.size() > 1) {
+            // Long session split into files: each is bounded in size and goes as a job of
+            // its own, all at once so that they stay ahead of the next dictation's
+            TranscriptionJob::Metadata part = metadata;
+            part.recordingDuration = -1.0; // the whole session's; parts report their own
+            for (const QString& file : segmentFiles) {
+                jobs.append(m_transcriptionService->transcribeAudioFile(file, part));
+            }
+        } else if (!m_writer->speechDetected()) {
+            // The VAD heard nothing; rather than risk dropping quiet speech, send it all
+            qCDebug(lcAudio) << "No speech detected, uploading the untrimmed recording";
+            abortStreamingUpload();
+            jobs.append(transcribeRecording(metadata));
+        } else if (m_streamingUpload && !m_streamingUpload->isClosed()) {
+            metadata.trimMap = m_writer->trimMap();
+            m_transcriptionService->finishStreamingTranscription(m_streamingJob,
+                                                                 m_streamingUpload, metadata);
+            jobs.append(m_streamingJob);
+            m_streamingJob = 0;
+        } else if (Config::instance().getSegmentedTranscription() &&
+                   m_transcriptionService->supportsSegmentation() &&
+                   m_lastRecordingDuration > kSegmentedMinSeconds) {
+            // Long dictation: transcribe pieces of the recording in parallel
+            jobs.append(transcribeRecordingSegmented(metadata));
+        } else if (!payload.isEmpty()) {
+            metadata.trimMap = m_writer->trimMap();
+            jobs.append(m_transcriptionService->transcribeAudioData(
+                format == AudioEncoder::Format::Wav ? wavHeader(payload.size()) + payload
+                                                    : payload,
+                uploadFileName(), AudioEncoder::contentType(format), metadata));
+        } else {
+            // Not streaming, or the streamed request already failed: upload the recording
+            jobs.append(transcribeRecording(metadata));
+        }
+
+        dictation->parts.resize(jobs.size());
+        dictation->remaining = jobs.size();
+        for (int part = 0; part < jobs.size(); ++part) {
+            m_pendingJobs.insert(jobs[part], PendingJob{dictation, part});
+        }
     }
+    // A streamed request that went unused (it failed early, or was bypassed) is dropped
+    if (m_streamingJob != 0) {
+        m_transcriptionService->cancel(m_streamingJob);
+        m_streamingJob = 0;
+    }
+    m_streamingUpload.reset();
 
     return true;
 }
@@ -150,6 +417,13 @@ int AudioHandler::recordCallback(const void *inputBuffer, void *outputBuffer,
     AudioHandler* handler = static_cast<AudioHandler*>(userData);
     const float* in = static_cast<const float*>(inputBuffer);
 
+    if (handler && (statusFlags & paInputOverflow)) {
+        handler->m_inputOverflowEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (handler && (statusFlags & paInputUnderflow)) {
+        handler->m_inputUnderflowEvents.fetch_add(1, std::memory_order_relaxed);
+    }
+
     if (handler && in) {
         handler->processAudioData(in, framesPerBuffer);
     }
@@ -157,62 +431,377 @@ int AudioHandler::recordCallback(const void *inputBuffer, void *outputBuffer,
     return paContinue;
 }
 
-void AudioHandler::processAudioData(const float* inputBuffer, unsigned long framesPerBuffer)
+QString AudioHandler::recordingsDirectory()
 {
-    if (!m_outputFile.isOpen()) return;
+    return QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) +
+           "/Vibeco/Recordings";
+}
+
+QStringList AudioHandler::inputDevices()
+{
+    // PortAudio counts initializations, so this is safe next to a live AudioHandler
+    QStringList names;
+    if (Pa_Initialize() != paNoError) {
+        return names;
+    }
+    for (PaDeviceIndex i = 0; i < Pa_GetDeviceCount(); ++i) {
+        const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
+        if (info && info->maxInputChannels > 0) {
+            names.append(deviceName(i));
+        }
+    }
+    Pa_Terminate();
+    return names;
+}
+
+QString AudioHandler::deviceName(PaDeviceIndex device)
+{
+    // Device names repeat across host APIs (e.g. MME and WASAPI on Windows)
+    const PaDeviceInfo* info = Pa_GetDeviceInfo(device);
+    const PaHostApiInfo* hostApi = info ? Pa_GetHostApiInfo(info->hostApi) : nullptr;
+    if (!info || !hostApi) {
+        return QString();
+    }
+    return QString("%1 (%2)").arg(QString::fromUtf8(info->name), QString::fromUtf8(hostApi->name));
+}
 
-    // Write the audio data to file
-    qint64 bytesWritten = m_outputFile.write(
-        reinterpret_cast<const char*>(inputBuffer),
-        framesPerBuffer * sizeof(float)
-    );
+PaDeviceIndex AudioHandler::findInputDevice(const QString& name) const
+{
+    if (!name.isEmpty()) {
+        for (PaDeviceIndex i = 0; i < Pa_GetDeviceCount(); ++i) {
+            const PaDeviceInfo* info = Pa_GetDeviceInfo(i);
+            if (info && info->maxInputChannels >= m_numChannels && deviceName(i) == name) {
+                return i;
+            }
+        }
+        qCDebug(lcAudio) << "Input device" << name << "not found, using the default";
+    }
+    return Pa_GetDefaultInputDevice();
+}
+
+bool AudioHandler::configureInput(PaStreamParameters& parameters, unsigned long& framesPerBuffer)
+{
+    const QString deviceSetting = Config::instance().getInputDevice();
+    if (deviceSetting != m_bufferScaleDevice) {
+        // Whatever was learned about the previous device doesn't apply to this one
+        m_bufferScale = 1;
+        m_bufferScaleDevice = deviceSetting;
+    }
+
+    const PaDeviceIndex device = findInputDevice(deviceSetting);
+    const PaDeviceInfo* info = device == paNoDevice ? nullptr : Pa_GetDeviceInfo(device);
+    if (!info) {
+        qCDebug(lcAudio) << "No audio input device available";
+        return false;
+    }
 
-    if (bytesWritten > 0) {
-        m_dataSize += bytesWritten;
+    const int latencyMs = Config::instance().getInputLatencyMs();
+    parameters.device = device;
+    parameters.channelCount = m_numChannels;
+    parameters.sampleFormat = paFloat32;
+    parameters.suggestedLatency =
+        (latencyMs > 0 ? latencyMs / 1000.0 : info->defaultLowInputLatency) * m_bufferScale;
+    parameters.hostApiSpecificStreamInfo = nullptr;
+
+    // Capture at the device's native rate so the host API doesn't convert on the
+    // audio thread; the writer resamples to 16 kHz anyway
+    const QList<int> candidates = {qRound(info->defaultSampleRate), 48000, 44100, 16000};
+    int sampleRate = 0;
+    for (int candidate : candidates) {
+        if (Pa_IsFormatSupported(&parameters, nullptr, candidate) == paFormatIsSupported) {
+            sampleRate = candidate;
+            break;
+        }
     }
+    if (sampleRate == 0) {
+        qCWarning(lcAudio) << deviceName(device) << "can't capture at any of" << candidates
+                           << "Hz";
+        return false;
+    }
+    m_captureSampleRate = sampleRate;
+
+    const int frames = Config::instance().getBufferFrames();
+    framesPerBuffer = frames > 0 ? std::min(frames * m_bufferScale, kMaxBufferFrames)
+                                 : paFramesPerBufferUnspecified;
+
+    qCDebug(lcAudio) << "Capturing from" << deviceName(device) << "at" << sampleRate << "Hz,"
+                     << framesPerBuffer << "frames per buffer, suggested latency"
+                     << parameters.suggestedLatency * 1000.0 << "ms";
+    return true;
+}
 
-    emit audioDataReady(QByteArray(reinterpret_cast<const char*>(inputBuffer),
-                                 framesPerBuffer * sizeof(float)));
+bool AudioHandler::adaptToInputErrors()
+{
+    const quint32 overflows = m_inputOverflowEvents.load(std::memory_order_relaxed);
+    const quint32 underflows = m_inputUnderflowEvents.load(std::memory_order_relaxed);
+    if (overflows == 0 && underflows == 0) {
+        return false;
+    }
+    qCWarning(lcAudio) << "Input device reported" << overflows << "overflows and" << underflows
+                       << "underflows";
+
+    static Metrics::Counter& overflowCounter = Metrics::Registry::instance().counter(
+        "vibeco_input_overflows_total", "Callbacks where the audio device reported lost input");
+    static Metrics::Counter& underflowCounter = Metrics::Registry::instance().counter(
+        "vibeco_input_underflows_total", "Callbacks where the audio device ran short of input");
+    overflowCounter.add(overflows);
+    underflowCounter.add(underflows);
+
+    // A single glitch (e.g. a busy moment at startup) isn't worth more latency
+    if (Config::instance().getAdaptiveBuffer() && overflows >= kOverflowsBeforeGrowing &&
+        m_bufferScale < kMaxBufferScale) {
+        m_bufferScale *= 2;
+        qCDebug(lcAudio) << "Input kept overflowing, using" << m_bufferScale
+                         << "times the configured buffer from the next recording on";
+        return true;
+    }
+    return false;
 }
 
-bool AudioHandler::writeWavHeader()
+void AudioHandler::processAudioData(const float* inputBuffer, unsigned long framesPerBuffer)
 {
-    // RIFF header
-    m_outputFile.write("RIFF", 4);
-    m_outputFile.write("\x00\x00\x00\x00", 4); // Size (to be updated later)
-    m_outputFile.write("WAVE", 4);
+    // Runs on the real-time audio thread: copy into preallocated storage and return.
+    // Disk writes and signal delivery happen on the AudioWriter thread.
+    const size_t count = framesPerBuffer * m_numChannels;
+    if (!m_capturing.load(std::memory_order_acquire)) {
+        m_preRoll.write(inputBuffer, count);
+        m_callbackCapturing.store(false, std::memory_order_release);
+        return;
+    }
 
-    // Format chunk
-    m_outputFile.write("fmt ", 4);
-    qint32 subchunk1Size = 16;
-    m_outputFile.write(reinterpret_cast<const char*>(&subchunk1Size), 4);
-    qint16 audioFormat = 3; // IEEE float
-    m_outputFile.write(reinterpret_cast<const char*>(&audioFormat), 2);
-    m_outputFile.write(reinterpret_cast<const char*>(&m_numChannels), 2);
-    m_outputFile.write(reinterpret_cast<const char*>(&m_sampleRate), 4);
-    qint32 byteRate = m_sampleRate * m_numChannels * (m_bitsPerSample/8);
-    m_outputFile.write(reinterpret_cast<const char*>(&byteRate), 4);
-    qint16 blockAlign = m_numChannels * (m_bitsPerSample/8);
-    m_outputFile.write(reinterpret_cast<const char*>(&blockAlign), 2);
-    m_outputFile.write(reinterpret_cast<const char*>(&m_bitsPerSample), 2);
+    if (!m_callbackCapturing.load(std::memory_order_relaxed)) {
+        // First buffer of a take: the audio from just before the hotkey goes in first
+        m_preRoll.drain([this](const float* samples, size_t size) {
+            m_ringBuffer.write(samples, size);
+        });
+        m_callbackCapturing.store(true, std::memory_order_release);
+    }
+    m_ringBuffer.write(inputBuffer, count);
+}
 
-    // Data chunk header
-    m_outputFile.write("data", 4);
-    m_outputFile.write("\x00\x00\x00\x00", 4); // Size (to be updated later)
+bool AudioHandler::openInputStream(const PaStreamParameters& parameters,
+                                   unsigned long framesPerBuffer)
+{
+    // Sized while the stream is closed; the callback owns the buffer once it runs
+    const int preRollMs = Config::instance().getAlwaysArmed()
+                              ? qBound(0, Config::instance().getPreRollMs(), 5000)
+                              : 0;
+    m_preRoll.setCapacity(static_cast<size_t>(m_captureSampleRate) * preRollMs / 1000 *
+                          m_numChannels);
+    m_callbackCapturing.store(false, std::memory_order_relaxed);
+
+    PaError err = Pa_OpenStream(&m_stream,
+                                &parameters,
+                                nullptr,             // no output
+                                m_captureSampleRate,
+                                framesPerBuffer,
+                                paNoFlag,
+                                recordCallback,
+                                this);
+    if (err != paNoError) {
+        qCDebug(lcAudio) << "PortAudio error:" << Pa_GetErrorText(err);
+        Metrics::countError("portaudio");
+        m_stream = nullptr;
+        return false;
+    }
 
+    err = Pa_StartStream(m_stream);
+    if (err != paNoError) {
+        qCDebug(lcAudio) << "PortAudio error:" << Pa_GetErrorText(err);
+        Metrics::countError("portaudio");
+        Pa_CloseStream(m_stream);
+        m_stream = nullptr;
+        return false;
+    }
     return true;
 }
 
-void AudioHandler::updateWavHeader()
+void AudioHandler::closeInputStream()
+{
+    m_idleTimer.stop();
+    if (!m_stream) {
+        return;
+    }
+    Pa_StopStream(m_stream);
+    Pa_CloseStream(m_stream);
+    m_stream = nullptr;
+}
+
+void AudioHandler::restartIdleTimer()
+{
+    const int idleMinutes = Config::instance().getArmedIdleMinutes();
+    if (idleMinutes > 0) {
+        m_idleTimer.start(idleMinutes * 60 * 1000);
+    }
+}
+
+WavFile::Format AudioHandler::recordingFormat() const
+{
+    WavFile::Format format;
+    format.audioFormat = WavFile::kFormatPcm;
+    format.channels = static_cast<quint16>(m_numChannels);
+    format.sampleRate = static_cast<quint32>(m_sampleRate);
+    format.bitsPerSample = static_cast<quint16>(m_bitsPerSample);
+    return format;
+}
+
+QByteArray AudioHandler::wavHeader(quint32 dataSize) const
+{
+    const auto header = WavFile::header(recordingFormat(), dataSize);
+    return QByteArray(header.data(), static_cast<qsizetype>(header.size()));
+}
+
+QString AudioHandler::uploadFileName() const
 {
-    if (!m_outputFile.isOpen()) return;
+    // The server sniffs the container from the extension as well as the content type
+    return QFileInfo(m_currentFilePath).completeBaseName() + "."
+           + AudioEncoder::fileExtension(m_writer->uploadFormat());
+}
 
-    // Update RIFF chunk size
-    qint32 riffSize = m_dataSize + 36; // Total size - 8 bytes
-    m_outputFile.seek(4);
-    m_outputFile.write(reinterpret_cast<const char*>(&riffSize), 4);
+void AudioHandler::publishLevels()
+{
+    LevelMeter::Snapshot snapshot;
+    if (!m_writer->readLevels(snapshot)) {
+        return;
+    }
 
-    // Update data chunk size
-    m_outputFile.seek(40);
-    m_outputFile.write(reinterpret_cast<const char*>(&m_dataSize), 4);
-}
\ No newline at end of file
+    const double db = snapshot.rms > 0.0f ? 20.0 * std::log10(snapshot.rms) : kLevelFloorDb;
+    const qreal level = qBound(0.0, 1.0 - db / kLevelFloorDb, 1.0);
+
+    QVariantList waveform;
+    waveform.reserve(2 * LevelMeter::kWaveformColumns);
+    for (size_t i = 0; i < LevelMeter::kWaveformColumns; ++i) {
+        waveform.append(snapshot.minimum[i]);
+        waveform.append(snapshot.maximum[i]);
+    }
+    emit levelsChanged(level, waveform);
+}
+
+void AudioHandler::handleTranscription(quint64 job, const TranscriptionResult& result)
+{
+    const PendingJob pending = m_pendingJobs.take(job);
+    if (!pending.dictation) {
+        return; // Not a dictation's, or one of a dictation that already failed
+    }
+    Dictation& dictation = *pending.dictation;
+    dictation.parts[pending.part] = result;
+    if (--dictation.remaining > 0) {
+        return;
+    }
+    if (dictation.parts.size() == 1) {
+        deliverDictation(dictation, result);
+        return;
+    }
+
+    // Stitch the long session's parts into one result, each part's times after the last
+    TranscriptionResult joined{};
+    for (const TranscriptionResult& part : std::as_const(dictation.parts)) {
+        const QString text = part.text.trimmed();
+        if (!text.isEmpty()) {
+            joined.text += joined.text.isEmpty() ? text : ' ' + text;
+        }
+        if (joined.language.isEmpty()) {
+            joined.language = part.language;
+        }
+        joined.segments.append(part.segments, qMax(0.0, joined.duration));
+        joined.duration = qMax(0.0, joined.duration) + qMax(0.0, part.duration);
+    }
+    deliverDictation(dictation, joined);
+}
+
+void AudioHandler::handleTranscriptionError(quint64 job, const QString& error)
+{
+    qCDebug(lcAudio) << "Transcription error for job" << job << ":" << error;
+    const PendingJob pending = m_pendingJobs.take(job);
+    if (!pending.dictation) {
+        return;
+    }
+
+    // Without one part the dictation is lost; stop its other jobs
+    for (auto it = m_pendingJobs.begin(); it != m_pendingJobs.end();) {
+        if (it->dictation == pending.dictation) {
+            m_transcriptionService->cancel(it.key());
+            it = m_pendingJobs.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void AudioHandler::deliverDictation(const Dictation& dictation, const TranscriptionResult& result)
+{
+    emit transcriptionReceived(result);
+    Trace::asyncEnd("dictation", dictation.traceDictation);
+
+    static Metrics::Histogram& latency = Metrics::Registry::instance().histogram(
+        "vibeco_stop_to_text_seconds", "From stopping a recording to its text being delivered");
+    latency.record(dictation.stopToText.nsecsElapsed() / 1e6);
+}
+
+void AudioHandler::saveRecordingInBackground()
+{
+    // The arena is complete and no longer written, so the pool thread can read it
+    // while the upload reads it too
+    std::shared_ptr<const ChunkArena> arena = m_recordingArena;
+    const QByteArray header = wavHeader(static_cast<quint32>(arena->size()));
+    const QString path = m_currentFilePath;
+    m_recordingSaved = true;
+
+    QThreadPool::globalInstance()->start([arena, header, path]() {
+        QSaveFile file(path);
+        bool ok = file.open(QIODevice::WriteOnly) && file.write(header) == header.size();
+        size_t offset = 0;
+        while (ok && offset < arena->size()) {
+            size_t available = 0;
+            const char* data = arena->peek(offset, available);
+            ok = file.write(data, static_cast<qint64>(available)) ==
+                 static_cast<qint64>(available);
+            offset += available;
+        }
+        if (!ok || !file.commit()) {
+            qCWarning(lcAudio) << "Failed to save recording:" << path << file.errorString();
+        }
+    });
+}
+
+quint64 AudioHandler::transcribeRecording(const TranscriptionJob::Metadata& metadata)
+{
+    if (!m_recordingArena) {
+        return m_transcriptionService->transcribeAudioFile(m_currentFilePath, metadata);
+    }
+
+    // Each request attempt gets its own device over the same chunks
+    std::shared_ptr<const ChunkArena> arena = m_recordingArena;
+    const QByteArray header = wavHeader(static_cast<quint32>(arena->size()));
+    return m_transcriptionService->transcribeAudioDevice(
+        [arena, header](QObject* parent) { return new ChunkArenaDevice(arena, header, parent); },
+        header.size() + static_cast<qint64>(arena->size()), QFileInfo(m_currentFilePath).fileName(),
+        "audio/wav", metadata);
+}
+
+quint64 AudioHandler::transcribeRecordingSegmented(const TranscriptionJob::Metadata& metadata)
+{
+    if (!m_recordingArena) {
+        return m_transcriptionService->transcribeAudioFileSegmented(m_currentFilePath, metadata);
+    }
+
+    // Splitting needs the samples in one piece
+    QByteArray wav = wavHeader(static_cast<quint32>(m_recordingArena->size()));
+    const qsizetype headerSize = wav.size();
+    wav.resize(headerSize + static_cast<qsizetype>(m_recordingArena->size()));
+    m_recordingArena->read(0, wav.data() + headerSize, m_recordingArena->size());
+    return m_transcriptionService->transcribeAudioDataSegmented(
+        wav, QFileInfo(m_currentFilePath).fileName(), metadata);
+}
+
+void AudioHandler::abortStreamingUpload()
+{
+    if (m_streamingUpload) {
+        m_streamingUpload->close();
+        m_streamingUpload.reset();
+    }
+    if (m_streamingJob != 0) {
+        m_transcriptionService->cancel(m_streamingJob);
+        m_streamingJob = 0;
+    }
+}
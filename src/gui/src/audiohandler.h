@@ -3,11 +3,28 @@
 
 #include <portaudio.h>
 #include <QObject>
-#include <QFile>
+#include <QStringList>
 #include <QDateTime>
 #include <QElapsedTimer>
+#include <QHash>
+#include <QSharedPointer>
+#include <QTimer>
+#include <QVariantList>
+#include <QVector>
+#include <atomic>
+#include <future>
+#include <memory>
+#include "AudioRingBuffer.h"
+#include "ChunkArena.h"
+#include "PreRollBuffer.h"
+#include "SilenceTrimmer.h"
+#include "WavFile.h"
+#include "WavSegmentWriter.h"
 #include "transcriptionservice.h"
 
+class AudioWriter;
+class StreamingUploadDevice;
+
 class AudioHandler : public QObject
 {
     Q_OBJECT
@@ -16,22 +33,63 @@ public:
     explicit AudioHandler(QObject *parent = nullptr);
     ~AudioHandler();
 
+    // Initializes PortAudio, or waits for initializeInBackground() to finish doing so
     bool initialize();
-    bool startRecording();
+    // Starts PortAudio initialization on another thread; initialized() tells when it's done
+    void initializeInBackground();
+    // Opens or releases the always-armed input stream per Config; call after settings
+    // change. While recording this waits for the recording to stop.
+    void updateArming();
+    // Traces into traceDictation when the caller has begun one, otherwise into a new one
+    bool startRecording(uint64_t traceDictation = 0);
     bool stopRecording();
     bool isRecording() const { return m_isRecording; }
-    QString getLastRecordingPath() const { return m_currentFilePath; }
+    // Empty when the recording was kept in memory only
+    QString getLastRecordingPath() const {
+        return m_recordingSaved ? m_currentFilePath : QString();
+    }
     void setAutoTranscribe(bool enabled) { m_autoTranscribe = enabled; }
     bool autoTranscribe() const { return m_autoTranscribe; }
     double getLastRecordingDuration() const { return m_lastRecordingDuration; }
 
+    // Capture devices by name, for Config::setInputDevice(); empty if PortAudio can't start
+    static QStringList inputDevices();
+    // Where saved recordings go: Documents/Vibeco/Recordings
+    static QString recordingsDirectory();
+
+    // Capture health: buffers dropped because the writer thread fell behind
+    quint64 overflowCount() const { return m_ringBuffer.overflowCount(); }
+    quint64 droppedSamples() const { return m_ringBuffer.droppedSamples(); }
+
     signals:
         void recordingStarted();
     void recordingStopped();
-    void audioDataReady(const QByteArray& data);
-    void transcriptionReceived(const QString& text);
+    // Input level for the UI, ~30 times a second while recording: level is RMS mapped
+    // from -60..0 dBFS to 0..1, waveform is (min, max) amplitude pairs, oldest first
+    void levelsChanged(qreal level, const QVariantList& waveform);
+    void captureOverflow(quint64 overflowCount, quint64 droppedSamples);
+    void transcriptionReceived(const TranscriptionResult& result);
+    void initialized(bool ok);
+
+private slots:
+    void handleTranscription(quint64 job, const TranscriptionResult& result);
+    void handleTranscriptionError(quint64 job, const QString& error);
+    void publishLevels();
 
 private:
+    // A stopped recording whose text hasn't been delivered yet. Long sessions send
+    // every segment file as a job of its own and are delivered once all are back.
+    struct Dictation {
+        uint64_t traceDictation = 0;
+        QElapsedTimer stopToText;
+        QVector<TranscriptionResult> parts; // One per job, in recording order
+        int remaining = 0;
+    };
+    struct PendingJob {
+        QSharedPointer<Dictation> dictation;
+        int part = 0;
+    };
+
     static int recordCallback(const void *inputBuffer, void *outputBuffer,
                             unsigned long framesPerBuffer,
                             const PaStreamCallbackTimeInfo* timeInfo,
@@ -39,25 +97,72 @@ private:
                             void *userData);
 
     void processAudioData(const float* inputBuffer, unsigned long framesPerBuffer);
-    bool writeWavHeader();
-    void updateWavHeader();
+    bool completeInitialization(PaError err);
+    static QString deviceName(PaDeviceIndex device);
+    PaDeviceIndex findInputDevice(const QString& name) const;
+    // Picks the device, its native rate and the buffering; sets m_captureSampleRate
+    bool configureInput(PaStreamParameters& parameters, unsigned long& framesPerBuffer);
+    // Counts what the device reported during the recording; true if the buffer was grown
+    bool adaptToInputErrors();
+    bool openInputStream(const PaStreamParameters& parameters, unsigned long framesPerBuffer);
+    void closeInputStream();
+    bool armInput();
+    void restartIdleTimer();
+    WavFile::Format recordingFormat() const;
+    QByteArray wavHeader(quint32 dataSize) const;
+    QString uploadFileName() const;
+    void abortStreamingUpload();
+    void saveRecordingInBackground();
+    // Start a job for the recording just stopped and return its ID
+    quint64 transcribeRecording(const TranscriptionJob::Metadata& metadata);
+    quint64 transcribeRecordingSegmented(const TranscriptionJob::Metadata& metadata);
+    void deliverDictation(const Dictation& dictation, const TranscriptionResult& result);
 
     PaStream *m_stream;
     bool m_isRecording;
     bool m_isInitialized;
+    std::future<PaError> m_pendingInit; // Pa_Initialize() running in the background
 
-    QFile m_outputFile;
+    WavSegmentWriter m_outputFile;
     QString m_currentFilePath;
-    qint64 m_dataSize;
-    const int m_sampleRate = 44100;
+    bool m_recordingSaved;
+    uint64_t m_traceDictation; // Latency trace ID of the current/last recording
+    // Multiplies the configured buffer size and latency; grown by adaptToInputErrors()
+    int m_bufferScale;
+    QString m_bufferScaleDevice;
+    // paInputOverflow/paInputUnderflow callbacks in the current recording
+    std::atomic<quint32> m_inputOverflowEvents;
+    std::atomic<quint32> m_inputUnderflowEvents;
+    // Set by the GUI thread for the duration of a take; the callback mirrors it into
+    // m_callbackCapturing once it has acted on it (spliced the pre-roll, or stopped
+    // writing to m_ringBuffer)
+    std::atomic<bool> m_capturing;
+    std::atomic<bool> m_callbackCapturing;
+    // Audio from before the hotkey while always-armed; owned by the callback
+    PreRollBuffer m_preRoll;
+    QTimer m_idleTimer; // releases an armed device nobody is using
+    // Set while recording in memory instead of to m_outputFile
+    std::shared_ptr<ChunkArena> m_recordingArena;
+    // Captured as float at the device's native rate, stored as 16 kHz PCM16 (what Whisper
+    // uses anyway). Declared before m_writer, which is constructed with them.
+    int m_captureSampleRate = 44100;
+    const int m_sampleRate = 16000;
     const int m_numChannels = 1;
-    const int m_bitsPerSample = 32;
+    const int m_bitsPerSample = 16;
+    AudioRingBuffer m_ringBuffer;
+    AudioWriter* m_writer;
     TranscriptionService* m_transcriptionService;
     bool m_autoTranscribe;
+    QSharedPointer<StreamingUploadDevice> m_streamingUpload;
+    quint64 m_streamingJob; // TranscriptionService job fed by m_streamingUpload, or 0
+    QTimer m_levelTimer;
 
     // Recording duration tracking
     QElapsedTimer m_recordingTimer;
     double m_lastRecordingDuration;
+
+    // Dictations being transcribed, by job; results are matched by ID, never by timing
+    QHash<quint64, PendingJob> m_pendingJobs;
 };
 
 #endif // AUDIOHANDLER_H
\ No newline at end of file
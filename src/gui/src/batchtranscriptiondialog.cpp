@@ -0,0 +1,164 @@
+#include "batchtranscriptiondialog.h"
+#include "BatchTranscriber.h"
+#include "audiohandler.h"
+#include "config.h"
+
+#include <QFileDialog>
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QVBoxLayout>
+
+namespace {
+    constexpr int kStatsIntervalMs = 1000;
+}
+
+BatchTranscriptionDialog::BatchTranscriptionDialog(BatchTranscriber* transcriber,
+                                                   QWidget *parent)
+    : QDialog(parent)
+    , m_transcriber(transcriber)
+{
+    setupUi();
+    updateStats();
+}
+
+void BatchTranscriptionDialog::setupUi()
+{
+    setWindowTitle(tr("Transcribe Recordings"));
+    setMinimumSize(560, 360);
+
+    auto mainLayout = new QVBoxLayout(this);
+
+    // Adding files
+    auto addLayout = new QHBoxLayout;
+    auto addFilesButton = new QPushButton(tr("Add Files..."), this);
+    auto addFolderButton = new QPushButton(tr("Add Folder..."), this);
+    auto priorityLabel = new QLabel(tr("Priority:"), this);
+    m_priorityCombo = new QComboBox(this);
+    m_priorityCombo->addItem(tr("High"), static_cast<int>(BatchTranscriber::Priority::High));
+    m_priorityCombo->addItem(tr("Normal"), static_cast<int>(BatchTranscriber::Priority::Normal));
+    m_priorityCombo->addItem(tr("Low"), static_cast<int>(BatchTranscriber::Priority::Low));
+    m_priorityCombo->setCurrentIndex(1);
+    addLayout->addWidget(addFilesButton);
+    addLayout->addWidget(addFolderButton);
+    addLayout->addStretch();
+    addLayout->addWidget(priorityLabel);
+    addLayout->addWidget(m_priorityCombo);
+    mainLayout->addLayout(addLayout);
+
+    // Jobs
+    m_jobsView = new QTableView(this);
+    m_jobsView->setModel(m_transcriber);
+    m_jobsView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    m_jobsView->verticalHeader()->hide();
+    m_jobsView->horizontalHeader()->setSectionResizeMode(BatchTranscriber::FileColumn,
+                                                         QHeaderView::Stretch);
+    mainLayout->addWidget(m_jobsView);
+
+    // Queue controls
+    auto controlLayout = new QHBoxLayout;
+    auto concurrencyLabel = new QLabel(tr("Files at once:"), this);
+    m_concurrencySpin = new QSpinBox(this);
+    m_concurrencySpin->setRange(1, 8);
+    m_concurrencySpin->setValue(Config::instance().getBatchConcurrency());
+    auto prioritizeButton = new QPushButton(tr("Prioritize Selected"), this);
+    m_pauseButton = new QPushButton(this);
+    auto clearButton = new QPushButton(tr("Clear Finished"), this);
+    controlLayout->addWidget(concurrencyLabel);
+    controlLayout->addWidget(m_concurrencySpin);
+    controlLayout->addStretch();
+    controlLayout->addWidget(prioritizeButton);
+    controlLayout->addWidget(m_pauseButton);
+    controlLayout->addWidget(clearButton);
+    mainLayout->addLayout(controlLayout);
+
+    m_statsLabel = new QLabel(this);
+    mainLayout->addWidget(m_statsLabel);
+
+    auto buttonLayout = new QHBoxLayout;
+    auto closeButton = new QPushButton(tr("Close"), this);
+    buttonLayout->addStretch();
+    buttonLayout->addWidget(closeButton);
+    mainLayout->addLayout(buttonLayout);
+
+    const auto updatePauseButton = [this](bool paused) {
+        m_pauseButton->setText(paused ? tr("Resume") : tr("Pause"));
+    };
+    updatePauseButton(m_transcriber->isPaused());
+
+    // Connect signals
+    connect(addFilesButton, &QPushButton::clicked, this, &BatchTranscriptionDialog::addFiles);
+    connect(addFolderButton, &QPushButton::clicked, this, &BatchTranscriptionDialog::addFolder);
+    connect(prioritizeButton, &QPushButton::clicked, this,
+            &BatchTranscriptionDialog::prioritizeSelected);
+    connect(m_pauseButton, &QPushButton::clicked, this,
+            [this]() { m_transcriber->setPaused(!m_transcriber->isPaused()); });
+    connect(m_transcriber, &BatchTranscriber::pausedChanged, this, updatePauseButton);
+    connect(clearButton, &QPushButton::clicked, m_transcriber, &BatchTranscriber::clearFinished);
+    connect(m_concurrencySpin, &QSpinBox::valueChanged, this,
+            [](int count) { Config::instance().setBatchConcurrency(count); });
+    connect(closeButton, &QPushButton::clicked, this, &QDialog::close);
+
+    connect(m_transcriber, &BatchTranscriber::statsChanged, this,
+            &BatchTranscriptionDialog::updateStats);
+    m_statsTimer.setInterval(kStatsIntervalMs);
+    connect(&m_statsTimer, &QTimer::timeout, this, &BatchTranscriptionDialog::updateStats);
+}
+
+int BatchTranscriptionDialog::selectedPriority() const
+{
+    return m_priorityCombo->currentData().toInt();
+}
+
+void BatchTranscriptionDialog::addFiles()
+{
+    const QString filter =
+        tr("Audio files (%1)").arg(BatchTranscriber::audioFileFilters().join(' '));
+    const QStringList paths = QFileDialog::getOpenFileNames(
+        this, tr("Transcribe Recordings"), AudioHandler::recordingsDirectory(), filter);
+    m_transcriber->addFiles(paths, static_cast<BatchTranscriber::Priority>(selectedPriority()));
+}
+
+void BatchTranscriptionDialog::addFolder()
+{
+    const QString directory = QFileDialog::getExistingDirectory(
+        this, tr("Transcribe Every Recording In"), AudioHandler::recordingsDirectory());
+    if (!directory.isEmpty()) {
+        m_transcriber->addDirectory(directory,
+                                    static_cast<BatchTranscriber::Priority>(selectedPriority()));
+    }
+}
+
+void BatchTranscriptionDialog::prioritizeSelected()
+{
+    const QModelIndexList rows = m_jobsView->selectionModel()->selectedRows();
+    for (const QModelIndex& row : rows) {
+        m_transcriber->setPriority(row.row(), BatchTranscriber::Priority::High);
+    }
+}
+
+void BatchTranscriptionDialog::updateStats()
+{
+    const BatchTranscriber::Stats stats = m_transcriber->stats();
+    if (stats.running > 0 && !m_statsTimer.isActive()) {
+        m_statsTimer.start();
+    } else if (stats.running == 0) {
+        m_statsTimer.stop();
+    }
+
+    QString text = tr("%1 done, %2 in progress, %3 queued, %4 skipped, %5 failed")
+                       .arg(stats.done)
+                       .arg(stats.running)
+                       .arg(stats.queued)
+                       .arg(stats.skipped)
+                       .arg(stats.failed);
+    if (stats.activeSeconds > 0.0 && stats.done > 0) {
+        // Throughput over the time anything was running, so pauses don't drag it down
+        text += tr("\n%1 min of audio in %2 s: %3x real time, %4 files/min, %5 MB/s")
+                    .arg(stats.audioSeconds / 60.0, 0, 'f', 1)
+                    .arg(stats.activeSeconds, 0, 'f', 0)
+                    .arg(stats.audioSeconds / stats.activeSeconds, 0, 'f', 1)
+                    .arg(stats.done * 60.0 / stats.activeSeconds, 0, 'f', 1)
+                    .arg(stats.fileBytes / stats.activeSeconds / 1e6, 0, 'f', 2);
+    }
+    m_statsLabel->setText(text);
+}
@@ -1,92 +1,426 @@
 #include "config.h"
+#include "Logging.h"
+#include "Metrics.h"
+#include <QCoreApplication>
 #include <QCryptographicHash>
 #include <QDataStream>
 #include <QDebug>
+#include <QMutexLocker>
 
 const QString Config::CONFIG_ORG = "Vibeco";
 const QString Config::CONFIG_APP = "Vibeco";
 const QString Config::KEY_API_KEY = "GroqApiKey";
 const QString Config::KEY_MODEL = "WhisperModel";
+const QString Config::KEY_TRANSCRIPTION_BACKEND = "TranscriptionBackend";
+const QString Config::KEY_LOCAL_MODEL = "LocalWhisperModel";
+const QString Config::KEY_STREAMING_UPLOAD = "StreamingUpload";
+const QString Config::KEY_UPLOAD_FORMAT = "UploadFormat";
+const QString Config::KEY_TRIM_SILENCE = "TrimSilence";
+const QString Config::KEY_WORD_TIMESTAMPS = "WordTimestamps";
+const QString Config::KEY_SEGMENTED_TRANSCRIPTION = "SegmentedTranscription";
+const QString Config::KEY_MAX_PARALLEL_UPLOADS = "MaxParallelUploads";
+const QString Config::KEY_BATCH_CONCURRENCY = "BatchConcurrency";
+const QString Config::KEY_RESULT_ORDER = "ResultOrder";
+const QString Config::KEY_HEDGE_REQUESTS = "HedgeRequests";
+const QString Config::KEY_IN_MEMORY_RECORDING = "InMemoryRecording";
+const QString Config::KEY_SAVE_RECORDINGS = "SaveRecordings";
+const QString Config::KEY_LONG_SESSION_RECORDING = "LongSessionRecording";
+const QString Config::KEY_SEGMENT_MINUTES = "SegmentMinutes";
+const QString Config::KEY_SEGMENT_MEGABYTES = "SegmentMegabytes";
+const QString Config::KEY_WRITE_RF64 = "WriteRf64";
+const QString Config::KEY_INPUT_DEVICE = "InputDevice";
+const QString Config::KEY_INPUT_LATENCY_MS = "InputLatencyMs";
+const QString Config::KEY_BUFFER_FRAMES = "BufferFrames";
+const QString Config::KEY_ADAPTIVE_BUFFER = "AdaptiveBuffer";
+const QString Config::KEY_ALWAYS_ARMED = "AlwaysArmed";
+const QString Config::KEY_PRE_ROLL_MS = "PreRollMs";
+const QString Config::KEY_ARMED_IDLE_MINUTES = "ArmedIdleMinutes";
+const QString Config::KEY_LATENCY_TRACING = "LatencyTracing";
+const QString Config::KEY_METRICS_PORT = "MetricsPort";
 const QString Config::DEFAULT_MODEL = "whisper-large-v3-turbo";
+const QString Config::DEFAULT_LOCAL_MODEL = "base-q5_1";
+
+namespace {
+    // Writes that arrive within this long of each other are saved together
+    constexpr int kWriteDelayMs = 500;
+
+    // Simple XOR-based obfuscation (not true encryption, but better than plaintext);
+    // applying it twice gives back the input
+    QByteArray xorWithMachineId(const QByteArray& data) {
+        QByteArray machineId = QSysInfo::machineUniqueId();
+        if (machineId.isEmpty()) {
+            return data;
+        }
+        QByteArray result;
+        result.reserve(data.size());
+        for (int i = 0; i < data.size(); ++i) {
+            result.append(data.at(i) ^ machineId.at(i % machineId.size()));
+        }
+        return result;
+    }
+} // namespace
 
 Config::Config()
-    : m_settings(CONFIG_ORG, CONFIG_APP)
+    : m_lastWriteOk(true)
 {
+    QSettings settings(CONFIG_ORG, CONFIG_APP);
+
     // Ensure the config directory exists
     QString configPath = getConfigPath();
     QDir dir;
     if (!dir.exists(configPath)) {
         dir.mkpath(configPath);
     }
-    qDebug() << "Config initialized. Path:" << configPath;
-    qDebug() << "Settings file:" << m_settings.fileName();
+    qCDebug(lcConfig) << "Config initialized. Path:" << configPath;
+    qCDebug(lcConfig) << "Settings file:" << settings.fileName();
+
+    m_values = QSharedPointer<const Values>::create(load(settings));
+    qCDebug(lcConfig) << "API key configured:" << !m_values->apiKey.isEmpty();
+
+    m_writeTimer.setSingleShot(true);
+    m_writeTimer.setInterval(kWriteDelayMs);
+    connect(&m_writeTimer, &QTimer::timeout, this, &Config::writePending);
+    if (QCoreApplication::instance()) {
+        connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, &Config::flush);
+    }
 }
 
-QString Config::getApiKey() const {
-    QString encryptedKey = m_settings.value(KEY_API_KEY).toString();
-    qDebug() << "Getting API key. Encrypted key exists:" << !encryptedKey.isEmpty();
+Config::~Config() {
+    flush();
+}
+
+Config::Values Config::load(const QSettings& settings) {
+    Values values;
 
-    if (encryptedKey.isEmpty()) {
-        qDebug() << "No API key found in settings";
-        return QString();
+    const QString encryptedKey = settings.value(KEY_API_KEY).toString();
+    if (!encryptedKey.isEmpty()) {
+        values.apiKey =
+            QString::fromUtf8(xorWithMachineId(QByteArray::fromBase64(encryptedKey.toLatin1())));
     }
+    values.model = settings.value(KEY_MODEL, DEFAULT_MODEL).toString();
+    values.localModel = settings.value(KEY_LOCAL_MODEL, DEFAULT_LOCAL_MODEL).toString();
+    values.transcriptionBackend = settings.value(KEY_TRANSCRIPTION_BACKEND, "groq").toString();
+    values.streamingUpload = settings.value(KEY_STREAMING_UPLOAD, false).toBool();
+    values.trimSilence = settings.value(KEY_TRIM_SILENCE, true).toBool();
+    values.wordTimestamps = settings.value(KEY_WORD_TIMESTAMPS, false).toBool();
+    values.segmentedTranscription = settings.value(KEY_SEGMENTED_TRANSCRIPTION, false).toBool();
+    values.maxParallelUploads = settings.value(KEY_MAX_PARALLEL_UPLOADS, 4).toInt();
+    values.batchConcurrency = settings.value(KEY_BATCH_CONCURRENCY, 2).toInt();
+    values.resultOrder = settings.value(KEY_RESULT_ORDER, "submission").toString();
+    values.hedgeRequests = settings.value(KEY_HEDGE_REQUESTS, false).toBool();
+    values.inMemoryRecording = settings.value(KEY_IN_MEMORY_RECORDING, false).toBool();
+    values.saveRecordings = settings.value(KEY_SAVE_RECORDINGS, true).toBool();
+    values.longSessionRecording = settings.value(KEY_LONG_SESSION_RECORDING, false).toBool();
+    values.segmentMinutes = settings.value(KEY_SEGMENT_MINUTES, 60).toInt();
+    values.segmentMegabytes = settings.value(KEY_SEGMENT_MEGABYTES, 0).toInt();
+    values.writeRf64 = settings.value(KEY_WRITE_RF64, false).toBool();
+    values.inputDevice = settings.value(KEY_INPUT_DEVICE, "").toString();
+    values.inputLatencyMs = settings.value(KEY_INPUT_LATENCY_MS, 0).toInt();
+    values.bufferFrames = settings.value(KEY_BUFFER_FRAMES, 256).toInt();
+    values.adaptiveBuffer = settings.value(KEY_ADAPTIVE_BUFFER, true).toBool();
+    values.alwaysArmed = settings.value(KEY_ALWAYS_ARMED, false).toBool();
+    values.preRollMs = settings.value(KEY_PRE_ROLL_MS, 500).toInt();
+    values.armedIdleMinutes = settings.value(KEY_ARMED_IDLE_MINUTES, 10).toInt();
+    values.latencyTracing = settings.value(KEY_LATENCY_TRACING, false).toBool();
+    values.metricsPort = settings.value(KEY_METRICS_PORT, 0).toInt();
+    values.uploadFormat = settings.value(KEY_UPLOAD_FORMAT, "wav").toString();
+    return values;
+}
 
-    // Simple XOR-based obfuscation (not true encryption, but better than plaintext)
-    QByteArray key = QByteArray::fromBase64(encryptedKey.toLatin1());
-    QByteArray machineId = QSysInfo::machineUniqueId();
-    QByteArray result;
+QSharedPointer<const Config::Values> Config::values() const {
+    QMutexLocker lock(&m_mutex);
+    return m_values;
+}
 
-    for (int i = 0; i < key.size(); ++i) {
-        result.append(key.at(i) ^ machineId.at(i % machineId.size()));
+template <typename T>
+bool Config::update(const QString& key, T Values::*field, const T& value, const QVariant& stored) {
+    {
+        QMutexLocker lock(&m_mutex);
+        if ((*m_values).*field == value) {
+            return m_lastWriteOk.load();
+        }
+        auto values = QSharedPointer<Values>::create(*m_values);
+        (*values).*field = value;
+        m_values = values;
+        m_pendingWrites.insert(key, stored);
     }
 
-    QString decryptedKey = QString::fromUtf8(result);
-    qDebug() << "API key retrieved successfully. Length:" << decryptedKey.length();
-    return decryptedKey;
+    // (Re)start the coalescing delay on the thread that owns the timer
+    QMetaObject::invokeMethod(&m_writeTimer, qOverload<>(&QTimer::start));
+    emit changed(key);
+    return m_lastWriteOk.load();
 }
 
-bool Config::setApiKey(const QString& key) {
-    qDebug() << "Setting API key. Key length:" << key.length();
+void Config::writePending() {
+    QVariantMap writes;
+    {
+        QMutexLocker lock(&m_mutex);
+        writes.swap(m_pendingWrites);
+    }
+    if (writes.isEmpty()) {
+        return;
+    }
 
-    if (key.isEmpty()) {
-        qDebug() << "Removing API key from settings";
-        m_settings.remove(KEY_API_KEY);
-        return true;
+    // One write at a time, so a later value can't be overtaken by an earlier one
+    if (m_writing.valid()) {
+        m_writing.get();
     }
+    m_writing = std::async(std::launch::async, [this, writes]() {
+        QSettings settings(CONFIG_ORG, CONFIG_APP);
+        for (auto it = writes.constBegin(); it != writes.constEnd(); ++it) {
+            if (it.value().isValid()) {
+                settings.setValue(it.key(), it.value());
+            } else {
+                settings.remove(it.key());
+            }
+        }
+        settings.sync();
 
-    // Simple XOR-based obfuscation
-    QByteArray machineId = QSysInfo::machineUniqueId();
-    QByteArray rawKey = key.toUtf8();
-    QByteArray result;
+        const bool ok = settings.status() == QSettings::NoError;
+        m_lastWriteOk.store(ok);
+        if (!ok) {
+            qCWarning(lcConfig) << "Could not save settings to" << settings.fileName();
+            Metrics::countError("config_write");
+        }
+    });
+}
 
-    for (int i = 0; i < rawKey.size(); ++i) {
-        result.append(rawKey.at(i) ^ machineId.at(i % machineId.size()));
+void Config::flush() {
+    m_writeTimer.stop();
+    writePending();
+    if (m_writing.valid()) {
+        m_writing.get();
     }
+}
 
-    QString encryptedKey = QString::fromLatin1(result.toBase64());
-    m_settings.setValue(KEY_API_KEY, encryptedKey);
-    m_settings.sync(); // Force write to disk
+QString Config::getApiKey() const {
+    return values()->apiKey;
+}
 
-    bool success = m_settings.status() == QSettings::NoError;
-    qDebug() << "API key saved:" << success << "Settings file:" << m_settings.fileName();
-    return success;
+bool Config::setApiKey(const QString& key) {
+    qCDebug(lcConfig) << "Setting API key. Key length:" << key.length();
+    const QVariant stored =
+        key.isEmpty() ? QVariant() : QString::fromLatin1(xorWithMachineId(key.toUtf8()).toBase64());
+    return update(KEY_API_KEY, &Values::apiKey, key, stored);
 }
 
 QString Config::getModel() const {
-    QString model = m_settings.value(KEY_MODEL, DEFAULT_MODEL).toString();
-    qDebug() << "Getting model:" << model;
-    return model;
+    return values()->model;
 }
 
 bool Config::setModel(const QString& model) {
-    qDebug() << "Setting model:" << model;
-    if (model.isEmpty()) {
-        m_settings.setValue(KEY_MODEL, DEFAULT_MODEL);
-    } else {
-        m_settings.setValue(KEY_MODEL, model);
-    }
-    m_settings.sync(); // Force write to disk
-    return m_settings.status() == QSettings::NoError;
+    qCDebug(lcConfig) << "Setting model:" << model;
+    const QString value = model.isEmpty() ? DEFAULT_MODEL : model;
+    return update(KEY_MODEL, &Values::model, value, value);
+}
+
+QString Config::getLocalModel() const {
+    return values()->localModel;
+}
+
+bool Config::setLocalModel(const QString& model) {
+    const QString value = model.isEmpty() ? DEFAULT_LOCAL_MODEL : model;
+    return update(KEY_LOCAL_MODEL, &Values::localModel, value, value);
+}
+
+QString Config::getTranscriptionBackend() const {
+    return values()->transcriptionBackend;
+}
+
+bool Config::setTranscriptionBackend(const QString& backend) {
+    return update(KEY_TRANSCRIPTION_BACKEND, &Values::transcriptionBackend, backend, backend);
+}
+
+bool Config::getStreamingUpload() const {
+    return values()->streamingUpload;
+}
+
+bool Config::setStreamingUpload(bool enabled) {
+    return update(KEY_STREAMING_UPLOAD, &Values::streamingUpload, enabled, enabled);
+}
+
+bool Config::getTrimSilence() const {
+    return values()->trimSilence;
+}
+
+bool Config::setTrimSilence(bool enabled) {
+    return update(KEY_TRIM_SILENCE, &Values::trimSilence, enabled, enabled);
+}
+
+bool Config::getWordTimestamps() const {
+    return values()->wordTimestamps;
+}
+
+bool Config::setWordTimestamps(bool enabled) {
+    return update(KEY_WORD_TIMESTAMPS, &Values::wordTimestamps, enabled, enabled);
+}
+
+bool Config::getSegmentedTranscription() const {
+    return values()->segmentedTranscription;
+}
+
+bool Config::setSegmentedTranscription(bool enabled) {
+    return update(KEY_SEGMENTED_TRANSCRIPTION, &Values::segmentedTranscription, enabled, enabled);
+}
+
+int Config::getMaxParallelUploads() const {
+    return values()->maxParallelUploads;
+}
+
+bool Config::setMaxParallelUploads(int count) {
+    return update(KEY_MAX_PARALLEL_UPLOADS, &Values::maxParallelUploads, count, count);
+}
+
+int Config::getBatchConcurrency() const {
+    return values()->batchConcurrency;
+}
+
+bool Config::setBatchConcurrency(int count) {
+    return update(KEY_BATCH_CONCURRENCY, &Values::batchConcurrency, count, count);
+}
+
+QString Config::getResultOrder() const {
+    return values()->resultOrder;
+}
+
+bool Config::setResultOrder(const QString& order) {
+    return update(KEY_RESULT_ORDER, &Values::resultOrder, order, order);
+}
+
+bool Config::getHedgeRequests() const {
+    return values()->hedgeRequests;
+}
+
+bool Config::setHedgeRequests(bool enabled) {
+    return update(KEY_HEDGE_REQUESTS, &Values::hedgeRequests, enabled, enabled);
+}
+
+bool Config::getInMemoryRecording() const {
+    return values()->inMemoryRecording;
+}
+
+bool Config::setInMemoryRecording(bool enabled) {
+    return update(KEY_IN_MEMORY_RECORDING, &Values::inMemoryRecording, enabled, enabled);
+}
+
+bool Config::getSaveRecordings() const {
+    return values()->saveRecordings;
+}
+
+bool Config::setSaveRecordings(bool enabled) {
+    return update(KEY_SAVE_RECORDINGS, &Values::saveRecordings, enabled, enabled);
+}
+
+bool Config::getLongSessionRecording() const {
+    return values()->longSessionRecording;
+}
+
+bool Config::setLongSessionRecording(bool enabled) {
+    return update(KEY_LONG_SESSION_RECORDING, &Values::longSessionRecording, enabled, enabled);
+}
+
+int Config::getSegmentMinutes() const {
+    return values()->segmentMinutes;
+}
+
+bool Config::setSegmentMinutes(int minutes) {
+    return update(KEY_SEGMENT_MINUTES, &Values::segmentMinutes, minutes, minutes);
+}
+
+int Config::getSegmentMegabytes() const {
+    return values()->segmentMegabytes;
+}
+
+bool Config::setSegmentMegabytes(int megabytes) {
+    return update(KEY_SEGMENT_MEGABYTES, &Values::segmentMegabytes, megabytes, megabytes);
+}
+
+bool Config::getWriteRf64() const {
+    return values()->writeRf64;
+}
+
+bool Config::setWriteRf64(bool enabled) {
+    return update(KEY_WRITE_RF64, &Values::writeRf64, enabled, enabled);
+}
+
+QString Config::getInputDevice() const {
+    return values()->inputDevice;
+}
+
+bool Config::setInputDevice(const QString& device) {
+    return update(KEY_INPUT_DEVICE, &Values::inputDevice, device, device);
+}
+
+int Config::getInputLatencyMs() const {
+    return values()->inputLatencyMs;
+}
+
+bool Config::setInputLatencyMs(int milliseconds) {
+    return update(KEY_INPUT_LATENCY_MS, &Values::inputLatencyMs, milliseconds, milliseconds);
+}
+
+int Config::getBufferFrames() const {
+    return values()->bufferFrames;
+}
+
+bool Config::setBufferFrames(int frames) {
+    return update(KEY_BUFFER_FRAMES, &Values::bufferFrames, frames, frames);
+}
+
+bool Config::getAdaptiveBuffer() const {
+    return values()->adaptiveBuffer;
+}
+
+bool Config::setAdaptiveBuffer(bool enabled) {
+    return update(KEY_ADAPTIVE_BUFFER, &Values::adaptiveBuffer, enabled, enabled);
+}
+
+bool Config::getAlwaysArmed() const {
+    return values()->alwaysArmed;
+}
+
+bool Config::setAlwaysArmed(bool enabled) {
+    return update(KEY_ALWAYS_ARMED, &Values::alwaysArmed, enabled, enabled);
+}
+
+int Config::getPreRollMs() const {
+    return values()->preRollMs;
+}
+
+bool Config::setPreRollMs(int milliseconds) {
+    return update(KEY_PRE_ROLL_MS, &Values::preRollMs, milliseconds, milliseconds);
+}
+
+int Config::getArmedIdleMinutes() const {
+    return values()->armedIdleMinutes;
+}
+
+bool Config::setArmedIdleMinutes(int minutes) {
+    return update(KEY_ARMED_IDLE_MINUTES, &Values::armedIdleMinutes, minutes, minutes);
+}
+
+bool Config::getLatencyTracing() const {
+    return values()->latencyTracing;
+}
+
+bool Config::setLatencyTracing(bool enabled) {
+    return update(KEY_LATENCY_TRACING, &Values::latencyTracing, enabled, enabled);
+}
+
+int Config::getMetricsPort() const {
+    return values()->metricsPort;
+}
+
+bool Config::setMetricsPort(int port) {
+    return update(KEY_METRICS_PORT, &Values::metricsPort, port, port);
+}
+
+QString Config::getUploadFormat() const {
+    return values()->uploadFormat;
+}
+
+bool Config::setUploadFormat(const QString& format) {
+    return update(KEY_UPLOAD_FORMAT, &Values::uploadFormat, format, format);
 }
 
 QString Config::getConfigPath() {
@@ -2,16 +2,22 @@
 #include <QQmlApplicationEngine>
 #include <QApplication>
 #include <QDebug>
-#include <QFile>
-#include <QDir>
+#include <QStandardPaths>
+#include "Logging.h"
+#include "StartupProfile.h"
 #include "systemtrayhandler.h"
 #include <QQmlEngine>
 #include <QQmlContext>
-#include "ShortcutManager.h"
 #include "QmlDictationManager.h"
 
 int main(int argc, char *argv[])
 {
+    // --startup-benchmark: report startup milestones on stdout and quit once ready
+    bool startupBenchmark = false;
+    for (int i = 1; i < argc; ++i) {
+        startupBenchmark = startupBenchmark || qstrcmp(argv[i], "--startup-benchmark") == 0;
+    }
+    StartupProfile::begin(startupBenchmark);
     QApplication app(argc, argv);
 
     // Set application information
@@ -19,17 +25,14 @@ int main(int argc, char *argv[])
     app.setOrganizationName("Vibeco");
     app.setApplicationVersion("0.1.0");
 
+    // From here on, log output is written by a background thread
+    Logging::install(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) +
+                     "/Logs");
+
     QQmlApplicationEngine engine;
 
     // Debug logging
-    qDebug() << "Starting application...";
-    qDebug() << "Current working directory:" << QDir::currentPath();
-    qDebug() << "QML File exists:" << QFile::exists(":/main.qml");
-    qDebug() << "Available resource files:";
-    QDir resourceDir(":/");
-    for(const QString &file : resourceDir.entryList()) {
-        qDebug() << "  -" << file;
-    }
+    qCDebug(lcUi) << "Starting application...";
 
     // Register Style singleton if needed
     qmlRegisterSingletonType(QUrl("qrc:/Style.qml"), "com.vibeco.style", 1, 0, "Style");
@@ -39,11 +42,9 @@ int main(int argc, char *argv[])
 
     // This is critical - set the tray handler as a context property BEFORE loading the QML
     engine.rootContext()->setContextProperty("trayHandler", trayHandler);
-    qDebug() << "TrayHandler set as context property";
-
-    // Create and register ShortcutManager
-    ShortcutManager* shortcutManager = new ShortcutManager(trayHandler, &app);
-    engine.rootContext()->setContextProperty("shortcutManager", shortcutManager);
+    engine.rootContext()->setContextProperty("transcriptionHistory", trayHandler->history());
+    engine.rootContext()->setContextProperty("transcriptionSearch", trayHandler->search());
+    qCDebug(lcUi) << "TrayHandler set as context property";
 
     const QUrl url(QStringLiteral("qrc:/main.qml"));
 
@@ -51,45 +52,33 @@ int main(int argc, char *argv[])
     QObject::connect(&engine, &QQmlApplicationEngine::objectCreated,
                      &app, [url, trayHandler](QObject *obj, const QUrl &objUrl) {
         if (!obj && url == objUrl) {
-            qCritical() << "Failed to create QML object for" << objUrl;
+            qCCritical(lcUi) << "Failed to create QML object for" << objUrl;
             QCoreApplication::exit(-1);
             return;
         }
 
         if (url == objUrl) {
-            qDebug() << "Main window created, setting it in TrayHandler";
+            qCDebug(lcUi) << "Main window created, setting it in TrayHandler";
             // obj is the main window
             trayHandler->setMainWindow(obj);
 
             // Verify the trayHandler is accessible from QML
             QVariant result;
             QMetaObject::invokeMethod(obj, "checkTrayHandler", Q_RETURN_ARG(QVariant, result));
-            qDebug() << "TrayHandler check result:" << result.toBool();
-
-            // Connect signal for transcription reception
-            QObject::connect(trayHandler, &SystemTrayHandler::transcriptionReceived,
-                             obj, [obj](const QString& text, double duration, const QString& language) {
-                // Call the QML method to add a transcription
-                QVariantMap transcription;
-                transcription["text"] = text;
-                transcription["timestamp"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-                transcription["duration"] = duration;
-                transcription["language"] = language;
-
-                QMetaObject::invokeMethod(obj, "onTranscriptionReceived",
-                                          Q_ARG(QVariant, QVariant::fromValue(transcription)));
-            });
+            qCDebug(lcUi) << "TrayHandler check result:" << result.toBool();
         }
     }, Qt::QueuedConnection);
 
-    qDebug() << "Loading QML file:" << url.toString();
+    qCDebug(lcUi) << "Loading QML file:" << url.toString();
     engine.load(url);
 
     if (engine.rootObjects().isEmpty()) {
-        qCritical() << "No root objects created - QML loading failed!";
+        qCCritical(lcUi) << "No root objects created - QML loading failed!";
         return -1;
     }
 
-    qDebug() << "QML loaded successfully, starting application";
-    return app.exec();
+    qCDebug(lcUi) << "QML loaded successfully, starting application";
+    const int result = app.exec();
+    Logging::shutdown();
+    return result;
 }
\ No newline at end of file
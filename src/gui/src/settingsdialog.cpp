@@ -1,6 +1,8 @@
 #include "settingsdialog.h"
 #include "config.h"
 #include "transcriptionservice.h"
+#include "AudioEncoder.h"
+#include "audiohandler.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -22,6 +24,28 @@ void SettingsDialog::setupUi()
 
     auto mainLayout = new QVBoxLayout(this);
 
+    // Where transcription runs
+    auto backendLayout = new QHBoxLayout;
+    auto backendLabel = new QLabel(tr("Transcribe With:"), this);
+    m_backendCombo = new QComboBox(this);
+    m_backendCombo->addItem(tr("Groq API"), "groq");
+    if (TranscriptionService::isLocalBackendAvailable()) {
+        m_backendCombo->addItem(tr("This computer (offline)"), "local");
+    }
+    backendLayout->addWidget(backendLabel);
+    backendLayout->addWidget(m_backendCombo);
+    mainLayout->addLayout(backendLayout);
+
+    auto localModelLayout = new QHBoxLayout;
+    auto localModelLabel = new QLabel(tr("Local Model:"), this);
+    m_localModelCombo = new QComboBox(this);
+    m_localModelCombo->addItems(TranscriptionService::availableLocalModels());
+    localModelLayout->addWidget(localModelLabel);
+    localModelLayout->addWidget(m_localModelCombo);
+    mainLayout->addLayout(localModelLayout);
+    localModelLabel->setVisible(TranscriptionService::isLocalBackendAvailable());
+    m_localModelCombo->setVisible(TranscriptionService::isLocalBackendAvailable());
+
     // API Key section
     auto apiKeyLayout = new QHBoxLayout;
     auto apiKeyLabel = new QLabel(tr("Groq API Key:"), this);
@@ -41,6 +65,146 @@ void SettingsDialog::setupUi()
     modelLayout->addWidget(m_modelCombo);
     mainLayout->addLayout(modelLayout);
 
+    // Input device and buffering
+    auto inputDeviceLayout = new QHBoxLayout;
+    auto inputDeviceLabel = new QLabel(tr("Microphone:"), this);
+    m_inputDeviceCombo = new QComboBox(this);
+    m_inputDeviceCombo->addItem(tr("System default"), QString());
+    for (const QString& device : AudioHandler::inputDevices()) {
+        m_inputDeviceCombo->addItem(device, device);
+    }
+    inputDeviceLayout->addWidget(inputDeviceLabel);
+    inputDeviceLayout->addWidget(m_inputDeviceCombo, 1);
+    mainLayout->addLayout(inputDeviceLayout);
+
+    auto bufferLayout = new QHBoxLayout;
+    auto bufferLabel = new QLabel(tr("Input buffer:"), this);
+    m_bufferFramesSpin = new QSpinBox(this);
+    m_bufferFramesSpin->setRange(0, 8192);
+    m_bufferFramesSpin->setSingleStep(64);
+    m_bufferFramesSpin->setSuffix(tr(" frames"));
+    m_bufferFramesSpin->setSpecialValueText(tr("automatic"));
+    m_inputLatencySpin = new QSpinBox(this);
+    m_inputLatencySpin->setRange(0, 500);
+    m_inputLatencySpin->setSuffix(tr(" ms latency"));
+    m_inputLatencySpin->setSpecialValueText(tr("device latency"));
+    bufferLayout->addWidget(bufferLabel);
+    bufferLayout->addWidget(m_bufferFramesSpin);
+    bufferLayout->addWidget(m_inputLatencySpin);
+    bufferLayout->addStretch();
+    mainLayout->addLayout(bufferLayout);
+    m_adaptiveBufferCheck =
+        new QCheckBox(tr("Enlarge the buffer when the microphone keeps overflowing"), this);
+    mainLayout->addWidget(m_adaptiveBufferCheck);
+
+    auto armedLayout = new QHBoxLayout;
+    m_alwaysArmedCheck = new QCheckBox(tr("Keep the microphone open, pre-roll:"), this);
+    m_preRollSpin = new QSpinBox(this);
+    m_preRollSpin->setRange(0, 5000);
+    m_preRollSpin->setSingleStep(100);
+    m_preRollSpin->setSuffix(tr(" ms"));
+    m_armedIdleSpin = new QSpinBox(this);
+    m_armedIdleSpin->setRange(0, 24 * 60);
+    m_armedIdleSpin->setPrefix(tr("release after "));
+    m_armedIdleSpin->setSuffix(tr(" min idle"));
+    m_armedIdleSpin->setSpecialValueText(tr("never release"));
+    armedLayout->addWidget(m_alwaysArmedCheck);
+    armedLayout->addWidget(m_preRollSpin);
+    armedLayout->addWidget(m_armedIdleSpin);
+    armedLayout->addStretch();
+    mainLayout->addLayout(armedLayout);
+    connect(m_alwaysArmedCheck, &QCheckBox::toggled, m_preRollSpin, &QWidget::setEnabled);
+    connect(m_alwaysArmedCheck, &QCheckBox::toggled, m_armedIdleSpin, &QWidget::setEnabled);
+
+    // Upload options
+    m_streamingUploadCheck = new QCheckBox(tr("Upload audio while recording (lower latency)"), this);
+    mainLayout->addWidget(m_streamingUploadCheck);
+    m_trimSilenceCheck = new QCheckBox(tr("Trim silence before uploading"), this);
+    mainLayout->addWidget(m_trimSilenceCheck);
+    m_wordTimestampsCheck = new QCheckBox(tr("Request word-level timestamps"), this);
+    mainLayout->addWidget(m_wordTimestampsCheck);
+
+    auto segmentedLayout = new QHBoxLayout;
+    m_segmentedCheck = new QCheckBox(tr("Split long recordings, parallel uploads:"), this);
+    m_parallelUploadsSpin = new QSpinBox(this);
+    m_parallelUploadsSpin->setRange(1, 8);
+    segmentedLayout->addWidget(m_segmentedCheck);
+    segmentedLayout->addWidget(m_parallelUploadsSpin);
+    segmentedLayout->addStretch();
+    mainLayout->addLayout(segmentedLayout);
+    connect(m_segmentedCheck, &QCheckBox::toggled, m_parallelUploadsSpin, &QWidget::setEnabled);
+
+    m_hedgeRequestsCheck = new QCheckBox(tr("Send a backup request when the API is slow"), this);
+    mainLayout->addWidget(m_hedgeRequestsCheck);
+
+    m_inMemoryCheck =
+        new QCheckBox(tr("Keep recordings in memory (skip the disk before uploading)"), this);
+    mainLayout->addWidget(m_inMemoryCheck);
+    m_saveRecordingsCheck = new QCheckBox(tr("Save a copy of each in-memory recording"), this);
+    mainLayout->addWidget(m_saveRecordingsCheck);
+    connect(m_inMemoryCheck, &QCheckBox::toggled, m_saveRecordingsCheck, &QWidget::setEnabled);
+
+    // Meeting capture: split into files, keep memory flat
+    m_longSessionCheck = new QCheckBox(tr("Long sessions (split the recording into files)"), this);
+    mainLayout->addWidget(m_longSessionCheck);
+    auto segmentLimitLayout = new QHBoxLayout;
+    auto segmentLimitLabel = new QLabel(tr("New file every:"), this);
+    m_segmentMinutesSpin = new QSpinBox(this);
+    m_segmentMinutesSpin->setRange(0, 24 * 60);
+    m_segmentMinutesSpin->setSuffix(tr(" min"));
+    m_segmentMinutesSpin->setSpecialValueText(tr("any length"));
+    m_segmentMegabytesSpin = new QSpinBox(this);
+    m_segmentMegabytesSpin->setRange(0, 64 * 1024);
+    m_segmentMegabytesSpin->setSuffix(tr(" MB"));
+    m_segmentMegabytesSpin->setSpecialValueText(tr("any size"));
+    segmentLimitLayout->addWidget(segmentLimitLabel);
+    segmentLimitLayout->addWidget(m_segmentMinutesSpin);
+    segmentLimitLayout->addWidget(m_segmentMegabytesSpin);
+    segmentLimitLayout->addStretch();
+    mainLayout->addLayout(segmentLimitLayout);
+    m_rf64Check = new QCheckBox(tr("Write RF64 files larger than 4 GB instead of splitting"), this);
+    mainLayout->addWidget(m_rf64Check);
+    connect(m_longSessionCheck, &QCheckBox::toggled, m_segmentMinutesSpin, &QWidget::setEnabled);
+    connect(m_longSessionCheck, &QCheckBox::toggled, m_segmentMegabytesSpin, &QWidget::setEnabled);
+    connect(m_longSessionCheck, &QCheckBox::toggled, m_rf64Check, &QWidget::setEnabled);
+
+    m_latencyTracingCheck = new QCheckBox(tr("Record latency traces (tray menu to save)"), this);
+    mainLayout->addWidget(m_latencyTracingCheck);
+
+    auto metricsPortLayout = new QHBoxLayout;
+    auto metricsPortLabel = new QLabel(tr("Metrics endpoint (localhost port):"), this);
+    m_metricsPortSpin = new QSpinBox(this);
+    m_metricsPortSpin->setRange(0, 65535);
+    m_metricsPortSpin->setSpecialValueText(tr("off"));
+    m_metricsPortSpin->setToolTip(tr("Prometheus metrics at http://127.0.0.1:<port>/metrics"));
+    metricsPortLayout->addWidget(metricsPortLabel);
+    metricsPortLayout->addWidget(m_metricsPortSpin);
+    metricsPortLayout->addStretch();
+    mainLayout->addLayout(metricsPortLayout);
+
+    auto uploadFormatLayout = new QHBoxLayout;
+    auto uploadFormatLabel = new QLabel(tr("Upload Format:"), this);
+    m_uploadFormatCombo = new QComboBox(this);
+    m_uploadFormatCombo->addItem(tr("WAV (uncompressed)"), "wav");
+    if (AudioEncoder::isAvailable(AudioEncoder::Format::Flac)) {
+        m_uploadFormatCombo->addItem(tr("FLAC (lossless)"), "flac");
+    }
+    if (AudioEncoder::isAvailable(AudioEncoder::Format::Opus)) {
+        m_uploadFormatCombo->addItem(tr("Opus (smallest, voice-optimized)"), "opus");
+    }
+    uploadFormatLayout->addWidget(uploadFormatLabel);
+    uploadFormatLayout->addWidget(m_uploadFormatCombo);
+    mainLayout->addLayout(uploadFormatLayout);
+
+    auto resultOrderLayout = new QHBoxLayout;
+    auto resultOrderLabel = new QLabel(tr("Deliver Results:"), this);
+    m_resultOrderCombo = new QComboBox(this);
+    m_resultOrderCombo->addItem(tr("In recording order"), "submission");
+    m_resultOrderCombo->addItem(tr("As soon as each is ready"), "completion");
+    resultOrderLayout->addWidget(resultOrderLabel);
+    resultOrderLayout->addWidget(m_resultOrderCombo);
+    mainLayout->addLayout(resultOrderLayout);
+
     // Buttons
     auto buttonLayout = new QHBoxLayout;
     auto saveButton = new QPushButton(tr("Save"), this);
@@ -57,6 +221,14 @@ void SettingsDialog::setupUi()
 
 void SettingsDialog::loadSettings()
 {
+    int backendIndex = m_backendCombo->findData(Config::instance().getTranscriptionBackend());
+    m_backendCombo->setCurrentIndex(backendIndex >= 0 ? backendIndex : 0);
+
+    int localModelIndex = m_localModelCombo->findText(Config::instance().getLocalModel());
+    if (localModelIndex >= 0) {
+        m_localModelCombo->setCurrentIndex(localModelIndex);
+    }
+
     // Load API key
     QString apiKey = Config::instance().getApiKey();
     m_apiKeyEdit->setText(apiKey);
@@ -67,22 +239,65 @@ void SettingsDialog::loadSettings()
     if (index >= 0) {
         m_modelCombo->setCurrentIndex(index);
     }
+
+    m_streamingUploadCheck->setChecked(Config::instance().getStreamingUpload());
+    m_trimSilenceCheck->setChecked(Config::instance().getTrimSilence());
+    m_wordTimestampsCheck->setChecked(Config::instance().getWordTimestamps());
+    m_segmentedCheck->setChecked(Config::instance().getSegmentedTranscription());
+    m_parallelUploadsSpin->setValue(Config::instance().getMaxParallelUploads());
+    m_parallelUploadsSpin->setEnabled(m_segmentedCheck->isChecked());
+    m_hedgeRequestsCheck->setChecked(Config::instance().getHedgeRequests());
+    const QString inputDevice = Config::instance().getInputDevice();
+    int deviceIndex = m_inputDeviceCombo->findData(inputDevice);
+    if (deviceIndex < 0) {
+        // Keep the choice of a device that is unplugged right now
+        m_inputDeviceCombo->addItem(tr("%1 (not connected)").arg(inputDevice), inputDevice);
+        deviceIndex = m_inputDeviceCombo->count() - 1;
+    }
+    m_inputDeviceCombo->setCurrentIndex(deviceIndex);
+    m_bufferFramesSpin->setValue(Config::instance().getBufferFrames());
+    m_inputLatencySpin->setValue(Config::instance().getInputLatencyMs());
+    m_adaptiveBufferCheck->setChecked(Config::instance().getAdaptiveBuffer());
+    m_alwaysArmedCheck->setChecked(Config::instance().getAlwaysArmed());
+    m_preRollSpin->setValue(Config::instance().getPreRollMs());
+    m_armedIdleSpin->setValue(Config::instance().getArmedIdleMinutes());
+    m_preRollSpin->setEnabled(m_alwaysArmedCheck->isChecked());
+    m_armedIdleSpin->setEnabled(m_alwaysArmedCheck->isChecked());
+    m_inMemoryCheck->setChecked(Config::instance().getInMemoryRecording());
+    m_saveRecordingsCheck->setChecked(Config::instance().getSaveRecordings());
+    m_saveRecordingsCheck->setEnabled(m_inMemoryCheck->isChecked());
+    m_longSessionCheck->setChecked(Config::instance().getLongSessionRecording());
+    m_segmentMinutesSpin->setValue(Config::instance().getSegmentMinutes());
+    m_segmentMegabytesSpin->setValue(Config::instance().getSegmentMegabytes());
+    m_rf64Check->setChecked(Config::instance().getWriteRf64());
+    m_segmentMinutesSpin->setEnabled(m_longSessionCheck->isChecked());
+    m_segmentMegabytesSpin->setEnabled(m_longSessionCheck->isChecked());
+    m_rf64Check->setEnabled(m_longSessionCheck->isChecked());
+    m_latencyTracingCheck->setChecked(Config::instance().getLatencyTracing());
+    m_metricsPortSpin->setValue(Config::instance().getMetricsPort());
+
+    int formatIndex = m_uploadFormatCombo->findData(Config::instance().getUploadFormat());
+    m_uploadFormatCombo->setCurrentIndex(formatIndex >= 0 ? formatIndex : 0);
+
+    int orderIndex = m_resultOrderCombo->findData(Config::instance().getResultOrder());
+    m_resultOrderCombo->setCurrentIndex(orderIndex >= 0 ? orderIndex : 0);
 }
 
 void SettingsDialog::saveSettings()
 {
     QString apiKey = m_apiKeyEdit->text().trimmed();
     QString model = m_modelCombo->currentText();
+    QString backend = m_backendCombo->currentData().toString();
 
-    // Validate API key
-    if (apiKey.isEmpty()) {
+    // The key is only needed when transcribing through Groq
+    if (apiKey.isEmpty() && backend == "groq") {
         QMessageBox::warning(this, tr("Error"),
             tr("Please enter your Groq API key. You can get one from https://console.groq.com"));
         return;
     }
 
     // Validate API key format (basic check)
-    if (!apiKey.startsWith("gsk_") || apiKey.length() < 20) {
+    if (!apiKey.isEmpty() && (!apiKey.startsWith("gsk_") || apiKey.length() < 20)) {
         QMessageBox::warning(this, tr("Error"),
             tr("Invalid API key format. Groq API keys should start with 'gsk_' and be at least 20 characters long."));
         return;
@@ -104,6 +319,42 @@ void SettingsDialog::saveSettings()
             tr("Failed to save model selection. Please check your permissions."));
     }
 
+    if (!Config::instance().setTranscriptionBackend(backend) ||
+        (!m_localModelCombo->currentText().isEmpty() &&
+         !Config::instance().setLocalModel(m_localModelCombo->currentText()))) {
+        success = false;
+        QMessageBox::warning(this, tr("Error"),
+            tr("Failed to save transcription settings. Please check your permissions."));
+    }
+
+    if (!Config::instance().setInputDevice(m_inputDeviceCombo->currentData().toString()) ||
+        !Config::instance().setBufferFrames(m_bufferFramesSpin->value()) ||
+        !Config::instance().setInputLatencyMs(m_inputLatencySpin->value()) ||
+        !Config::instance().setAdaptiveBuffer(m_adaptiveBufferCheck->isChecked()) ||
+        !Config::instance().setAlwaysArmed(m_alwaysArmedCheck->isChecked()) ||
+        !Config::instance().setPreRollMs(m_preRollSpin->value()) ||
+        !Config::instance().setArmedIdleMinutes(m_armedIdleSpin->value()) ||
+        !Config::instance().setStreamingUpload(m_streamingUploadCheck->isChecked()) ||
+        !Config::instance().setTrimSilence(m_trimSilenceCheck->isChecked()) ||
+        !Config::instance().setWordTimestamps(m_wordTimestampsCheck->isChecked()) ||
+        !Config::instance().setSegmentedTranscription(m_segmentedCheck->isChecked()) ||
+        !Config::instance().setMaxParallelUploads(m_parallelUploadsSpin->value()) ||
+        !Config::instance().setHedgeRequests(m_hedgeRequestsCheck->isChecked()) ||
+        !Config::instance().setInMemoryRecording(m_inMemoryCheck->isChecked()) ||
+        !Config::instance().setSaveRecordings(m_saveRecordingsCheck->isChecked()) ||
+        !Config::instance().setLongSessionRecording(m_longSessionCheck->isChecked()) ||
+        !Config::instance().setSegmentMinutes(m_segmentMinutesSpin->value()) ||
+        !Config::instance().setSegmentMegabytes(m_segmentMegabytesSpin->value()) ||
+        !Config::instance().setWriteRf64(m_rf64Check->isChecked()) ||
+        !Config::instance().setLatencyTracing(m_latencyTracingCheck->isChecked()) ||
+        !Config::instance().setMetricsPort(m_metricsPortSpin->value()) ||
+        !Config::instance().setUploadFormat(m_uploadFormatCombo->currentData().toString()) ||
+        !Config::instance().setResultOrder(m_resultOrderCombo->currentData().toString())) {
+        success = false;
+        QMessageBox::warning(this, tr("Error"),
+            tr("Failed to save upload settings. Please check your permissions."));
+    }
+
     if (success) {
         QMessageBox::information(this, tr("Success"),
             tr("Settings saved successfully."));
@@ -1,15 +1,33 @@
 #include "systemtrayhandler.h"
+#include "Logging.h"
+#include "BatchTranscriber.h"
+#include "MetricsServer.h"
 #include "QmlDictationManager.h"
 #include "ShortcutManager.h"
+#include "StartupProfile.h"
+#include "Trace.h"
+#include "TranscriptionHistory.h"
+#include "TranscriptionSearch.h"
 #include "audiohandler.h"
+#include "batchtranscriptiondialog.h"
+#include "config.h"
 #include "settingsdialog.h"
 #include <QApplication>
 #include <QDebug>
+#include <QDir>
 #include <QFile>
 #include <QMessageBox>
 #include <QQmlProperty>
+#include <QQuickWindow>
+#include <QSaveFile>
+#include <QStandardPaths>
 #include <QTimer>
 
+namespace {
+    // Finish starting up even if the main window never renders a frame
+    constexpr int kDeferredStartupFallbackMs = 2000;
+} // namespace
+
 SystemTrayHandler::SystemTrayHandler(QQmlApplicationEngine* engine, QObject* parent)
     : QObject(parent), m_trayIcon(new QSystemTrayIcon(this)), trayIconMenu(new QMenu()),
       quitAction(new QAction(tr("&Quit"), this)),
@@ -17,19 +35,40 @@ SystemTrayHandler::SystemTrayHandler(QQmlApplicationEngine* engine, QObject* par
       stopRecordingAction(new QAction(tr("&Stop Recording"), this)),
       autoTranscribeAction(new QAction(tr("&Auto Transcribe"), this)), m_shortcutManager(nullptr),
       m_audioHandler(nullptr), m_dictationManager(nullptr), m_qmlEngine(engine),
-      m_mainWindow(nullptr) {
+      m_mainWindow(nullptr), m_metricsServer(new MetricsServer(this)),
+      m_history(new TranscriptionHistory(
+          QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/History",
+          this)),
+      m_search(new TranscriptionSearch(m_history, this)), m_batchTranscriber(nullptr),
+      m_batchDialog(nullptr), m_diagnosticsChanged(false), m_inputChanged(false) {
 
     createActions();
     createTrayIcon();
     setupQmlDictationManager();
 
     m_trayIcon->show();
-    m_shortcutManager = new ShortcutManager(this, this);
+    StartupProfile::mark("tray_icon");
+    applyDiagnosticsSettings();
+    connect(&Config::instance(), &Config::changed, this, &SystemTrayHandler::handleConfigChanged);
     m_audioHandler = new AudioHandler(this);
-    m_audioHandler->initialize();
+    connect(m_audioHandler, &AudioHandler::initialized, this, [](bool ok) {
+        if (ok) {
+            StartupProfile::markReady();
+        }
+    });
+
+    // Hotkeys, PortAudio and the dictation window wait until the main window has shown
+    // its first frame (see setMainWindow); this is the fallback if it never does
+    QTimer::singleShot(kDeferredStartupFallbackMs, this, &SystemTrayHandler::finishStartup);
 
     connect(m_audioHandler, &AudioHandler::transcriptionReceived, this,
             &SystemTrayHandler::handleTranscriptionReceived);
+    connect(m_audioHandler, &AudioHandler::levelsChanged, this,
+            [this](qreal level, const QVariantList& waveform) {
+                if (m_dictationManager) {
+                    m_dictationManager->setLevels(level, waveform);
+                }
+            });
 
     connect(this, &SystemTrayHandler::recordingStarted, this, [this]() {
         startRecordingAction->setEnabled(false);
@@ -64,12 +103,34 @@ SystemTrayHandler::~SystemTrayHandler() {
     }
     delete m_trayIcon;
     delete trayIconMenu;
+    delete m_batchDialog; // A top-level widget, so not one of our children
     delete m_audioHandler;
     // m_dictationManager is deleted by QObject parent-child relationship
 }
 
 void SystemTrayHandler::setMainWindow(QObject* mainWindow) {
     m_mainWindow = mainWindow;
+
+    if (auto window = qobject_cast<QQuickWindow*>(mainWindow)) {
+        connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+            StartupProfile::mark("first_frame");
+            // Queued, so the frame is on screen before the slow work starts
+            QMetaObject::invokeMethod(this, &SystemTrayHandler::finishStartup,
+                                      Qt::QueuedConnection);
+        }, Qt::SingleShotConnection);
+    }
+}
+
+void SystemTrayHandler::finishStartup() {
+    if (m_shortcutManager) {
+        return;
+    }
+
+    m_audioHandler->initializeInBackground();
+    m_shortcutManager = new ShortcutManager(this, this);
+    if (m_dictationManager) {
+        m_dictationManager->preload();
+    }
 }
 
 void SystemTrayHandler::setupQmlDictationManager() {
@@ -77,9 +138,9 @@ void SystemTrayHandler::setupQmlDictationManager() {
         m_dictationManager = new QmlDictationManager(m_qmlEngine, this);
         connect(m_dictationManager, &QmlDictationManager::dictationWidgetClicked, this,
                 &SystemTrayHandler::onDictationWidgetClicked);
-        qDebug() << "QML Dictation Manager created";
+        qCDebug(lcUi) << "QML Dictation Manager created";
     } else {
-        qWarning() << "Cannot create QML Dictation Manager: QML engine is null";
+        qCWarning(lcUi) << "Cannot create QML Dictation Manager: QML engine is null";
     }
 }
 
@@ -93,7 +154,7 @@ void SystemTrayHandler::setQmlEngine(QQmlApplicationEngine* engine) {
 void SystemTrayHandler::createActions() {
     // Connect all actions
     connect(quitAction, &QAction::triggered, this, &SystemTrayHandler::quit);
-    connect(startRecordingAction, &QAction::triggered, this, &SystemTrayHandler::startRecording);
+    connect(startRecordingAction, &QAction::triggered, this, [this]() { startRecording(); });
     connect(stopRecordingAction, &QAction::triggered, this, &SystemTrayHandler::stopRecording);
     connect(autoTranscribeAction, &QAction::triggered, this, [this]() {
         if (m_audioHandler) {
@@ -122,6 +183,14 @@ void SystemTrayHandler::createTrayIcon() {
     connect(settingsAction, &QAction::triggered, this, &SystemTrayHandler::showSettings);
     trayIconMenu->addAction(settingsAction);
 
+    QAction* batchAction = new QAction(tr("Transcribe Recordings..."), this);
+    connect(batchAction, &QAction::triggered, this, &SystemTrayHandler::showBatchTranscription);
+    trayIconMenu->addAction(batchAction);
+
+    QAction* saveTraceAction = new QAction(tr("Save Latency Trace"), this);
+    connect(saveTraceAction, &QAction::triggered, this, &SystemTrayHandler::saveLatencyTrace);
+    trayIconMenu->addAction(saveTraceAction);
+
     trayIconMenu->addSeparator();
     trayIconMenu->addAction(quitAction);
 
@@ -132,7 +201,7 @@ void SystemTrayHandler::createTrayIcon() {
     // Load the icon from resources
     QIcon icon(":/icons/app-icon.png");
     if (icon.isNull()) {
-        qWarning() << "Failed to load icon from resource, using fallback icon";
+        qCWarning(lcUi) << "Failed to load icon from resource, using fallback icon";
         icon = QIcon::fromTheme("system-run"); // Fallback icon
     }
     m_trayIcon->setIcon(icon);
@@ -165,53 +234,22 @@ void SystemTrayHandler::trayIconActivated(QSystemTrayIcon::ActivationReason reas
     }
 }
 
-void SystemTrayHandler::handleTranscriptionReceived(const QString& text) {
-    // Show notification
-    m_trayIcon->showMessage(tr("Transcription Complete"), text);
+void SystemTrayHandler::handleTranscriptionReceived(const TranscriptionResult& result) {
+    Trace::Span span("show text");
 
-    // Add to main window history if available
-    if (m_mainWindow) {
-        // Create a QVariantMap for the transcription data
-        QVariantMap transcription;
-        transcription["text"] = text;
-        transcription["timestamp"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-        transcription["duration"] = 0.0;  // This would need to be tracked in AudioHandler
-        transcription["language"] = "en"; // This would come from the actual transcription
-
-        // Use QMetaObject::invokeMethod to call the QML method
-        QMetaObject::invokeMethod(m_mainWindow, "onTranscriptionReceived",
-                                  Q_ARG(QVariant, QVariant::fromValue(transcription)));
-    }
+    m_trayIcon->showMessage(tr("Transcription Complete"), result.text);
+
+    // The main window lists the history model, so this is all it needs
+    m_history->append(result);
 
-    // Also emit the signal for any connected slots
-    emit transcriptionReceived(text, 0.0, "en");
+    emit transcriptionReceived(result.text, result.duration, result.language);
 }
 
 void SystemTrayHandler::showTranscriptionComplete(const QString& text) {
     m_trayIcon->showMessage(tr("Transcription Complete"), text);
-
-    // Also add to main window history
-    handleTranscriptionReceived(text);
 }
 
 void SystemTrayHandler::showTranscriptionComplete(const TranscriptionResult& result) {
-    // Add to main window history if available
-    if (m_mainWindow) {
-        // Create a QVariantMap for the transcription data
-        QVariantMap transcription;
-        transcription["text"] = result.text;
-        transcription["timestamp"] = QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss");
-        transcription["duration"] = result.duration;
-        transcription["language"] = result.language;
-
-        // Use QMetaObject::invokeMethod to call the QML method
-        QMetaObject::invokeMethod(m_mainWindow, "onTranscriptionReceived",
-                                  Q_ARG(QVariant, QVariant::fromValue(transcription)));
-    }
-
-    // Also emit the signal for any connected slots
-    emit transcriptionReceived(result.text, result.duration, result.language);
-
     // Create a detailed message
     QString details = tr("Transcription Details:\n\n");
     details += tr("Text: %1\n\n").arg(result.text);
@@ -220,12 +258,22 @@ void SystemTrayHandler::showTranscriptionComplete(const TranscriptionResult& res
     details += tr("Task: %1\n").arg(result.task);
     details += tr("Request ID: %1\n\n").arg(result.requestId);
 
-    details += tr("Segment Details:\n");
-    details += tr("- Time: %1s to %2s\n").arg(result.segment.start).arg(result.segment.end);
-    details += tr("- Avg Log Probability: %1\n").arg(result.segment.avgLogProb);
-    details += tr("- No Speech Probability: %1\n").arg(result.segment.noSpeechProb);
-    details += tr("- Temperature: %1\n").arg(result.segment.temperature);
-    details += tr("- Compression Ratio: %1").arg(result.segment.compressionRatio);
+    const TranscriptSegments& segments = result.segments;
+    if (!segments.empty()) {
+        double logProbSum = 0.0;
+        double maxNoSpeech = 0.0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            logProbSum += segments.avgLogProb(i);
+            maxNoSpeech = qMax(maxNoSpeech, segments.noSpeechProb(i));
+        }
+        details += tr("Segment Details:\n");
+        details += tr("- Segments: %1, words: %2\n").arg(segments.size()).arg(segments.wordCount());
+        details += tr("- Time: %1s to %2s\n")
+                       .arg(segments.start(0))
+                       .arg(segments.end(segments.size() - 1));
+        details += tr("- Avg Log Probability: %1\n").arg(logProbSum / segments.size());
+        details += tr("- Max No Speech Probability: %1").arg(maxNoSpeech);
+    }
 
     // Show brief notification in system tray
     m_trayIcon->showMessage(tr("Transcription Complete"), result.text);
@@ -234,8 +282,12 @@ void SystemTrayHandler::showTranscriptionComplete(const TranscriptionResult& res
     QMessageBox::information(nullptr, tr("Transcription Details"), details);
 }
 
-void SystemTrayHandler::startRecording() {
-    if (m_audioHandler && m_audioHandler->startRecording()) {
+bool SystemTrayHandler::isRecording() const {
+    return m_audioHandler && m_audioHandler->isRecording();
+}
+
+void SystemTrayHandler::startRecording(uint64_t traceDictation) {
+    if (m_audioHandler && m_audioHandler->startRecording(traceDictation)) {
         startRecordingAction->setEnabled(false);
         stopRecordingAction->setEnabled(true);
 
@@ -256,8 +308,10 @@ void SystemTrayHandler::stopRecording() {
         stopRecordingAction->setEnabled(false);
 
         hideDictationWidget();
-        QString message =
-            tr("Audio recording stopped\nSaved to: %1").arg(m_audioHandler->getLastRecordingPath());
+        const QString path = m_audioHandler->getLastRecordingPath();
+        QString message = path.isEmpty()
+                              ? tr("Audio recording stopped")
+                              : tr("Audio recording stopped\nSaved to: %1").arg(path);
         m_trayIcon->showMessage(tr("Recording"), message);
         emit recordingStopped();
     } else {
@@ -271,10 +325,101 @@ void SystemTrayHandler::quit() {
 }
 
 void SystemTrayHandler::showSettings() {
+    // The dialog lists input devices; PortAudio must be fully up (and idle) for that
+    if (m_audioHandler) {
+        m_audioHandler->initialize();
+    }
     SettingsDialog dialog;
     dialog.exec();
 }
 
+void SystemTrayHandler::showBatchTranscription() {
+    if (!m_batchTranscriber) {
+        m_batchTranscriber = new BatchTranscriber(this);
+        // Batch results join the history, so they can be searched with the rest
+        connect(m_batchTranscriber, &BatchTranscriber::jobFinished, this,
+                [this](const QString&, const TranscriptionResult& result) {
+                    m_history->append(result);
+                });
+        m_batchDialog = new BatchTranscriptionDialog(m_batchTranscriber);
+    }
+    m_batchDialog->show();
+    m_batchDialog->raise();
+    m_batchDialog->activateWindow();
+}
+
+void SystemTrayHandler::handleConfigChanged(const QString& key) {
+    static const QStringList diagnosticsKeys = {Config::KEY_LATENCY_TRACING,
+                                                Config::KEY_METRICS_PORT};
+    static const QStringList inputKeys = {Config::KEY_INPUT_DEVICE, Config::KEY_INPUT_LATENCY_MS,
+                                          Config::KEY_BUFFER_FRAMES, Config::KEY_ALWAYS_ARMED,
+                                          Config::KEY_PRE_ROLL_MS, Config::KEY_ARMED_IDLE_MINUTES};
+
+    const bool diagnostics = diagnosticsKeys.contains(key);
+    const bool input = inputKeys.contains(key);
+    if (!diagnostics && !input) {
+        return;
+    }
+
+    // Settings usually change several at a time; apply them once, after the last one
+    const bool scheduled = m_diagnosticsChanged || m_inputChanged;
+    m_diagnosticsChanged = m_diagnosticsChanged || diagnostics;
+    m_inputChanged = m_inputChanged || input;
+    if (scheduled) {
+        return;
+    }
+    QTimer::singleShot(0, this, [this]() {
+        if (m_diagnosticsChanged) {
+            applyDiagnosticsSettings();
+        }
+        if (m_inputChanged && m_audioHandler) {
+            m_audioHandler->updateArming();
+        }
+        m_diagnosticsChanged = false;
+        m_inputChanged = false;
+    });
+}
+
+void SystemTrayHandler::applyDiagnosticsSettings() {
+    Trace::setEnabled(Config::instance().getLatencyTracing());
+
+    const int port = Config::instance().getMetricsPort();
+    if (port == 0) {
+        m_metricsServer->close();
+    } else if (!m_metricsServer->listen(static_cast<quint16>(port))) {
+        m_trayIcon->showMessage(tr("Metrics"),
+                                tr("Could not serve metrics on port %1; is it in use?").arg(port),
+                                QSystemTrayIcon::Warning);
+    }
+}
+
+void SystemTrayHandler::saveLatencyTrace() {
+    if (!Trace::enabled()) {
+        m_trayIcon->showMessage(tr("Latency Trace"),
+                                tr("Turn on latency tracing in Settings, then dictate again"));
+        return;
+    }
+
+    const QString tracesPath =
+        QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/Vibeco/Traces";
+    QDir().mkpath(tracesPath);
+    const QString path = tracesPath + "/trace_" +
+                         QDateTime::currentDateTime().toString("yyyy-MM-dd_hh-mm-ss") + ".json";
+
+    const std::string json = Trace::exportChromeJson();
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) ||
+        file.write(json.data(), static_cast<qint64>(json.size())) !=
+            static_cast<qint64>(json.size()) ||
+        !file.commit()) {
+        m_trayIcon->showMessage(tr("Error"), tr("Could not write %1").arg(path),
+                                QSystemTrayIcon::Critical);
+        return;
+    }
+    // Open in chrome://tracing or ui.perfetto.dev
+    m_trayIcon->showMessage(tr("Latency Trace"), tr("Saved to: %1").arg(path));
+}
+
 void SystemTrayHandler::showDictationWidget() {
     if (m_dictationManager) {
         m_dictationManager->showDictationWidget();
@@ -288,7 +433,7 @@ void SystemTrayHandler::hideDictationWidget() {
 }
 
 void SystemTrayHandler::onDictationWidgetClicked() {
-    qDebug() << "Dictation widget clicked";
+    qCDebug(lcUi) << "Dictation widget clicked";
     if (m_audioHandler) {
         if (m_audioHandler->isRecording()) {
             stopRecording();
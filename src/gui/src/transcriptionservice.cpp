@@ -1,14 +1,24 @@
 #include "transcriptionservice.h"
-#include "audiohandler.h"
+#include "Logging.h"
 #include "config.h"
-#include <QFile>
-#include <QFileInfo>
-#include <QHttpMultiPart>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
+#include "GroqTranscriptionBackend.h"
+#include "Metrics.h"
+#include "StreamingUploadDevice.h"
+#include "Trace.h"
+#ifdef VIBECO_HAVE_WHISPER
+#include "LocalWhisperBackend.h"
+#endif
 #include <QDebug>
-#include <QUrl>
+#include <QFutureWatcher>
+#include <QPromise>
+#include <QThreadPool>
+#include <algorithm>
+#include <memory>
+
+namespace {
+    // Entries are ~1 KB of JSON, so this keeps tens of thousands of results
+    constexpr qint64 kCacheMaxBytes = 32 * 1024 * 1024;
+} // namespace
 
 // Define available models
 const QStringList TranscriptionService::AVAILABLE_MODELS = {
@@ -21,8 +31,67 @@ const QStringList TranscriptionService::AVAILABLE_MODELS = {
 
 TranscriptionService::TranscriptionService(QObject *parent)
     : QObject(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_remoteBackend(new GroqTranscriptionBackend(this))
+    , m_localBackend(nullptr)
+    , m_cache(Config::getConfigPath() + "/TranscriptionCache", kCacheMaxBytes)
+    , m_nextJob(1)
+    , m_deliveryScheduled(false)
+{
+    connectBackend(m_remoteBackend);
+
+    // Switching to completion order lets held-back results go at once
+    connect(&Config::instance(), &Config::changed, this, [this](const QString& key) {
+        if (key == Config::KEY_RESULT_ORDER) {
+            scheduleDelivery();
+        }
+    });
+
+#ifdef VIBECO_HAVE_WHISPER
+    auto* local = new LocalWhisperBackend(this);
+    connectBackend(local);
+    m_localBackend = local;
+
+    // Loading a model takes seconds; do it now rather than on the first dictation
+    if (backend() == m_localBackend) {
+        local->preloadModel();
+    }
+#endif
+}
+
+void TranscriptionService::connectBackend(TranscriptionBackend* backend)
+{
+    // Backend request IDs are job IDs; cancelled jobs have nobody left to tell
+    connect(backend, &TranscriptionBackend::transcriptionComplete,
+            this, [this](quint64 job, const TranscriptionResult& result) {
+                finishJob(job, &result, QString());
+            });
+    connect(backend, &TranscriptionBackend::transcriptionError,
+            this, [this](quint64 job, const QString& error) { finishJob(job, nullptr, error); });
+    connect(backend, &TranscriptionBackend::uploadProgress,
+            this, [this](quint64 job, qint64 bytesSent, qint64 bytesTotal) {
+                if (m_jobs.contains(job)) {
+                    emit uploadProgress(job, bytesSent, bytesTotal);
+                }
+            });
+    connect(backend, &TranscriptionBackend::requestTimed,
+            this, [this](quint64 job, const RequestTiming& timing) {
+                if (m_jobs.contains(job)) {
+                    traceRequestTiming(job, timing);
+                    emit requestTimed(job, timing);
+                }
+            });
+    connect(backend, &TranscriptionBackend::processingStarted,
+            this, &TranscriptionService::processingStarted);
+    connect(backend, &TranscriptionBackend::processingFinished,
+            this, &TranscriptionService::processingFinished);
+}
+
+TranscriptionBackend* TranscriptionService::backend() const
 {
+    if (m_localBackend && Config::instance().getTranscriptionBackend() == m_localBackend->name()) {
+        return m_localBackend;
+    }
+    return m_remoteBackend;
 }
 
 QStringList TranscriptionService::availableModels()
@@ -42,180 +111,328 @@ void TranscriptionService::setModel(const QString& model)
     }
 }
 
-void TranscriptionService::transcribeAudioFile(const QString& filePath)
+bool TranscriptionService::isLocalBackendAvailable()
 {
-    QString apiKey = Config::instance().getApiKey();
-    qDebug() << "Starting transcription. API key exists:" << !apiKey.isEmpty();
-
-    if (apiKey.isEmpty()) {
-        emit transcriptionError("API key not set. Please set your Groq API key in Settings.");
-        return;
-    }
+#ifdef VIBECO_HAVE_WHISPER
+    return true;
+#else
+    return false;
+#endif
+}
 
-    // Basic validation of API key format
-    if (!apiKey.startsWith("gsk_") || apiKey.length() < 20) {
-        emit transcriptionError("Invalid API key format. Please check your API key in Settings.");
-        return;
-    }
+QStringList TranscriptionService::availableLocalModels()
+{
+#ifdef VIBECO_HAVE_WHISPER
+    return LocalWhisperBackend::availableModels();
+#else
+    return {};
+#endif
+}
 
-    // Store the file path for reference later
-    m_currentFilePath = filePath;
+bool TranscriptionService::supportsStreaming() const
+{
+    return backend()->supportsStreaming();
+}
 
-    QFile* file = new QFile(filePath);
-    if (!file->open(QIODevice::ReadOnly)) {
-        emit transcriptionError("Could not open audio file");
-        delete file;
-        return;
-    }
+bool TranscriptionService::supportsSegmentation() const
+{
+    return backend()->supportsSegmentation();
+}
 
-    // Create multipart request
-    QHttpMultiPart* multiPart = new QHttpMultiPart(QHttpMultiPart::FormDataType);
+bool TranscriptionService::acceptsCompressedAudio() const
+{
+    return backend()->acceptsCompressedAudio();
+}
 
-    // Add file part
-    QHttpPart filePart;
-    filePart.setHeader(QNetworkRequest::ContentTypeHeader, QVariant("audio/wav"));
-    filePart.setHeader(QNetworkRequest::ContentDispositionHeader,
-                      QVariant("form-data; name=\"file\"; filename=\"" +
-                      QFileInfo(filePath).fileName() + "\""));
-    filePart.setBodyDevice(file);
-    file->setParent(multiPart); // Delete file with multiPart
-    multiPart->append(filePart);
+void TranscriptionService::prepare()
+{
+    backend()->prepare();
+}
 
-    // Add model part
-    QHttpPart modelPart;
-    modelPart.setHeader(QNetworkRequest::ContentDispositionHeader,
-                       QVariant("form-data; name=\"model\""));
-    modelPart.setBody(currentModel().toUtf8());
-    multiPart->append(modelPart);
+QString TranscriptionService::cacheParameters(const QString& contentType,
+                                              const QString& mode) const
+{
+    const QString format =
+        Config::instance().getWordTimestamps() ? "verbose_json+words" : "verbose_json";
+    return QStringList{backend()->name(), backend()->modelName(), format, contentType, mode}
+        .join('|');
+}
 
-    // Add response_format part
-    QHttpPart formatPart;
-    formatPart.setHeader(QNetworkRequest::ContentDispositionHeader,
-                        QVariant("form-data; name=\"response_format\""));
-    formatPart.setBody("verbose_json");
-    multiPart->append(formatPart);
+void TranscriptionService::traceRequestTiming(quint64 job, const RequestTiming& timing)
+{
+    if (!Trace::enabled() || timing.totalMs < 0.0) {
+        return;
+    }
+    const uint64_t dictation = m_jobs.value(job).metadata.traceDictation;
 
-    // Create request
-    QUrl url(API_URL);
-    QNetworkRequest request(url);
-    request.setRawHeader("Authorization", "Bearer " + apiKey.toUtf8());
+    // Only durations are known; lay the phases out backwards from now, when the reply finished
+    const auto us = [](double ms) { return static_cast<int64_t>(qMax(ms, 0.0) * 1000.0); };
+    const int64_t end = Trace::nowUs();
+    const int64_t responseStart = end - us(timing.downloadMs);
+    const int64_t uploadEnd = responseStart - us(timing.firstByteMs);
+    const int64_t start = end - us(timing.totalMs);
 
-    qDebug() << "Sending transcription request to:" << url.toString();
-    qDebug() << "Using model:" << currentModel();
+    if (timing.connectMs >= 0.0) {
+        Trace::complete("connect", start, us(timing.connectMs), dictation);
+    }
+    if (timing.uploadMs >= 0.0) {
+        Trace::complete("upload", uploadEnd - us(timing.uploadMs), us(timing.uploadMs),
+                        dictation);
+    }
+    if (timing.firstByteMs >= 0.0) {
+        Trace::complete("server", uploadEnd, us(timing.firstByteMs), dictation);
+    }
+    if (timing.downloadMs >= 0.0) {
+        Trace::complete("download", responseStart, us(timing.downloadMs), dictation);
+    }
+}
 
-    // Send request
-    QNetworkReply* reply = m_networkManager->post(request, multiPart);
-    multiPart->setParent(reply); // Delete multiPart with reply
+quint64 TranscriptionService::submit(const QString& source, const QString& mode,
+                                     const TranscriptionJob::Metadata& metadata)
+{
+    TranscriptionJob job;
+    job.id = m_nextJob++;
+    job.source = source;
+    job.mode = mode;
+    job.metadata = metadata;
+    job.backend = backend();
+    job.submitted.start();
+    m_jobs.insert(job.id, job);
+    return job.id;
+}
 
-    // Connect signals for progress reporting
-    connect(reply, &QNetworkReply::uploadProgress,
-            this, &TranscriptionService::handleUploadProgress);
+bool TranscriptionService::serveFromCache(quint64 job, const QString& key)
+{
+    // Every non-streaming request comes through here first
+    const uint64_t dictation = m_jobs.value(job).metadata.traceDictation;
+    Trace::asyncBegin("transcription", dictation);
+    Trace::Span span("cache lookup", dictation);
+
+    TranscriptionResult result{};
+    if (key.isEmpty() || !m_cache.lookup(key, result)) {
+        m_jobs[job].cacheKey = key;
+        return false;
+    }
 
-    connect(reply, &QNetworkReply::finished,
-            this, [this, reply]() { handleTranscriptionResponse(reply); });
+    // Delivery is queued anyway, so callers never see a nested signal
+    emit processingStarted(job);
+    finishJob(job, &result, QString());
+    emit processingFinished(job);
+    return true;
+}
 
-    emit processingStarted();
+void TranscriptionService::submitFile(quint64 job, const QString& filePath,
+                                      const QString& parameters, const FileSender& send)
+{
+    // Hashing reads the whole file, and a long-session segment can run to 100 MB or more
+    auto promise = std::make_shared<QPromise<QString>>();
+    auto* watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher, job, send]() {
+        watcher->deleteLater();
+        auto it = m_jobs.find(job);
+        if (it == m_jobs.end()) {
+            return; // Cancelled meanwhile
+        }
+        // The backend picked at submission, even if the setting changed since
+        TranscriptionBackend* jobBackend = it->backend;
+        if (!serveFromCache(job, watcher->result()) && jobBackend) {
+            send(jobBackend);
+        }
+    });
+    watcher->setFuture(promise->future());
+
+    QThreadPool::globalInstance()->start([promise, filePath, parameters]() {
+        promise->start();
+        promise->addResult(TranscriptionCache::keyForFile(filePath, parameters));
+        promise->finish();
+    });
 }
 
-void TranscriptionService::handleUploadProgress(qint64 bytesSent, qint64 bytesTotal)
+quint64 TranscriptionService::transcribeAudioFile(const QString& filePath,
+                                                  const TranscriptionJob::Metadata& metadata)
 {
-    emit uploadProgress(bytesSent, bytesTotal);
+    const quint64 job = submit(filePath, "file", metadata);
+    submitFile(job, filePath, cacheParameters("audio/wav", "file"),
+               [job, filePath](TranscriptionBackend* backend) {
+                   qCDebug(lcTranscription) << "Transcribing" << filePath << "with the"
+                                            << backend->name() << "backend as job" << job;
+                   backend->transcribeFile(job, filePath);
+               });
+    return job;
 }
 
-void TranscriptionService::handleTranscriptionResponse(QNetworkReply* reply) {
-    reply->deleteLater();
+quint64 TranscriptionService::transcribeAudioData(const QByteArray& data, const QString& fileName,
+                                                  const QString& contentType,
+                                                  const TranscriptionJob::Metadata& metadata)
+{
+    const quint64 job = submit(fileName, "file", metadata);
+    if (!serveFromCache(job,
+                        TranscriptionCache::keyFor(data, cacheParameters(contentType, "file")))) {
+        backend()->transcribeData(job, data, fileName, contentType);
+    }
+    return job;
+}
 
-    // Log response details
-    qDebug() << "\n=== Transcription API Response ===";
-    qDebug() << "Status Code:" << reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    qDebug() << "Content Type:" << reply->header(QNetworkRequest::ContentTypeHeader).toString();
+quint64 TranscriptionService::transcribeAudioDevice(
+    const TranscriptionBackend::DeviceFactory& openDevice, qint64 size, const QString& fileName,
+    const QString& contentType, const TranscriptionJob::Metadata& metadata)
+{
+    const quint64 job = submit(fileName, "file", metadata);
+    std::unique_ptr<QIODevice> device(openDevice(nullptr));
+    if (!serveFromCache(job, TranscriptionCache::keyForDevice(
+                                 device.get(), cacheParameters(contentType, "file")))) {
+        backend()->transcribeDevice(job, openDevice, size, fileName, contentType);
+    }
+    return job;
+}
 
-    // Log response headers
-    qDebug() << "\nResponse Headers:";
-    const QList<QByteArray>& headerList = reply->rawHeaderList();
-    for(const QByteArray& header : headerList) {
-        qDebug() << header << ":" << reply->rawHeader(header);
+quint64 TranscriptionService::transcribeAudioDataSegmented(
+    const QByteArray& wav, const QString& fileName, const TranscriptionJob::Metadata& metadata)
+{
+    const quint64 job = submit(fileName, "segmented", metadata);
+    const QString parameters = cacheParameters("audio/wav", "segmented");
+    if (!serveFromCache(job, TranscriptionCache::keyFor(wav, parameters))) {
+        backend()->transcribeDataSegmented(job, wav, fileName);
     }
+    return job;
+}
 
-    if (reply->error() != QNetworkReply::NoError) {
-        QString errorString = reply->errorString();
-        qDebug() << "\nNetwork Error:" << errorString;
-        qDebug() << "Error Code:" << reply->error();
+quint64 TranscriptionService::transcribeAudioFileSegmented(
+    const QString& filePath, const TranscriptionJob::Metadata& metadata)
+{
+    const quint64 job = submit(filePath, "segmented", metadata);
+    submitFile(job, filePath, cacheParameters("audio/wav", "segmented"),
+               [job, filePath](TranscriptionBackend* backend) {
+                   backend->transcribeFileSegmented(job, filePath);
+               });
+    return job;
+}
 
-        // Try to read error response body
-        QByteArray errorData = reply->readAll();
-        qDebug() << "Error Response Body:" << errorData;
+QSharedPointer<StreamingUploadDevice> TranscriptionService::startStreamingTranscription(
+    const QString& fileName, const QString& contentType, const QByteArray& header, quint64& job)
+{
+    // The audio isn't known yet, so streamed results can't be keyed
+    job = submit(fileName, "streaming", TranscriptionJob::Metadata());
+    QSharedPointer<StreamingUploadDevice> device =
+        backend()->startStreaming(job, fileName, contentType, header);
+    if (!device) {
+        cancel(job);
+        job = 0;
+    }
+    return device;
+}
 
-        emit transcriptionError(errorString);
-        emit processingFinished();
+void TranscriptionService::finishStreamingTranscription(
+    quint64 job, const QSharedPointer<StreamingUploadDevice>& device,
+    const TranscriptionJob::Metadata& metadata)
+{
+    auto it = m_jobs.find(job);
+    if (it == m_jobs.end()) {
         return;
     }
+    it->metadata = metadata;
+    Trace::asyncBegin("transcription", metadata.traceDictation);
+    // The device belongs to whichever backend opened it, even if the setting changed since
+    if (it->backend) {
+        it->backend->finishStreaming(device);
+    }
+}
 
-    QByteArray data = reply->readAll();
-    qDebug() << "\nResponse Body:" << data;
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    qDebug() << "\nParsed JSON:" << doc.toJson(QJsonDocument::Indented);
-
-    if (!doc.isObject()) {
-        qDebug() << "Error: Response is not a valid JSON object";
-        emit transcriptionError("Invalid response format");
-        emit processingFinished();
+void TranscriptionService::cancel(quint64 job)
+{
+    auto it = m_jobs.find(job);
+    if (it == m_jobs.end()) {
         return;
     }
+    const QPointer<TranscriptionBackend> jobBackend = it->backend;
+    const bool running = it->state == TranscriptionJob::State::Running;
+    // Gone before the backend hears of it, so whatever it still reports is dropped
+    m_jobs.erase(it);
+    qCDebug(lcTranscription) << "Cancelled transcription job" << job;
+    if (running && jobBackend) {
+        jobBackend->cancel(job);
+    }
+    scheduleDelivery();
+}
 
-    QJsonObject obj = doc.object();
-    if (!obj.contains("text")) {
-        qDebug() << "Error: No 'text' field in response";
-        emit transcriptionError("No transcription in response");
-        emit processingFinished();
+void TranscriptionService::finishJob(quint64 id, const TranscriptionResult* backendResult,
+                                     const QString& error)
+{
+    auto it = m_jobs.find(id);
+    if (it == m_jobs.end() || it->state != TranscriptionJob::State::Running) {
+        return;
+    }
+    TranscriptionJob& job = *it;
+    job.answeredMs = job.submitted.elapsed();
+    Trace::asyncEnd("transcription", job.metadata.traceDictation);
+
+    if (!backendResult) {
+        job.state = TranscriptionJob::State::Failed;
+        job.error = error;
+        scheduleDelivery();
         return;
     }
 
-    // Parse the detailed result
-    TranscriptionResult result;
-    result.text = obj["text"].toString();
-    result.language = obj["language"].toString();
-
-    // Use API-provided duration or estimate from audio file
-    if (obj.contains("duration")) {
-        result.duration = obj["duration"].toDouble();
-    } else {
-        // Get duration from AudioHandler if possible
-        AudioHandler* audioHandler = qobject_cast<AudioHandler*>(parent());
-        if (audioHandler) {
-            result.duration = audioHandler->getLastRecordingDuration();
-        } else {
-            result.duration = 0.0;
-        }
+    // Cache what the backend said, before mapping it onto this particular recording
+    if (!job.cacheKey.isEmpty()) {
+        m_cache.store(job.cacheKey, *backendResult);
     }
 
-    result.task = obj["task"].toString();
+    job.result = *backendResult;
+    // Fall back to the recording's own length if the backend didn't report one
+    if (job.result.duration < 0.0) {
+        job.result.duration = qMax(0.0, job.metadata.recordingDuration);
+    }
+    // Silence may have been cut before upload; report times in the saved recording
+    const SilenceTrimmer::TimeMap& trimMap = job.metadata.trimMap;
+    job.result.segments.mapTimes(
+        [&trimMap](double seconds) { return trimMap.toSourceTime(seconds); });
+    job.state = TranscriptionJob::State::Done;
+    scheduleDelivery();
+}
 
-    // Get request ID from x_groq object
-    if (obj.contains("x_groq")) {
-        QJsonObject groqObj = obj["x_groq"].toObject();
-        result.requestId = groqObj["id"].toString();
+void TranscriptionService::scheduleDelivery()
+{
+    // Backends may answer before the call that started the job returns
+    if (!m_deliveryScheduled) {
+        m_deliveryScheduled = true;
+        QMetaObject::invokeMethod(this, &TranscriptionService::deliverReady,
+                                  Qt::QueuedConnection);
     }
+}
 
-    // Parse first segment details if available
-    if (obj.contains("segments") && obj["segments"].isArray()) {
-        QJsonArray segments = obj["segments"].toArray();
-        if (!segments.isEmpty()) {
-            QJsonObject segment = segments.first().toObject();
-            result.segment.start = segment["start"].toDouble();
-            result.segment.end = segment["end"].toDouble();
-            result.segment.avgLogProb = segment["avg_logprob"].toDouble();
-            result.segment.noSpeechProb = segment["no_speech_prob"].toDouble();
-            result.segment.temperature = segment["temperature"].toDouble();
-            result.segment.compressionRatio = segment["compression_ratio"].toDouble();
+void TranscriptionService::deliverReady()
+{
+    static Metrics::Histogram& held = Metrics::Registry::instance().histogram(
+        "vibeco_result_hold_seconds",
+        "Time a transcription result waited for earlier ones before being delivered");
+
+    m_deliveryScheduled = false;
+    const bool inOrder = Config::instance().getResultOrder() != "completion";
+    const auto answered = [](const TranscriptionJob& job) {
+        return job.state != TranscriptionJob::State::Running;
+    };
+
+    while (!m_jobs.isEmpty()) {
+        // In submission order only the oldest job may go; otherwise any that has answered
+        auto it = inOrder ? m_jobs.begin() : std::find_if(m_jobs.begin(), m_jobs.end(), answered);
+        if (it == m_jobs.end() || !answered(*it)) {
+            break;
+        }
+        // Out of the map before signalling: receivers may submit or cancel jobs
+        const TranscriptionJob job = *it;
+        m_jobs.erase(it);
+
+        const qint64 deliveredMs = job.submitted.elapsed();
+        held.record(static_cast<double>(deliveredMs - job.answeredMs));
+        qCDebug(lcTranscription) << "Job" << job.id << "(" << job.mode << job.source
+                                 << ") answered in" << job.answeredMs << "ms, delivered after"
+                                 << deliveredMs << "ms;" << m_jobs.size() << "still pending";
+
+        if (job.state == TranscriptionJob::State::Done) {
+            emit transcriptionComplete(job.id, job.result);
+        } else {
+            emit transcriptionError(job.id, job.error);
         }
     }
-
-    // Emit both the simple text and detailed result
-    emit transcriptionComplete(result.text);
-    emit transcriptionComplete(result);
-
-    qDebug() << "=== End of Response ===\n";
-    emit processingFinished();
-}
\ No newline at end of file
+}
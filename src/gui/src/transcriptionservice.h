@@ -1,58 +1,125 @@
 #ifndef TRANSCRIPTIONSERVICE_H
 #define TRANSCRIPTIONSERVICE_H
 
+#include "TranscriptionBackend.h"
+#include "TranscriptionCache.h"
+#include "TranscriptionJob.h"
+#include <QMap>
 #include <QObject>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
-
-struct TranscriptionResult {
-    QString text;           // The transcribed text
-    QString language;       // Detected language
-    double duration;        // Audio duration in seconds
-    QString task;          // Task type (e.g., "transcribe")
-    QString requestId;      // Request ID from Groq
-
-    // Segment details (for the first segment)
-    struct Segment {
-        double start;
-        double end;
-        double avgLogProb;
-        double noSpeechProb;
-        double temperature;
-        double compressionRatio;
-    } segment;
-};
+#include <QSharedPointer>
+#include <functional>
+
+class GroqTranscriptionBackend;
+class StreamingUploadDevice;
 
+// Front for the configured TranscriptionBackend (Config::getTranscriptionBackend()).
+// Callers don't need to know where transcription runs; results are reported
+// relative to the saved recording either way.
+//
+// Every transcribe call starts a TranscriptionJob and returns its ID (never 0).
+// Any number of jobs can be in flight; each result or error is signalled once,
+// with the job's ID, and never before the call that started it has returned.
+// Config::getResultOrder() decides whether results are held back until every
+// earlier job has been delivered ("submission") or go out as they arrive.
 class TranscriptionService : public QObject
 {
     Q_OBJECT
 
 public:
     explicit TranscriptionService(QObject *parent = nullptr);
-    void transcribeAudioFile(const QString& filePath);
+    quint64 transcribeAudioFile(const QString& filePath,
+                                const TranscriptionJob::Metadata& metadata = {});
+    // Uploads an already encoded recording (e.g. FLAC or Ogg Opus) held in memory
+    quint64 transcribeAudioData(const QByteArray& data, const QString& fileName,
+                                const QString& contentType,
+                                const TranscriptionJob::Metadata& metadata = {});
+    // Uploads a recording that is held in memory, without copying it into one buffer
+    quint64 transcribeAudioDevice(const TranscriptionBackend::DeviceFactory& openDevice,
+                                  qint64 size, const QString& fileName,
+                                  const QString& contentType,
+                                  const TranscriptionJob::Metadata& metadata = {});
+    // Splits a long WAV recording at pauses and transcribes the pieces concurrently
+    // (up to Config::getMaxParallelUploads() at once), then emits one stitched
+    // result. Short or foreign-format files go through transcribeAudioFile().
+    quint64 transcribeAudioFileSegmented(const QString& filePath,
+                                         const TranscriptionJob::Metadata& metadata = {});
+    quint64 transcribeAudioDataSegmented(const QByteArray& wav, const QString& fileName,
+                                         const TranscriptionJob::Metadata& metadata = {});
+
+    // Streaming mode: the request is opened before recording ends and the returned
+    // device is fed with audio bytes while capturing. header is sent first (the WAV
+    // header for raw PCM, empty for self-describing formats). job is set to the new
+    // job's ID. Returns null (and job 0) if the request cannot be started (e.g. no
+    // API key), in which case callers should fall back to transcribeAudioFile().
+    QSharedPointer<StreamingUploadDevice> startStreamingTranscription(const QString& fileName,
+                                                                      const QString& contentType,
+                                                                      const QByteArray& header,
+                                                                      quint64& job);
+    // The metadata is only known once recording has stopped
+    void finishStreamingTranscription(quint64 job,
+                                      const QSharedPointer<StreamingUploadDevice>& device,
+                                      const TranscriptionJob::Metadata& metadata);
+
+    // Forgets a job and stops its backend working on it: nothing more is signalled
+    // for it, and later jobs no longer wait for it
+    void cancel(quint64 job);
+    // Submitted and not yet delivered, including results held back for ordering
+    int pendingJobs() const { return m_jobs.size(); }
+
+    // Gets the active backend ready while the user is still talking: opens the
+    // connection to the API, or loads the local model
+    void prepare();
+
+
+    // What the active backend can do with a recording
+    bool supportsStreaming() const;
+    bool supportsSegmentation() const;
+    bool acceptsCompressedAudio() const;
 
     // Available Whisper models
     static QStringList availableModels();
     QString currentModel() const;
     void setModel(const QString& model);
 
-    signals:
-        void transcriptionComplete(const QString& text);
-    void transcriptionComplete(const TranscriptionResult& result);
-    void transcriptionError(const QString& error);
-    void uploadProgress(qint64 bytesSent, qint64 bytesTotal);
-    void processingStarted();
-    void processingFinished();
+    // In-process whisper.cpp backend, if it was compiled in
+    static bool isLocalBackendAvailable();
+    static QStringList availableLocalModels();
 
-    private slots:
-        void handleTranscriptionResponse(QNetworkReply* reply);
-    void handleUploadProgress(qint64 bytesSent, qint64 bytesTotal);
+    signals:
+        void transcriptionComplete(quint64 job, const TranscriptionResult& result);
+    void transcriptionError(quint64 job, const QString& error);
+    void uploadProgress(quint64 job, qint64 bytesSent, qint64 bytesTotal);
+    // Per-request network phases, for checking that handshakes stay off the critical path
+    void requestTimed(quint64 job, const RequestTiming& timing);
+    void processingStarted(quint64 job);
+    void processingFinished(quint64 job);
 
 private:
-    QNetworkAccessManager* m_networkManager;
-    const QString API_URL = "https://api.groq.com/openai/v1/audio/transcriptions";
+    TranscriptionBackend* backend() const;
+    void connectBackend(TranscriptionBackend* backend);
+    // Everything besides the audio that changes what comes back
+    QString cacheParameters(const QString& contentType, const QString& mode) const;
+    quint64 submit(const QString& source, const QString& mode,
+                   const TranscriptionJob::Metadata& metadata);
+    // Answers the job from the cache, or remembers the key for storing its result
+    bool serveFromCache(quint64 job, const QString& key);
+    using FileSender = std::function<void(TranscriptionBackend*)>;
+    // Keys the file on the thread pool, then serves the job from the cache or sends it
+    void submitFile(quint64 job, const QString& filePath, const QString& parameters,
+                    const FileSender& send);
+    // The backend's answer; result is null on error
+    void finishJob(quint64 job, const TranscriptionResult* result, const QString& error);
+    void scheduleDelivery();
+    void deliverReady();
+    void traceRequestTiming(quint64 job, const RequestTiming& timing);
+
+    GroqTranscriptionBackend* m_remoteBackend;
+    TranscriptionBackend* m_localBackend; // null without whisper.cpp
+    TranscriptionCache m_cache;
+    QMap<quint64, TranscriptionJob> m_jobs; // Not yet delivered, in submission order
+    quint64 m_nextJob;
+    bool m_deliveryScheduled;
     static const QStringList AVAILABLE_MODELS;
-    QString m_currentFilePath;
 };
 
-#endif // TRANSCRIPTIONSERVICE_H
\ No newline at end of file
+#endif // TRANSCRIPTIONSERVICE_H
@@ -0,0 +1,171 @@
+// Streams an upload through GroqTranscriptionBackend to a local stand-in server
+// (VIBECO_API_URL) and checks the body arrives while it is still being written.
+// Exits non-zero on failure.
+
+#include "GroqTranscriptionBackend.h"
+#include "StreamingUploadDevice.h"
+#include "UnitTest.h"
+#include "config.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTemporaryDir>
+#include <functional>
+
+namespace {
+    bool waitFor(const std::function<bool()>& condition, int timeoutMs = 5000) {
+        QElapsedTimer timer;
+        timer.start();
+        while (!condition() && timer.elapsed() < timeoutMs) {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+        }
+        return condition();
+    }
+
+    // Accepts one connection and collects everything sent on it
+    class StandInServer {
+      public:
+        StandInServer() {
+            CHECK(m_server.listen(QHostAddress::LocalHost));
+            qputenv("VIBECO_API_URL", QByteArray("http://127.0.0.1:") +
+                                          QByteArray::number(m_server.serverPort()) +
+                                          "/openai/v1/audio/transcriptions");
+            QObject::connect(&m_server, &QTcpServer::newConnection, [this]() {
+                m_connection = m_server.nextPendingConnection();
+                QObject::connect(m_connection, &QTcpSocket::readyRead,
+                                 [this]() { m_received += m_connection->readAll(); });
+            });
+        }
+
+        const QByteArray& received() const {
+            return m_received;
+        }
+        // The request body with the chunked framing taken off
+        QByteArray body() const {
+            QByteArray body;
+            qsizetype pos = m_received.indexOf("\r\n\r\n") + 4;
+            for (;;) {
+                const qsizetype lineEnd = m_received.indexOf("\r\n", pos);
+                bool ok = false;
+                const qint64 size = m_received.mid(pos, lineEnd - pos).toLongLong(&ok, 16);
+                if (lineEnd < 0 || !ok || size == 0) {
+                    return body;
+                }
+                body += m_received.mid(lineEnd + 2, size);
+                pos = lineEnd + 2 + size + 2;
+            }
+        }
+        void respond(const QByteArray& response) {
+            m_connection->write(response);
+            m_connection->flush();
+        }
+
+      private:
+        QTcpServer m_server;
+        QTcpSocket* m_connection = nullptr;
+        QByteArray m_received;
+    };
+
+    struct Outcome {
+        QString text;
+        QString error;
+        bool done = false;
+    };
+
+    void watch(GroqTranscriptionBackend& backend, Outcome& outcome) {
+        QObject::connect(&backend, &TranscriptionBackend::transcriptionComplete,
+                         [&outcome](quint64, const TranscriptionResult& result) {
+                             outcome.text = result.text;
+                             outcome.done = true;
+                         });
+        QObject::connect(&backend, &TranscriptionBackend::transcriptionError,
+                         [&outcome](quint64, const QString& error) {
+                             outcome.error = error;
+                             outcome.done = true;
+                         });
+    }
+
+    void testBodyStreamsBeforeFinish() {
+        StandInServer server;
+        GroqTranscriptionBackend backend;
+        Outcome outcome;
+        watch(backend, outcome);
+
+        const QSharedPointer<StreamingUploadDevice> device =
+            backend.startStreaming(1, "dictation.wav", "audio/wav", "WAV-HEADER");
+        CHECK(device);
+        if (!device) {
+            return;
+        }
+
+        // Each append must reach the server while the body is still open
+        const QByteArray first = QByteArray(3000, 'a') + "FIRST-AUDIO";
+        device->appendData(first);
+        CHECK(waitFor([&]() { return server.received().contains("FIRST-AUDIO"); }));
+        CHECK(server.received().contains("Transfer-Encoding: chunked\r\n"));
+        CHECK(server.received().contains("Authorization: Bearer gsk_"));
+        CHECK(!server.received().contains("\r\n0\r\n\r\n"));
+
+        device->appendData("SECOND-AUDIO");
+        CHECK(waitFor([&]() { return server.received().contains("SECOND-AUDIO"); }));
+        CHECK(!outcome.done);
+
+        backend.finishStreaming(device);
+        CHECK(waitFor([&]() { return server.received().endsWith("\r\n0\r\n\r\n"); }));
+        const QByteArray body = server.body();
+        CHECK(body.contains("name=\"model\""));
+        CHECK(body.contains("\r\n\r\nWAV-HEADER" + first + "SECOND-AUDIO\r\n--"));
+        CHECK(body.endsWith("--\r\n"));
+
+        // A chunked response, split inside the JSON
+        server.respond("HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                       "Transfer-Encoding: chunked\r\n\r\n"
+                       "9\r\n{\"text\": \r\n"
+                       "13\r\n\"hello, streaming\"}\r\n"
+                       "0\r\n\r\n");
+        CHECK(waitFor([&]() { return outcome.done; }));
+        CHECK(outcome.error.isEmpty());
+        CHECK(outcome.text == "hello, streaming");
+    }
+
+    void testEarlyRejectionClosesBody() {
+        StandInServer server;
+        GroqTranscriptionBackend backend;
+        Outcome outcome;
+        watch(backend, outcome);
+
+        const QSharedPointer<StreamingUploadDevice> device =
+            backend.startStreaming(2, "dictation.wav", "audio/wav", "WAV-HEADER");
+        CHECK(device);
+        if (!device) {
+            return;
+        }
+        device->appendData("AUDIO");
+        CHECK(waitFor([&]() { return server.received().contains("AUDIO"); }));
+
+        // Rejected while still recording: the body is closed, so the recording
+        // is uploaded as a file once it stops
+        const QByteArray error = "{\"error\":{\"message\":\"Invalid API Key\"}}";
+        server.respond("HTTP/1.1 401 Unauthorized\r\nContent-Type: application/json\r\n"
+                       "Content-Length: " +
+                       QByteArray::number(error.size()) + "\r\n\r\n" + error);
+        CHECK(waitFor([&]() { return outcome.done; }));
+        CHECK(!outcome.error.isEmpty());
+        CHECK(device->isClosed());
+    }
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // Keep the settings written for the API key away from the real ones
+    QTemporaryDir settings;
+    qputenv("XDG_CONFIG_HOME", settings.path().toUtf8());
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setOrganizationName("vibeco-tests");
+    QCoreApplication::setApplicationName("streaming-upload-test");
+    Config::instance().setApiKey("gsk_integration_test_key_0123456789");
+
+    testBodyStreamsBeforeFinish();
+    testEarlyRejectionClosesBody();
+    return UnitTest::finish("streaming_upload");
+}
@@ -0,0 +1,271 @@
+// Unit tests for HistoryLog's crash recovery. Exits non-zero on failure.
+
+#include "HistoryLog.h"
+#include "UnitTest.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace {
+    namespace fs = std::filesystem;
+
+    constexpr uint64_t kLogHeaderBytes = 8;
+    constexpr uint64_t kRecordHeaderBytes = 8;
+
+    // A fresh log path in its own temporary directory, removed again on destruction
+    class TempLog {
+      public:
+        explicit TempLog(const char* name)
+            : m_dir(fs::temp_directory_path() / ("vibeco_historylog_" + std::string(name))) {
+            fs::remove_all(m_dir);
+            fs::create_directories(m_dir);
+        }
+        ~TempLog() {
+            std::error_code error;
+            fs::remove_all(m_dir, error);
+        }
+
+        std::string path() const {
+            return (m_dir / "history.log").string();
+        }
+        std::string indexPath() const {
+            return path() + ".idx";
+        }
+
+      private:
+        fs::path m_dir;
+    };
+
+    const std::vector<std::string> kRecords = {"first record", "", "third, a little longer"};
+
+    // Writes kRecords and closes the log; returns the byte offset of each
+    std::vector<uint64_t> writeRecords(const std::string& path) {
+        std::vector<uint64_t> offsets;
+        HistoryLog log;
+        CHECK(log.open(path));
+        uint64_t offset = kLogHeaderBytes;
+        for (const std::string& record : kRecords) {
+            CHECK(log.append(record));
+            offsets.push_back(offset);
+            offset += kRecordHeaderBytes + record.size();
+        }
+        return offsets;
+    }
+
+    bool holds(HistoryLog& log, const std::vector<std::string>& records) {
+        if (log.size() != records.size()) {
+            return false;
+        }
+        std::string payload;
+        for (size_t i = 0; i < records.size(); ++i) {
+            if (!log.read(i, payload) || payload != records[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void appendRaw(const std::string& path, const std::string& bytes) {
+        std::ofstream(path, std::ios::binary | std::ios::app) << bytes;
+    }
+
+    void flipByte(const std::string& path, uint64_t offset) {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekg(static_cast<std::streamoff>(offset));
+        const char byte = static_cast<char>(file.get() ^ 0x5A);
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.put(byte);
+    }
+
+    void testRoundTrip() {
+        TempLog temp("roundtrip");
+        writeRecords(temp.path());
+
+        HistoryLog log;
+        CHECK(log.open(temp.path()));
+        CHECK(holds(log, kRecords));
+        std::string payload;
+        CHECK(!log.read(kRecords.size(), payload));
+        CHECK(fs::file_size(temp.indexPath()) == kRecords.size() * 8);
+
+        CHECK(log.clear());
+        CHECK(log.size() == 0);
+        CHECK(log.append("after clear"));
+        CHECK(holds(log, {"after clear"}));
+    }
+
+    void testTornTail() {
+        TempLog temp("torn");
+        const std::vector<uint64_t> offsets = writeRecords(temp.path());
+        const uint64_t intact = offsets.back();
+
+        // Crash partway through the last record's payload
+        fs::resize_file(temp.path(), intact + kRecordHeaderBytes + 4);
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(holds(log, {kRecords[0], kRecords[1]}));
+            CHECK(fs::file_size(temp.path()) == intact);
+            CHECK(fs::file_size(temp.indexPath()) == 2 * 8);
+
+            // The next append goes where the torn record was
+            CHECK(log.append("replacement"));
+        }
+        HistoryLog log;
+        CHECK(log.open(temp.path()));
+        CHECK(holds(log, {kRecords[0], kRecords[1], "replacement"}));
+
+        // Crash partway through a record header
+        log.close();
+        appendRaw(temp.path(), std::string("\x05\x00\x00", 3));
+        CHECK(log.open(temp.path()));
+        CHECK(log.size() == 3);
+        CHECK(log.append("after header"));
+        CHECK(holds(log, {kRecords[0], kRecords[1], "replacement", "after header"}));
+    }
+
+    void testTornLogHeader() {
+        TempLog temp("torn_header");
+        appendRaw(temp.path(), "VBH");
+        HistoryLog log;
+        CHECK(log.open(temp.path()));
+        CHECK(log.size() == 0);
+        CHECK(log.append("fresh"));
+        CHECK(holds(log, {"fresh"}));
+    }
+
+    void testIndexRecovery() {
+        TempLog temp("index");
+
+        // Missing index tail: the last append crashed before its index entry
+        writeRecords(temp.path());
+        fs::resize_file(temp.indexPath(), 8);
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(holds(log, kRecords));
+            CHECK(fs::file_size(temp.indexPath()) == kRecords.size() * 8);
+        }
+
+        // Misaligned: a torn index entry
+        fs::resize_file(temp.indexPath(), 2 * 8 + 3);
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(holds(log, kRecords));
+            CHECK(fs::file_size(temp.indexPath()) == kRecords.size() * 8);
+        }
+
+        // Missing altogether
+        fs::remove(temp.indexPath());
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(holds(log, kRecords));
+        }
+
+        // Stale: lists records past the end of the log
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(log.append("dropped later"));
+        }
+        fs::resize_file(temp.path(), fs::file_size(temp.path()) - 5);
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(holds(log, kRecords));
+            CHECK(fs::file_size(temp.indexPath()) == kRecords.size() * 8);
+        }
+
+        // Garbage: offsets out of order
+        std::ofstream(temp.indexPath(), std::ios::binary | std::ios::trunc)
+            << std::string("\x30\0\0\0\0\0\0\0\x08\0\0\0\0\0\0\0", 16);
+        HistoryLog log;
+        CHECK(log.open(temp.path()));
+        CHECK(holds(log, kRecords));
+    }
+
+    void testCorruptedChecksum() {
+        TempLog temp("checksum");
+        const std::vector<uint64_t> offsets = writeRecords(temp.path());
+
+        // Damage in the middle only fails that record
+        flipByte(temp.path(), offsets[0] + kRecordHeaderBytes + 2);
+        {
+            HistoryLog log;
+            CHECK(log.open(temp.path()));
+            CHECK(log.size() == kRecords.size());
+            std::string payload;
+            CHECK(!log.read(0, payload));
+            CHECK(log.read(1, payload) && payload == kRecords[1]);
+            CHECK(log.read(2, payload) && payload == kRecords[2]);
+        }
+
+        // Damage to the last record looks like a torn write and is cut off, without
+        // the damaged first record costing the intact one between them
+        flipByte(temp.path(), offsets[2] + 4);
+        HistoryLog log;
+        CHECK(log.open(temp.path()));
+        CHECK(log.size() == 2);
+        CHECK(fs::file_size(temp.path()) == offsets[2]);
+        std::string payload;
+        CHECK(log.read(1, payload) && payload == kRecords[1]);
+    }
+
+    void testForeignFile() {
+        TempLog temp("foreign");
+        const std::string contents = "not a history log at all";
+        appendRaw(temp.path(), contents);
+        HistoryLog log;
+        CHECK(!log.open(temp.path()));
+        CHECK(fs::file_size(temp.path()) == contents.size());
+    }
+
+    void testReadOnlyBesideWriter() {
+        TempLog temp("readonly");
+        HistoryLog reader;
+        CHECK(!reader.open(temp.path(), HistoryLog::Mode::ReadOnly));
+
+        HistoryLog writer;
+        CHECK(writer.open(temp.path()));
+        CHECK(writer.append(kRecords[0]));
+
+        CHECK(reader.open(temp.path(), HistoryLog::Mode::ReadOnly));
+        CHECK(holds(reader, {kRecords[0]}));
+        CHECK(!reader.append("refused"));
+        CHECK(!reader.clear());
+
+        CHECK(writer.append(kRecords[1]));
+        CHECK(reader.size() == 1);
+        CHECK(reader.refresh() == 2);
+        CHECK(holds(reader, {kRecords[0], kRecords[1]}));
+
+        // An append in progress is neither shown nor cut off by the reader
+        const uint64_t before = fs::file_size(temp.path());
+        appendRaw(temp.path(), std::string("\x40\0\0\0\0\0\0\0partial", 15));
+        CHECK(reader.refresh() == 2);
+        HistoryLog second;
+        CHECK(second.open(temp.path(), HistoryLog::Mode::ReadOnly));
+        CHECK(second.size() == 2);
+        CHECK(fs::file_size(temp.path()) == before + 15);
+
+        // The writer's next append goes where it thinks the log ends
+        CHECK(writer.append(kRecords[2]));
+        CHECK(reader.refresh() == 3);
+        CHECK(holds(reader, kRecords));
+    }
+} // namespace
+
+int main() {
+    testRoundTrip();
+    testTornTail();
+    testTornLogHeader();
+    testIndexRecovery();
+    testCorruptedChecksum();
+    testForeignFile();
+    testReadOnlyBesideWriter();
+    return UnitTest::finish("history_log");
+}
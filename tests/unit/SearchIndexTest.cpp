@@ -0,0 +1,112 @@
+// Unit tests for SearchIndex's word splitting and matching. Exits non-zero on failure.
+
+#include "SearchIndex.h"
+#include "UnitTest.h"
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    bool finds(const SearchIndex& index, std::string_view query, std::vector<uint32_t> documents) {
+        std::vector<uint32_t> found;
+        for (const SearchIndex::Hit& hit : index.search(query, 10)) {
+            found.push_back(hit.document);
+        }
+        std::sort(found.begin(), found.end());
+        return found == documents;
+    }
+
+    // The highlighted substrings of text
+    std::vector<std::string> highlighted(std::string_view text, std::string_view query) {
+        std::vector<std::string> words;
+        for (const SearchIndex::Range& range : SearchIndex::highlights(text, query)) {
+            words.emplace_back(text.substr(range.offset, range.length));
+        }
+        return words;
+    }
+
+    void testPunctuation() {
+        SearchIndex index;
+        index.add(0, "He said \xE2\x80\x9Chello\xE2\x80\x9D and left");        // Curly quotes
+        index.add(1, "wait\xE2\x80\x94what");                                  // Em dash
+        index.add(2, "10\xC2\xA0km away");                                     // NBSP
+        index.add(3, "caf\xC3\xA9 na\xC3\xAFve");                              // Accented letters
+        index.add(4, "\xC2\xBFQu\xC3\xA9 tal?");                               // Inverted question mark
+
+        CHECK(finds(index, "hello", {0}));
+        CHECK(finds(index, "said hello", {0}));
+        CHECK(finds(index, "what ", {1}));
+        CHECK(finds(index, "wait ", {1}));
+        CHECK(finds(index, "km", {2}));
+        CHECK(finds(index, "10 ", {2}));
+        CHECK(finds(index, "caf\xC3\xA9", {3}));
+        CHECK(finds(index, "caf", {3}));
+        CHECK(finds(index, "na\xC3\xAFve ", {3}));
+        CHECK(finds(index, "qu\xC3\xA9", {4}));
+
+        CHECK((highlighted("\xE2\x80\x9Chello\xE2\x80\x9D", "hello") ==
+               std::vector<std::string>{"hello"}));
+        // A query ending in punctuation has no word being typed
+        CHECK(finds(index, "wai\xE2\x80\x94", {}));
+    }
+
+    void testIdeographs() {
+        SearchIndex index;
+        // "Today the weather is good." with ideographic punctuation, no spaces
+        index.add(0, "\xE4\xBB\x8A\xE5\xA4\xA9\xE5\xA4\xA9\xE6\xB0\x94\xE5\xBE\x88"
+                     "\xE5\xA5\xBD\xE3\x80\x82");
+        // "Tomorrow"
+        index.add(1, "\xE6\x98\x8E\xE5\xA4\xA9\xEF\xBC\x81");
+
+        // 天 (day) occurs in both, 天气 (weather) only in the first
+        CHECK(finds(index, "\xE5\xA4\xA9", {0, 1}));
+        CHECK(finds(index, "\xE5\xA4\xA9\xE6\xB0\x94", {0}));
+        CHECK(finds(index, "\xE5\xA5\xBD", {0}));
+        // Punctuation isn't glued to the last character
+        CHECK(finds(index, "\xE5\xA5\xBD ", {0}));
+        CHECK(finds(index, "\xE3\x80\x82", {}));
+
+        CHECK((highlighted("\xE6\x98\x8E\xE5\xA4\xA9\xEF\xBC\x81", "\xE5\xA4\xA9") ==
+               std::vector<std::string>{"\xE5\xA4\xA9"}));
+    }
+
+    void testPrefixAndCase() {
+        SearchIndex index;
+        index.add(0, "Transcription finished");
+        index.add(1, "Translation pending");
+
+        CHECK(finds(index, "tran", {0, 1}));
+        CHECK(finds(index, "TRANS", {0, 1}));
+        CHECK(finds(index, "transc", {0}));
+        CHECK(finds(index, "tran ", {}));
+        CHECK(finds(index, "finished transl", {}));
+
+        CHECK((highlighted("Transcription finished", "transcription fin") ==
+               std::vector<std::string>{"Transcription", "finished"}));
+    }
+
+    void testLongAndMalformed() {
+        SearchIndex index;
+        // Truncated to 48 bytes without splitting the two-byte é
+        std::string longWord(47, 'a');
+        longWord += "\xC3\xA9tail";
+        index.add(0, longWord);
+        CHECK(finds(index, longWord, {0}));
+        CHECK(finds(index, std::string(47, 'a'), {0}));
+
+        // Stray continuation bytes and a cut-off sequence read as letters
+        index.add(1, "ab\x80\x80 cd\xE4\xBB");
+        CHECK(finds(index, "ab\x80\x80", {1}));
+        CHECK(finds(index, "cd\xE4\xBB", {1}));
+        CHECK(finds(index, "cd", {1}));
+    }
+} // namespace
+
+int main() {
+    testPunctuation();
+    testIdeographs();
+    testPrefixAndCase();
+    testLongAndMalformed();
+    return UnitTest::finish("search_index");
+}
@@ -0,0 +1,30 @@
+#ifndef UNITTEST_H
+#define UNITTEST_H
+
+#include <cstdio>
+
+// Just enough of a harness for the core unit tests: CHECK() reports a failed
+// condition and carries on, and main() returns UnitTest::finish(name).
+namespace UnitTest {
+    inline int failures = 0;
+
+    inline void check(bool condition, const char* what, const char* file, int line) {
+        if (!condition) {
+            std::fprintf(stderr, "%s:%d: %s\n", file, line, what);
+            ++failures;
+        }
+    }
+
+    inline int finish(const char* name) {
+        if (failures != 0) {
+            std::fprintf(stderr, "%d %s check(s) failed\n", failures, name);
+            return 1;
+        }
+        std::printf("All %s checks passed\n", name);
+        return 0;
+    }
+} // namespace UnitTest
+
+#define CHECK(condition) UnitTest::check((condition), #condition, __FILE__, __LINE__)
+
+#endif // UNITTEST_H
@@ -0,0 +1,138 @@
+// Unit tests for the verbose_json response parser. Exits non-zero on failure.
+
+#include "UnitTest.h"
+#include "VerboseJson.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+namespace {
+    bool parses(const std::string& json, VerboseTranscript& out) {
+        std::string error;
+        const bool ok = VerboseJson::parse(json, out, error);
+        if (!ok) {
+            std::fprintf(stderr, "  %s: %s\n", json.c_str(), error.c_str());
+        }
+        return ok;
+    }
+
+    bool rejects(const std::string& json) {
+        VerboseTranscript out;
+        std::string error;
+        return !VerboseJson::parse(json, out, error) && !error.empty();
+    }
+
+    // {"text":"x","duration":<number>}
+    bool durationIs(const char* number, double expected) {
+        VerboseTranscript out;
+        return parses(std::string(R"({"text":"x","duration":)") + number + "}", out) &&
+               std::abs(out.duration - expected) <= 1e-9 * std::max(1.0, std::abs(expected));
+    }
+
+    void testFullResponse() {
+        VerboseTranscript out;
+        CHECK(parses(R"({
+            "task": "transcribe", "language": "english", "duration": 2.5,
+            "text": " Hello world",
+            "segments": [
+                {"id": 0, "seek": 0, "start": 0.0, "end": 2.5, "text": " Hello world",
+                 "tokens": [50364, 2425], "temperature": 0.0, "avg_logprob": -0.25,
+                 "compression_ratio": 0.8, "no_speech_prob": 0.01}
+            ],
+            "words": [{"word": "Hello", "start": 0.1, "end": 0.6},
+                      {"word": "world", "start": 0.7, "end": 1.2}],
+            "x_groq": {"id": "req_01"}
+        })",
+                     out));
+        CHECK(out.text == " Hello world");
+        CHECK(out.language == "english");
+        CHECK(out.task == "transcribe");
+        CHECK(out.requestId == "req_01");
+        CHECK(out.duration == 2.5);
+        CHECK(out.segments.size() == 1 && out.segments.text(0) == " Hello world" &&
+              out.segments.avgLogProb(0) == -0.25);
+        CHECK(out.segments.wordCount() == 2);
+    }
+
+    void testNullStrings() {
+        VerboseTranscript out;
+        CHECK(parses(R"({"text":"hi","language":null,"task":null,"x_groq":{"id":null}})", out));
+        CHECK(out.text == "hi");
+        CHECK(out.language.empty());
+        CHECK(out.task.empty());
+        CHECK(out.requestId.empty());
+
+        CHECK(parses(R"({"text":null,"segments":[{"start":0,"end":1,"text":null}]})", out));
+        CHECK(out.text.empty());
+        CHECK(out.segments.size() == 1 && out.segments.text(0).empty());
+
+        // Names can't be null, and a misspelt null is still an error
+        CHECK(rejects(R"({"text":"hi",null:1})"));
+        CHECK(rejects(R"({"text":nul})"));
+    }
+
+    void testNullNumbers() {
+        VerboseTranscript out;
+        CHECK(parses(R"({"text":"hi","duration":null})", out));
+        CHECK(out.duration < 0.0);
+    }
+
+    void testNumbers() {
+        CHECK(durationIs("0", 0.0));
+        CHECK(durationIs("-0", 0.0));
+        CHECK(durationIs("7", 7.0));
+        CHECK(durationIs("120", 120.0));
+        CHECK(durationIs("0.5", 0.5));
+        CHECK(durationIs("-12.25", -12.25));
+        CHECK(durationIs("1e3", 1000.0));
+        CHECK(durationIs("1.5E-2", 0.015));
+        CHECK(durationIs("2e+2", 200.0));
+
+        CHECK(rejects(R"({"text":"x","duration":01})"));
+        CHECK(rejects(R"({"text":"x","duration":-01})"));
+        CHECK(rejects(R"({"text":"x","duration":.5})"));
+        CHECK(rejects(R"({"text":"x","duration":1.})"));
+        CHECK(rejects(R"({"text":"x","duration":1.e3})"));
+        CHECK(rejects(R"({"text":"x","duration":-})"));
+        CHECK(rejects(R"({"text":"x","duration":1e})"));
+        CHECK(rejects(R"({"text":"x","duration":+1})"));
+    }
+
+    void testEscapes() {
+        VerboseTranscript out;
+        CHECK(parses(R"({"text":"a\"b\\c\/d\n\t"})", out));
+        CHECK(out.text == "a\"b\\c/d\n\t");
+        CHECK(parses(R"({"text":"\u00e9\u20AC\uD83D\uDE00"})", out));
+        CHECK(out.text == "\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80");
+
+        // Unpaired surrogates become U+FFFD without swallowing what follows
+        CHECK(parses(R"({"text":"\uD800\u0041"})", out));
+        CHECK(out.text == "\xEF\xBF\xBD" "A");
+        CHECK(parses(R"({"text":"\uD800\uD83D\uDE00"})", out));
+        CHECK(out.text == "\xEF\xBF\xBD\xF0\x9F\x98\x80");
+        CHECK(parses(R"({"text":"\uDC00x\uD800"})", out));
+        CHECK(out.text == "\xEF\xBF\xBDx\xEF\xBF\xBD");
+
+        CHECK(rejects(R"({"text":"\uD800\u00"})"));
+        CHECK(rejects(R"({"text":"\q"})"));
+    }
+
+    void testMalformed() {
+        CHECK(rejects(""));
+        CHECK(rejects(R"({"duration":1})"));
+        CHECK(rejects(R"({"text":"unterminated})"));
+        CHECK(rejects(R"({"text":"x"} trailing)"));
+        CHECK(rejects(R"({"text":"x",})"));
+    }
+} // namespace
+
+int main() {
+    testFullResponse();
+    testNullStrings();
+    testNullNumbers();
+    testNumbers();
+    testEscapes();
+    testMalformed();
+    return UnitTest::finish("verbose_json");
+}
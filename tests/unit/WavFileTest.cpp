@@ -0,0 +1,119 @@
+// Unit tests for the WAV/RF64 header helpers. Exits non-zero on failure.
+
+#include "UnitTest.h"
+#include "WavFile.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+    uint32_t get32(const char* in) {
+        const auto* b = reinterpret_cast<const unsigned char*>(in);
+        return static_cast<uint32_t>(b[0]) | (static_cast<uint32_t>(b[1]) << 8) |
+               (static_cast<uint32_t>(b[2]) << 16) | (static_cast<uint32_t>(b[3]) << 24);
+    }
+
+    uint64_t get64(const char* in) {
+        return static_cast<uint64_t>(get32(in)) | (static_cast<uint64_t>(get32(in + 4)) << 32);
+    }
+
+    void testPlainHeaderRoundTrip() {
+        WavFile::Format format;
+        format.sampleRate = 44100;
+        format.channels = 2;
+        std::vector<char> file(WavFile::kHeaderSize + 400);
+        const auto header = WavFile::header(format, 400);
+        std::memcpy(file.data(), header.data(), header.size());
+
+        CHECK(std::memcmp(file.data(), "RIFF", 4) == 0);
+        CHECK(get32(file.data() + 4) == 436);
+
+        WavFile::Format parsed;
+        size_t dataOffset = 0, dataSize = 0;
+        CHECK(WavFile::parse(file.data(), file.size(), parsed, dataOffset, dataSize));
+        CHECK(parsed.sampleRate == 44100 && parsed.channels == 2 &&
+              parsed.bitsPerSample == 16 && parsed.audioFormat == WavFile::kFormatPcm);
+        CHECK(dataOffset == WavFile::kHeaderSize);
+        CHECK(dataSize == 400);
+
+        // An unpatched streaming header covers whatever is actually there
+        const auto streaming = WavFile::header(format, WavFile::kUnknownSize);
+        std::memcpy(file.data(), streaming.data(), streaming.size());
+        CHECK(WavFile::parse(file.data(), file.size(), parsed, dataOffset, dataSize));
+        CHECK(dataSize == 400);
+    }
+
+    void testRf64HeaderRoundTrip() {
+        WavFile::Format format;
+        std::vector<char> file(WavFile::kRf64HeaderSize + 100);
+        const auto header = WavFile::rf64Header(format, 100);
+        std::memcpy(file.data(), header.data(), header.size());
+
+        CHECK(std::memcmp(file.data(), "RIFF", 4) == 0);
+        CHECK(std::memcmp(file.data() + 12, "JUNK", 4) == 0);
+        CHECK(get32(file.data() + 4) == 100 + WavFile::kRf64HeaderSize - 8);
+
+        WavFile::Format parsed;
+        size_t dataOffset = 0, dataSize = 0;
+        CHECK(WavFile::parse(file.data(), file.size(), parsed, dataOffset, dataSize));
+        CHECK(dataOffset == WavFile::kRf64HeaderSize);
+        CHECK(dataSize == 100);
+    }
+
+    void testRf64Threshold() {
+        const WavFile::Format format;
+        // The largest data whose RIFF size still fits in 32 bits
+        const uint64_t lastRiff = 0xFFFFFFFFULL - (WavFile::kRf64HeaderSize - 8);
+
+        auto header = WavFile::rf64Header(format, lastRiff);
+        CHECK(std::memcmp(header.data(), "RIFF", 4) == 0);
+        CHECK(get32(header.data() + 4) == 0xFFFFFFFFU);
+        CHECK(get32(header.data() + 76) == lastRiff);
+
+        // Would have wrapped the 32-bit RIFF size before the switch moved down
+        for (const uint64_t dataSize : {lastRiff + 1, WavFile::kMaxRiffDataSize,
+                                        uint64_t{0x123456789}}) {
+            header = WavFile::rf64Header(format, dataSize);
+            CHECK(std::memcmp(header.data(), "RF64", 4) == 0);
+            CHECK(std::memcmp(header.data() + 12, "ds64", 4) == 0);
+            CHECK(get32(header.data() + 4) == WavFile::kUnknownSize);
+            CHECK(get64(header.data() + 20) == dataSize + WavFile::kRf64HeaderSize - 8);
+            CHECK(get64(header.data() + 28) == dataSize);
+            CHECK(get64(header.data() + 36) == dataSize / 2);
+            CHECK(get32(header.data() + 76) == WavFile::kUnknownSize);
+        }
+
+        // An RF64 file is parsed through ds64, clamped to the bytes present
+        std::vector<char> file(WavFile::kRf64HeaderSize + 64);
+        header = WavFile::rf64Header(format, uint64_t{0x123456789});
+        std::memcpy(file.data(), header.data(), header.size());
+        WavFile::Format parsed;
+        size_t dataOffset = 0, dataSize = 0;
+        CHECK(WavFile::parse(file.data(), file.size(), parsed, dataOffset, dataSize));
+        CHECK(dataOffset == WavFile::kRf64HeaderSize);
+        CHECK(dataSize == 64);
+    }
+
+    void testRejects() {
+        WavFile::Format parsed;
+        size_t dataOffset = 0, dataSize = 0;
+        const char notWav[] = "RIFF\x10\0\0\0AVI LIST";
+        CHECK(!WavFile::parse(notWav, sizeof(notWav) - 1, parsed, dataOffset, dataSize));
+        CHECK(!WavFile::parse("RIFF", 4, parsed, dataOffset, dataSize));
+
+        // A data chunk before any fmt chunk can't be read
+        std::vector<char> file(20, '\0');
+        std::memcpy(file.data(), "RIFF", 4);
+        std::memcpy(file.data() + 8, "WAVE", 4);
+        std::memcpy(file.data() + 12, "data", 4);
+        CHECK(!WavFile::parse(file.data(), file.size(), parsed, dataOffset, dataSize));
+    }
+} // namespace
+
+int main() {
+    testPlainHeaderRoundTrip();
+    testRf64HeaderRoundTrip();
+    testRf64Threshold();
+    testRejects();
+    return UnitTest::finish("wav_file");
+}
@@ -0,0 +1,67 @@
+// Unit tests for XXH64 against the reference output. Exits non-zero on failure.
+
+#include "UnitTest.h"
+#include "XxHash64.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+    // Bytes (i * 31 + 7) mod 256, so every tail length sees distinct data
+    std::vector<unsigned char> pattern(size_t size) {
+        std::vector<unsigned char> data(size);
+        for (size_t i = 0; i < size; ++i) {
+            data[i] = static_cast<unsigned char>(i * 31 + 7);
+        }
+        return data;
+    }
+
+    struct Vector {
+        size_t size;
+        uint64_t hash;
+    };
+    // From the reference implementation; lengths cover each tail path and the 32-byte stripes
+    constexpr Vector kVectors[] = {
+        {1, 0xa96c7f0ce858bbb7},   {3, 0x56e6957632a487f9},   {4, 0xc60d15b1e3ff8f04},
+        {8, 0x3da5c7aa269683e0},   {31, 0x4a74f3a1a39ad4a1},  {32, 0x8d57d6a4671cc43d},
+        {33, 0x62c9fd21ed857664},  {100, 0xefa0ad2d3e70c151}, {1000, 0x99594f4828043d35},
+    };
+
+    void testReference() {
+        CHECK(XxHash64::hash("", 0) == 0xef46db3751d8e999);
+        CHECK(XxHash64::hash("abc", 3) == 0x44bc2cf5ad770999);
+
+        const std::vector<unsigned char> data = pattern(1000);
+        for (const Vector& vector : kVectors) {
+            CHECK(XxHash64::hash(data.data(), vector.size) == vector.hash);
+        }
+        CHECK(XxHash64::hash(data.data(), 100, 0x9E3779B97F4A7C15) == 0xbc7ab33be7528c18);
+    }
+
+    void testStreaming() {
+        const std::vector<unsigned char> data = pattern(1000);
+        // Chunk sizes that straddle the internal 32-byte buffer in different ways
+        for (const size_t chunk : {size_t{1}, size_t{7}, size_t{32}, size_t{45}, size_t{999}}) {
+            for (const Vector& vector : kVectors) {
+                XxHash64 hasher;
+                for (size_t offset = 0; offset < vector.size; offset += chunk) {
+                    const size_t size = offset + chunk < vector.size ? chunk : vector.size - offset;
+                    hasher.update(data.data() + offset, size);
+                }
+                CHECK(hasher.digest() == vector.hash);
+            }
+        }
+
+        // digest() doesn't end the stream
+        XxHash64 hasher;
+        hasher.update(data.data(), 40);
+        CHECK(hasher.digest() == XxHash64::hash(data.data(), 40));
+        hasher.update(data.data() + 40, 60);
+        CHECK(hasher.digest() == 0xefa0ad2d3e70c151);
+    }
+} // namespace
+
+int main() {
+    testReference();
+    testStreaming();
+    return UnitTest::finish("xxhash64");
+}